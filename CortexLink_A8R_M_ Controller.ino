@@ -1,13 +1,14 @@
 ﻿#include <Arduino.h>
 #include <WiFi.h>
 #include "esp_wifi.h"
-#include <WebServer.h>
+#include "src/HttpServer.h"
 #include <Preferences.h>
 #include <LittleFS.h>
 
 #include "src/Config.h"
 #include "src/Settings.h"
 #include "src/Debug.h"
+#include "src/Console.h"
 #include "src/DigitalInputDriver.h"
 #include "src/RelayDriver.h"
 #include "src/DACControl.h"
@@ -62,14 +63,14 @@ String g_staDns = "8.8.8.8";
 EthernetServer* g_tcpServer = nullptr;
 EthernetClient  g_tcpClient;
 uint16_t        g_tcpPort = 5000;
+LineReader      g_tcpLine;
 unsigned long   g_lastClientRx = 0;
 const uint32_t  CLIENT_TIMEOUT_MS = 30000;
 
 // ======================================================================
 // SERIAL CONSOLE
 // ======================================================================
-String  g_serialCmd;
-bool    g_serialCmdReady = false;
+LineReader g_serialLine;
 
 // ======================================================================
 // SCHEDULER
@@ -408,6 +409,7 @@ static uint16_t mbDacGet(TRegister* reg, uint16_t val);
 static uint16_t mbDacSet(TRegister* reg, uint16_t val);
 static uint16_t mbRtcGet(TRegister* reg, uint16_t val);
 static uint16_t mbRtcSet(TRegister* reg, uint16_t val);
+static uint16_t mbHeapCallback(TRegister* reg, uint16_t val);
 
 // ======================================================================
 // Utility
@@ -1252,6 +1254,13 @@ void loop() {
 
     processSerial();
 
+    // Heap / stack telemetry (MQTT sys/*, Modbus IR 260..267)
+    static uint32_t lastHeapSample = 0;
+    if (lastHeapSample == 0 || (millis() - lastHeapSample) > HEAP_SAMPLE_INTERVAL_MS) {
+        lastHeapSample = millis();
+        Debug::sampleHeap();
+    }
+
     if (g_rebootPending && (int32_t)(millis() - g_rebootAtMs) >= 0) {
         tcpSend("NETCFG REBOOTING");
         delay(40);
@@ -1334,6 +1343,11 @@ static void initModbus() {
             ERROR_LOG("Failed to add input register handlers for DS18B20");
         }
 
+        // Heap telemetry (260..267) as input registers
+        if (!g_modbus.addInputRegisterHandler(MB_REG_HEAP_START, 8, mbHeapCallback)) {
+            ERROR_LOG("Failed to add input register handlers for heap telemetry");
+        }
+
         // DAC controls (70..73) as holding registers
         if (!g_modbus.addHoldingRegisterHandlers(MB_REG_DAC_START, 4, mbDacGet, mbDacSet)) {
             ERROR_LOG("Failed to add holding register handlers for DAC");
@@ -1630,6 +1644,23 @@ static uint16_t mbRtcSet(TRegister* reg, uint16_t val) {
     return reg->value;
 }
 
+// Heap telemetry input regs (FC04): free, min free, largest block (lo/hi word pairs),
+// fragmentation %, loop task stack free
+static uint16_t mbHeapCallback(TRegister* reg, uint16_t) {
+    const HeapStats& hs = Debug::heapStats();
+    switch (reg->address.address - MB_REG_HEAP_START) {
+    case 0: return (uint16_t)(hs.freeBytes & 0xFFFF);
+    case 1: return (uint16_t)(hs.freeBytes >> 16);
+    case 2: return (uint16_t)(hs.minFreeBytes & 0xFFFF);
+    case 3: return (uint16_t)(hs.minFreeBytes >> 16);
+    case 4: return (uint16_t)(hs.largestBlock & 0xFFFF);
+    case 5: return (uint16_t)(hs.largestBlock >> 16);
+    case 6: return hs.fragmentationPct;
+    case 7: return (uint16_t)min(hs.loopStackFree, (uint32_t)0xFFFF);
+    default: return 0;
+    }
+}
+
 
 
 // ======================================================================
@@ -2114,7 +2145,7 @@ void handleTcpClient() {
         g_tcpClient = g_tcpServer->available();
         if (g_tcpClient) {
             g_lastClientRx = millis();
-            g_tcpClient.setTimeout(100);
+            g_tcpLine.reset();
             g_tcpClient.println(F("HELLO A8R-M"));
             sendSnapshot(g_tcpClient, true);
         }
@@ -2126,12 +2157,11 @@ void handleTcpClient() {
         return;
     }
 
-    while (g_tcpClient && g_tcpClient.connected() && g_tcpClient.available()) {
-        String line = g_tcpClient.readStringUntil('\n');
-        line.trim();
-        if (line.length() == 0) continue;
-        g_lastClientRx = millis();
-        handleTcpCommand(line);
+    // Only bytes already received are taken; a partial line waits for the next pass
+    if (g_tcpClient.available()) g_lastClientRx = millis();
+    while (g_tcpClient && g_tcpClient.connected() && g_tcpLine.poll(g_tcpClient)) {
+        if (g_tcpLine.overflowed()) tcpSend("ERR TOOLONG");
+        else handleTcpCommand(g_tcpLine.line());
     }
 }
 
@@ -2409,381 +2439,396 @@ static bool analogStableConditionUpdate(AnalogTriggerConfig& a) {
 // ======================================================================
 // TCP COMMAND HANDLER
 // ======================================================================
-void handleTcpCommand(const String& line) {
-    String cmd = line;
-    cmd.trim();
-    if (cmd.length() == 0) return;
-
-    int sp = cmd.indexOf(' ');
-    String op = (sp < 0) ? cmd : cmd.substring(0, sp);
-    op.toUpperCase();
-    String args = (sp < 0) ? "" : cmd.substring(sp + 1);
-
-    if (op == "PING") { tcpSend("PONG"); return; }
-
-    if (op == "SNAPSHOT") { if (g_tcpClient && g_tcpClient.connected()) sendSnapshot(g_tcpClient, false); return; }
-    if (op == "SNAPJSON") { if (g_tcpClient && g_tcpClient.connected()) sendSnapshot(g_tcpClient, true);  return; }
-
-    if (op == "NETCFG") {
-        String sub = args; sub.trim();
-        int sp2 = sub.indexOf(' ');
-        String sop = (sp2 < 0) ? sub : sub.substring(0, sp2);
-        sop.toUpperCase();
-        String sargs = (sp2 < 0) ? "" : sub.substring(sp2 + 1);
-
-        if (sop == "GET") { netcfgReplyGet(); return; }
-        if (sop == "SET") { netcfgApplySet(sargs); return; }
-        tcpSend("NETCFG ERR");
-        return;
-    }
-
-    if (op == "SERIALNET") {
-        netcfgSerialDump();
-        tcpSend("SERIALNET OK");
-        return;
-    }
-
-    if (op == "REL") {
-        int sp1 = args.indexOf(' ');
-        if (sp1 < 0) { tcpSend("ERR REL"); return; }
-        uint8_t ch = args.substring(0, sp1).toInt();
-        String v = args.substring(sp1 + 1); v.toUpperCase();
-        bool ok = false;
-        if (ch >= 1 && ch <= NUM_RELAY_OUTPUTS && g_relays.isConnected()) {
-            if (v == "1" || v == "ON") ok = g_relays.turnOn(ch);
-            else if (v == "0" || v == "OFF") ok = g_relays.turnOff(ch);
-            else if (v == "TOGGLE" || v == "TG") ok = g_relays.toggle(ch);
-        }
-        tcpSend(String("REL ") + String(ch) + " " + (ok ? "OK" : "FAIL"));
-        return;
-    }
+static void tcpCmdPing(const String& args) {
+    tcpSend("PONG");
+}
 
-    if (op == "DACV") {
-        int sp1 = args.indexOf(' ');
-        if (sp1 < 0) { tcpSend("ERR DACV"); return; }
-        uint8_t ch = args.substring(0, sp1).toInt();
-        int mv = args.substring(sp1 + 1).toInt();
-        if (ch < 1 || ch > 2 || !g_dac.isInitialized()) { tcpSend("ERR DACV"); return; }
-        g_dac.setVoltage(ch - 1, mv / 1000.0f);
-        tcpSend("DACV OK");
-        return;
-    }
+static void tcpCmdSnapshot(const String& args) {
+    if (g_tcpClient && g_tcpClient.connected()) sendSnapshot(g_tcpClient, false);
+}
 
-    if (op == "BEEP") {
-        int sp1 = args.indexOf(' ');
-        if (sp1 < 0) { tcpSend("ERR BEEP"); return; }
-        uint16_t freq = (uint16_t)args.substring(0, sp1).toInt();
-        uint32_t ms = (uint32_t)args.substring(sp1 + 1).toInt();
-        g_rtc.simpleBeep(freq, ms);
-        tcpSend("BEEP OK");
-        return;
-    }
+static void tcpCmdSnapJson(const String& args) {
+    if (g_tcpClient && g_tcpClient.connected()) sendSnapshot(g_tcpClient, true);
+}
 
-    if (op == "BUZZOFF") {
-        buzzStop();
-        g_rtc.stopBeep();
-        tcpSend("BUZZOFF OK");
-        return;
-    }
+static void tcpCmdNetcfg(const String& args) {
+    String sub = args; sub.trim();
+    int sp2 = sub.indexOf(' ');
+    String sop = (sp2 < 0) ? sub : sub.substring(0, sp2);
+    sop.toUpperCase();
+    String sargs = (sp2 < 0) ? "" : sub.substring(sp2 + 1);
 
-    if (op == "RTCGET") {
-        DateTime now = g_rtc.getDateTime(true);
-        char buf[32];
-        snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u",
-            now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
-        tcpSend(String("RTC ") + buf);
-        return;
-    }
-
-    if (op == "RTCSET") {
-        if (g_rtc.setDateTimeFromString(args.c_str())) tcpSend("RTCSET OK");
-        else tcpSend("RTCSET ERR");
-        return;
-    }
+    if (sop == "GET") { netcfgReplyGet(); return; }
+    if (sop == "SET") { netcfgApplySet(sargs); return; }
+    tcpSend("NETCFG ERR");
+}
 
-    if (op == "NET?") {
-        IPAddress ip = g_eth.getIP();
-        bool link = g_eth.getLinkStatus();
-        tcpSend(String("NET IP=") + ipToString(ip) + " LINK=" + (link ? "UP" : "DOWN"));
-        return;
-    }
+static void tcpCmdSerialNet(const String& args) {
+    netcfgSerialDump();
+    tcpSend("SERIALNET OK");
+}
 
-    if (op == "BOARDINFO") {
-        hwInfoPrintBoardInfoTcp();
-        return;
+static void tcpCmdRel(const String& args) {
+    int sp1 = args.indexOf(' ');
+    if (sp1 < 0) { tcpSend("ERR REL"); return; }
+    uint8_t ch = args.substring(0, sp1).toInt();
+    String v = args.substring(sp1 + 1); v.toUpperCase();
+    bool ok = false;
+    if (ch >= 1 && ch <= NUM_RELAY_OUTPUTS && g_relays.isConnected()) {
+        if (v == "1" || v == "ON") ok = g_relays.turnOn(ch);
+        else if (v == "0" || v == "OFF") ok = g_relays.turnOff(ch);
+        else if (v == "TOGGLE" || v == "TG") ok = g_relays.toggle(ch);
     }
+    tcpSend(String("REL ") + String(ch) + " " + (ok ? "OK" : "FAIL"));
+}
 
-    // ==================================================================
-    // SCHED protocol (extended with analog trigger)
-    // ==================================================================
-    if (op == "SCHED") {
-        String sub = args; sub.trim();
-        int sp2 = sub.indexOf(' ');
-        String sop = (sp2 < 0) ? sub : sub.substring(0, sp2);
-        sop.toUpperCase();
-        String sargs = (sp2 < 0) ? "" : sub.substring(sp2 + 1);
-
-        auto parseInto = [&](ScheduleConfig& s, const String& t) {
-            String enS = getTokValue(t, "EN");
-            String modeS = getTokValue(t, "MODE"); modeS.toUpperCase();
-            String diS = getTokValue(t, "DI");
-            String edgeS = getTokValue(t, "EDGE"); edgeS.toUpperCase();
-            String startS = getTokValue(t, "START");
-            String endS = getTokValue(t, "END");
-            String recurS = getTokValue(t, "RECUR");
-            String daysS = getTokValue(t, "DAYS");
-
-            String rmaskS = getTokValue(t, "RELMASK");
-            String ractS = getTokValue(t, "RELACT"); ractS.toUpperCase();
-
-            String d1mvS = getTokValue(t, "DAC1MV");
-            String d2mvS = getTokValue(t, "DAC2MV");
-            String d1rS = getTokValue(t, "DAC1R");
-            String d2rS = getTokValue(t, "DAC2R");
-
-            String buzenS = getTokValue(t, "BUZEN");
-            String buzfS = getTokValue(t, "BUZFREQ");
-            String buzonS = getTokValue(t, "BUZON");
-            String buzoffS = getTokValue(t, "BUZOFF");
-            String buzrepS = getTokValue(t, "BUZREP");
-
-            // NEW Analog tokens
-            String aenS = getTokValue(t, "AEN");
-            String atyS = getTokValue(t, "ATYPE"); atyS.toUpperCase();
-            String achS = getTokValue(t, "ACH");
-            String aopS = getTokValue(t, "AOP"); aopS.toUpperCase();
-            String av1S = getTokValue(t, "AV1");
-            String av2S = getTokValue(t, "AV2");
-            String ahyS = getTokValue(t, "AHYS");
-            String adbS = getTokValue(t, "ADBMS");
-            String atolS = getTokValue(t, "ATOL");
-
-            if (enS.length()) s.enabled = (enS.toInt() != 0);
-
-            // modes
-            if (modeS == "DI") s.mode = S_MODE_DI;
-            else if (modeS == "RTC") s.mode = S_MODE_RTC;
-            else if (modeS == "DI_RTC") s.mode = S_MODE_COMBINED;
-            else if (modeS == "ANALOG") s.mode = S_MODE_ANALOG;
-            else if (modeS == "ANALOG_DI") s.mode = S_MODE_ANALOG_DI;
-            else if (modeS == "ANALOG_RTC") s.mode = S_MODE_ANALOG_RTC;
-            else if (modeS == "ANALOG_DI_RTC") s.mode = S_MODE_ANALOG_DI_RTC;
-
-            if (diS.length()) {
-                int di = diS.toInt();
-                if (di < 1) di = 1; if (di > 8) di = 8;
-                s.triggerDI = (uint8_t)di;
-            }
+static void tcpCmdDacv(const String& args) {
+    int sp1 = args.indexOf(' ');
+    if (sp1 < 0) { tcpSend("ERR DACV"); return; }
+    uint8_t ch = args.substring(0, sp1).toInt();
+    int mv = args.substring(sp1 + 1).toInt();
+    if (ch < 1 || ch > 2 || !g_dac.isInitialized()) { tcpSend("ERR DACV"); return; }
+    g_dac.setVoltage(ch - 1, mv / 1000.0f);
+    tcpSend("DACV OK");
+}
 
-            if (edgeS.length()) {
-                if (edgeS == "RISING") s.edge = EDGE_RISING;
-                else if (edgeS == "FALLING") s.edge = EDGE_FALLING;
-                else if (edgeS == "BOTH") s.edge = EDGE_BOTH;
-                else if (edgeS == "HIGH") s.edge = EDGE_HIGH;
-                else if (edgeS == "LOW") s.edge = EDGE_LOW;
-                else s.edge = EDGE_BOTH;
-            }
+static void tcpCmdBeep(const String& args) {
+    int sp1 = args.indexOf(' ');
+    if (sp1 < 0) { tcpSend("ERR BEEP"); return; }
+    uint16_t freq = (uint16_t)args.substring(0, sp1).toInt();
+    uint32_t ms = (uint32_t)args.substring(sp1 + 1).toInt();
+    g_rtc.simpleBeep(freq, ms);
+    tcpSend("BEEP OK");
+}
 
-            if (startS.length()) { uint16_t m; if (parseHHMM(startS, m)) s.startMin = m; }
-            if (endS.length()) { uint16_t m; if (parseHHMM(endS, m)) s.endMin = m; }
+static void tcpCmdBuzzOff(const String& args) {
+    buzzStop();
+    g_rtc.stopBeep();
+    tcpSend("BUZZOFF OK");
+}
 
-            if (recurS.length()) s.recurring = (recurS.toInt() != 0);
+static void tcpCmdRtcGet(const String& args) {
+    DateTime now = g_rtc.getDateTime(true);
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%04u-%02u-%02u %02u:%02u:%02u",
+        now.year(), now.month(), now.day(), now.hour(), now.minute(), now.second());
+    tcpSend(String("RTC ") + buf);
+}
 
-            if (daysS.length()) {
-                int dm = daysS.toInt();
-                if (dm < 0) dm = 0;
-                if (dm > 127) dm = 127;
-                s.daysMask = (uint8_t)dm;
-            }
+static void tcpCmdRtcSet(const String& args) {
+    if (g_rtc.setDateTimeFromString(args.c_str())) tcpSend("RTCSET OK");
+    else tcpSend("RTCSET ERR");
+}
 
-            if (rmaskS.length()) {
-                int rm = rmaskS.toInt();
-                if (rm < 0) rm = 0;
-                if (rm > 63) rm = 63;
-                s.relayMask = (uint8_t)rm;
-            }
+static void tcpCmdNetQuery(const String& args) {
+    IPAddress ip = g_eth.getIP();
+    bool link = g_eth.getLinkStatus();
+    tcpSend(String("NET IP=") + ipToString(ip) + " LINK=" + (link ? "UP" : "DOWN"));
+}
+
+static void tcpCmdBoardInfo(const String& args) {
+    hwInfoPrintBoardInfoTcp();
+}
+
+// ==================================================================
+// SCHED protocol (extended with analog trigger)
+// ==================================================================
+static void tcpCmdSched(const String& args) {
+    String sub = args; sub.trim();
+    int sp2 = sub.indexOf(' ');
+    String sop = (sp2 < 0) ? sub : sub.substring(0, sp2);
+    sop.toUpperCase();
+    String sargs = (sp2 < 0) ? "" : sub.substring(sp2 + 1);
+
+    auto parseInto = [&](ScheduleConfig& s, const String& t) {
+        String enS = getTokValue(t, "EN");
+        String modeS = getTokValue(t, "MODE"); modeS.toUpperCase();
+        String diS = getTokValue(t, "DI");
+        String edgeS = getTokValue(t, "EDGE"); edgeS.toUpperCase();
+        String startS = getTokValue(t, "START");
+        String endS = getTokValue(t, "END");
+        String recurS = getTokValue(t, "RECUR");
+        String daysS = getTokValue(t, "DAYS");
+
+        String rmaskS = getTokValue(t, "RELMASK");
+        String ractS = getTokValue(t, "RELACT"); ractS.toUpperCase();
+
+        String d1mvS = getTokValue(t, "DAC1MV");
+        String d2mvS = getTokValue(t, "DAC2MV");
+        String d1rS = getTokValue(t, "DAC1R");
+        String d2rS = getTokValue(t, "DAC2R");
+
+        String buzenS = getTokValue(t, "BUZEN");
+        String buzfS = getTokValue(t, "BUZFREQ");
+        String buzonS = getTokValue(t, "BUZON");
+        String buzoffS = getTokValue(t, "BUZOFF");
+        String buzrepS = getTokValue(t, "BUZREP");
+
+        // NEW Analog tokens
+        String aenS = getTokValue(t, "AEN");
+        String atyS = getTokValue(t, "ATYPE"); atyS.toUpperCase();
+        String achS = getTokValue(t, "ACH");
+        String aopS = getTokValue(t, "AOP"); aopS.toUpperCase();
+        String av1S = getTokValue(t, "AV1");
+        String av2S = getTokValue(t, "AV2");
+        String ahyS = getTokValue(t, "AHYS");
+        String adbS = getTokValue(t, "ADBMS");
+        String atolS = getTokValue(t, "ATOL");
+
+        if (enS.length()) s.enabled = (enS.toInt() != 0);
+
+        // modes
+        if (modeS == "DI") s.mode = S_MODE_DI;
+        else if (modeS == "RTC") s.mode = S_MODE_RTC;
+        else if (modeS == "DI_RTC") s.mode = S_MODE_COMBINED;
+        else if (modeS == "ANALOG") s.mode = S_MODE_ANALOG;
+        else if (modeS == "ANALOG_DI") s.mode = S_MODE_ANALOG_DI;
+        else if (modeS == "ANALOG_RTC") s.mode = S_MODE_ANALOG_RTC;
+        else if (modeS == "ANALOG_DI_RTC") s.mode = S_MODE_ANALOG_DI_RTC;
+
+        if (diS.length()) {
+            int di = diS.toInt();
+            if (di < 1) di = 1; if (di > 8) di = 8;
+            s.triggerDI = (uint8_t)di;
+        }
 
-            if (ractS.length()) {
-                if (ractS == "ON") s.relayAct = RELACT_ON;
-                else if (ractS == "OFF") s.relayAct = RELACT_OFF;
-                else s.relayAct = RELACT_TOGGLE;
-            }
+        if (edgeS.length()) {
+            if (edgeS == "RISING") s.edge = EDGE_RISING;
+            else if (edgeS == "FALLING") s.edge = EDGE_FALLING;
+            else if (edgeS == "BOTH") s.edge = EDGE_BOTH;
+            else if (edgeS == "HIGH") s.edge = EDGE_HIGH;
+            else if (edgeS == "LOW") s.edge = EDGE_LOW;
+            else s.edge = EDGE_BOTH;
+        }
 
-            if (d1mvS.length()) s.dac1mV = d1mvS.toInt();
-            if (d2mvS.length()) s.dac2mV = d2mvS.toInt();
-
-            if (d1rS.length()) { int r = d1rS.toInt(); s.dac1Range = (uint8_t)((r == 10) ? 10 : 5); }
-            if (d2rS.length()) { int r = d2rS.toInt(); s.dac2Range = (uint8_t)((r == 10) ? 10 : 5); }
-
-            if (buzenS.length()) s.buzEnable = (buzenS.toInt() != 0);
-            if (buzfS.length()) { int v = buzfS.toInt(); if (v <= 0) v = 2000; s.buzFreq = (uint16_t)v; }
-            if (buzonS.length()) { int v = buzonS.toInt(); if (v <= 0) v = 200;  s.buzOnMs = (uint16_t)v; }
-            if (buzoffS.length()) { int v = buzoffS.toInt(); if (v < 0) v = 0;  s.buzOffMs = (uint16_t)v; }
-            if (buzrepS.length()) { int v = buzrepS.toInt(); if (v <= 0) v = 1; if (v > 255) v = 255; s.buzRepeats = (uint8_t)v; }
-
-            // Analog
-            if (aenS.length()) s.a.enabled = (aenS.toInt() != 0);
-            if (atyS.length()) s.a.type = (atyS == "CURR" || atyS == "CURRENT") ? A_TYPE_CURR : A_TYPE_VOLT;
-            if (achS.length()) {
-                int c = achS.toInt();
-                if (c < 1) c = 1;
-                if (c > 2) c = 2;
-                s.a.ch = (uint8_t)c;
-            }
-            if (aopS.length()) {
-                if (aopS == "ABOVE") s.a.op = A_OP_ABOVE;
-                else if (aopS == "BELOW") s.a.op = A_OP_BELOW;
-                else if (aopS == "EQUAL") s.a.op = A_OP_EQUAL;
-                else s.a.op = A_OP_IN_RANGE;
-            }
-            if (av1S.length()) s.a.v1 = av1S.toInt();
-            if (av2S.length()) s.a.v2 = av2S.toInt();
-            if (ahyS.length()) s.a.hysteresis = ahyS.toInt();
-            if (adbS.length()) {
-                long db = adbS.toInt();
-                if (db < 10) db = 10;
-                if (db > 60000) db = 60000;
-                s.a.debounceMs = (uint16_t)db;
-            }
-            if (atolS.length()) s.a.tol = atolS.toInt();
+        if (startS.length()) { uint16_t m; if (parseHHMM(startS, m)) s.startMin = m; }
+        if (endS.length()) { uint16_t m; if (parseHHMM(endS, m)) s.endMin = m; }
 
-            // reset runtime flags
-            s.firedForWindow = false;
-            s.lastDiEdgeMs = 0;
-            s.a.condition = false;
-            s.a.pending = false;
-            s.a.pendingSinceMs = 0;
-        };
+        if (recurS.length()) s.recurring = (recurS.toInt() != 0);
 
-        if (sop == "LIST") {
-            tcpSend("SCHED LIST BEGIN");
-            for (uint8_t i = 0; i < g_schedCount; i++) {
-                const ScheduleConfig& s = g_scheds[i];
-                uint32_t id = i + 1;
-
-                String modeTxt =
-                    (s.mode == S_MODE_DI) ? "DI" :
-                    (s.mode == S_MODE_RTC) ? "RTC" :
-                    (s.mode == S_MODE_COMBINED) ? "DI_RTC" :
-                    (s.mode == S_MODE_ANALOG) ? "ANALOG" :
-                    (s.mode == S_MODE_ANALOG_DI) ? "ANALOG_DI" :
-                    (s.mode == S_MODE_ANALOG_RTC) ? "ANALOG_RTC" :
-                    "ANALOG_DI_RTC";
-
-                String l = "SCHED ITEM ";
-                l += "ID=" + String(id);
-                l += " EN=" + String(s.enabled ? 1 : 0);
-                l += " MODE=" + modeTxt;
-                l += " DAYS=" + String(s.daysMask);
-                l += " START=" + fmtHHMM(s.startMin);
-                l += " END=" + fmtHHMM(s.endMin);
-                l += " RECUR=" + String(s.recurring ? 1 : 0);
-                l += " DI=" + String(s.triggerDI);
-
-                String edgeTxt =
-                    (s.edge == EDGE_RISING) ? "RISING" :
-                    (s.edge == EDGE_FALLING) ? "FALLING" :
-                    (s.edge == EDGE_BOTH) ? "BOTH" :
-                    (s.edge == EDGE_HIGH) ? "HIGH" :
-                    "LOW";
-
-                l += " EDGE=" + edgeTxt;
-                l += " RELMASK=" + String(s.relayMask);
-                l += " RELACT=" + String(s.relayAct == RELACT_ON ? "ON" : (s.relayAct == RELACT_OFF ? "OFF" : "TOGGLE"));
-                l += " DAC1MV=" + String(s.dac1mV);
-                l += " DAC2MV=" + String(s.dac2mV);
-                l += " DAC1R=" + String(s.dac1Range);
-                l += " DAC2R=" + String(s.dac2Range);
-                l += " BUZEN=" + String(s.buzEnable ? 1 : 0);
-                l += " BUZFREQ=" + String(s.buzFreq);
-                l += " BUZON=" + String(s.buzOnMs);
-                l += " BUZOFF=" + String(s.buzOffMs);
-                l += " BUZREP=" + String(s.buzRepeats);
-
-                // analog extensions
-                l += " AEN=" + String(s.a.enabled ? 1 : 0);
-                l += " ATYPE=" + String(s.a.type == A_TYPE_CURR ? "CURR" : "VOLT");
-                l += " ACH=" + String(s.a.ch);
-                l += " AOP=" + String(
-                    (s.a.op == A_OP_ABOVE) ? "ABOVE" :
-                    (s.a.op == A_OP_BELOW) ? "BELOW" :
-                    (s.a.op == A_OP_EQUAL) ? "EQUAL" : "IN_RANGE"
-                );
-                l += " AV1=" + String(s.a.v1);
-                l += " AV2=" + String(s.a.v2);
-                l += " AHYS=" + String(s.a.hysteresis);
-                l += " ADBMS=" + String(s.a.debounceMs);
-                l += " ATOL=" + String(s.a.tol);
-
-                tcpSend(l);
-            }
-            tcpSend("SCHED LIST END");
-            return;
+        if (daysS.length()) {
+            int dm = daysS.toInt();
+            if (dm < 0) dm = 0;
+            if (dm > 127) dm = 127;
+            s.daysMask = (uint8_t)dm;
         }
 
-        if (sop == "CLEAR") {
-            schedResetAll();
-            tcpSend("SCHED OK CLEAR");
-            return;
+        if (rmaskS.length()) {
+            int rm = rmaskS.toInt();
+            if (rm < 0) rm = 0;
+            if (rm > 63) rm = 63;
+            s.relayMask = (uint8_t)rm;
         }
 
-        if (sop == "DEL") {
-            int id = getTokValue(sargs, "ID").toInt();
-            if (id <= 0 || id > g_schedCount) { tcpSend("ERR SCHED DEL"); return; }
-            uint8_t idx = (uint8_t)(id - 1);
-            schedDelete(idx);
-            tcpSend(String("SCHED OK DEL ID=") + String(id));
-            return;
+        if (ractS.length()) {
+            if (ractS == "ON") s.relayAct = RELACT_ON;
+            else if (ractS == "OFF") s.relayAct = RELACT_OFF;
+            else s.relayAct = RELACT_TOGGLE;
         }
 
-        if (sop == "DISABLE") {
-            int id = getTokValue(sargs, "ID").toInt();
-            if (id <= 0 || id > g_schedCount) { tcpSend("ERR SCHED DISABLE"); return; }
-            uint8_t idx = (uint8_t)(id - 1);
-            g_scheds[idx].enabled = false;
-            schedSaveOne(idx);
-            tcpSend(String("SCHED OK DISABLE ID=") + String(id));
-            return;
+        if (d1mvS.length()) s.dac1mV = d1mvS.toInt();
+        if (d2mvS.length()) s.dac2mV = d2mvS.toInt();
+
+        if (d1rS.length()) { int r = d1rS.toInt(); s.dac1Range = (uint8_t)((r == 10) ? 10 : 5); }
+        if (d2rS.length()) { int r = d2rS.toInt(); s.dac2Range = (uint8_t)((r == 10) ? 10 : 5); }
+
+        if (buzenS.length()) s.buzEnable = (buzenS.toInt() != 0);
+        if (buzfS.length()) { int v = buzfS.toInt(); if (v <= 0) v = 2000; s.buzFreq = (uint16_t)v; }
+        if (buzonS.length()) { int v = buzonS.toInt(); if (v <= 0) v = 200;  s.buzOnMs = (uint16_t)v; }
+        if (buzoffS.length()) { int v = buzoffS.toInt(); if (v < 0) v = 0;  s.buzOffMs = (uint16_t)v; }
+        if (buzrepS.length()) { int v = buzrepS.toInt(); if (v <= 0) v = 1; if (v > 255) v = 255; s.buzRepeats = (uint8_t)v; }
+
+        // Analog
+        if (aenS.length()) s.a.enabled = (aenS.toInt() != 0);
+        if (atyS.length()) s.a.type = (atyS == "CURR" || atyS == "CURRENT") ? A_TYPE_CURR : A_TYPE_VOLT;
+        if (achS.length()) {
+            int c = achS.toInt();
+            if (c < 1) c = 1;
+            if (c > 2) c = 2;
+            s.a.ch = (uint8_t)c;
+        }
+        if (aopS.length()) {
+            if (aopS == "ABOVE") s.a.op = A_OP_ABOVE;
+            else if (aopS == "BELOW") s.a.op = A_OP_BELOW;
+            else if (aopS == "EQUAL") s.a.op = A_OP_EQUAL;
+            else s.a.op = A_OP_IN_RANGE;
+        }
+        if (av1S.length()) s.a.v1 = av1S.toInt();
+        if (av2S.length()) s.a.v2 = av2S.toInt();
+        if (ahyS.length()) s.a.hysteresis = ahyS.toInt();
+        if (adbS.length()) {
+            long db = adbS.toInt();
+            if (db < 10) db = 10;
+            if (db > 60000) db = 60000;
+            s.a.debounceMs = (uint16_t)db;
+        }
+        if (atolS.length()) s.a.tol = atolS.toInt();
+
+        // reset runtime flags
+        s.firedForWindow = false;
+        s.lastDiEdgeMs = 0;
+        s.a.condition = false;
+        s.a.pending = false;
+        s.a.pendingSinceMs = 0;
+    };
+
+    if (sop == "LIST") {
+        tcpSend("SCHED LIST BEGIN");
+        for (uint8_t i = 0; i < g_schedCount; i++) {
+            const ScheduleConfig& s = g_scheds[i];
+            uint32_t id = i + 1;
+
+            String modeTxt =
+                (s.mode == S_MODE_DI) ? "DI" :
+                (s.mode == S_MODE_RTC) ? "RTC" :
+                (s.mode == S_MODE_COMBINED) ? "DI_RTC" :
+                (s.mode == S_MODE_ANALOG) ? "ANALOG" :
+                (s.mode == S_MODE_ANALOG_DI) ? "ANALOG_DI" :
+                (s.mode == S_MODE_ANALOG_RTC) ? "ANALOG_RTC" :
+                "ANALOG_DI_RTC";
+
+            String l = "SCHED ITEM ";
+            l += "ID=" + String(id);
+            l += " EN=" + String(s.enabled ? 1 : 0);
+            l += " MODE=" + modeTxt;
+            l += " DAYS=" + String(s.daysMask);
+            l += " START=" + fmtHHMM(s.startMin);
+            l += " END=" + fmtHHMM(s.endMin);
+            l += " RECUR=" + String(s.recurring ? 1 : 0);
+            l += " DI=" + String(s.triggerDI);
+
+            String edgeTxt =
+                (s.edge == EDGE_RISING) ? "RISING" :
+                (s.edge == EDGE_FALLING) ? "FALLING" :
+                (s.edge == EDGE_BOTH) ? "BOTH" :
+                (s.edge == EDGE_HIGH) ? "HIGH" :
+                "LOW";
+
+            l += " EDGE=" + edgeTxt;
+            l += " RELMASK=" + String(s.relayMask);
+            l += " RELACT=" + String(s.relayAct == RELACT_ON ? "ON" : (s.relayAct == RELACT_OFF ? "OFF" : "TOGGLE"));
+            l += " DAC1MV=" + String(s.dac1mV);
+            l += " DAC2MV=" + String(s.dac2mV);
+            l += " DAC1R=" + String(s.dac1Range);
+            l += " DAC2R=" + String(s.dac2Range);
+            l += " BUZEN=" + String(s.buzEnable ? 1 : 0);
+            l += " BUZFREQ=" + String(s.buzFreq);
+            l += " BUZON=" + String(s.buzOnMs);
+            l += " BUZOFF=" + String(s.buzOffMs);
+            l += " BUZREP=" + String(s.buzRepeats);
+
+            // analog extensions
+            l += " AEN=" + String(s.a.enabled ? 1 : 0);
+            l += " ATYPE=" + String(s.a.type == A_TYPE_CURR ? "CURR" : "VOLT");
+            l += " ACH=" + String(s.a.ch);
+            l += " AOP=" + String(
+                (s.a.op == A_OP_ABOVE) ? "ABOVE" :
+                (s.a.op == A_OP_BELOW) ? "BELOW" :
+                (s.a.op == A_OP_EQUAL) ? "EQUAL" : "IN_RANGE"
+            );
+            l += " AV1=" + String(s.a.v1);
+            l += " AV2=" + String(s.a.v2);
+            l += " AHYS=" + String(s.a.hysteresis);
+            l += " ADBMS=" + String(s.a.debounceMs);
+            l += " ATOL=" + String(s.a.tol);
+
+            tcpSend(l);
         }
+        tcpSend("SCHED LIST END");
+        return;
+    }
 
-        if (sop == "UPSERT") {
-            int id = getTokValue(sargs, "ID").toInt();
-            if (id < 0) id = 0;
-
-            if (id == 0) {
-                if (g_schedCount >= SCHED_MAX) { tcpSend("ERR SCHED FULL"); return; }
-                uint8_t idx = g_schedCount++;
-                g_scheds[idx] = ScheduleConfig();
-                parseInto(g_scheds[idx], sargs);
-                schedSaveMeta();
-                schedSaveOne(idx);
-                tcpSend(String("SCHED OK UPSERT ID=") + String(idx + 1));
-                return;
-            }
+    if (sop == "CLEAR") {
+        schedResetAll();
+        tcpSend("SCHED OK CLEAR");
+        return;
+    }
 
-            if (id > SCHED_MAX) { tcpSend("ERR SCHED ID"); return; }
-            uint8_t idx = (uint8_t)(id - 1);
+    if (sop == "DEL") {
+        int id = getTokValue(sargs, "ID").toInt();
+        if (id <= 0 || id > g_schedCount) { tcpSend("ERR SCHED DEL"); return; }
+        uint8_t idx = (uint8_t)(id - 1);
+        schedDelete(idx);
+        tcpSend(String("SCHED OK DEL ID=") + String(id));
+        return;
+    }
 
-            if (idx >= g_schedCount) {
-                while (g_schedCount <= idx && g_schedCount < SCHED_MAX) {
-                    g_scheds[g_schedCount] = ScheduleConfig();
-                    g_scheds[g_schedCount].enabled = false;
-                    g_schedCount++;
-                }
-            }
+    if (sop == "DISABLE") {
+        int id = getTokValue(sargs, "ID").toInt();
+        if (id <= 0 || id > g_schedCount) { tcpSend("ERR SCHED DISABLE"); return; }
+        uint8_t idx = (uint8_t)(id - 1);
+        g_scheds[idx].enabled = false;
+        schedSaveOne(idx);
+        tcpSend(String("SCHED OK DISABLE ID=") + String(id));
+        return;
+    }
 
+    if (sop == "UPSERT") {
+        int id = getTokValue(sargs, "ID").toInt();
+        if (id < 0) id = 0;
+
+        if (id == 0) {
+            if (g_schedCount >= SCHED_MAX) { tcpSend("ERR SCHED FULL"); return; }
+            uint8_t idx = g_schedCount++;
+            g_scheds[idx] = ScheduleConfig();
             parseInto(g_scheds[idx], sargs);
             schedSaveMeta();
             schedSaveOne(idx);
-            tcpSend(String("SCHED OK UPSERT ID=") + String(id));
+            tcpSend(String("SCHED OK UPSERT ID=") + String(idx + 1));
             return;
         }
 
-        tcpSend("ERR SCHED");
+        if (id > SCHED_MAX) { tcpSend("ERR SCHED ID"); return; }
+        uint8_t idx = (uint8_t)(id - 1);
+
+        if (idx >= g_schedCount) {
+            while (g_schedCount <= idx && g_schedCount < SCHED_MAX) {
+                g_scheds[g_schedCount] = ScheduleConfig();
+                g_scheds[g_schedCount].enabled = false;
+                g_schedCount++;
+            }
+        }
+
+        parseInto(g_scheds[idx], sargs);
+        schedSaveMeta();
+        schedSaveOne(idx);
+        tcpSend(String("SCHED OK UPSERT ID=") + String(id));
         return;
     }
 
-    tcpSend("ERR UNKNOWN");
+    tcpSend("ERR SCHED");
+}
+// Sorted by name (findConsoleCommand() binary-searches it)
+static const ConsoleCommand tcpCommands[] = {
+    { "BEEP", tcpCmdBeep },
+    { "BOARDINFO", tcpCmdBoardInfo },
+    { "BUZZOFF", tcpCmdBuzzOff },
+    { "DACV", tcpCmdDacv },
+    { "NET?", tcpCmdNetQuery },
+    { "NETCFG", tcpCmdNetcfg },
+    { "PING", tcpCmdPing },
+    { "REL", tcpCmdRel },
+    { "RTCGET", tcpCmdRtcGet },
+    { "RTCSET", tcpCmdRtcSet },
+    { "SCHED", tcpCmdSched },
+    { "SERIALNET", tcpCmdSerialNet },
+    { "SNAPJSON", tcpCmdSnapJson },
+    { "SNAPSHOT", tcpCmdSnapshot },
+};
+
+void handleTcpCommand(const String& line) {
+    String cmd = line;
+    cmd.trim();
+    if (cmd.length() == 0) return;
+
+    int sp = cmd.indexOf(' ');
+    String op = (sp < 0) ? cmd : cmd.substring(0, sp);
+    op.toUpperCase();
+    String args = (sp < 0) ? "" : cmd.substring(sp + 1);
+
+    const ConsoleCommand* c = findConsoleCommand(tcpCommands, sizeof(tcpCommands) / sizeof(tcpCommands[0]), op.c_str());
+    if (c) c->handler(args);
+    else tcpSend("ERR UNKNOWN");
 }
 
 // ======================================================================
@@ -2878,35 +2923,36 @@ void sendSnapshot(EthernetClient& c, bool json) {
 // SERIAL CONSOLE
 // ======================================================================
 void processSerial() {
-    while (Serial.available()) {
-        char c = Serial.read();
-        if (c == '\r' || c == '\n') { if (g_serialCmd.length()) g_serialCmdReady = true; }
-        else if (c == 0x08 || c == 0x7F) { if (g_serialCmd.length()) g_serialCmd.remove(g_serialCmd.length() - 1); }
-        else { if (g_serialCmd.length() < 200) g_serialCmd += c; }
-    }
-
-    if (g_serialCmdReady) {
-        String cmd = g_serialCmd;
-        cmd.trim();
-        if (cmd.length()) {
-            Serial.print(F("> "));
-            Serial.println(cmd);
-            execSerialCommand(cmd);
-        }
-        g_serialCmd = "";
-        g_serialCmdReady = false;
-    }
-}
+    while (g_serialLine.poll(Serial)) {
+        Serial.print(F("> "));
+        Serial.println(g_serialLine.line());
+        if (g_serialLine.overflowed()) Serial.println(F("ERR TOOLONG"));
+        else execSerialCommand(g_serialLine.line());
+    }
+}
+
+static void serialCmdHelp(const String&) { printHelp(); }
+static void serialCmdStatus(const String&) { printStatus(); }
+static void serialCmdNetDump(const String&) { netcfgSerialDump(); }
+static void serialCmdBoardInfo(const String&) { hwInfoPrintBoardInfoSerial(); }
+
+// Serial-only commands (whole line); sorted by name. Anything else goes to the TCP set.
+static const ConsoleCommand serialCommands[] = {
+    { "?", serialCmdHelp },
+    { "BOARDINFO", serialCmdBoardInfo },
+    { "HELP", serialCmdHelp },
+    { "NETDUMP", serialCmdNetDump },
+    { "SERIALNET", serialCmdNetDump },
+    { "STATUS", serialCmdStatus },
+};
 
 void execSerialCommand(const String& raw) {
     String line = raw; line.trim();
     if (!line.length()) return;
 
     String upper = line; upper.toUpperCase();
-    if (upper == "HELP" || upper == "?") { printHelp(); return; }
-    if (upper == "STATUS") { printStatus(); return; }
-    if (upper == "SERIALNET" || upper == "NETDUMP") { netcfgSerialDump(); return; }
-    if (upper == "BOARDINFO") { hwInfoPrintBoardInfoSerial(); return; }
+    const ConsoleCommand* c = findConsoleCommand(serialCommands, sizeof(serialCommands) / sizeof(serialCommands[0]), upper.c_str());
+    if (c) { c->handler(""); return; }
 
     handleTcpCommand(line);
 }
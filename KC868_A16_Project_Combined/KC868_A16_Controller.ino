@@ -5,7 +5,7 @@
 
     * KC868_A16_Controller.ino
     * Complete control system for Kincony KC868-A16 Smart Home Controller
-    * Using Renzo Mischianti's PCF8574 Library
+    * PCF8574 expanders driven directly through the I2C bus manager
 
    Features:
    - 16 relay outputs via PCF8574 I2C expanders
@@ -23,7 +23,6 @@
 #include <RCSwitch.h>
 #include <RTClib.h>
 #include <DNSServer.h>
-#include <PCF8574.h>  // Using Renzo Mischianti's library
 #include <esp_intr_alloc.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
@@ -33,6 +32,7 @@
 #define PCF8574_INPUTS_9_16   0x21
 #define PCF8574_OUTPUTS_1_8   0x24
 #define PCF8574_OUTPUTS_9_16  0x25
+#define RTC_I2C_ADDRESS       0x68    // DS3231
 #define SDA_PIN               4
 #define SCL_PIN               5
 #define HT1_PIN               32
@@ -42,6 +42,19 @@
 #define RF_TX_PIN             15
 #define RS485_TX_PIN          13
 #define RS485_RX_PIN          16
+
+// Binary RS485 frames (comm/RS485Frame.cpp)
+#define RS485_FRAME_SOF           0xA5
+#define RS485_FRAME_BROADCAST     0x00
+#define RS485_FRAME_MAX_PAYLOAD   32
+#define RS485_FRAME_TIMEOUT_MS    50      // inter-byte gap that abandons a frame
+#define RS485_OP_PING             0x01
+#define RS485_OP_READ_STATE       0x02
+#define RS485_OP_WRITE_OUTPUTS    0x03
+#define RS485_STATUS_OK           0x00
+#define RS485_STATUS_BAD_OPCODE   0x01
+#define RS485_STATUS_BAD_LENGTH   0x02
+#define RS485_STATUS_IO_ERROR     0x03
 #define ANALOG_PIN_1          36
 #define ANALOG_PIN_2          34
 #define ANALOG_PIN_3          35
@@ -68,6 +81,72 @@
 #define EEPROM_INTERRUPT_CONFIG_ADDR 3584
 #define MAX_SCHEDULES         30
 #define MAX_ANALOG_TRIGGERS   16
+#define TRIGGER_HYST_RAW      40    // default release band, raw ADC counts (~50 mV)
+#define TRIGGER_HYST_TEMP     0.5f  // default release band, deg C
+#define TRIGGER_HYST_HUMIDITY 2.0f  // default release band, % RH
+#define RF_MAX_CODES          32    // learned remote codes (NVS, see comm/RFManager.cpp)
+#define RF_HASH_SLOTS         64    // code lookup table, power of two > RF_MAX_CODES
+#define RF_REPEAT_MS          250   // same code within this gap is the same press
+#define RF_LEARN_TIMEOUT_MS   30000
+#define RF_TX_QUEUE_DEPTH     8
+#define RF_TX_REPEATS         8     // frames per transmitted code
+#define RF_TX_TASK_STACK      2048
+#define RF_TX_TASK_PRIORITY   3     // sleeps while the RMT sends, so it may sit above the loop
+#define RF_TX_TASK_CORE       1     // APP_CPU, with the loop that set up the RMT channel
+#define RF_VIRTUAL_INPUTS     8
+#define RF_ACTION_NONE          0
+#define RF_ACTION_TOGGLE_OUTPUT 1
+#define RF_ACTION_OUTPUT_ON     2
+#define RF_ACTION_OUTPUT_OFF    3
+#define RF_ACTION_RUN_SCHEDULE  4
+#define RF_ACTION_VIRTUAL_INPUT 5
+#define LOGIC_MAX_INSTR       128   // scan program length (NVS, see services/LogicEngine.cpp)
+#define LOGIC_BITS            64    // virtual bits M0-M63
+#define LOGIC_REGS            32    // virtual registers R0-R31 (int16)
+#define LOGIC_TIMERS          16
+#define LOGIC_COUNTERS        16
+#define LOGIC_STACK_DEPTH     8     // PUSH nesting
+#define LOGIC_SCAN_MS         50    // fixed scan period
+#define LOGIC_TIMER_UNIT_MS   100   // timer presets are in these units
+#define LOGIC_OP_END          0     // Scan program opcodes
+#define LOGIC_OP_LD           1
+#define LOGIC_OP_LDN          2
+#define LOGIC_OP_AND          3
+#define LOGIC_OP_ANDN         4
+#define LOGIC_OP_OR           5
+#define LOGIC_OP_ORN          6
+#define LOGIC_OP_NOT          7
+#define LOGIC_OP_PUSH         8
+#define LOGIC_OP_ANDB         9
+#define LOGIC_OP_ORB          10
+#define LOGIC_OP_ST           11
+#define LOGIC_OP_STN          12
+#define LOGIC_OP_SET          13
+#define LOGIC_OP_RST          14
+#define LOGIC_OP_TON          15
+#define LOGIC_OP_TOF          16
+#define LOGIC_OP_TP           17
+#define LOGIC_OP_CTU          18
+#define LOGIC_OP_CTR          19
+#define LOGIC_OP_GT           20
+#define LOGIC_OP_LT           21
+#define LOGIC_OP_EQ           22
+#define LOGIC_OP_MOV          23
+#define LOGIC_OP_ADD          24
+#define LOGIC_OP_CPY          25
+#define LOGIC_OP_RE           26
+#define LOGIC_OP_FE           27
+#define LOGIC_AREA_INPUT      0     // I0-I18 (inputs 1-16, HT1-HT3)
+#define LOGIC_AREA_OUTPUT     1     // Q0-Q15
+#define LOGIC_AREA_BIT        2     // M
+#define LOGIC_AREA_TIMER      3     // T: output / elapsed units
+#define LOGIC_AREA_COUNTER    4     // C: done / count
+#define LOGIC_AREA_REG        5     // R
+#define LOGIC_AREA_ANALOG     6     // A0-A3 raw
+#define LOGIC_AREA_RF         7     // V0-V7 RF virtual inputs
+#define LOGIC_AREA_SENSOR     8     // S0-S2 HT temperature x10, S3-S5 humidity x10
+#define CONFIG_BACKUP_MAGIC   0x4B43424BUL // 'KCBK'
+#define CONFIG_BACKUP_VERSION 1
 #define MAX_INTERRUPT_HANDLERS 16
 #define INPUT_PRIORITY_HIGH 1
 #define INPUT_PRIORITY_MEDIUM 2
@@ -82,6 +161,101 @@
 #define SENSOR_TYPE_DHT11    1  // DHT11 temperature/humidity sensor
 #define SENSOR_TYPE_DHT22    2  // DHT22/AM2302 temperature/humidity sensor
 #define SENSOR_TYPE_DS18B20  3  // DS18B20 temperature sensor
+#define WS_TOPIC_OUTPUTS     0x01  // WebSocket subscription topics
+#define WS_TOPIC_INPUTS      0x02
+#define WS_TOPIC_ANALOG      0x04
+#define WS_TOPIC_SENSORS     0x08
+#define WS_TOPIC_SYSTEM      0x10
+#define WS_TOPIC_ALL         0x1F
+#define WS_DEFAULT_MIN_INTERVAL_MS 100   // per-client update rate cap (10 Hz)
+#define WS_SLOW_SEND_MS      20    // a send slower than this marks the client congested
+#define WS_MAX_BACKOFF_MS    5000
+#define OUTPUT_PULSE_MAX_MS  3600000UL   // longest timed pulse accepted by /api/outputs
+#define OUTPUT_PRIORITY_LEVELS 16        // per-output command slots, 1 = highest (as BACnet)
+#define OUTPUT_PRIO_INTERLOCK  1         // master enable off
+#define OUTPUT_PRIO_LOGIC      7         // running logic program, outputs it writes
+#define OUTPUT_PRIO_MANUAL     8         // default: web, WebSocket, console, RS485
+#define OUTPUT_PRIO_MODBUS     10        // default: Modbus coils
+#define OUTPUT_PRIO_AUTOMATION 12        // default: schedules, analog triggers, RF remotes
+#define OUTPUT_PRIO_BACNET     16        // default: BACnet writes without a priority
+#define OUTPUT_JOURNAL_SIZE    64        // output changes kept for /api/outputs/priority
+#define OUTPUT_RETRY_MS        1000      // expander rewrite interval after an I2C error
+#define OUTPUT_SRC_WEB         0         // command sources (journal, priority slots)
+#define OUTPUT_SRC_WEBSOCKET   1
+#define OUTPUT_SRC_CONSOLE     2
+#define OUTPUT_SRC_RS485       3
+#define OUTPUT_SRC_MODBUS      4
+#define OUTPUT_SRC_BACNET      5
+#define OUTPUT_SRC_SCHEDULE    6
+#define OUTPUT_SRC_TRIGGER     7
+#define OUTPUT_SRC_RF          8
+#define OUTPUT_SRC_LOGIC       9
+#define OUTPUT_SRC_PULSE       10
+#define OUTPUT_SRC_INTERLOCK   11
+#define OUTPUT_SRC_COUNT       12
+#define SSE_REPLAY_EVENTS    32      // events kept for Last-Event-ID resume
+#define SSE_EVENT_DATA_LEN   96
+#define SSE_KEEPALIVE_MS     15000
+#define SSE_RETRY_MS         2000    // client reconnect delay sent in "retry:"
+#define SSE_SENSOR_DEADBAND  0.1f    // temperature/humidity change worth an event
+#define OTA_TARGET_APP       0
+#define OTA_TARGET_FS        1
+#define OTA_STATE_IDLE       0
+#define OTA_STATE_RECEIVING  1
+#define OTA_STATE_READY      2
+#define OTA_STATE_ERROR      3
+#define OTA_SECTOR_SIZE      4096
+#define OTA_APP_IMAGE_MAGIC  0xE9    // first byte of an ESP32 app image
+#define OTA_MAX_TRIAL_BOOTS  3       // restarts allowed before a new image is rolled back
+#define OTA_CONFIRM_MS       60000   // uptime after which a new image is kept
+#define METRIC_I2C_INPUTS_1_8   0
+#define METRIC_I2C_INPUTS_9_16  1
+#define METRIC_I2C_OUTPUTS_9_16 2
+#define METRIC_I2C_OUTPUTS_1_8  3
+#define I2C_CLOCK_SLOW       50000   // start-up rate and floor (the old fixed rate)
+#define I2C_CLOCK_STANDARD   100000
+#define I2C_CLOCK_FAST       400000
+#define I2C_TIMEOUT_MS       10      // Wire transaction timeout; bounds clock stretching
+#define I2C_CLEAN_WINDOW     2000    // error-free transactions before the clock steps up
+#define I2C_SLOW_DOWN_ERRORS 3       // errors within a window that step it down
+#define I2C_SPEED_HOLD_MS    600000UL // no step up for this long after a step down
+#define I2C_BACKOFF_MS       1000    // low-priority traffic refused after a failed bus clear
+#define I2C_MAX_DEVICES      8       // addresses with their own counters
+#define I2C_PRIO_HIGH        0       // expander I/O, scans: waits for the bus
+#define I2C_PRIO_LOW         1       // RTC reads: skipped while busy or backing off
+#define I2C_INPUT_CACHE_MS   10      // input expander read shared by the input pollers
+#define RTC_READ_INTERVAL_MS 1000    // DS3231 read at most this often, millis() in between
+#define TIME_VALID_EPOCH     1600000000UL // unix time below this has not been set
+#define TIME_INVALID         0       // timestampNow() when neither clock knows the time
+#define UPLINK_NONE          0
+#define UPLINK_ETH           1
+#define UPLINK_WIFI          2
+#define UPLINK_AP            3
+#ifndef NET_WIFI_STANDBY
+#define NET_WIFI_STANDBY     1       // keep WiFi STA associated while Ethernet is the uplink
+#endif
+#define EVENT_PARTITION_LABEL "events"  // data partition holding the event journal (partitions.csv)
+#define EVENT_SECTOR_SIZE    4096
+#define EVENT_MAX_SECTORS    64      // sectors used (and index entries kept); 256 KB
+#define EVENT_QUEUE_DEPTH    32      // records waiting for the writer task
+#define EVENT_TASK_STACK     3072
+#define EVENT_TASK_PRIORITY  1
+#define EVENT_TASK_CORE      0
+#define EVENT_QUERY_MAX      200     // records returned by one /api/journal request
+#define EVENT_MODBUS_FILE_EVENTS 1250 // records per Modbus file (10000 registers / 8)
+#define EVENT_BOOT           1       // arg: esp_reset_reason()
+#define EVENT_OUTPUT         2       // subject: output 0-15, value: state, source: OUTPUT_SRC_*, arg: priority
+#define EVENT_TIME_SET       3       // clock set from a client; time is already the new time
+#define EVENT_CONFIG         4       // arg: sections restored from a backup
+#define EVENT_OTA            5       // subject: OTA_TARGET_*
+#define EVENT_LOGIC          6       // value: running, arg: program steps
+#define STATE_BUS_DEPTH      16      // events queued from other tasks for the main loop
+#define STATE_EVENT_ETH      1       // code: arduino_event_id_t, arg: millis() when posted
+#define STATE_EVENT_WIFI     2       // code: arduino_event_id_t, arg: millis() when posted
+#define HEAP_SAMPLE_MS       5000
+#define HEAP_MAX_TASKS       4       // tasks whose stack high-water mark is tracked
+#define ALLOC_TRACE_SITES    64      // call sites counted by the KC868_ALLOC_TRACE tracer
+#define ALLOC_TRACE_REPORT   16      // busiest sites listed by /api/debug/heap
 #define FIRMWARE_VERSION firmwareVersion
 
 // -----------------------------------------------------------------------------
@@ -12,17 +12,95 @@
 void appSetup();
 void appLoop();
 
+void initI2CBus();
+bool i2cWrite(uint8_t address, const uint8_t* data, size_t len, uint8_t priority);
+bool i2cRead(uint8_t address, uint8_t* data, size_t len, uint8_t priority);
+bool i2cProbe(uint8_t address);
+bool i2cBeginDevice(uint8_t priority);
+void i2cEndDevice(uint8_t address, bool ok);
+uint8_t i2cDeviceCount();
+const I2CDeviceStats* i2cDeviceStats(uint8_t index);
+const I2CBusStats& i2cBusStats();
 void initI2C();
 void initWiFi();
 void initEthernet();
 void printMacSummary();
 void serviceEthernetDhcp();
 void initRTC();
+bool readRtc(DateTime& out);
+uint32_t timestampNow();
 void setupWebServer();
 void handleWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
-void broadcastUpdate();
+void broadcastUpdate(uint8_t topics = WS_TOPIC_ALL);
+void serviceWebSocketClients();
+void handleEventStream();
+void publishStateEvents(uint8_t topics);
+void publishScheduleEvent(int scheduleIndex);
+void serviceEventStream();
+void scheduleRestart(uint32_t delayMs);
+bool otaBegin(uint8_t target, uint32_t size, const String& sha256Hex);
+bool otaWrite(uint32_t offset, const uint8_t* data, size_t len);
+bool otaFinish();
+void otaAbort();
+uint32_t otaReceived();
+String otaLastError();
+void otaStatusJson(JsonDocument& doc);
+void otaBootCheck();
+void serviceOta();
+void registerMonitoredTask(const char* name, TaskHandle_t handle);
+void initEventLog();
+bool logEvent(uint8_t type, uint8_t source, uint8_t subject, uint8_t value, uint16_t arg);
+bool eventLogAvailable();
+bool eventLogRange(uint32_t& oldest, uint32_t& newest);
+bool readEvent(uint32_t seq, EventRecord& out);
+uint32_t findEventSeq(uint32_t since);
+const char* eventTypeName(uint8_t type);
+uint16_t eventLogSectors();
+const EventLogStats& eventLogStats();
+void sampleHeap();
+void serviceHeapMonitor();
+void heapStatsJson(JsonObject obj);
+void allocTraceJson(JsonObject obj);
+void handleOtaStatus();
+void handleOtaBegin();
+void handleOtaChunk();
+void handleOtaChunkUpload();
+void handleOtaFinish();
+void handleOtaAbort();
 void initRS485();
 void initRF();
+void serviceRf();
+int findRfCode(uint32_t code);
+void saveRfCodes();
+void startRfLearn(const RfCode& settings);
+bool rfLearning();
+bool queueRfTransmit(uint32_t code, uint8_t bits, uint8_t protocol);
+bool queueLearnedRfCode(uint8_t index);
+const RfStats& rfStats();
+uint8_t rfVirtualInputs();
+bool rfLastReceived(uint32_t& code, uint8_t& bits, uint8_t& protocol, uint32_t& ageMs);
+void handleGetRf();
+void handleSetRf();
+void initLogic();
+void serviceLogic();
+bool validateLogicProgram(const LogicInstr* prog, uint8_t count, String& error);
+bool installLogicProgram(const LogicInstr* prog, uint8_t count, String& error);
+void saveLogicProgram();
+bool assembleLogicLine(const String& line, LogicInstr& out, String& error);
+String disassembleLogic(const LogicInstr& in);
+bool logicRunning();
+void setLogicRunning(bool run);
+uint8_t logicProgramLength();
+const LogicInstr* logicProgram();
+bool logicBit(uint8_t index);
+void setLogicBit(uint8_t index, bool value);
+int16_t logicReg(uint8_t index);
+void setLogicReg(uint8_t index, int16_t value);
+bool logicTimerOutput(uint8_t index);
+int16_t logicCounterValue(uint8_t index);
+const LogicStats& logicStats();
+void handleGetLogic();
+void handleSetLogic();
 void saveConfiguration();
 void loadConfiguration();
 void saveWiFiCredentials(String ssid, String password);
@@ -32,11 +110,40 @@ void loadCommunicationSettings();
 void saveCommunicationConfig();
 void loadCommunicationConfig();
 bool readInputs();
+bool readInputBank(uint8_t bank, uint8_t& bits);
 bool writeOutputs();
+bool writeOutputBank(uint8_t bank);
+void initOutputs();
+bool commandOutputs(uint8_t source, uint8_t priority, uint16_t mask, uint16_t value);
+void relinquishOutputs(uint8_t priority, uint16_t mask);
+void commandOutputAction(uint8_t source, uint16_t mask, uint8_t action);
+bool flushOutputs();
+void serviceOutputs();
+bool outputSlot(uint8_t output, uint8_t priority, bool& value, uint8_t& source);
+uint8_t outputActivePriority(uint8_t output);
+const char* outputSourceName(uint8_t source);
+uint8_t outputSourcePriority(uint8_t source);
+bool setOutputSourcePriority(uint8_t source, uint8_t priority);
+void resetOutputSourcePriorities();
+void saveOutputSourcePriorities();
+bool outputJournalEntry(uint32_t age, OutputChange& out);
+uint32_t outputJournalCount();
+const OutputStats& outputStats();
+uint16_t getOutputMask();
+uint16_t getPendingPulseMask();
+bool applyOutputs(uint8_t source, uint16_t mask, uint16_t value);
+bool applyOutputsOnce(uint8_t source, uint16_t mask, uint16_t value);
+void scheduleOutputPulse(uint8_t relay, uint32_t durationMs, uint8_t priority);
 void handleWebRoot();
 void handleNotFound();
 void handleFileUpload();
+void handleFileUploadDone();
 void handleRelayControl();
+void handleGetOutputs();
+void handleSetOutputs();
+void handleGetOutputPriority();
+void handleSetOutputPriority();
+void handleGetJournal();
 void handleSystemStatus();
 void handleSchedules();
 void handleUpdateSchedule();
@@ -45,6 +152,8 @@ void handleUpdateConfig();
 void handleAnalogTriggers();
 void handleUpdateAnalogTriggers();
 void handleDebug();
+void handleMetrics();
+void handleHeapDebug();
 void handleDebugCommand();
 void handleReboot();
 void handleCommunicationStatus();
@@ -54,11 +163,32 @@ void handleUpdateCommunicationConfig();
 void handleGetTime();
 void handleSetTime();
 void handleI2CScan();
+void handleGetI2CStats();
 void checkSchedules();
 void checkAnalogTriggers();
+bool analogTriggerActive(int index);
+void checkSensorSchedules();
+bool sensorScheduleActive(int index);
+bool thresholdLevel(bool wasOn, float value, float threshold, uint8_t condition, float tolerance, float hysteresis);
+bool updateThresholdState(ThresholdState& st, bool condition, uint16_t minOnSec, uint16_t minOffSec);
 void processRS485Commands();
+bool rs485FrameFeed(uint8_t b);
 void processSerialCommands();
 void WiFiEvent(WiFiEvent_t event);
+void applyWiFiEvent(arduino_event_id_t event, uint32_t atMs);
+void serviceWiFiReconnect();
+void onEthEvent(arduino_event_id_t event);
+void applyEthEvent(arduino_event_id_t event, uint32_t atMs);
+void startWiFiStandby();
+void updateUplink();
+uint8_t activeUplink();
+const char* uplinkName(uint8_t uplink);
+const NetFailoverStats& failoverStats();
+void initStateBus();
+bool postStateEvent(uint8_t type, uint16_t code, uint32_t arg = 0);
+void serviceStateBus();
+uint32_t stateBusPosted();
+uint32_t stateBusDropped();
 void EthEvent(WiFiEvent_t event);
 void debugPrintln(String message);
 void syncTimeFromNTP();
@@ -101,6 +231,15 @@ void checkInputBasedSchedules();
 
 void initializeDefaultConfig();
 void saveSchedulesToEEPROM();
+void beginConfigBatch();
+void endConfigBatch();
+size_t getPrefsRecords(Preferences& prefs, const char* key, void* dst, size_t recordSize, size_t maxRecords);
+size_t configBackupSize(bool includeSecrets);
+void configBackupWrite(Print& out, bool includeSecrets);
+uint8_t configBackupSectionMask(const String& names);
+bool configRestore(const uint8_t* data, size_t len, uint8_t sectionMask, bool& restartRequired, String& error);
+void handleBackup();
+void handleRestore();
 void initializeSensor(uint8_t htIndex);
 void readSensor(uint8_t htIndex);
 void saveHTSensorConfig();
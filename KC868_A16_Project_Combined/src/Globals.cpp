@@ -7,17 +7,11 @@ const char* default_password = "12345678";
 const char* ap_ssid = "KC868-A16";      // AP SSID
 const char* ap_password = "admin";      // AP Password
 
-// Create PCF8574 objects using the Mischianti library
-PCF8574 inputIC1(PCF8574_INPUTS_1_8);    // Digital Inputs 1-8
-PCF8574 inputIC2(PCF8574_INPUTS_9_16);   // Digital Inputs 9-16
-PCF8574 outputIC3(PCF8574_OUTPUTS_9_16); // Digital Outputs 9-16
-PCF8574 outputIC4(PCF8574_OUTPUTS_1_8);  // Digital Outputs 1-8
-
 // DNS server
 DNSServer dnsServer;
 
 // Web server port
-WebServer server(80);
+HttpServer server(80);
 
 // WebSocket server
 WebSocketsServer webSocket = WebSocketsServer(81);
@@ -34,7 +28,6 @@ HardwareSerial rs485(2);
 
 // RF receiver/transmitter
 RCSwitch rfReceiver = RCSwitch();
-RCSwitch rfTransmitter = RCSwitch();
 
 // RTC object
 RTC_DS3231 rtc;
@@ -153,6 +146,12 @@ String wifiApMacConfig = WIFI_AP_MAC;
 // DHCP or static IP mode
 bool dhcpMode = true;
 
+// BACnet/IP foreign-device registration (disabled until a BBMD is configured)
+bool bacnetFdEnabled = false;
+IPAddress bacnetBbmdIp(0, 0, 0, 0);
+uint16_t bacnetBbmdPort = 47808;
+uint16_t bacnetFdTtl = 300;
+
 // File upload
 File fsUploadFile;
 
@@ -168,9 +167,11 @@ HTSensorConfig htSensorConfig[3] = {
 
 TimeSchedule schedules[MAX_SCHEDULES];
 AnalogTrigger analogTriggers[MAX_ANALOG_TRIGGERS];
+RfCode rfCodes[RF_MAX_CODES];
 
 // Diagnostics
 unsigned long i2cErrorCount = 0;
+SystemMetrics metrics = {};
 unsigned long lastSystemUptime = 0;
 String lastErrorMessage = "";
 
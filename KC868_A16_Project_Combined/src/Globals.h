@@ -6,6 +6,8 @@
  */
 
 #include "Types.h"
+#include "web/HttpServer.h"
+#include "web/JsonPool.h"
 
 // Default WiFi credentials (can be changed via web interface)
 extern const char* default_ssid;
@@ -13,17 +15,11 @@ extern const char* default_password;
 extern const char* ap_ssid;
 extern const char* ap_password;
 
-// I2C expanders
-extern PCF8574 inputIC1;
-extern PCF8574 inputIC2;
-extern PCF8574 outputIC3;
-extern PCF8574 outputIC4;
-
 // DNS server
 extern DNSServer dnsServer;
 
 // Web server + WebSocket server
-extern WebServer server;
+extern HttpServer server;
 extern WebSocketsServer webSocket;
 extern bool webSocketClients[WEBSOCKETS_SERVER_CLIENT_MAX];
 
@@ -36,7 +32,6 @@ extern HardwareSerial rs485;
 
 // RF receiver/transmitter
 extern RCSwitch rfReceiver;
-extern RCSwitch rfTransmitter;
 
 // RTC object
 extern RTC_DS3231 rtc;
@@ -165,6 +160,12 @@ extern String wifiApMacConfig;
 // DHCP or static IP mode
 extern bool dhcpMode;
 
+// BACnet/IP foreign-device registration (BBMD on another subnet)
+extern bool bacnetFdEnabled;
+extern IPAddress bacnetBbmdIp;
+extern uint16_t bacnetBbmdPort;
+extern uint16_t bacnetFdTtl;
+
 // File upload
 extern File fsUploadFile;
 
@@ -175,8 +176,11 @@ extern bool restartRequired;
 extern HTSensorConfig htSensorConfig[3];
 extern TimeSchedule schedules[MAX_SCHEDULES];
 extern AnalogTrigger analogTriggers[MAX_ANALOG_TRIGGERS];
+extern RfCode rfCodes[RF_MAX_CODES];
 
 // Diagnostics
 extern unsigned long i2cErrorCount;
+extern SystemMetrics metrics;
+extern HeapStats heapStats;
 extern unsigned long lastSystemUptime;
 extern String lastErrorMessage;
@@ -34,8 +34,8 @@ struct TimeSchedule {
     uint16_t inputStates; // Required state for each input (0=LOW, 1=HIGH)
     uint8_t logic;        // 0=AND (all conditions must be met), 1=OR (any condition can trigger)
     uint8_t action;       // 0=OFF, 1=ON, 2=TOGGLE
-    uint8_t targetType;   // 0=Output, 1=Multiple outputs
-    uint16_t targetId;    // Output number (0-15) or bitmask for multiple outputs
+    uint8_t targetType;   // 0=Output, 1=Multiple outputs, 2=Send learned RF code
+    uint16_t targetId;    // Output number (0-15), bitmask for multiple outputs or RF code slot
     uint16_t targetIdLow; // Additional target for LOW state (when input is FALSE)
     char name[32];        // Name/description of the schedule
 
@@ -44,6 +44,155 @@ struct TimeSchedule {
     uint8_t sensorTriggerType; // 0=Temperature, 1=Humidity
     uint8_t sensorCondition;   // 0=Above, 1=Below, 2=Equal
     float sensorThreshold;     // Temperature or humidity threshold value
+
+    // Sensor trigger hysteresis (see services/ThresholdTrigger.cpp)
+    float sensorHysteresis;    // Release band past the threshold (0 = default)
+    uint16_t minOnSec;         // Shortest time active before it may release
+    uint16_t minOffSec;        // Shortest time released before it may fire again
+};
+
+// Counters behind /metrics (monotonic unless noted)
+struct SystemMetrics {
+    uint32_t i2cErrors[4];          // METRIC_I2C_* expander index
+    uint32_t inputEdges[19];        // inputs 1-16, HT1-HT3
+    uint32_t modbusRequests[17];    // by function code (0 = other)
+    uint32_t modbusSuccess;
+    uint32_t rs485Frames;           // binary frames addressed to this board
+    uint32_t rs485FrameErrors;      // CRC / length / timeout
+    uint32_t triggerEdges;          // analog trigger / sensor schedule state changes
+    uint32_t wsMessagesSent;
+    uint64_t wsBytesSent;
+    uint32_t loopCount;
+    uint32_t loopLastUs;            // gauge: last loop period
+    uint32_t loopMaxUs;             // gauge: longest loop period since boot
+    uint64_t loopTotalUs;
+};
+
+// Uplink changes made by the connectivity manager (see comm/NetworkManager.cpp)
+struct NetFailoverStats {
+    uint32_t count;
+    uint32_t lastMs;                // uplink lost -> services re-bound on the next one
+    uint32_t maxMs;
+};
+
+// Learned 433 MHz remote code (see comm/RFManager.cpp)
+struct RfCode {
+    uint32_t code;                  // 0 = free slot
+    uint8_t bits;
+    uint8_t protocol;               // RCSwitch protocol number
+    uint8_t action;                 // RF_ACTION_*
+    uint8_t target;                 // output 0-15, schedule index or virtual input
+    char name[24];
+};
+
+struct RfStats {
+    uint32_t received;              // presses (first frame of a burst)
+    uint32_t repeats;               // repeat frames suppressed
+    uint32_t unknown;               // presses with no learned code
+    uint32_t transmitted;           // codes queued for sending
+    uint32_t txDropped;             // transmit queue full
+    uint32_t txFailed;              // RMT write failed or timed out
+};
+
+// One scan program step (see services/LogicEngine.cpp)
+struct LogicInstr {
+    uint8_t op;                     // LOGIC_OP_*
+    uint8_t area;                   // LOGIC_AREA_* of the operand
+    uint8_t index;                  // operand within the area
+    uint8_t reserved;
+    int16_t arg;                    // preset, constant, or CPY source (area << 8 | index)
+};
+
+// Scan cycle timing
+struct LogicStats {
+    uint32_t scans;
+    uint32_t lastUs;                // duration of the last scan
+    uint32_t maxUs;
+    uint32_t lateMaxMs;             // worst start delay past the scan tick
+    uint32_t overruns;              // ticks missed entirely (loop blocked > LOGIC_SCAN_MS)
+};
+
+// Output arbitration (see services/OutputManager.cpp)
+struct OutputChange {
+    uint32_t ms;
+    uint8_t output;
+    uint8_t state;
+    uint8_t priority;               // winning slot, 0 = relinquish default (off)
+    uint8_t source;                 // OUTPUT_SRC_* of that slot, 0xFF for the default
+};
+
+struct OutputStats {
+    uint32_t commands;              // slot writes and relinquishes
+    uint32_t changes;               // output transitions
+    uint32_t writes;                // expander transactions
+    uint32_t writeErrors;
+};
+
+// Event journal record, 16 bytes as stored in flash (see services/EventLog.cpp)
+struct EventRecord {
+    uint32_t seq;                   // 0xFFFFFFFF = erased slot
+    uint32_t time;                  // unix seconds when logged, TIME_INVALID = unknown
+    uint8_t type;                   // EVENT_*
+    uint8_t source;                 // OUTPUT_SRC_*, 0xFF = none
+    uint8_t subject;
+    uint8_t value;
+    uint16_t arg;
+    uint16_t crc;                   // CRC-16/MODBUS over the bytes before it
+};
+
+struct EventLogStats {
+    uint32_t logged;                // records written to flash
+    uint32_t dropped;               // queue full
+    uint32_t writeErrors;
+    uint32_t sectorsErased;
+    uint32_t maxEraseCount;         // most-worn sector
+};
+
+// Per-address I2C counters (see hal/I2CBus.cpp)
+struct I2CDeviceStats {
+    uint8_t address;
+    uint8_t lastError;              // Wire status of the last failure (2/3 NACK, 4 bus, 5 timeout)
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t lastUs;
+    uint32_t maxUs;
+    uint64_t totalUs;
+};
+
+struct I2CBusStats {
+    uint32_t clockHz;
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t recoveries;            // bus clears
+    uint32_t recoveryFailures;      // a line still held low afterwards
+    uint32_t clockChanges;
+    uint32_t deferred;              // low-priority transactions refused
+};
+
+// Posted from other tasks, applied by the main loop (see core/StateBus.cpp)
+struct StateEvent {
+    uint8_t type;                   // STATE_EVENT_*
+    uint16_t code;
+    uint32_t arg;
+};
+
+struct MonitoredTask {
+    const char* name;
+    TaskHandle_t handle;
+    uint32_t stackFree;             // bytes never touched so far
+    uint32_t stackFreeMin;          // lowest value sampled
+};
+
+// Heap / stack samples taken every HEAP_SAMPLE_MS (see core/HeapMonitor.cpp)
+struct HeapStats {
+    uint32_t freeBytes;
+    uint32_t minFreeBytes;          // lowest free heap since boot (allocator watermark)
+    uint32_t largestBlock;          // largest single allocation currently possible
+    uint32_t largestBlockMin;       // lowest sampled largest block
+    uint8_t fragmentationPct;       // 100 - largest block / free heap
+    uint32_t samples;
+    uint8_t taskCount;
+    MonitoredTask tasks[HEAP_MAX_TASKS];
 };
 
 struct AnalogTrigger {
@@ -67,4 +216,17 @@ struct AnalogTrigger {
     uint8_t sensorTriggerType; // 0=Temperature, 1=Humidity
     uint8_t sensorCondition;   // 0=Above, 1=Below, 2=Equal
     float sensorThreshold;     // Temperature or humidity threshold value
+
+    // Hysteresis (see services/ThresholdTrigger.cpp)
+    uint16_t hysteresis;       // Release band in raw counts (0 = default)
+    float sensorHysteresis;    // Release band for HT sensor triggers (0 = default)
+    uint16_t minOnSec;         // Shortest time active before it may release
+    uint16_t minOffSec;        // Shortest time released before it may fire again
+};
+
+// Run-time state of one threshold trigger
+struct ThresholdState {
+    bool level;                 // comparator output, with hysteresis
+    bool active;                // level after the dwell times; actions fire on its edges
+    uint32_t changedMs;         // last change of active (0 = never)
 };
@@ -2,6 +2,7 @@
 #include "BACnetDriver.h"
 #include <WiFi.h>
 #include <string.h>
+#include <time.h>
 #include "../Globals.h"
 #include "../FunctionPrototypes.h"
 
@@ -14,8 +15,16 @@ static inline uint16_t u16be(uint8_t hi, uint8_t lo) { return ((uint16_t)hi << 8
 BACnetDriver::BACnetDriver()
     : _initialized(false),
       _deviceID(BACNET_DEVICE_ID),
-      _lastIAmMs(0) {
-
+      _lastIAmMs(0),
+      _fdEnabled(false),
+      _fdRegistered(false),
+      _fdAwaitingResult(false),
+      _bbmdPort(BACNET_UDP_PORT),
+      _fdTtl(BACNET_FD_DEFAULT_TTL_S),
+      _lastFdRegisterMs(0),
+      _fdRefreshMs(0) {
+
+    memset(&_stats, 0, sizeof(_stats));
     memset(_deviceName, 0, sizeof(_deviceName));
     memset(_deviceDescription, 0, sizeof(_deviceDescription));
     memset(_deviceLocation, 0, sizeof(_deviceLocation));
@@ -28,6 +37,12 @@ BACnetDriver::BACnetDriver()
     for (uint8_t i = 0; i < BACNET_MAX_BO; i++) {
         _boCmdPending[i] = false;
         _boCmdValue[i] = false;
+        _boCmdPriority[i] = 0;
+        _boCmdRelinquish[i] = false;
+    }
+    for (uint8_t i = 0; i < BACNET_MAX_BV; i++) {
+        _bvCmdPending[i] = false;
+        _bvCmdValue[i] = false;
     }
 
     // Initialize AI Main (A1..A4)
@@ -95,6 +110,30 @@ BACnetDriver::BACnetDriver()
         _bo[i].outOfService = false;
         _bo[i].lastUpdateMs = 0;
     }
+
+    // Initialize BV (logic engine bits M0..M15)
+    for (uint8_t i = 0; i < BACNET_MAX_BV; i++) {
+        _bv[i].instance = (uint32_t)(i + 1);
+        _bv[i].type = OBJECT_BINARY_VALUE;
+        snprintf(_bv[i].name, sizeof(_bv[i].name), "Logic Bit M%u", (unsigned)i);
+        strncpy(_bv[i].description, "Logic engine virtual bit", sizeof(_bv[i].description) - 1);
+        _bv[i].presentValue = 0.0f;
+        _bv[i].units = UNITS_NO_UNITS;
+        _bv[i].outOfService = false;
+        _bv[i].lastUpdateMs = 0;
+    }
+
+    // Initialize AV (logic engine registers R0..R7)
+    for (uint8_t i = 0; i < BACNET_MAX_AV; i++) {
+        _av[i].instance = (uint32_t)(i + 1);
+        _av[i].type = OBJECT_ANALOG_VALUE;
+        snprintf(_av[i].name, sizeof(_av[i].name), "Logic Register R%u", (unsigned)i);
+        strncpy(_av[i].description, "Logic engine register", sizeof(_av[i].description) - 1);
+        _av[i].presentValue = 0.0f;
+        _av[i].units = UNITS_NO_UNITS;
+        _av[i].outOfService = false;
+        _av[i].lastUpdateMs = 0;
+    }
 }
 
 BACnetDriver::~BACnetDriver() {
@@ -121,6 +160,12 @@ bool BACnetDriver::begin(IPAddress localIP, IPAddress gateway, IPAddress subnet)
     _initialized = true;
     _lastIAmMs = 0;
 
+    // Register with the BBMD first so the initial I-Am can be distributed
+    _fdRegistered = false;
+    if (_fdEnabled) {
+        sendRegisterForeignDevice();
+    }
+
     // Announce once quickly (broadcast)
     sendIAmBroadcast();
     _lastIAmMs = millis();
@@ -134,6 +179,8 @@ void BACnetDriver::end() {
     }
     _udp.stop();
     _initialized = false;
+    _fdRegistered = false;
+    _fdAwaitingResult = false;
     Serial.println("[BACnet] Stopped");
 }
 
@@ -142,9 +189,11 @@ void BACnetDriver::task() {
 
     processIncomingPacket();
 
-    // Periodic broadcast I-Am (every 15 seconds)
     const uint32_t now = millis();
-    if ((now - _lastIAmMs) > 15000UL) {
+    serviceForeignDevice(now);
+
+    // Periodic broadcast I-Am (slow keep-alive, see BACNET_IAM_INTERVAL_MS)
+    if ((now - _lastIAmMs) > BACNET_IAM_INTERVAL_MS) {
         sendIAmBroadcast();
         _lastIAmMs = now;
     }
@@ -170,23 +219,69 @@ void BACnetDriver::setLocation(const char* loc) {
     strncpy(_deviceLocation, loc, sizeof(_deviceLocation) - 1);
 }
 
+void BACnetDriver::setForeignDevice(IPAddress bbmdIP, uint16_t bbmdPort, uint16_t ttlSeconds) {
+    _bbmdIP = bbmdIP;
+    _bbmdPort = bbmdPort ? bbmdPort : BACNET_UDP_PORT;
+    _fdTtl = (ttlSeconds < BACNET_FD_MIN_TTL_S) ? BACNET_FD_MIN_TTL_S : ttlSeconds;
+    _fdEnabled = ((uint32_t)bbmdIP != 0);
+    _fdRegistered = false;
+
+    if (!_fdEnabled) {
+        // Entry on the BBMD simply expires after TTL + 30 s grace
+        Serial.println("[BACnet] Foreign-device registration disabled");
+        return;
+    }
+
+    Serial.printf("[BACnet] Foreign device -> BBMD %s:%u (TTL %us)\n",
+                  _bbmdIP.toString().c_str(), (unsigned)_bbmdPort, (unsigned)_fdTtl);
+
+    if (_initialized) {
+        sendRegisterForeignDevice();
+    }
+}
+
+IPAddress BACnetDriver::getBroadcastAddress() const {
+    const uint32_t ipRaw = (uint32_t)_localIP;
+    uint32_t maskRaw = (uint32_t)_subnet;
+    if (maskRaw == 0) {
+        // No mask known: fall back to the classic /24 assumption
+        maskRaw = (uint32_t)IPAddress(255, 255, 255, 0);
+    }
+    return IPAddress(ipRaw | ~maskRaw);
+}
+
 // -------------------- Hardware -> BACnet --------------------
 void BACnetDriver::updateAnalogInput(uint8_t channel, float volts) {
     if (channel >= BACNET_MAX_AI_MAIN) return;
     _aiMain[channel].presentValue = volts;
     _aiMain[channel].lastUpdateMs = millis();
+    bacnetTrendLogs.sample(OBJECT_ANALOG_INPUT, _aiMain[channel].instance, volts, _aiMain[channel].lastUpdateMs);
 }
 
 void BACnetDriver::updateBinaryInput(uint8_t channel, bool active) {
     if (channel >= BACNET_MAX_BI) return;
     _bi[channel].presentValue = active ? 1.0f : 0.0f;
     _bi[channel].lastUpdateMs = millis();
+    bacnetTrendLogs.sample(OBJECT_BINARY_INPUT, _bi[channel].instance, _bi[channel].presentValue, _bi[channel].lastUpdateMs);
 }
 
 void BACnetDriver::updateBinaryOutput(uint8_t channel, bool active) {
     if (channel >= BACNET_MAX_BO) return;
     _bo[channel].presentValue = active ? 1.0f : 0.0f;
     _bo[channel].lastUpdateMs = millis();
+    bacnetTrendLogs.sample(OBJECT_BINARY_OUTPUT, _bo[channel].instance, _bo[channel].presentValue, _bo[channel].lastUpdateMs);
+}
+
+void BACnetDriver::updateBinaryValue(uint8_t channel, bool active) {
+    if (channel >= BACNET_MAX_BV) return;
+    _bv[channel].presentValue = active ? 1.0f : 0.0f;
+    _bv[channel].lastUpdateMs = millis();
+}
+
+void BACnetDriver::updateAnalogValue(uint8_t channel, float value) {
+    if (channel >= BACNET_MAX_AV) return;
+    _av[channel].presentValue = value;
+    _av[channel].lastUpdateMs = millis();
 }
 
 void BACnetDriver::updateSensorAnalog(uint16_t instance, float value, uint16_t units, const char* desc) {
@@ -198,21 +293,33 @@ void BACnetDriver::updateSensorAnalog(uint16_t instance, float value, uint16_t u
                 strncpy(_aiSensors[i].description, desc, sizeof(_aiSensors[i].description) - 1);
             }
             _aiSensors[i].lastUpdateMs = millis();
+            bacnetTrendLogs.sample(OBJECT_ANALOG_INPUT, instance, value, _aiSensors[i].lastUpdateMs);
             return;
         }
     }
 }
 
 // -------------------- BACnet -> Hardware Commands --------------------
-bool BACnetDriver::getBinaryOutputCommand(uint8_t channel, bool& active) {
+bool BACnetDriver::getBinaryOutputCommand(uint8_t channel, bool& active, uint8_t& priority, bool& relinquish) {
     if (channel >= BACNET_MAX_BO) return false;
     if (!_boCmdPending[channel]) return false;
 
     active = _boCmdValue[channel];
+    priority = _boCmdPriority[channel];
+    relinquish = _boCmdRelinquish[channel];
     _boCmdPending[channel] = false; // consume
     return true;
 }
 
+bool BACnetDriver::getBinaryValueCommand(uint8_t channel, bool& active) {
+    if (channel >= BACNET_MAX_BV) return false;
+    if (!_bvCmdPending[channel]) return false;
+
+    active = _bvCmdValue[channel];
+    _bvCmdPending[channel] = false; // consume
+    return true;
+}
+
 // -------------------- Packet Processing --------------------
 void BACnetDriver::processIncomingPacket() {
     const int packetSize = _udp.parsePacket();
@@ -222,62 +329,115 @@ void BACnetDriver::processIncomingPacket() {
     uint16_t remotePort = (uint16_t)_udp.remotePort();
 
     const int len = _udp.read(_rxBuffer, BACNET_RX_BUFFER_SIZE);
-    if (len < 8) return;
+    if (len <= 0) return;
 
-    // BVLL
-    if (_rxBuffer[0] != BVLL_TYPE_BACNET_IP) return;
+    processPacket(_rxBuffer, (uint16_t)len, remoteIP, remotePort);
+}
+
+void BACnetDriver::processPacket(const uint8_t* data, uint16_t dataLen, IPAddress remoteIP, uint16_t remotePort) {
+    const uint32_t t0 = micros();
+    _stats.rxPackets++;
+
+    if (!data || dataLen == 0) return;
+    if (dataLen > BACNET_RX_BUFFER_SIZE) {
+        _stats.rxMalformed++;
+        return;
+    }
+    if (data != _rxBuffer) {
+        memcpy(_rxBuffer, data, dataLen);
+    }
+
+    if (dispatchPacket(dataLen, remoteIP, remotePort)) {
+        const uint32_t dt = micros() - t0;
+        _stats.lastServiceUs = dt;
+        _stats.totalServiceUs += dt;
+        if (dt > _stats.maxServiceUs) _stats.maxServiceUs = dt;
+    } else {
+        _stats.rxMalformed++;
+    }
+}
+
+// Returns false for malformed/unsupported frames (dropped without reply)
+bool BACnetDriver::dispatchPacket(uint16_t len, IPAddress remoteIP, uint16_t remotePort) {
+    // BVLL header (4) + minimal NPDU (2)
+    if (len < 6) return false;
+    if (_rxBuffer[0] != BVLL_TYPE_BACNET_IP) return false;
 
     const uint8_t bvllFunc = _rxBuffer[1];
     const uint16_t bvllLen = u16be(_rxBuffer[2], _rxBuffer[3]);
-    if (bvllLen < 8 || bvllLen > (uint16_t)len) {
-        // Use actual length if header is inconsistent
-        // (some stacks may send larger UDP packet than bvll length)
+    if (bvllLen < 4 || bvllLen > len) return false;
+
+    // Ignore trailing bytes past the BVLL length (some stacks pad the datagram)
+    len = bvllLen;
+
+    uint16_t offset = 4;
+
+    if (bvllFunc == BVLL_FUNC_RESULT) {
+        handleBvllResult(&_rxBuffer[offset], len - offset, remoteIP, remotePort);
+        return true;
     }
 
-    if (bvllFunc != BVLL_FUNC_ORIGINAL_UNICAST_NPDU &&
-        bvllFunc != BVLL_FUNC_ORIGINAL_BROADCAST_NPDU) {
-        return;
+    if (bvllFunc == BVLL_FUNC_FORWARDED_NPDU) {
+        // BBMD re-broadcast of a remote device's broadcast. The 6-byte
+        // original source B/IP address follows the header; confirmed
+        // replies (e.g. I-Am for Who-Is) must go there, not to the BBMD.
+        if (len < 4 + 6 + 2) return false;
+        remoteIP = IPAddress(_rxBuffer[4], _rxBuffer[5], _rxBuffer[6], _rxBuffer[7]);
+        remotePort = u16be(_rxBuffer[8], _rxBuffer[9]);
+        offset += 6;
+    } else if (bvllFunc != BVLL_FUNC_ORIGINAL_UNICAST_NPDU &&
+               bvllFunc != BVLL_FUNC_ORIGINAL_BROADCAST_NPDU) {
+        return false;
     }
 
     // NPDU
-    uint16_t offset = 4;
-    if (_rxBuffer[offset++] != 0x01) return; // BACnet Protocol Version
+    if (offset + 2 > len) return false;
+    if (_rxBuffer[offset++] != 0x01) return false; // BACnet Protocol Version
 
-    uint8_t npduCtrl = _rxBuffer[offset++];
+    const uint8_t npduCtrl = _rxBuffer[offset++];
 
     // Skip destination address if present
     if (npduCtrl & 0x20) {
-        if (offset + 3 > (uint16_t)len) return;
+        if (offset + 3 > len) return false;
         offset += 2; // DNET
-        uint8_t dlen = _rxBuffer[offset++];
+        const uint8_t dlen = _rxBuffer[offset++];
+        if (offset + dlen + 1 > len) return false;
         offset += dlen; // DADR
-        if (offset + 1 > (uint16_t)len) return;
-        offset += 1; // hop count
+        offset += 1;    // hop count
     }
 
     // Skip source address if present
     if (npduCtrl & 0x08) {
-        if (offset + 3 > (uint16_t)len) return;
+        if (offset + 3 > len) return false;
         offset += 2; // SNET
-        uint8_t slen = _rxBuffer[offset++];
+        const uint8_t slen = _rxBuffer[offset++];
+        if (offset + slen > len) return false;
         offset += slen; // SADR
     }
 
-    if (offset >= (uint16_t)len) return;
+    // Network layer messages carry no APDU
+    if (npduCtrl & 0x80) return true;
+
+    if (offset >= len) return false;
 
     // APDU
-    uint8_t pduType = (_rxBuffer[offset] & 0xF0);
+    const uint8_t pduType = (_rxBuffer[offset] & 0xF0);
     if (pduType == PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST) {
-        if (offset + 1 >= (uint16_t)len) return;
-        uint8_t serviceChoice = _rxBuffer[offset + 1];
+        if (offset + 1 >= len) return false;
+        const uint8_t serviceChoice = _rxBuffer[offset + 1];
         if (serviceChoice == SERVICE_UNCONFIRMED_WHO_IS) {
+            _stats.whoIs++;
             handleWhoIs(remoteIP, remotePort);
         }
-        return;
+        return true;
     }
 
     if (pduType == PDU_TYPE_CONFIRMED_SERVICE_REQUEST) {
-        if (offset + 3 >= (uint16_t)len) return;
+        if (offset + 3 >= len) return false;
+
+        // Segmented requests carry two extra header octets; we never
+        // advertise segmentation, so anything segmented is dropped.
+        if (_rxBuffer[offset] & 0x08) return false;
 
         // Confirmed request header:
         // [0] PDU Type/flags
@@ -287,18 +447,40 @@ void BACnetDriver::processIncomingPacket() {
         const uint8_t invokeId = _rxBuffer[offset + 2];
         const uint8_t serviceChoice = _rxBuffer[offset + 3];
 
+        // Max APDU the client accepts (lower nibble, ASHRAE 135 20.1.2.5)
+        static const uint16_t kMaxApdu[6] = { 50, 128, 206, 480, 1024, 1476 };
+        const uint8_t apduCode = _rxBuffer[offset + 1] & 0x0F;
+        const uint16_t clientMaxApdu = (apduCode < 6) ? kMaxApdu[apduCode] : 480;
+
         uint8_t* svcData = &_rxBuffer[offset + 4];
-        uint16_t svcLen  = (uint16_t)len - (offset + 4);
+        const uint16_t svcLen = len - (offset + 4);
 
         if (serviceChoice == SERVICE_CONFIRMED_READ_PROPERTY) {
+            _stats.readProperty++;
             handleReadProperty(invokeId, svcData, svcLen, remoteIP, remotePort);
         } else if (serviceChoice == SERVICE_CONFIRMED_WRITE_PROPERTY) {
+            _stats.writeProperty++;
             handleWriteProperty(invokeId, svcData, svcLen, remoteIP, remotePort);
+        } else if (serviceChoice == SERVICE_CONFIRMED_READ_RANGE) {
+            _stats.readRange++;
+            handleReadRange(invokeId, clientMaxApdu, svcData, svcLen, remoteIP, remotePort);
         } else {
             // Service not supported
+            _stats.unsupported++;
             sendError(invokeId, serviceChoice, 2 /*services*/, 9 /*service request denied*/, remoteIP, remotePort);
         }
+        return true;
     }
+
+    // Acks/errors/aborts addressed to us: nothing outstanding, ignore
+    return true;
+}
+
+void BACnetDriver::sendPacket(uint16_t len, IPAddress remoteIP, uint16_t remotePort) {
+    _stats.txPackets++;
+    _udp.beginPacket(remoteIP, remotePort);
+    _udp.write(_txBuffer, len);
+    _udp.endPacket();
 }
 
 void BACnetDriver::handleWhoIs(IPAddress remoteIP, uint16_t remotePort) {
@@ -525,7 +707,7 @@ void BACnetDriver::handleReadProperty(uint8_t invokeId, uint8_t* pdu, uint16_t p
             {
                 // Return list of supported objects (application tag: Object ID repeated)
                 // Format: [ObjectID] [ObjectID] ...
-                // Device + AI main + AI sensors + BI + BO
+                // Device + AI main + AI sensors + BI + BO + BV + AV
                 // Device
                 _txBuffer[tx++] = 0xC4;
                 tx += encodeObjectId(&_txBuffer[tx], OBJECT_DEVICE, _deviceID);
@@ -550,6 +732,22 @@ void BACnetDriver::handleReadProperty(uint8_t invokeId, uint8_t* pdu, uint16_t p
                     _txBuffer[tx++] = 0xC4;
                     tx += encodeObjectId(&_txBuffer[tx], OBJECT_BINARY_OUTPUT, _bo[i].instance);
                 }
+                // BV / AV (logic engine)
+                for (uint8_t i = 0; i < BACNET_MAX_BV; i++) {
+                    _txBuffer[tx++] = 0xC4;
+                    tx += encodeObjectId(&_txBuffer[tx], OBJECT_BINARY_VALUE, _bv[i].instance);
+                }
+                for (uint8_t i = 0; i < BACNET_MAX_AV; i++) {
+                    _txBuffer[tx++] = 0xC4;
+                    tx += encodeObjectId(&_txBuffer[tx], OBJECT_ANALOG_VALUE, _av[i].instance);
+                }
+                // Trend Logs
+                for (uint8_t i = 0; i < bacnetTrendLogs.count(); i++) {
+                    BACnetTrendLog* log = bacnetTrendLogs.at(i);
+                    if (!log) continue;
+                    _txBuffer[tx++] = 0xC4;
+                    tx += encodeObjectId(&_txBuffer[tx], OBJECT_TREND_LOG, log->instance);
+                }
 
                 encoded = true;
                 break;
@@ -558,6 +756,11 @@ void BACnetDriver::handleReadProperty(uint8_t invokeId, uint8_t* pdu, uint16_t p
             default:
                 break;
         }
+    } else if (objectType == OBJECT_TREND_LOG) {
+        BACnetTrendLog* log = bacnetTrendLogs.find(instance);
+        if (log) {
+            encoded = encodeTrendLogProperty(log, propertyId, tx);
+        }
     } else {
         // Normal object
         BACnetObject* obj = findObject(objectType, instance);
@@ -585,16 +788,17 @@ void BACnetDriver::handleReadProperty(uint8_t invokeId, uint8_t* pdu, uint16_t p
                     break;
 
                 case PROP_PRESENT_VALUE:
-                    if (objectType == OBJECT_ANALOG_INPUT) {
+                    if (objectType == OBJECT_ANALOG_INPUT || objectType == OBJECT_ANALOG_VALUE) {
                         tx += encodeAppReal(&_txBuffer[tx], obj->presentValue);
-                    } else if (objectType == OBJECT_BINARY_INPUT || objectType == OBJECT_BINARY_OUTPUT) {
+                    } else if (objectType == OBJECT_BINARY_INPUT || objectType == OBJECT_BINARY_OUTPUT ||
+                               objectType == OBJECT_BINARY_VALUE) {
                         tx += encodeAppEnumerated(&_txBuffer[tx], (obj->presentValue > 0.5f) ? 1 : 0);
                     }
                     encoded = true;
                     break;
 
                 case PROP_UNITS:
-                    if (objectType == OBJECT_ANALOG_INPUT) {
+                    if (objectType == OBJECT_ANALOG_INPUT || objectType == OBJECT_ANALOG_VALUE) {
                         tx += encodeAppEnumerated(&_txBuffer[tx], obj->units);
                         encoded = true;
                     }
@@ -605,6 +809,29 @@ void BACnetDriver::handleReadProperty(uint8_t invokeId, uint8_t* pdu, uint16_t p
                     encoded = true;
                     break;
 
+                case PROP_PRIORITY_ARRAY:
+                    // All 16 slots; NULL where relinquished
+                    if (objectType == OBJECT_BINARY_OUTPUT) {
+                        for (uint8_t p = 1; p <= 16; p++) {
+                            bool value;
+                            uint8_t source;
+                            if (outputSlot((uint8_t)(instance - 1), p, value, source)) {
+                                tx += encodeAppEnumerated(&_txBuffer[tx], value ? 1 : 0);
+                            } else {
+                                _txBuffer[tx++] = 0x00;
+                            }
+                        }
+                        encoded = true;
+                    }
+                    break;
+
+                case PROP_RELINQUISH_DEFAULT:
+                    if (objectType == OBJECT_BINARY_OUTPUT) {
+                        tx += encodeAppEnumerated(&_txBuffer[tx], 0 /*inactive*/);
+                        encoded = true;
+                    }
+                    break;
+
                 default:
                     break;
             }
@@ -625,13 +852,11 @@ void BACnetDriver::handleReadProperty(uint8_t invokeId, uint8_t* pdu, uint16_t p
     _txBuffer[3] = (uint8_t)(tx & 0xFF);
 
     // Send response
-    _udp.beginPacket(remoteIP, remotePort);
-    _udp.write(_txBuffer, tx);
-    _udp.endPacket();
+    sendPacket(tx, remoteIP, remotePort);
 }
 
 void BACnetDriver::handleWriteProperty(uint8_t invokeId, uint8_t* pdu, uint16_t pduLen, IPAddress remoteIP, uint16_t remotePort) {
-    // Support: BO Present_Value only
+    // Support: BO / BV Present_Value only
     if (pduLen < 9) {
         sendError(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, 5, 1, remoteIP, remotePort);
         return;
@@ -712,16 +937,69 @@ void BACnetDriver::handleWriteProperty(uint8_t invokeId, uint8_t* pdu, uint16_t
         return;
     }
 
-    // Value: accept Enumerated (active/inactive) or Boolean
+    // Value: accept Enumerated (active/inactive) or Boolean; NULL relinquishes a BO slot
     bool newValue = false;
+    bool relinquish = false;
     uint16_t valConsumed = 0;
-    if (!decodeAnyValueToBool(&pdu[offset], pduLen - offset, newValue, valConsumed)) {
+    if (objectType == OBJECT_BINARY_OUTPUT && pdu[offset] == 0x00) {
+        relinquish = true;
+        valConsumed = 1;
+    } else if (!decodeAnyValueToBool(&pdu[offset], pduLen - offset, newValue, valConsumed)) {
         sendError(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, 2, 2, remoteIP, remotePort);
         return;
     }
     offset += valConsumed;
 
-    // Expect closing tag3 (0x3F) somewhere later; ignore strict.
+    // Closing tag3, then the optional priority (context tag 4)
+    uint32_t priority = 0;
+    if (offset < pduLen && pdu[offset] == 0x3F) {
+        offset++;
+        uint16_t c4 = 0;
+        if (offset < pduLen && decodeContextUnsigned(4, &pdu[offset], pduLen - offset, priority, c4)) {
+            offset += c4;
+            if (priority < 1 || priority > 16) {
+                sendError(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, 2 /*property*/, 37 /*value out of range*/, remoteIP, remotePort);
+                return;
+            }
+        }
+    }
+
+    // Trend Log: Enable on/off, Record_Count = 0 clears the buffer
+    if (objectType == OBJECT_TREND_LOG) {
+        BACnetTrendLog* log = bacnetTrendLogs.find(instance);
+        if (!log) {
+            sendError(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, 1 /*object*/, 31 /*unknown object*/, remoteIP, remotePort);
+            return;
+        }
+        if (propertyId == PROP_ENABLE) {
+            log->enabled = newValue;
+        } else if (propertyId == PROP_RECORD_COUNT && !newValue) {
+            bacnetTrendLogs.clear(log);
+        } else {
+            sendError(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, 2 /*property*/, 40 /*write access denied*/, remoteIP, remotePort);
+            return;
+        }
+        Serial.printf("[BACnet] WriteProperty TL%lu prop %lu = %u\n", (unsigned long)instance, (unsigned long)propertyId, (unsigned)newValue);
+        sendSimpleAck(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, remoteIP, remotePort);
+        return;
+    }
+
+    // Logic bits: picked up by BACnetIntegration on its next sync
+    if (objectType == OBJECT_BINARY_VALUE && propertyId == PROP_PRESENT_VALUE) {
+        if (instance < 1 || instance > BACNET_MAX_BV) {
+            sendError(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, 8, 42 /*unknown object*/, remoteIP, remotePort);
+            return;
+        }
+        const uint8_t ch = (uint8_t)(instance - 1);
+        _bvCmdValue[ch] = newValue;
+        _bvCmdPending[ch] = true;
+        _bv[ch].presentValue = newValue ? 1.0f : 0.0f;
+        _bv[ch].lastUpdateMs = millis();
+
+        Serial.printf("[BACnet] WriteProperty BV%u Present_Value = %u\n", (unsigned)instance, (unsigned)newValue);
+        sendSimpleAck(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, remoteIP, remotePort);
+        return;
+    }
 
     // Validate object and property
     if (objectType != OBJECT_BINARY_OUTPUT || propertyId != PROP_PRESENT_VALUE) {
@@ -738,18 +1016,343 @@ void BACnetDriver::handleWriteProperty(uint8_t invokeId, uint8_t* pdu, uint16_t
 
     // Store command pending (do NOT get overwritten by status sync)
     _boCmdValue[ch] = newValue;
+    _boCmdPriority[ch] = (uint8_t)priority;
+    _boCmdRelinquish[ch] = relinquish;
     _boCmdPending[ch] = true;
 
-    // Also update BO present value immediately for reads
-    _bo[ch].presentValue = newValue ? 1.0f : 0.0f;
-    _bo[ch].lastUpdateMs = millis();
-
-    Serial.printf("[BACnet] WriteProperty BO%u Present_Value = %u\n", (unsigned)instance, (unsigned)newValue);
+    Serial.printf("[BACnet] WriteProperty BO%u Present_Value = %s @%u\n", (unsigned)instance,
+                  relinquish ? "NULL" : (newValue ? "1" : "0"), (unsigned)priority);
 
     // ACK
     sendSimpleAck(invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY, remoteIP, remotePort);
 }
 
+// -------------------- Trend Log --------------------
+bool BACnetDriver::encodeTrendLogProperty(BACnetTrendLog* log, uint32_t propertyId, uint16_t& tx) {
+    switch (propertyId) {
+        case PROP_OBJECT_IDENTIFIER:
+            _txBuffer[tx++] = 0xC4;
+            tx += encodeObjectId(&_txBuffer[tx], OBJECT_TREND_LOG, log->instance);
+            return true;
+
+        case PROP_OBJECT_NAME:
+            tx += encodeAppCharacterString(&_txBuffer[tx], log->name);
+            return true;
+
+        case PROP_OBJECT_TYPE:
+            tx += encodeAppEnumerated(&_txBuffer[tx], OBJECT_TREND_LOG);
+            return true;
+
+        case PROP_ENABLE:
+            tx += encodeAppBoolean(&_txBuffer[tx], log->enabled);
+            return true;
+
+        case PROP_LOG_INTERVAL:
+            // Hundredths of a second; 0 for COV logs
+            tx += encodeAppUnsigned(&_txBuffer[tx],
+                                    (log->loggingType == TRENDLOG_LOGGING_POLLED) ? (log->logIntervalMs / 10UL) : 0);
+            return true;
+
+        case PROP_LOGGING_TYPE:
+            tx += encodeAppEnumerated(&_txBuffer[tx], log->loggingType);
+            return true;
+
+        case PROP_BUFFER_SIZE:
+            tx += encodeAppUnsigned(&_txBuffer[tx], log->capacity);
+            return true;
+
+        case PROP_RECORD_COUNT:
+            tx += encodeAppUnsigned(&_txBuffer[tx], log->count);
+            return true;
+
+        case PROP_TOTAL_RECORD_COUNT:
+            tx += encodeAppUnsigned(&_txBuffer[tx], log->totalCount);
+            return true;
+
+        case PROP_STOP_WHEN_FULL:
+            tx += encodeAppBoolean(&_txBuffer[tx], false); // ring buffer
+            return true;
+
+        case PROP_STATUS_FLAGS:
+            // Bit string, 4 bits used, all clear
+            _txBuffer[tx++] = 0x82;
+            _txBuffer[tx++] = 0x04;
+            _txBuffer[tx++] = 0x00;
+            return true;
+
+        case PROP_EVENT_STATE:
+            tx += encodeAppEnumerated(&_txBuffer[tx], 0 /*normal*/);
+            return true;
+
+        case PROP_LOG_DEVICE_OBJECT_PROPERTY:
+            // BACnetDeviceObjectPropertyReference { [0] object, [1] property }
+            _txBuffer[tx++] = 0x0C;
+            tx += encodeObjectId(&_txBuffer[tx], log->monitoredType, log->monitoredInstance);
+            _txBuffer[tx++] = 0x19;
+            _txBuffer[tx++] = PROP_PRESENT_VALUE;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+uint16_t BACnetDriver::encodeLogRecord(uint8_t* buffer, const TrendLogRecord& rec, bool binary) {
+    uint16_t idx = 0;
+
+    time_t t = (time_t)rec.timestamp;
+    struct tm lt;
+    localtime_r(&t, &lt);
+    const bool known = rec.timestamp != TRENDLOG_TIME_INVALID;
+
+    // timestamp [0] BACnetDateTime; all fields unspecified (0xFF) when unknown
+    buffer[idx++] = 0x0E;
+    buffer[idx++] = 0xA4; // Date
+    buffer[idx++] = known ? (uint8_t)lt.tm_year : 0xFF;
+    buffer[idx++] = known ? (uint8_t)(lt.tm_mon + 1) : 0xFF;
+    buffer[idx++] = known ? (uint8_t)lt.tm_mday : 0xFF;
+    buffer[idx++] = known ? (uint8_t)((lt.tm_wday == 0) ? 7 : lt.tm_wday) : 0xFF; // 1 = Monday
+    buffer[idx++] = 0xB4; // Time
+    buffer[idx++] = known ? (uint8_t)lt.tm_hour : 0xFF;
+    buffer[idx++] = known ? (uint8_t)lt.tm_min : 0xFF;
+    buffer[idx++] = known ? (uint8_t)lt.tm_sec : 0xFF;
+    buffer[idx++] = known ? 0 : 0xFF;
+    buffer[idx++] = 0x0F;
+
+    // logDatum [1]
+    buffer[idx++] = 0x1E;
+    if (binary) {
+        buffer[idx++] = 0x39; // [3] enumerated, len 1
+        buffer[idx++] = (rec.value > 0.5f) ? 1 : 0;
+    } else {
+        buffer[idx++] = 0x2C; // [2] real, len 4
+        uint32_t raw;
+        memcpy(&raw, &rec.value, sizeof(raw));
+        buffer[idx++] = (uint8_t)((raw >> 24) & 0xFF);
+        buffer[idx++] = (uint8_t)((raw >> 16) & 0xFF);
+        buffer[idx++] = (uint8_t)((raw >> 8) & 0xFF);
+        buffer[idx++] = (uint8_t)(raw & 0xFF);
+    }
+    buffer[idx++] = 0x1F;
+
+    return idx;
+}
+
+void BACnetDriver::handleReadRange(uint8_t invokeId, uint16_t maxApdu, uint8_t* pdu, uint16_t pduLen, IPAddress remoteIP, uint16_t remotePort) {
+    // Service parameters:
+    // [0] object id, [1] property id, [2] array index (opt),
+    // range: [3] byPosition | [6] bySequenceNumber | [7] byTime (opt, default = all)
+    if (pduLen < 7 || pdu[0] != 0x0C) {
+        sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 5, 1, remoteIP, remotePort);
+        return;
+    }
+
+    uint8_t objectType = 0;
+    uint32_t instance = 0;
+    if (!decodeObjectId(&pdu[1], pduLen - 1, objectType, instance)) {
+        sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 5, 1, remoteIP, remotePort);
+        return;
+    }
+    uint16_t offset = 5;
+
+    uint32_t propertyId = 0;
+    uint16_t consumed = 0;
+    if (!decodeContextUnsigned(1, &pdu[offset], pduLen - offset, propertyId, consumed)) {
+        sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 5, 1, remoteIP, remotePort);
+        return;
+    }
+    offset += consumed;
+
+    if (offset < pduLen && (pdu[offset] & 0xF8) == 0x28) {
+        uint32_t dummy = 0;
+        if (decodeContextUnsigned(2, &pdu[offset], pduLen - offset, dummy, consumed)) {
+            offset += consumed;
+        }
+    }
+
+    BACnetTrendLog* log = (objectType == OBJECT_TREND_LOG) ? bacnetTrendLogs.find(instance) : nullptr;
+    if (!log) {
+        sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 1 /*object*/, 31 /*unknown object*/, remoteIP, remotePort);
+        return;
+    }
+    if (propertyId != PROP_LOG_BUFFER) {
+        sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 2 /*property*/, 32 /*unknown property*/, remoteIP, remotePort);
+        return;
+    }
+
+    // ---- Decode range ----
+    const uint32_t held = log->count;
+    const uint32_t firstSeq = bacnetTrendLogs.firstSequence(log);
+    uint8_t rangeTag = 0;     // 0 = whole buffer
+    uint32_t first = 1;       // 1-based positions, inclusive
+    uint32_t last = held;
+    int32_t reqCount = (int32_t)held;
+
+    if (offset < pduLen) {
+        const uint8_t open = pdu[offset];
+        rangeTag = (open >> 4) & 0x0F;
+        if ((open & 0x0F) != 0x0E || (rangeTag != 3 && rangeTag != 6 && rangeTag != 7)) {
+            sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 5, 1, remoteIP, remotePort);
+            return;
+        }
+        offset++;
+
+        uint32_t ref = 0;
+        time_t refTime = 0;
+        if (rangeTag == 7) {
+            // BACnetDateTime: Date (0xA4) + Time (0xB4), local time
+            if (offset + 10 > pduLen || pdu[offset] != 0xA4 || pdu[offset + 5] != 0xB4) {
+                sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 5, 1, remoteIP, remotePort);
+                return;
+            }
+            struct tm rt = {};
+            rt.tm_year = pdu[offset + 1];
+            rt.tm_mon = pdu[offset + 2] - 1;
+            rt.tm_mday = pdu[offset + 3];
+            rt.tm_hour = (pdu[offset + 6] == 0xFF) ? 0 : pdu[offset + 6];
+            rt.tm_min = (pdu[offset + 7] == 0xFF) ? 0 : pdu[offset + 7];
+            rt.tm_sec = (pdu[offset + 8] == 0xFF) ? 0 : pdu[offset + 8];
+            rt.tm_isdst = -1;
+            refTime = (pdu[offset + 1] == 0xFF) ? 0 : mktime(&rt);
+            offset += 10;
+        } else {
+            if (!decodeAppUnsigned(&pdu[offset], pduLen - offset, ref, consumed)) {
+                sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 5, 1, remoteIP, remotePort);
+                return;
+            }
+            offset += consumed;
+        }
+
+        if (!decodeAppSigned(&pdu[offset], pduLen - offset, reqCount, consumed) || reqCount == 0) {
+            sendError(invokeId, SERVICE_CONFIRMED_READ_RANGE, 5, 1, remoteIP, remotePort);
+            return;
+        }
+        offset += consumed;
+
+        // Resolve reference to a position; for byTime the reference itself is excluded
+        int64_t refPos = 0;
+        if (rangeTag == 3) {
+            refPos = ref;
+        } else if (rangeTag == 6) {
+            refPos = (int64_t)ref - (int64_t)firstSeq + 1;
+        } else if (!bacnetTrendLogs.hasInvalidTime(log)) {
+            // Records are chronological: binary search the first record newer than refTime
+            uint32_t lo = 1, hi = held + 1;
+            while (lo < hi) {
+                const uint32_t mid = lo + (hi - lo) / 2;
+                TrendLogRecord r;
+                bacnetTrendLogs.recordAt(log, mid, r);
+                if ((time_t)r.timestamp <= refTime) lo = mid + 1; else hi = mid;
+            }
+            refPos = (reqCount > 0) ? (int64_t)lo : (int64_t)lo - 1;
+        } else {
+            // Some records were taken before the clock was set: they are not
+            // in time order, so scan and match only records with a time
+            TrendLogRecord r;
+            if (reqCount > 0) {
+                refPos = held + 1;
+                for (uint32_t pos = 1; pos <= held; pos++) {
+                    bacnetTrendLogs.recordAt(log, pos, r);
+                    if (r.timestamp != TRENDLOG_TIME_INVALID && (time_t)r.timestamp > refTime) {
+                        refPos = pos;
+                        break;
+                    }
+                }
+            } else {
+                refPos = 0;
+                for (uint32_t pos = held; pos >= 1; pos--) {
+                    bacnetTrendLogs.recordAt(log, pos, r);
+                    if (r.timestamp != TRENDLOG_TIME_INVALID && (time_t)r.timestamp <= refTime) {
+                        refPos = pos;
+                        break;
+                    }
+                }
+            }
+        }
+
+        if (held == 0 || refPos < 1 || refPos > (int64_t)held) {
+            first = 1;
+            last = 0; // empty
+        } else if (reqCount > 0) {
+            first = (uint32_t)refPos;
+            const int64_t end = refPos + reqCount - 1;
+            last = (uint32_t)((end > (int64_t)held) ? held : end);
+        } else {
+            last = (uint32_t)refPos;
+            const int64_t start = refPos + reqCount + 1;
+            first = (uint32_t)((start < 1) ? 1 : start);
+        }
+    }
+
+    // ---- Fit into the client's APDU (no segmentation) ----
+    const bool binary = (log->monitoredType != OBJECT_ANALOG_INPUT);
+    const uint16_t recSize = binary ? 16 : 19;
+    const uint16_t limit = (maxApdu < (BACNET_TX_BUFFER_SIZE - 4)) ? maxApdu : (BACNET_TX_BUFFER_SIZE - 4);
+    const uint16_t headerSize = 32; // NPDU + APDU header + ack fields around itemData
+    const uint32_t fit = (limit > headerSize) ? (uint32_t)((limit - headerSize) / recSize) : 0;
+
+    uint32_t items = (last >= first) ? (last - first + 1) : 0;
+    bool more = false;
+    if (items > fit) {
+        more = true;
+        if (reqCount < 0) {
+            first = last - fit + 1; // keep the records closest to the reference
+        } else {
+            last = first + fit - 1;
+        }
+        items = fit;
+    }
+
+    // ---- Build ReadRange-ACK ----
+    uint16_t tx = 0;
+    _txBuffer[tx++] = BVLL_TYPE_BACNET_IP;
+    _txBuffer[tx++] = BVLL_FUNC_ORIGINAL_UNICAST_NPDU;
+    _txBuffer[tx++] = 0x00;
+    _txBuffer[tx++] = 0x00;
+
+    _txBuffer[tx++] = 0x01;
+    _txBuffer[tx++] = 0x00;
+
+    _txBuffer[tx++] = PDU_TYPE_COMPLEX_ACK;
+    _txBuffer[tx++] = invokeId;
+    _txBuffer[tx++] = SERVICE_CONFIRMED_READ_RANGE;
+
+    _txBuffer[tx++] = 0x0C;
+    tx += encodeObjectId(&_txBuffer[tx], OBJECT_TREND_LOG, log->instance);
+    tx += encodeContextUnsigned(&_txBuffer[tx], 1, PROP_LOG_BUFFER);
+
+    // resultFlags [3]: firstItem, lastItem, moreItems
+    uint8_t flags = 0;
+    if (items > 0 && first == 1) flags |= 0x80;
+    if (items > 0 && last == held) flags |= 0x40;
+    if (more) flags |= 0x20;
+    _txBuffer[tx++] = 0x3A;
+    _txBuffer[tx++] = 0x05; // unused bits
+    _txBuffer[tx++] = flags;
+
+    // itemCount [4]
+    tx += encodeContextUnsigned(&_txBuffer[tx], 4, items);
+
+    // itemData [5]
+    _txBuffer[tx++] = 0x5E;
+    for (uint32_t pos = first; items > 0 && pos <= last; pos++) {
+        TrendLogRecord r;
+        if (!bacnetTrendLogs.recordAt(log, pos, r)) break;
+        tx += encodeLogRecord(&_txBuffer[tx], r, binary);
+    }
+    _txBuffer[tx++] = 0x5F;
+
+    // firstSequenceNumber [6] (bySequence/byTime only)
+    if (items > 0 && (rangeTag == 6 || rangeTag == 7)) {
+        tx += encodeContextUnsigned(&_txBuffer[tx], 6, firstSeq + first - 1);
+    }
+
+    _txBuffer[2] = (uint8_t)((tx >> 8) & 0xFF);
+    _txBuffer[3] = (uint8_t)(tx & 0xFF);
+
+    sendPacket(tx, remoteIP, remotePort);
+}
+
 BACnetObject* BACnetDriver::findObject(uint8_t objectType, uint32_t instance) {
     if (objectType == OBJECT_ANALOG_INPUT) {
         for (uint8_t i = 0; i < BACNET_MAX_AI_MAIN; i++) {
@@ -771,22 +1374,99 @@ BACnetObject* BACnetDriver::findObject(uint8_t objectType, uint32_t instance) {
         return &_bo[instance - 1];
     }
 
+    if (objectType == OBJECT_BINARY_VALUE) {
+        if (instance < 1 || instance > BACNET_MAX_BV) return nullptr;
+        return &_bv[instance - 1];
+    }
+
+    if (objectType == OBJECT_ANALOG_VALUE) {
+        if (instance < 1 || instance > BACNET_MAX_AV) return nullptr;
+        return &_av[instance - 1];
+    }
+
     return nullptr;
 }
 
+void BACnetDriver::handleBvllResult(const uint8_t* data, uint16_t len, IPAddress remoteIP, uint16_t remotePort) {
+    if (len < 2) return;
+    const uint16_t code = u16be(data[0], data[1]);
+
+    if (!_fdEnabled) return;
+
+    // Only the configured BBMD may change the registration state; any other
+    // host on the LAN could otherwise fake a result and stop the renewals
+    if (!(remoteIP == _bbmdIP) || remotePort != _bbmdPort) {
+        _stats.rxIgnored++;
+        return;
+    }
+
+    if (code == BVLL_RESULT_SUCCESSFUL_COMPLETION) {
+        if (!_fdRegistered) {
+            Serial.printf("[BACnet] Registered as foreign device with %s\n", _bbmdIP.toString().c_str());
+        }
+        _fdRegistered = true;
+        _fdAwaitingResult = false;
+        // Refresh at half the TTL so the BBMD never ages us out
+        _fdRefreshMs = (uint32_t)_fdTtl * 500UL;
+    } else if (code == BVLL_RESULT_REGISTER_FOREIGN_DEVICE_NAK) {
+        Serial.printf("[BACnet] BBMD %s refused foreign-device registration\n", _bbmdIP.toString().c_str());
+        _fdRegistered = false;
+        _fdAwaitingResult = false;
+        _fdRefreshMs = BACNET_FD_RETRY_MS;
+    }
+}
+
+// -------------------- Foreign Device --------------------
+void BACnetDriver::sendRegisterForeignDevice() {
+    uint16_t tx = 0;
+
+    _txBuffer[tx++] = BVLL_TYPE_BACNET_IP;
+    _txBuffer[tx++] = BVLL_FUNC_REGISTER_FOREIGN_DEVICE;
+    _txBuffer[tx++] = 0x00;
+    _txBuffer[tx++] = 0x06;
+    _txBuffer[tx++] = (uint8_t)((_fdTtl >> 8) & 0xFF);
+    _txBuffer[tx++] = (uint8_t)(_fdTtl & 0xFF);
+
+    sendPacket(tx, _bbmdIP, _bbmdPort);
+
+    _lastFdRegisterMs = millis();
+    // Until a BVLL-Result arrives, retry at the short interval
+    _fdAwaitingResult = true;
+    _fdRefreshMs = BACNET_FD_RETRY_MS;
+}
+
+void BACnetDriver::serviceForeignDevice(uint32_t now) {
+    if (!_fdEnabled) return;
+    if ((now - _lastFdRegisterMs) < _fdRefreshMs) return;
+
+    if (_fdAwaitingResult) {
+        // Refresh sent but never acknowledged
+        _fdRegistered = false;
+    }
+    sendRegisterForeignDevice();
+}
+
 // -------------------- I-Am --------------------
 void BACnetDriver::sendIAmBroadcast() {
-    // Broadcast to x.x.x.255
-    IPAddress broadcastIP(_localIP[0], _localIP[1], _localIP[2], 255);
-    sendIAmUnicast(broadcastIP, BACNET_UDP_PORT);
+    // Local segment: subnet-directed broadcast (honours the mask on routed VLANs)
+    sendIAm(getBroadcastAddress(), BACNET_UDP_PORT, BVLL_FUNC_ORIGINAL_BROADCAST_NPDU);
+
+    // Remote segments: let the BBMD distribute it
+    if (_fdEnabled && _fdRegistered) {
+        sendIAm(_bbmdIP, _bbmdPort, BVLL_FUNC_DISTRIBUTE_BROADCAST_TO_NETWORK);
+    }
 }
 
 void BACnetDriver::sendIAmUnicast(IPAddress remoteIP, uint16_t remotePort) {
+    sendIAm(remoteIP, remotePort, BVLL_FUNC_ORIGINAL_UNICAST_NPDU);
+}
+
+void BACnetDriver::sendIAm(IPAddress remoteIP, uint16_t remotePort, uint8_t bvllFunc) {
     uint16_t tx = 0;
 
     // BVLL
     _txBuffer[tx++] = BVLL_TYPE_BACNET_IP;
-    _txBuffer[tx++] = (remoteIP[3] == 255) ? BVLL_FUNC_ORIGINAL_BROADCAST_NPDU : BVLL_FUNC_ORIGINAL_UNICAST_NPDU;
+    _txBuffer[tx++] = bvllFunc;
     _txBuffer[tx++] = 0x00;
     _txBuffer[tx++] = 0x00;
 
@@ -816,9 +1496,7 @@ void BACnetDriver::sendIAmUnicast(IPAddress remoteIP, uint16_t remotePort) {
     _txBuffer[2] = (uint8_t)((tx >> 8) & 0xFF);
     _txBuffer[3] = (uint8_t)(tx & 0xFF);
 
-    _udp.beginPacket(remoteIP, remotePort);
-    _udp.write(_txBuffer, tx);
-    _udp.endPacket();
+    sendPacket(tx, remoteIP, remotePort);
 }
 
 // -------------------- ACK/ERROR --------------------
@@ -840,9 +1518,7 @@ void BACnetDriver::sendSimpleAck(uint8_t invokeId, uint8_t serviceChoice, IPAddr
     _txBuffer[2] = (uint8_t)((tx >> 8) & 0xFF);
     _txBuffer[3] = (uint8_t)(tx & 0xFF);
 
-    _udp.beginPacket(remoteIP, remotePort);
-    _udp.write(_txBuffer, tx);
-    _udp.endPacket();
+    sendPacket(tx, remoteIP, remotePort);
 }
 
 void BACnetDriver::sendError(uint8_t invokeId, uint8_t serviceChoice, uint8_t errorClass, uint8_t errorCode, IPAddress remoteIP, uint16_t remotePort) {
@@ -856,6 +1532,8 @@ void BACnetDriver::sendError(uint8_t invokeId, uint8_t serviceChoice, uint8_t er
     _txBuffer[tx++] = 0x01;
     _txBuffer[tx++] = 0x00;
 
+    _stats.errorsSent++;
+
     _txBuffer[tx++] = PDU_TYPE_ERROR;
     _txBuffer[tx++] = invokeId;
     _txBuffer[tx++] = serviceChoice;
@@ -871,9 +1549,7 @@ void BACnetDriver::sendError(uint8_t invokeId, uint8_t serviceChoice, uint8_t er
     _txBuffer[2] = (uint8_t)((tx >> 8) & 0xFF);
     _txBuffer[3] = (uint8_t)(tx & 0xFF);
 
-    _udp.beginPacket(remoteIP, remotePort);
-    _udp.write(_txBuffer, tx);
-    _udp.endPacket();
+    sendPacket(tx, remoteIP, remotePort);
 }
 
 // -------------------- Encoding Helpers --------------------
@@ -945,7 +1621,9 @@ uint16_t BACnetDriver::encodeAppReal(uint8_t* buffer, float value) {
 
 uint16_t BACnetDriver::encodeAppCharacterString(uint8_t* buffer, const char* str) {
     if (!str) str = "";
-    const uint8_t slen = (uint8_t)strlen(str);
+    // Single-octet extended length only (payload <= 253)
+    const size_t rawLen = strlen(str);
+    const uint8_t slen = (uint8_t)((rawLen > 200) ? 200 : rawLen);
     const uint16_t payloadLen = (uint16_t)(1 + slen); // charset + chars
 
     uint16_t idx = 0;
@@ -962,6 +1640,19 @@ uint16_t BACnetDriver::encodeAppCharacterString(uint8_t* buffer, const char* str
     return idx;
 }
 
+uint16_t BACnetDriver::encodeContextUnsigned(uint8_t* buffer, uint8_t tagNumber, uint32_t value) {
+    uint8_t len = 1;
+    if (value > 0xFFFFFF) len = 4;
+    else if (value > 0xFFFF) len = 3;
+    else if (value > 0xFF) len = 2;
+
+    buffer[0] = (uint8_t)((tagNumber << 4) | 0x08 | len);
+    for (uint8_t i = 0; i < len; i++) {
+        buffer[1 + i] = (uint8_t)((value >> (8 * (len - 1 - i))) & 0xFF);
+    }
+    return (uint16_t)(1 + len);
+}
+
 // -------------------- Decoding Helpers --------------------
 bool BACnetDriver::decodeObjectId(uint8_t* buffer, uint16_t bufferLen, uint8_t& objectType, uint32_t& instance) {
     if (bufferLen < 4) return false;
@@ -1006,12 +1697,17 @@ bool BACnetDriver::decodeAnyValueToBool(uint8_t* buffer, uint16_t bufferLen, boo
     const bool isContext = (tag & 0x08) != 0;
     const uint8_t len = tag & 0x0F;
 
-    (void)isContext;
+    // Application Boolean carries its value in the length field, no content octet
+    if (tagNum == 1 && !isContext) {
+        value = (len != 0);
+        consumed = 1;
+        return true;
+    }
 
     // Enumerated (tag 9)
     if (tagNum == 9) {
         uint8_t l = tag & 0x0F;
-        if (l == 0x0F) return false;
+        if (l < 1 || l > 4) return false;
         if (bufferLen < (uint16_t)(1 + l)) return false;
         uint32_t v = 0;
         for (uint8_t i = 0; i < l; i++) v = (v << 8) | buffer[1 + i];
@@ -1062,6 +1758,7 @@ bool BACnetDriver::decodeAnyValueToString(uint8_t* buffer, uint16_t bufferLen, S
     } else if (lenNib == 5) {
         if (bufferLen < 2) return false;
         dataLen = buffer[1];
+        if (dataLen > 253) return false; // 16/32-bit extended lengths not supported
         offset = 2;
     } else {
         return false;
@@ -1082,3 +1779,30 @@ bool BACnetDriver::decodeAnyValueToString(uint8_t* buffer, uint16_t bufferLen, S
     return true;
 }
 
+bool BACnetDriver::decodeAppUnsigned(uint8_t* buffer, uint16_t bufferLen, uint32_t& value, uint16_t& consumed) {
+    if (bufferLen < 2) return false;
+    const uint8_t tag = buffer[0];
+    const uint8_t len = tag & 0x07;
+    if ((tag & 0xF8) != 0x20) return false; // application tag 2
+    if (len == 0 || len > 4 || bufferLen < (uint16_t)(1 + len)) return false;
+
+    value = 0;
+    for (uint8_t i = 0; i < len; i++) value = (value << 8) | buffer[1 + i];
+    consumed = (uint16_t)(1 + len);
+    return true;
+}
+
+bool BACnetDriver::decodeAppSigned(uint8_t* buffer, uint16_t bufferLen, int32_t& value, uint16_t& consumed) {
+    if (bufferLen < 2) return false;
+    const uint8_t tag = buffer[0];
+    const uint8_t len = tag & 0x07;
+    if ((tag & 0xF8) != 0x30) return false; // application tag 3
+    if (len == 0 || len > 4 || bufferLen < (uint16_t)(1 + len)) return false;
+
+    // Sign-extend from the first octet
+    uint32_t v = (buffer[1] & 0x80) ? 0xFFFFFFFFUL : 0;
+    for (uint8_t i = 0; i < len; i++) v = (v << 8) | buffer[1 + i];
+    value = (int32_t)v;
+    consumed = (uint16_t)(1 + len);
+    return true;
+}
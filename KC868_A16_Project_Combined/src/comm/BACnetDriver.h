@@ -5,6 +5,7 @@
 #include <WiFiUdp.h>
 #include <ETH.h>
 #include <IPAddress.h>
+#include "BACnetTrendLog.h"
 
 /*
  * KC868-A16 BACnet/IP Driver (Lightweight)
@@ -12,8 +13,13 @@
  * This driver implements a minimal BACnet/IP stack (BVLL + NPDU + APDU)
  * to support:
  *   - Device discovery (Who-Is / I-Am)
- *   - ReadProperty (BI/BO/AI/Device)
- *   - WriteProperty (BO Present_Value)
+ *   - ReadProperty (BI/BO/AI/BV/AV/Device)
+ *   - WriteProperty (BO/BV Present_Value, Trend Log Enable/Record_Count)
+ *     BO writes carry their priority (default 8) and NULL relinquishes;
+ *     Priority_Array reads come from the output manager
+ *   - ReadRange on Trend Log buffers (by position, sequence and time)
+ *   - Foreign-device registration with a BBMD (routed VLANs), Forwarded-NPDU
+ *     handling and subnet-directed broadcasts
  *
  * Designed for System.IO.BACnet (.NET) client compatibility.
  * No changes required to existing MODBUS code paths.
@@ -24,6 +30,15 @@
 #define BACNET_UDP_PORT                  47808     // BAC0 (0xBAC0)
 #define BACNET_MAX_APDU                  480
 
+// Unsolicited I-Am re-announce. Discovery is driven by Who-Is, so this is
+// only a slow keep-alive for passive listeners (was 15 s).
+#define BACNET_IAM_INTERVAL_MS           300000UL
+
+// Foreign-device registration (BVLL Register-Foreign-Device)
+#define BACNET_FD_DEFAULT_TTL_S          300       // Time-to-live requested from the BBMD
+#define BACNET_FD_MIN_TTL_S              30
+#define BACNET_FD_RETRY_MS               30000UL   // Retry after NAK / no Result
+
 // Object counts
 #define BACNET_MAX_AI_MAIN               4         // Analog Inputs A1..A4
 #define BACNET_MAX_AI_SENSORS            5         // AI101..AI105 (Sensors)
@@ -31,6 +46,8 @@
 
 #define BACNET_MAX_BI                    16        // Digital Inputs 1..16
 #define BACNET_MAX_BO                    16        // MOSFET Outputs 1..16
+#define BACNET_MAX_BV                    16        // Logic bits M0..M15 (BV1..BV16)
+#define BACNET_MAX_AV                    8         // Logic registers R0..R7 (AV1..AV8, read-only)
 
 // Buffer sizes
 #define BACNET_RX_BUFFER_SIZE            1500
@@ -40,6 +57,14 @@
 #define BVLL_TYPE_BACNET_IP              0x81
 #define BVLL_FUNC_ORIGINAL_UNICAST_NPDU  0x0A
 #define BVLL_FUNC_ORIGINAL_BROADCAST_NPDU 0x0B
+#define BVLL_FUNC_RESULT                 0x00
+#define BVLL_FUNC_FORWARDED_NPDU         0x04
+#define BVLL_FUNC_REGISTER_FOREIGN_DEVICE 0x05
+#define BVLL_FUNC_DISTRIBUTE_BROADCAST_TO_NETWORK 0x09
+
+// BVLL-Result codes
+#define BVLL_RESULT_SUCCESSFUL_COMPLETION        0x0000
+#define BVLL_RESULT_REGISTER_FOREIGN_DEVICE_NAK  0x0030
 
 // --------------------------- APDU Types ------------------------------
 #define PDU_TYPE_CONFIRMED_SERVICE_REQUEST   0x00
@@ -56,11 +81,14 @@
 // Confirmed services
 #define SERVICE_CONFIRMED_READ_PROPERTY      0x0C
 #define SERVICE_CONFIRMED_WRITE_PROPERTY     0x0F
+#define SERVICE_CONFIRMED_READ_RANGE         0x1A
 
 // --------------------------- Object Types ----------------------------
 #define OBJECT_ANALOG_INPUT                  0
+#define OBJECT_ANALOG_VALUE                  2
 #define OBJECT_BINARY_INPUT                  3
 #define OBJECT_BINARY_OUTPUT                 4
+#define OBJECT_BINARY_VALUE                  5
 #define OBJECT_DEVICE                        8
 
 // --------------------------- Property IDs ----------------------------
@@ -68,6 +96,8 @@
 #define PROP_OBJECT_NAME                     77
 #define PROP_OBJECT_TYPE                     79
 #define PROP_PRESENT_VALUE                   85
+#define PROP_PRIORITY_ARRAY                  87
+#define PROP_RELINQUISH_DEFAULT              104
 #define PROP_DESCRIPTION                     28
 #define PROP_UNITS                           117
 #define PROP_OUT_OF_SERVICE                  81
@@ -86,6 +116,19 @@
 
 #define PROP_SERIAL_NUMBER                 372
 
+// Trend Log properties
+#define PROP_BUFFER_SIZE                     126
+#define PROP_ENABLE                          133
+#define PROP_LOG_BUFFER                      131
+#define PROP_LOG_DEVICE_OBJECT_PROPERTY      132
+#define PROP_LOG_INTERVAL                    134
+#define PROP_RECORD_COUNT                    141
+#define PROP_STOP_WHEN_FULL                  144
+#define PROP_TOTAL_RECORD_COUNT              145
+#define PROP_LOGGING_TYPE                    197
+#define PROP_STATUS_FLAGS                    111
+#define PROP_EVENT_STATE                     36
+
 // ---- Vendor properties (Microcode / KC868) ----
 #define PROP_MESA_MAC_ADDRESS              512
 #define PROP_MESA_HARDWARE_VER             513
@@ -105,6 +148,23 @@
 #define UNITS_DEGREES_CELSIUS                62
 #define UNITS_PERCENT                        98
 
+// --------------------------- Service Statistics ----------------------
+struct BACnetStats {
+    uint32_t rxPackets;
+    uint32_t rxMalformed;          // dropped by BVLL/NPDU/APDU validation
+    uint32_t rxIgnored;            // well-formed, not for us (BVLL-Result from a host other than the BBMD)
+    uint32_t whoIs;
+    uint32_t readProperty;
+    uint32_t writeProperty;
+    uint32_t readRange;
+    uint32_t unsupported;
+    uint32_t errorsSent;
+    uint32_t txPackets;
+    uint32_t lastServiceUs;        // parse + handle + reply of the last valid frame
+    uint32_t maxServiceUs;
+    uint64_t totalServiceUs;
+};
+
 // --------------------------- Small Object Structure ------------------
 struct BACnetObject {
     uint32_t instance;
@@ -135,19 +195,39 @@ public:
     void setDescription(const char* desc);
     void setLocation(const char* loc);
 
+    // Foreign-device registration. A zero BBMD address disables it.
+    // Registration is (re)sent immediately and then refreshed at TTL/2.
+    void setForeignDevice(IPAddress bbmdIP, uint16_t bbmdPort, uint16_t ttlSeconds);
+    bool isForeignDevice() const { return _fdEnabled; }
+    bool isForeignDeviceRegistered() const { return _fdRegistered; }
+
+    // Subnet-directed broadcast for the bound interface (ip | ~mask)
+    IPAddress getBroadcastAddress() const;
+
     // ---- Updates from hardware to BACnet objects ----
     void updateAnalogInput(uint8_t channel, float volts);               // AI1..AI4
     void updateBinaryInput(uint8_t channel, bool active);               // BI1..BI16
     void updateBinaryOutput(uint8_t channel, bool active);              // BO1..BO16
+    void updateBinaryValue(uint8_t channel, bool active);               // BV1..BV16
+    void updateAnalogValue(uint8_t channel, float value);               // AV1..AV8
 
     // Sensor Analog Inputs (AI101..AI105)
     void updateSensorAnalog(uint16_t instance, float value, uint16_t units, const char* desc);
 
     // ---- Commands from BACnet to hardware ----
-    bool getBinaryOutputCommand(uint8_t channel, bool& active);         // returns true only when NEW command exists
+    // Returns true only when a NEW command exists. priority 0 = none given.
+    bool getBinaryOutputCommand(uint8_t channel, bool& active, uint8_t& priority, bool& relinquish);
+    bool getBinaryValueCommand(uint8_t channel, bool& active);          // same, for BV writes
+
+    // Feed one BVLL datagram. Used by task() for UDP traffic; also usable
+    // directly (replay/bench) since it does not touch the socket on input.
+    void processPacket(const uint8_t* data, uint16_t len, IPAddress remoteIP, uint16_t remotePort);
 
     // Status
+    const BACnetStats& stats() const { return _stats; }
+    void resetStats() { memset(&_stats, 0, sizeof(_stats)); }
     bool isRunning() const { return _initialized; }
+    IPAddress localIP() const { return _localIP; }
     uint32_t getDeviceID() const { return _deviceID; }
 
 private:
@@ -169,10 +249,16 @@ private:
     BACnetObject _aiSensors[BACNET_MAX_AI_SENSORS];
     BACnetObject _bi[BACNET_MAX_BI];
     BACnetObject _bo[BACNET_MAX_BO];
+    BACnetObject _bv[BACNET_MAX_BV];
+    BACnetObject _av[BACNET_MAX_AV];
 
     // Output commands (pending writes)
     bool _boCmdPending[BACNET_MAX_BO];
     bool _boCmdValue[BACNET_MAX_BO];
+    uint8_t _boCmdPriority[BACNET_MAX_BO];
+    bool _boCmdRelinquish[BACNET_MAX_BO];
+    bool _bvCmdPending[BACNET_MAX_BV];
+    bool _bvCmdValue[BACNET_MAX_BV];
 
     // RX/TX buffers
     uint8_t  _rxBuffer[BACNET_RX_BUFFER_SIZE];
@@ -180,17 +266,41 @@ private:
 
     // Stats / timing
     uint32_t _lastIAmMs;
+    BACnetStats _stats;
+
+    // Foreign-device registration
+    bool      _fdEnabled;
+    bool      _fdRegistered;
+    bool      _fdAwaitingResult;
+    IPAddress _bbmdIP;
+    uint16_t  _bbmdPort;
+    uint16_t  _fdTtl;
+    uint32_t  _lastFdRegisterMs;
+    uint32_t  _fdRefreshMs;
 
 private:
     // Packet processing
     void processIncomingPacket();
+    bool dispatchPacket(uint16_t len, IPAddress remoteIP, uint16_t remotePort);
+    void sendPacket(uint16_t len, IPAddress remoteIP, uint16_t remotePort);
+    void handleBvllResult(const uint8_t* data, uint16_t len, IPAddress remoteIP, uint16_t remotePort);
     void handleWhoIs(IPAddress remoteIP, uint16_t remotePort);
     void handleReadProperty(uint8_t invokeId, uint8_t* pdu, uint16_t pduLen, IPAddress remoteIP, uint16_t remotePort);
     void handleWriteProperty(uint8_t invokeId, uint8_t* pdu, uint16_t pduLen, IPAddress remoteIP, uint16_t remotePort);
+    void handleReadRange(uint8_t invokeId, uint16_t maxApdu, uint8_t* pdu, uint16_t pduLen, IPAddress remoteIP, uint16_t remotePort);
+
+    // Trend Log property encoding (ReadProperty)
+    bool encodeTrendLogProperty(BACnetTrendLog* log, uint32_t propertyId, uint16_t& tx);
+    uint16_t encodeLogRecord(uint8_t* buffer, const TrendLogRecord& rec, bool binary);
 
     // I-Am
     void sendIAmBroadcast();
     void sendIAmUnicast(IPAddress remoteIP, uint16_t remotePort);
+    void sendIAm(IPAddress remoteIP, uint16_t remotePort, uint8_t bvllFunc);
+
+    // Foreign device
+    void sendRegisterForeignDevice();
+    void serviceForeignDevice(uint32_t now);
 
     // Object lookup
     BACnetObject* findObject(uint8_t objectType, uint32_t instance);
@@ -206,12 +316,15 @@ private:
     uint16_t encodeAppBoolean(uint8_t* buffer, bool value);
     uint16_t encodeAppReal(uint8_t* buffer, float value);
     uint16_t encodeAppCharacterString(uint8_t* buffer, const char* str);
+    uint16_t encodeContextUnsigned(uint8_t* buffer, uint8_t tagNumber, uint32_t value);
 
     // Decoding helpers (very small subset)
     bool decodeObjectId(uint8_t* buffer, uint16_t bufferLen, uint8_t& objectType, uint32_t& instance);
     bool decodeContextUnsigned(uint8_t expectedTagNumber, uint8_t* buffer, uint16_t bufferLen, uint32_t& value, uint16_t& consumed);
     bool decodeAnyValueToBool(uint8_t* buffer, uint16_t bufferLen, bool& value, uint16_t& consumed);
     bool decodeAnyValueToString(uint8_t* buffer, uint16_t bufferLen, String& value, uint16_t& consumed);
+    bool decodeAppUnsigned(uint8_t* buffer, uint16_t bufferLen, uint32_t& value, uint16_t& consumed);
+    bool decodeAppSigned(uint8_t* buffer, uint16_t bufferLen, int32_t& value, uint16_t& consumed);
 };
 
 // Global instance
@@ -2,8 +2,8 @@
 #include "BACnetIntegration.h"
 #include "../Globals.h"
 #include "../Definitions.h"
+#include "../FunctionPrototypes.h"
 #include <WiFi.h>
-#include <Wire.h>
 
 // Static member initialization
 bool BACnetIntegration::_enabled = true;
@@ -21,6 +21,14 @@ void BACnetIntegration::initialize() {
     bacnetDriver.setDescription(deviceDescriptionStr.c_str());
     bacnetDriver.setLocation(deviceLocationStr.c_str());
 
+    // Trend Log buffers (sampled from the object updates below)
+    bacnetTrendLogs.begin();
+
+    // Routed VLANs: register with a BBMD so Who-Is/I-Am cross subnets
+    if (bacnetFdEnabled) {
+        bacnetDriver.setForeignDevice(bacnetBbmdIp, bacnetBbmdPort, bacnetFdTtl);
+    }
+
     Serial.println(F("[BACnet Integration] Ready"));
 }
 
@@ -71,6 +79,18 @@ void BACnetIntegration::startIfNeeded() {
     }
 }
 
+void BACnetIntegration::rebind() {
+    if (!_started) return;
+
+    IPAddress ip, gw, mask;
+    if (isNetworkReady(ip, gw, mask) && bacnetDriver.isRunning() && bacnetDriver.localIP() == ip) return;
+
+    // begin() re-announces (I-Am) and re-registers with the BBMD from the new address
+    bacnetDriver.end();
+    _started = false;
+    if (_enabled) startIfNeeded();
+}
+
 void BACnetIntegration::update() {
     if (!_enabled) return;
 
@@ -82,6 +102,10 @@ void BACnetIntegration::update() {
     // Always handle BACnet network traffic
     bacnetDriver.task();
 
+    // BO writes go straight into the output priority array; the output
+    // manager flushes them at the end of this loop pass
+    applyBinaryOutputCommands();
+
     // Sync hardware <-> BACnet at a controlled rate
     const uint32_t now = millis();
     if ((now - _lastSync) < SYNC_INTERVAL) {
@@ -89,14 +113,34 @@ void BACnetIntegration::update() {
     }
     _lastSync = now;
 
-    // 1) Apply any BO write commands from BACnet client to hardware first
-    applyBinaryOutputCommands();
+    // 1) Apply BV write commands to the logic bits first
+    applyBinaryValueCommands();
 
     // 2) Push current hardware states to BACnet objects
     updateBinaryInputs();
     updateBinaryOutputs();
     updateAnalogInputs();
     updateSensorValues();
+    updateLogicValues();
+}
+
+void BACnetIntegration::updateLogicValues() {
+    // BV1..BV16 = M0..M15, AV1..AV8 = R0..R7
+    for (uint8_t i = 0; i < BACNET_MAX_BV; i++) {
+        bacnetDriver.updateBinaryValue(i, logicBit(i));
+    }
+    for (uint8_t i = 0; i < BACNET_MAX_AV; i++) {
+        bacnetDriver.updateAnalogValue(i, (float)logicReg(i));
+    }
+}
+
+void BACnetIntegration::applyBinaryValueCommands() {
+    for (uint8_t i = 0; i < BACNET_MAX_BV; i++) {
+        bool cmd = false;
+        if (bacnetDriver.getBinaryValueCommand(i, cmd)) {
+            setLogicBit(i, cmd);
+        }
+    }
 }
 
 void BACnetIntegration::updateAnalogInputs() {
@@ -188,34 +232,29 @@ void BACnetIntegration::updateSensorValues() {
 }
 
 void BACnetIntegration::applyBinaryOutputCommands() {
-    // Read NEW Binary Output commands from BACnet and apply to hardware
+    // Each BO write commands (or relinquishes) its slot in the output
+    // priority array; serviceOutputs() writes the result with everything else
     for (uint8_t i = 0; i < 16; i++) {
-        bool value = false;
-        if (bacnetDriver.getBinaryOutputCommand(i, value)) {
-
-            // Respect master enable global flag
-            if (!outputsMasterEnable) {
-                Serial.println(F("[BACnet] Outputs blocked - Master Enable is OFF"));
-                continue;
-            }
-
-            if (outputStates[i] != value) {
-                outputStates[i] = value;
-
-                // Write to PCF8574 output expanders
-                if (i < 8) {
-                    // Outputs 1-8 (PCF8574 0x24)
-                    outputIC3.digitalWrite(i, value ? HIGH : LOW);
-                } else {
-                    // Outputs 9-16 (PCF8574 0x25)
-                    outputIC4.digitalWrite(i - 8, value ? HIGH : LOW);
-                }
-
-                Serial.printf("[BACnet] Output %u set to %u\n", (unsigned)(i + 1), (unsigned)value);
-
-                // Also update BACnet object immediately (faster UI feedback)
-                bacnetDriver.updateBinaryOutput(i, value);
-            }
+        bool cmd = false;
+        uint8_t priority = 0;
+        bool relinquish = false;
+        if (!bacnetDriver.getBinaryOutputCommand(i, cmd, priority, relinquish)) continue;
+
+        // Respect master enable global flag
+        if (!outputsMasterEnable) {
+            Serial.println(F("[BACnet] Outputs blocked - Master Enable is OFF"));
+            continue;
+        }
+
+        // No priority in the request: the BACnet source level (16 by default)
+        if (priority == 0) priority = outputSourcePriority(OUTPUT_SRC_BACNET);
+        const uint16_t bit = 1u << i;
+        if (relinquish) {
+            relinquishOutputs(priority, bit);
+            Serial.printf("[BACnet] Output %u relinquished at %u\n", (unsigned)(i + 1), (unsigned)priority);
+        } else {
+            commandOutputs(OUTPUT_SRC_BACNET, priority, bit, cmd ? bit : 0);
+            Serial.printf("[BACnet] Output %u set to %u at %u\n", (unsigned)(i + 1), (unsigned)cmd, (unsigned)priority);
         }
     }
 }
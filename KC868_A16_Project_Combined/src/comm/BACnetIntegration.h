@@ -11,7 +11,9 @@
  *
  * - Starts BACnet/IP automatically once Ethernet/WiFi is connected
  * - Keeps BI/BO/AI objects updated from hardware
- * - Applies BO write commands back to hardware (MOSFET outputs)
+ * - Applies BO write commands (with their priority) through the output manager
+ * - Mirrors logic engine bits/registers as BV/AV; BV writes set the bits
+ * - Feeds the Trend Log ring buffers through the object updates
  *
  * IMPORTANT:
  *   This file does NOT modify any MODBUS code paths.
@@ -25,6 +27,9 @@ public:
     static void setEnabled(bool enabled);
     static bool isEnabled();
 
+    // Uplink changed: restart on the interface isNetworkReady() now picks
+    static void rebind();
+
 private:
     static bool _enabled;
     static bool _started;
@@ -36,11 +41,13 @@ private:
     static void startIfNeeded();
 
     static void applyBinaryOutputCommands();
+    static void applyBinaryValueCommands();
 
     static void updateAnalogInputs();
     static void updateBinaryInputs();
     static void updateBinaryOutputs();
     static void updateSensorValues();
+    static void updateLogicValues();
 };
 
 #endif // BACNET_INTEGRATION_H
@@ -0,0 +1,152 @@
+#include "BACnetTrendLog.h"
+#include "BACnetDriver.h"
+#include "../FunctionPrototypes.h"
+#include <esp_heap_caps.h>
+#include <time.h>
+#include <string.h>
+#include <math.h>
+
+// Global instance
+BACnetTrendLogStore bacnetTrendLogs;
+
+BACnetTrendLogStore::BACnetTrendLogStore()
+    : _count(0),
+      _psram(false) {
+    memset(_logs, 0, sizeof(_logs));
+}
+
+bool BACnetTrendLogStore::begin() {
+    _psram = psramFound();
+
+    // Default set: A1..A4 and the three temperature channels every minute
+    configure(0, 1, "Analog Input 1 Log", OBJECT_ANALOG_INPUT, 1,   TRENDLOG_LOGGING_POLLED, 60000UL, 0.0f);
+    configure(1, 2, "Analog Input 2 Log", OBJECT_ANALOG_INPUT, 2,   TRENDLOG_LOGGING_POLLED, 60000UL, 0.0f);
+    configure(2, 3, "Analog Input 3 Log", OBJECT_ANALOG_INPUT, 3,   TRENDLOG_LOGGING_POLLED, 60000UL, 0.0f);
+    configure(3, 4, "Analog Input 4 Log", OBJECT_ANALOG_INPUT, 4,   TRENDLOG_LOGGING_POLLED, 60000UL, 0.0f);
+    configure(4, 5, "DHT1 Temp Log",      OBJECT_ANALOG_INPUT, 101, TRENDLOG_LOGGING_POLLED, 60000UL, 0.0f);
+    configure(5, 6, "DHT2 Temp Log",      OBJECT_ANALOG_INPUT, 103, TRENDLOG_LOGGING_POLLED, 60000UL, 0.0f);
+    configure(6, 7, "DS18B20 Temp Log",   OBJECT_ANALOG_INPUT, 105, TRENDLOG_LOGGING_POLLED, 60000UL, 0.0f);
+
+    // Input 1 on change (typical alarm/run-status contact)
+    configure(7, 8, "Digital Input 1 Log", OBJECT_BINARY_INPUT, 1,  TRENDLOG_LOGGING_COV, 0, 0.0f);
+
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_logs[i].records) total += _logs[i].capacity;
+    }
+    Serial.printf("[BACnet] Trend logs: %u objects, %lu records in %s\n",
+                  (unsigned)_count, (unsigned long)total, _psram ? "PSRAM" : "internal RAM");
+    return true;
+}
+
+bool BACnetTrendLogStore::configure(uint8_t index, uint32_t instance, const char* name,
+                                    uint8_t monitoredType, uint32_t monitoredInstance,
+                                    uint8_t loggingType, uint32_t logIntervalMs, float covIncrement) {
+    if (index >= BACNET_MAX_TREND_LOGS) return false;
+
+    BACnetTrendLog& log = _logs[index];
+
+    if (!log.records) {
+        const uint32_t cap = _psram ? BACNET_TRENDLOG_RECORDS_PSRAM : BACNET_TRENDLOG_RECORDS_INTERNAL;
+        const uint32_t caps = _psram ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : MALLOC_CAP_8BIT;
+        log.records = (TrendLogRecord*)heap_caps_malloc(cap * sizeof(TrendLogRecord), caps);
+        if (!log.records) {
+            Serial.printf("[BACnet] Trend log %lu: buffer allocation failed\n", (unsigned long)instance);
+            return false;
+        }
+        log.capacity = cap;
+    }
+
+    log.instance = instance;
+    memset(log.name, 0, sizeof(log.name));
+    strncpy(log.name, name ? name : "", sizeof(log.name) - 1);
+    log.monitoredType = monitoredType;
+    log.monitoredInstance = monitoredInstance;
+    log.loggingType = loggingType;
+    log.logIntervalMs = logIntervalMs ? logIntervalMs : 60000UL;
+    log.covIncrement = covIncrement;
+    log.enabled = true;
+    clear(&log);
+
+    if (index >= _count) _count = index + 1;
+    return true;
+}
+
+BACnetTrendLog* BACnetTrendLogStore::at(uint8_t index) {
+    if (index >= _count || !_logs[index].records) return nullptr;
+    return &_logs[index];
+}
+
+BACnetTrendLog* BACnetTrendLogStore::find(uint32_t instance) {
+    for (uint8_t i = 0; i < _count; i++) {
+        if (_logs[i].records && _logs[i].instance == instance) return &_logs[i];
+    }
+    return nullptr;
+}
+
+void BACnetTrendLogStore::clear(BACnetTrendLog* log) {
+    if (!log) return;
+    log->head = 0;
+    log->count = 0;
+    log->totalCount = 0;
+    log->invalidSeq = 0;
+    log->lastSampleMs = 0;
+    log->hasLast = false;
+}
+
+void BACnetTrendLogStore::sample(uint8_t objectType, uint32_t instance, float value, uint32_t nowMs) {
+    for (uint8_t i = 0; i < _count; i++) {
+        BACnetTrendLog& log = _logs[i];
+        if (!log.records || !log.enabled) continue;
+        if (log.monitoredType != objectType || log.monitoredInstance != instance) continue;
+
+        bool record = false;
+        if (log.loggingType == TRENDLOG_LOGGING_COV) {
+            if (!log.hasLast) {
+                record = true;
+            } else if (objectType == OBJECT_ANALOG_INPUT && log.covIncrement > 0.0f) {
+                record = fabsf(value - log.lastValue) >= log.covIncrement;
+            } else {
+                record = (value != log.lastValue);
+            }
+        } else {
+            record = !log.hasLast || (nowMs - log.lastSampleMs) >= log.logIntervalMs;
+        }
+
+        if (!record) continue;
+
+        append(log, value);
+        log.lastSampleMs = nowMs;
+        log.lastValue = value;
+        log.hasLast = true;
+    }
+}
+
+void BACnetTrendLogStore::append(BACnetTrendLog& log, float value) {
+    TrendLogRecord& r = log.records[log.head];
+    r.timestamp = timestampNow();
+    r.value = value;
+
+    log.head = (log.head + 1) % log.capacity;
+    if (log.count < log.capacity) log.count++;
+    log.totalCount++;
+    if (r.timestamp == TRENDLOG_TIME_INVALID) log.invalidSeq = log.totalCount;
+}
+
+bool BACnetTrendLogStore::recordAt(const BACnetTrendLog* log, uint32_t position, TrendLogRecord& out) const {
+    if (!log || position < 1 || position > log->count) return false;
+
+    // Oldest record sits at head when the ring is full, at 0 otherwise
+    const uint32_t oldest = (log->count < log->capacity) ? 0 : log->head;
+    out = log->records[(oldest + position - 1) % log->capacity];
+    return true;
+}
+
+uint32_t BACnetTrendLogStore::firstSequence(const BACnetTrendLog* log) const {
+    if (!log || log->count == 0) return 0;
+    return log->totalCount - log->count + 1;
+}
+
+bool BACnetTrendLogStore::hasInvalidTime(const BACnetTrendLog* log) const {
+    return log && log->count && log->invalidSeq >= firstSequence(log);
+}
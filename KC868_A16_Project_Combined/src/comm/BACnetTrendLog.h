@@ -0,0 +1,108 @@
+#ifndef BACNET_TREND_LOG_H
+#define BACNET_TREND_LOG_H
+
+#include <Arduino.h>
+
+/*
+ * KC868-A16 BACnet Trend Log storage
+ * ------------------------------------------------------------
+ * Fixed-record ring buffers backing Trend Log objects (type 20).
+ * Each log samples one AI/BI/BO present value either on a fixed
+ * interval (polled) or on change of value (COV). Buffers live in
+ * PSRAM when fitted, otherwise in a smaller internal-RAM ring.
+ *
+ * The BACnetDriver owns the protocol side (ReadProperty/ReadRange);
+ * this module only stores and indexes records.
+ */
+
+// --------------------------- Configuration ---------------------------
+#define BACNET_MAX_TREND_LOGS            8
+#define BACNET_TRENDLOG_RECORDS_PSRAM    8192      // ~64 KB per log in PSRAM
+#define BACNET_TRENDLOG_RECORDS_INTERNAL 256       // ~2 KB per log in internal RAM
+
+#define OBJECT_TREND_LOG                 20
+
+// Logging type (BACnetLoggingType)
+#define TRENDLOG_LOGGING_POLLED          0
+#define TRENDLOG_LOGGING_COV             1
+
+// One stored sample (8 bytes). Timestamp is UTC epoch seconds, or
+// TRENDLOG_TIME_INVALID when the sample was taken before either clock knew
+// the time; such records are skipped by ReadRange byTime.
+#define TRENDLOG_TIME_INVALID            0
+
+struct TrendLogRecord {
+    uint32_t timestamp;
+    float    value;
+};
+
+struct BACnetTrendLog {
+    uint32_t instance;
+    char     name[32];
+    uint8_t  monitoredType;        // OBJECT_ANALOG_INPUT / BINARY_INPUT / BINARY_OUTPUT
+    uint32_t monitoredInstance;
+    uint8_t  loggingType;          // TRENDLOG_LOGGING_*
+    uint32_t logIntervalMs;        // polled mode
+    float    covIncrement;         // COV mode (ignored for binary objects)
+    bool     enabled;
+
+    // Ring buffer
+    TrendLogRecord* records;
+    uint32_t capacity;
+    uint32_t head;                 // next write slot
+    uint32_t count;                // valid records (<= capacity)
+    uint32_t totalCount;           // records ever written (sequence number of newest)
+    uint32_t invalidSeq;           // sequence of the newest record without a time, 0 = none
+
+    // Sampling state
+    uint32_t lastSampleMs;
+    float    lastValue;
+    bool     hasLast;
+};
+
+class BACnetTrendLogStore {
+public:
+    BACnetTrendLogStore();
+
+    // Allocate buffers and install the default log set
+    bool begin();
+
+    // Define/replace a log slot (index 0..BACNET_MAX_TREND_LOGS-1)
+    bool configure(uint8_t index, uint32_t instance, const char* name,
+                   uint8_t monitoredType, uint32_t monitoredInstance,
+                   uint8_t loggingType, uint32_t logIntervalMs, float covIncrement);
+
+    // Feed the current value of an object; logs monitoring it decide whether to record
+    void sample(uint8_t objectType, uint32_t instance, float value, uint32_t nowMs);
+
+    // Lookup
+    uint8_t count() const { return _count; }
+    BACnetTrendLog* at(uint8_t index);
+    BACnetTrendLog* find(uint32_t instance);
+
+    // Record access by 1-based position (1 = oldest held record)
+    bool recordAt(const BACnetTrendLog* log, uint32_t position, TrendLogRecord& out) const;
+
+    // Sequence number of the oldest held record (newest is totalCount)
+    uint32_t firstSequence(const BACnetTrendLog* log) const;
+
+    // True when a held record has no valid time (records are then not
+    // guaranteed to be in time order)
+    bool hasInvalidTime(const BACnetTrendLog* log) const;
+
+    void clear(BACnetTrendLog* log);
+
+    bool inPsram() const { return _psram; }
+
+private:
+    BACnetTrendLog _logs[BACNET_MAX_TREND_LOGS];
+    uint8_t _count;
+    bool    _psram;
+
+    void append(BACnetTrendLog& log, float value);
+};
+
+// Global instance
+extern BACnetTrendLogStore bacnetTrendLogs;
+
+#endif // BACNET_TREND_LOG_H
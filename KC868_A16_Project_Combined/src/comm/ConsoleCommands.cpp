@@ -0,0 +1,569 @@
+// ConsoleCommands.cpp
+// Text command set shared by the USB serial, RS485 and web debug consoles
+//
+// The first word of a command selects its handler from a sorted table (binary
+// search), so dispatch does not grow with the number of commands; handlers get
+// the rest of the line. Words are matched case-sensitively, as before.
+
+#include "../FunctionPrototypes.h"
+
+typedef String (*ConsoleHandler)(const String& args);
+
+struct ConsoleCommand {
+    const char* name;
+    ConsoleHandler handler;
+};
+
+static String unknownCommand() {
+    return "ERROR: Unknown command. Type HELP for commands.";
+}
+
+static ConsoleHandler findCommand(const ConsoleCommand* table, size_t count, const char* name) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const int c = strcmp(name, table[mid].name);
+        if (c == 0) return table[mid].handler;
+        if (c < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return nullptr;
+}
+
+// Splits "WORD rest" and runs WORD's handler on rest
+static String dispatchCommand(const ConsoleCommand* table, size_t count, const String& command) {
+    const int sp = command.indexOf(' ');
+    const String word = (sp < 0) ? command : command.substring(0, sp);
+    String args = (sp < 0) ? String() : command.substring(sp + 1);
+    args.trim();
+
+    ConsoleHandler handler = findCommand(table, count, word.c_str());
+    return handler ? handler(args) : unknownCommand();
+}
+
+// ---- RELAY ----
+
+static String cmdRelay(const String& args) {
+    if (args.startsWith("STATUS")) {
+        // Return relay status
+        String response = "RELAY STATUS:\n";
+        for (int i = 0; i < 16; i++) {
+            response += String(i + 1) + " (Relay " + String(i + 1) + "): ";
+            response += outputStates[i] ? "ON" : "OFF";
+            response += "\n";
+        }
+        return response;
+    }
+    else if (args.startsWith("ALL ON")) {
+        // Turn all relays on
+        if (applyOutputsOnce(OUTPUT_SRC_CONSOLE, 0xFFFF, 0xFFFF)) {
+            broadcastUpdate();
+            return "All relays turned ON";
+        }
+        else {
+            return "ERROR: Failed to turn all relays ON";
+        }
+    }
+    else if (args.startsWith("ALL OFF")) {
+        // Turn all relays off
+        if (applyOutputsOnce(OUTPUT_SRC_CONSOLE, 0xFFFF, 0)) {
+            broadcastUpdate();
+            return "All relays turned OFF";
+        }
+        else {
+            return "ERROR: Failed to turn all relays OFF";
+        }
+    }
+    else {
+        // Individual relay control: RELAY <number> <ON|OFF>
+        int spacePos = args.indexOf(' ');
+        if (spacePos > 0) {
+            int relayNum = args.substring(0, spacePos).toInt();
+            String action = args.substring(spacePos + 1);
+
+            if (relayNum >= 1 && relayNum <= 16) {
+                int index = relayNum - 1;
+                if (action == "ON") {
+                    if (applyOutputsOnce(OUTPUT_SRC_CONSOLE, 1u << index, 0xFFFF)) {
+                        broadcastUpdate();
+                        return "Relay " + String(relayNum) + " turned ON";
+                    }
+                    else {
+                        return "ERROR: Failed to turn relay ON";
+                    }
+                }
+                else if (action == "OFF") {
+                    if (applyOutputsOnce(OUTPUT_SRC_CONSOLE, 1u << index, 0)) {
+                        broadcastUpdate();
+                        return "Relay " + String(relayNum) + " turned OFF";
+                    }
+                    else {
+                        return "ERROR: Failed to turn relay OFF";
+                    }
+                }
+            }
+        }
+    }
+
+    return "ERROR: Invalid relay command";
+}
+
+// ---- INPUT / ANALOG / COMM / SCAN ----
+
+static String cmdInput(const String& args) {
+    if (!args.startsWith("STATUS")) return unknownCommand();
+
+    // Return input status
+    String response = "INPUT STATUS:\n";
+    for (int i = 0; i < 16; i++) {
+        response += String(i + 1) + " (Input " + String(i + 1) + "): ";
+        response += inputStates[i] ? "HIGH" : "LOW";
+        response += "\n";
+    }
+    return response;
+}
+
+static String cmdAnalog(const String& args) {
+    if (!args.startsWith("STATUS")) return unknownCommand();
+
+    // Return analog input status with voltage values
+    String response = "ANALOG STATUS:\n";
+    for (int i = 0; i < 4; i++) {
+        response += String(i + 1) + " (Analog " + String(i + 1) + "): ";
+        response += String(analogValues[i]) + " (Raw), ";
+        response += String(analogVoltages[i], 2) + "V, ";
+        response += String(calculatePercentage(analogVoltages[i])) + "% (of 5V scale)";
+        response += "\n";
+    }
+    return response;
+}
+
+static String cmdComm(const String& args) {
+    if (!args.startsWith("STATUS")) return unknownCommand();
+
+    // Return communication status
+    String response = "COMMUNICATION STATUS:\n";
+    response += "Active Protocol: " + currentCommunicationProtocol + "\n";
+    response += "WiFi Connected: " + String(wifiConnected ? "Yes" : "No") + "\n";
+    response += "Ethernet Connected: " + String(ethConnected ? "Yes" : "No") + "\n";
+    response += "RS485 Available: Yes\n";
+    response += "USB Available: Yes\n";
+
+    // Add protocol-specific details
+    if (currentCommunicationProtocol == "wifi") {
+        response += "\nWIFI DETAILS:\n";
+        response += "SSID: " + wifiSSID + "\n";
+        response += "Security: " + wifiSecurity + "\n";
+        response += "Channel: " + String(wifiChannel) + "\n";
+        if (wifiConnected) {
+            response += "IP: " + WiFi.localIP().toString() + "\n";
+            response += "Signal: " + String(WiFi.RSSI()) + " dBm\n";
+        }
+    }
+    else if (currentCommunicationProtocol == "ethernet") {
+        response += "\nETHERNET DETAILS:\n";
+        if (ethConnected) {
+            response += "MAC: " + ETH.macAddress() + "\n";
+            response += "IP: " + ETH.localIP().toString() + "\n";
+            response += "Speed: " + String(ETH.linkSpeed()) + " Mbps\n";
+            response += "Duplex: " + String(ETH.fullDuplex() ? "Full" : "Half") + "\n";
+        }
+        else {
+            response += "Status: Disconnected\n";
+        }
+    }
+    else if (currentCommunicationProtocol == "rs485") {
+        response += "\nRS485 DETAILS:\n";
+        response += "Baud Rate: " + String(rs485BaudRate) + "\n";
+        response += "Protocol: " + rs485Protocol + "\n";
+        response += "Mode: " + rs485Mode + "\n";
+        response += "Address: " + String(rs485DeviceAddress) + "\n";
+    }
+    else if (currentCommunicationProtocol == "usb") {
+        response += "\nUSB DETAILS:\n";
+        response += "COM Port: " + String(usbComPort) + "\n";
+        response += "Baud Rate: " + String(usbBaudRate) + "\n";
+        response += "Data Bits: " + String(usbDataBits) + "\n";
+        response += "Parity: " + String(usbParity == 0 ? "None" : usbParity == 1 ? "Odd" : "Even") + "\n";
+        response += "Stop Bits: " + String(usbStopBits) + "\n";
+    }
+
+    return response;
+}
+
+static String cmdScan(const String& args) {
+    if (!args.startsWith("I2C")) return unknownCommand();
+
+    // Scan I2C bus
+    String response = "I2C DEVICES:\n";
+    int deviceCount = 0;
+
+    for (uint8_t address = 1; address < 127; address++) {
+        if (i2cProbe(address)) {
+            deviceCount++;
+            response += "0x" + String(address, HEX) + " - ";
+
+            // Identify known devices
+            if (address == PCF8574_INPUTS_1_8) {
+                response += "PCF8574 Inputs 1-8";
+            }
+            else if (address == PCF8574_INPUTS_9_16) {
+                response += "PCF8574 Inputs 9-16";
+            }
+            else if (address == PCF8574_OUTPUTS_1_8) {
+                response += "PCF8574 Outputs 1-8";
+            }
+            else if (address == PCF8574_OUTPUTS_9_16) {
+                response += "PCF8574 Outputs 9-16";
+            }
+            else if (address == RTC_I2C_ADDRESS) {
+                response += "DS3231 RTC";
+            }
+            else {
+                response += "Unknown device";
+            }
+
+            response += "\n";
+        }
+    }
+
+    response += "Found " + String(deviceCount) + " device(s)\n";
+    return response;
+}
+
+// ---- INTERRUPT <sub> ----
+
+static String cmdInterruptStatus(const String&) {
+    // Return interrupt configuration status
+    String response = "INTERRUPT CONFIGURATIONS:\n";
+    for (int i = 0; i < 16; i++) {
+        response += String(i + 1) + " (Input " + String(i + 1) + "): ";
+        response += interruptConfigs[i].enabled ? "Enabled" : "Disabled";
+        response += ", Priority: ";
+
+        switch (interruptConfigs[i].priority) {
+        case INPUT_PRIORITY_HIGH: response += "High"; break;
+        case INPUT_PRIORITY_MEDIUM: response += "Medium"; break;
+        case INPUT_PRIORITY_LOW: response += "Low"; break;
+        case INPUT_PRIORITY_NONE: response += "None (Polling)"; break;
+        default: response += "Unknown";
+        }
+
+        response += ", Trigger: ";
+        switch (interruptConfigs[i].triggerType) {
+        case INTERRUPT_TRIGGER_RISING: response += "Rising Edge"; break;
+        case INTERRUPT_TRIGGER_FALLING: response += "Falling Edge"; break;
+        case INTERRUPT_TRIGGER_CHANGE: response += "Change (Any Edge)"; break;
+        case INTERRUPT_TRIGGER_HIGH_LEVEL: response += "High Level"; break;
+        case INTERRUPT_TRIGGER_LOW_LEVEL: response += "Low Level"; break;
+        default: response += "Unknown";
+        }
+
+        response += "\n";
+    }
+    response += "\nInterrupt System: " + String(inputInterruptsEnabled ? "Active" : "Inactive");
+    return response;
+}
+
+static String cmdInterruptEnable(const String& args) {
+    int inputNum = args.toInt();
+    if (inputNum >= 1 && inputNum <= 16) {
+        int index = inputNum - 1;
+        interruptConfigs[index].enabled = true;
+        saveInterruptConfigs();
+
+        if (inputInterruptsEnabled) {
+            setupInputInterrupts(); // Reconfigure interrupts
+        }
+        else {
+            inputInterruptsEnabled = true; // Enable the interrupt system
+            setupInputInterrupts();
+        }
+
+        return "Interrupt enabled for input " + String(inputNum);
+    }
+    return "ERROR: Invalid input number. Must be between 1-16.";
+}
+
+static String cmdInterruptDisable(const String& args) {
+    int inputNum = args.toInt();
+    if (inputNum >= 1 && inputNum <= 16) {
+        int index = inputNum - 1;
+        interruptConfigs[index].enabled = false;
+        saveInterruptConfigs();
+
+        // Check if any interrupts are still enabled
+        bool anyEnabled = false;
+        for (int i = 0; i < 16; i++) {
+            if (interruptConfigs[i].enabled) {
+                anyEnabled = true;
+                break;
+            }
+        }
+
+        if (anyEnabled && inputInterruptsEnabled) {
+            setupInputInterrupts(); // Reconfigure interrupts
+        }
+        else if (!anyEnabled) {
+            disableInputInterrupts(); // Disable the entire interrupt system
+        }
+
+        return "Interrupt disabled for input " + String(inputNum);
+    }
+    return "ERROR: Invalid input number. Must be between 1-16.";
+}
+
+static String cmdInterruptPriority(const String& args) {
+    int spacePos = args.indexOf(' ');
+
+    if (spacePos > 0) {
+        int inputNum = args.substring(0, spacePos).toInt();
+        String priorityStr = args.substring(spacePos + 1);
+        priorityStr.toUpperCase();
+
+        uint8_t priority = INPUT_PRIORITY_MEDIUM; // Default medium
+        if (priorityStr == "HIGH") {
+            priority = INPUT_PRIORITY_HIGH;
+        }
+        else if (priorityStr == "MEDIUM") {
+            priority = INPUT_PRIORITY_MEDIUM;
+        }
+        else if (priorityStr == "LOW") {
+            priority = INPUT_PRIORITY_LOW;
+        }
+        else if (priorityStr == "NONE") {
+            priority = INPUT_PRIORITY_NONE;
+        }
+        else {
+            return "ERROR: Invalid priority. Use HIGH, MEDIUM, LOW, or NONE.";
+        }
+
+        if (inputNum >= 1 && inputNum <= 16) {
+            int index = inputNum - 1;
+            interruptConfigs[index].priority = priority;
+            saveInterruptConfigs();
+
+            if (inputInterruptsEnabled) {
+                setupInputInterrupts(); // Reconfigure interrupts
+            }
+
+            return "Priority for input " + String(inputNum) + " set to " + priorityStr;
+        }
+        return "ERROR: Invalid input number. Must be between 1-16.";
+    }
+    return "ERROR: Invalid format. Use INTERRUPT PRIORITY <input_num> <HIGH|MEDIUM|LOW|NONE>";
+}
+
+static String cmdInterruptTrigger(const String& args) {
+    int spacePos = args.indexOf(' ');
+
+    if (spacePos > 0) {
+        int inputNum = args.substring(0, spacePos).toInt();
+        String triggerStr = args.substring(spacePos + 1);
+        triggerStr.toUpperCase();
+
+        uint8_t triggerType = INTERRUPT_TRIGGER_CHANGE; // Default to change
+        if (triggerStr == "RISING" || triggerStr == "RISE") {
+            triggerType = INTERRUPT_TRIGGER_RISING;
+        }
+        else if (triggerStr == "FALLING" || triggerStr == "FALL") {
+            triggerType = INTERRUPT_TRIGGER_FALLING;
+        }
+        else if (triggerStr == "CHANGE" || triggerStr == "BOTH") {
+            triggerType = INTERRUPT_TRIGGER_CHANGE;
+        }
+        else if (triggerStr == "HIGH" || triggerStr == "HIGH_LEVEL") {
+            triggerType = INTERRUPT_TRIGGER_HIGH_LEVEL;
+        }
+        else if (triggerStr == "LOW" || triggerStr == "LOW_LEVEL") {
+            triggerType = INTERRUPT_TRIGGER_LOW_LEVEL;
+        }
+        else {
+            return "ERROR: Invalid trigger type. Use RISING, FALLING, CHANGE, HIGH_LEVEL, or LOW_LEVEL.";
+        }
+
+        if (inputNum >= 1 && inputNum <= 16) {
+            int index = inputNum - 1;
+            interruptConfigs[index].triggerType = triggerType;
+            saveInterruptConfigs();
+
+            if (inputInterruptsEnabled) {
+                setupInputInterrupts(); // Reconfigure interrupts
+            }
+
+            return "Trigger type for input " + String(inputNum) + " set to " + triggerStr;
+        }
+        return "ERROR: Invalid input number. Must be between 1-16.";
+    }
+    return "ERROR: Invalid format. Use INTERRUPT TRIGGER <input_num> <RISING|FALLING|CHANGE|HIGH_LEVEL|LOW_LEVEL>";
+}
+
+// Sorted by name
+static const ConsoleCommand interruptCommands[] = {
+    { "DISABLE", cmdInterruptDisable },
+    { "ENABLE", cmdInterruptEnable },
+    { "PRIORITY", cmdInterruptPriority },
+    { "STATUS", cmdInterruptStatus },
+    { "TRIGGER", cmdInterruptTrigger },
+};
+
+static String cmdInterrupt(const String& args) {
+    return dispatchCommand(interruptCommands, sizeof(interruptCommands) / sizeof(interruptCommands[0]), args);
+}
+
+// ---- System ----
+
+static String cmdStatus(const String&) {
+    // Return system status
+    String response = "KC868-A16 System Status\n";
+    response += "---------------------\n";
+    response += "Device: " + deviceName + "\n";
+    response += "Firmware: " + firmwareVersion + "\n";
+    response += "Uptime: " + String(millis() / 1000) + " seconds\n";
+
+    if (wifiConnected) {
+        response += "WiFi: Connected, IP: " + WiFi.localIP().toString() + "\n";
+    }
+    else {
+        response += "WiFi: Not connected\n";
+    }
+
+    if (ethConnected) {
+        response += "Ethernet: Connected, IP: " + ETH.localIP().toString() + "\n";
+    }
+    else {
+        response += "Ethernet: Not connected\n";
+    }
+
+    response += "Active Protocol: " + currentCommunicationProtocol + "\n";
+    response += "I2C errors: " + String(i2cErrorCount) + "\n";
+    response += "RTC available: " + String(rtcInitialized ? "Yes" : "No") + "\n";
+    response += "Current time: " + getTimeString() + "\n";
+    response += "Free heap: " + String(ESP.getFreeHeap()) + " bytes\n";
+
+    // Add analog inputs status with voltage values
+    response += "\nAnalog Inputs (0-5V range):\n";
+    for (int i = 0; i < 4; i++) {
+        response += "A" + String(i + 1) + ": ";
+        response += String(analogValues[i]) + " (Raw), ";
+        response += String(analogVoltages[i], 2) + "V, ";
+        response += String(calculatePercentage(analogVoltages[i])) + "%\n";
+    }
+
+    // Add interrupt status summary
+    response += "\nInterrupt System: " + String(inputInterruptsEnabled ? "Active" : "Inactive") + "\n";
+    int highCount = 0, medCount = 0, lowCount = 0, noneCount = 0;
+    for (int i = 0; i < 16; i++) {
+        if (!interruptConfigs[i].enabled) continue;
+
+        switch (interruptConfigs[i].priority) {
+        case INPUT_PRIORITY_HIGH: highCount++; break;
+        case INPUT_PRIORITY_MEDIUM: medCount++; break;
+        case INPUT_PRIORITY_LOW: lowCount++; break;
+        case INPUT_PRIORITY_NONE: noneCount++; break;
+        }
+    }
+    response += "Configured interrupts: High=" + String(highCount) +
+        ", Med=" + String(medCount) +
+        ", Low=" + String(lowCount) +
+        ", Polling=" + String(noneCount) + "\n";
+
+    return response;
+}
+
+static String cmdHelp(const String&) {
+    // Return help information
+    String response = "KC868-A16 Controller Command Help\n";
+    response += "---------------------\n";
+    response += "RELAY STATUS - Show all relay states\n";
+    response += "RELAY ALL ON - Turn all relays on\n";
+    response += "RELAY ALL OFF - Turn all relays off\n";
+    response += "RELAY <num> ON - Turn relay on (1-16)\n";
+    response += "RELAY <num> OFF - Turn relay off (1-16)\n";
+    response += "INPUT STATUS - Show all input states\n";
+    response += "INTERRUPT STATUS - Show interrupt configurations\n";
+    response += "ANALOG STATUS - Show all analog input values\n";
+    response += "COMM STATUS - Show communication interface status\n";
+    response += "SCAN I2C - Scan for I2C devices\n";
+    response += "STATUS - Show system status\n";
+    response += "DEBUG ON - Enable debug mode\n";
+    response += "DEBUG OFF - Disable debug mode\n";
+    response += "SET TIME <yyyy-mm-dd hh:mm:ss> - Set system time\n";
+    response += "INTERRUPT ENABLE <num> - Enable interrupt for input (1-16)\n";
+    response += "INTERRUPT DISABLE <num> - Disable interrupt for input (1-16)\n";
+    response += "INTERRUPT PRIORITY <num> <priority> - Set input interrupt priority (HIGH/MEDIUM/LOW/NONE)\n";
+    response += "INTERRUPT TRIGGER <num> <type> - Set input trigger type (RISING/FALLING/CHANGE/HIGH_LEVEL/LOW_LEVEL)\n";
+    response += "REBOOT - Restart the system\n";
+    response += "VERSION - Show firmware version\n";
+
+    return response;
+}
+
+static String cmdSet(const String& args) {
+    if (!args.startsWith("TIME ")) return unknownCommand();
+    String timeStr = args.substring(5);
+
+    // Format should be "yyyy-mm-dd hh:mm:ss"
+    if (timeStr.length() == 19) {
+        int year = timeStr.substring(0, 4).toInt();
+        int month = timeStr.substring(5, 7).toInt();
+        int day = timeStr.substring(8, 10).toInt();
+        int hour = timeStr.substring(11, 13).toInt();
+        int minute = timeStr.substring(14, 16).toInt();
+        int second = timeStr.substring(17, 19).toInt();
+
+        if (year >= 2023 && month >= 1 && month <= 12 && day >= 1 && day <= 31 &&
+            hour >= 0 && hour <= 23 && minute >= 0 && minute <= 59 && second >= 0 && second <= 59) {
+
+            syncTimeFromClient(year, month, day, hour, minute, second);
+            return "Time set successfully: " + getTimeString();
+        }
+    }
+
+    return "ERROR: Invalid time format. Use SET TIME yyyy-mm-dd hh:mm:ss";
+}
+
+static String cmdDebug(const String& args) {
+    if (args == "ON") {
+        debugMode = true;
+        return "Debug mode enabled";
+    }
+    if (args == "OFF") {
+        debugMode = false;
+        return "Debug mode disabled";
+    }
+    return unknownCommand();
+}
+
+static String cmdVersion(const String&) {
+    return "KC868-A16 Controller firmware version " + firmwareVersion;
+}
+
+static String cmdReboot(const String&) {
+    String response = "Rebooting system...";
+    delay(100);
+    ESP.restart();
+    return response;
+}
+
+// Sorted by name (findCommand() binary-searches it)
+static const ConsoleCommand consoleCommands[] = {
+    { "ANALOG", cmdAnalog },
+    { "COMM", cmdComm },
+    { "DEBUG", cmdDebug },
+    { "HELP", cmdHelp },
+    { "INPUT", cmdInput },
+    { "INTERRUPT", cmdInterrupt },
+    { "REBOOT", cmdReboot },
+    { "RELAY", cmdRelay },
+    { "SCAN", cmdScan },
+    { "SET", cmdSet },
+    { "STATUS", cmdStatus },
+    { "VERSION", cmdVersion },
+};
+
+String processCommand(String command) {
+    command.trim();
+    return dispatchCommand(consoleCommands, sizeof(consoleCommands) / sizeof(consoleCommands[0]), command);
+}
@@ -0,0 +1,33 @@
+// LineReader.cpp
+// Incremental console line assembly (see LineReader.h)
+
+#include "LineReader.h"
+
+bool LineReader::feed(char c) {
+    // The previous line has been consumed by now
+    if (_ready) reset();
+
+    if (c == '\r' || c == '\n') {
+        // Trim trailing blanks; a blank line is not a command
+        while (_len > 0 && _buf[_len - 1] == ' ') _len--;
+        if (_len == 0 && !_overflow) return false;
+        _buf[_len] = '\0';
+        _ready = true;
+        return true;
+    }
+    if (c == 0x08 || c == 0x7F) {
+        if (_len > 0 && !_overflow) _len--;
+        return false;
+    }
+    if (_len == 0 && (c == ' ' || c == '\t')) return false;
+    if (_len < sizeof(_buf) - 1) _buf[_len++] = c;
+    else _overflow = true;
+    return false;
+}
+
+bool LineReader::poll(Stream& in) {
+    while (in.available()) {
+        if (feed((char)in.read())) return true;
+    }
+    return false;
+}
@@ -0,0 +1,45 @@
+#pragma once
+/**
+ * LineReader.h
+ * Assembles console commands from a byte stream without waiting for them.
+ *
+ * Each console (USB serial, RS485) owns one reader and polls it from the loop;
+ * poll() only takes the bytes already received, so a half-sent command is kept
+ * for the next call instead of stalling in readStringUntil():
+ *
+ *   static LineReader reader;
+ *   while (reader.poll(Serial)) {
+ *       if (reader.overflowed()) ... reject
+ *       String response = processCommand(reader.line());
+ *       ...
+ *   }
+ *
+ * '\r' or '\n' ends a line, empty lines are skipped and backspace/DEL edit
+ * the pending line. A line longer than CONSOLE_LINE_MAX - 1 comes back marked
+ * overflowed(); it must be rejected, never run truncated.
+ */
+
+#include <Arduino.h>
+
+#define CONSOLE_LINE_MAX 384
+
+class LineReader {
+public:
+    LineReader() : _len(0), _ready(false), _overflow(false) {}
+
+    // Reads what is available; true when line() holds a complete command
+    bool poll(Stream& in);
+
+    // Same, one byte at a time (for ports that share bytes with another protocol)
+    bool feed(char c);
+
+    const char* line() const { return _buf; }
+    bool overflowed() const { return _overflow; }
+    void reset() { _len = 0; _ready = false; _overflow = false; }
+
+private:
+    char _buf[CONSOLE_LINE_MAX];
+    size_t _len;
+    bool _ready;
+    bool _overflow;     // bytes were dropped from the pending line
+};
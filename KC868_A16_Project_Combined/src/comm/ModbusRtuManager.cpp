@@ -54,6 +54,7 @@ static const uint16_t HR_OUTMASK_CUR    = 302;   // 40303 (RO mirror)
 static const uint16_t HR_INMASK_CUR     = 303;   // 40304 (RO mirror)
 static const uint16_t HR_ANALOG_SCALE_START = 310; // 40311.. (8 regs = 4 floats)
 static const uint16_t HR_ANALOG_OFFSET_START = 318; // 40319.. (8 regs = 4 floats)
+static const uint16_t HR_LOGIC_REG_START = 400;     // 40401..40432 logic R0..R31 (RW)
 
 static const uint16_t HR_CMD_ARM        = 609;   // 40610
 static const uint16_t HR_CMD_CODE       = 610;   // 40611
@@ -95,11 +96,35 @@ static const uint16_t IR_OUTMASK = 39;        // 30040
 static const uint16_t IR_INMASK = 40;         // 30041
 static const uint16_t IR_DIRECTMASK = 41;     // 30042
 static const uint16_t IR_SYSFLAGS = 42;       // 30043
+static const uint16_t IR_HEAP_MIN_LO = 43;    // 30044
+static const uint16_t IR_HEAP_MIN_HI = 44;    // 30045
+static const uint16_t IR_HEAP_LARGEST_LO = 45;      // 30046
+static const uint16_t IR_HEAP_LARGEST_HI = 46;      // 30047
+static const uint16_t IR_HEAP_LARGEST_MIN_LO = 47;  // 30048
+static const uint16_t IR_HEAP_LARGEST_MIN_HI = 48;  // 30049
+static const uint16_t IR_HEAP_FRAG_PCT = 49;  // 30050
+static const uint16_t IR_STACK_FREE_START = 50;     // 30051..52 (loop, http task), bytes
+static const uint16_t IR_LOGIC_SCAN_US = 52;        // 30053 last logic scan, us
+static const uint16_t IR_LOGIC_SCAN_MAX_US = 53;    // 30054
+static const uint16_t IR_LOGIC_SCANS_LO = 54;       // 30055
+static const uint16_t IR_LOGIC_SCANS_HI = 55;       // 30056
+static const uint16_t IR_LOGIC_OVERRUNS = 56;       // 30057
+static const uint16_t IR_EVENT_OLDEST_LO = 57;      // 30058 event journal, oldest seq held
+static const uint16_t IR_EVENT_OLDEST_HI = 58;      // 30059
+static const uint16_t IR_EVENT_NEWEST_LO = 59;      // 30060 newest seq written
+static const uint16_t IR_EVENT_NEWEST_HI = 60;      // 30061
+
+// Event journal as file records (FC20): file f, register r holds word r % 8
+// of event seq (f - 1) * EVENT_MODBUS_FILE_EVENTS + r / 8. Missing events read as 0.
+//   0/1 seq (lo, hi)   2/3 unix time (lo, hi)   4 type << 8 | source
+//   5 subject << 8 | value   6 arg   7 reserved
+static const uint16_t EVENT_REGS = 8;
 
 // Coils (0-based)
 static const uint16_t COIL_DO_START = 0;      // 00001..00016
 static const uint16_t COIL_MASTER_ENABLE = 18; // 00019
 static const uint16_t COIL_NIGHT_MODE = 19;    // 00020
+static const uint16_t COIL_LOGIC_BIT_START = 100; // 00101..00164 logic M0..M63
 
 // Discrete inputs (0-based)
 static const uint16_t DI_MAIN_START = 0;      // 10001..10016
@@ -131,8 +156,9 @@ static bool g_lastMasterEnable = true;
 static bool g_lastNightMode = false;
 
 
-// Snapshot of DO coil image to detect external Modbus writes vs local/web changes
-static bool g_lastDoCoils[16] = { false };
+// Same for the logic engine's M bits and R registers
+static bool g_lastLogicCoils[LOGIC_BITS] = { false };
+static int16_t g_lastLogicRegs[LOGIC_REGS] = { 0 };
 // For detecting holding-reg edits
 static uint16_t lastApplySaveValue = 0;
 static uint16_t lastCmdArm = 0;
@@ -295,34 +321,21 @@ static uint16_t buildSysFlags() {
     return f;
 }
 
-static void applyOutputsFromCoils() {
-    if (!outputsMasterEnable) {
-        // Force all outputs OFF
-        bool any = false;
-        for (int i = 0; i < 16; i++) {
-            if (outputStates[i]) { outputStates[i] = false; any = true; }
-        }
-        if (any) writeOutputs();
-        return;
-    }
+// FC05/FC15 on 00001..00016: a command to the output manager, applied with
+// the loop's output flush. Ignored (coil keeps the real state) while outputs
+// are disabled.
+static uint16_t onDoCoilWrite(TRegister* reg, uint16_t val) {
+    const uint16_t i = reg->address.address - COIL_DO_START;
+    if (i >= 16 || !outputsMasterEnable) return COIL_VAL(i < 16 && outputStates[i]);
 
-    bool changed = false;
-    for (int i = 0; i < 16; i++) {
-        bool desired = mb.Coil(COIL_DO_START + i);
-        g_lastDoCoils[i] = desired;
-        if (outputStates[i] != desired) {
-            outputStates[i] = desired;
-            changed = true;
-        }
-    }
-    if (changed) writeOutputs();
+    commandOutputs(OUTPUT_SRC_MODBUS, outputSourcePriority(OUTPUT_SRC_MODBUS), 1u << i, COIL_BOOL(val) ? 0xFFFF : 0);
+    return val;
 }
 
 static void syncCoilsToOutputs() {
-    // Keep coil image reflecting desired/actual output states.
+    // Coil image shows the arbitrated output states
     for (int i = 0; i < 16; i++) {
         mb.Coil(COIL_DO_START + i, outputStates[i]);
-        g_lastDoCoils[i] = outputStates[i];
     }
 }
 
@@ -337,20 +350,7 @@ static void applyOutmaskWriteIfNeeded() {
 
     // Apply mask bits
     if (!outputsMasterEnable) return;
-    bool changed = false;
-    for (int i = 0; i < 16; i++) {
-        if ((m >> i) & 1u) {
-            bool desired = ((w >> i) & 1u) != 0;
-            if (outputStates[i] != desired) {
-                outputStates[i] = desired;
-                changed = true;
-            }
-        }
-    }
-    if (changed) {
-        writeOutputs();
-        syncCoilsToOutputs();
-    }
+    commandOutputs(OUTPUT_SRC_MODBUS, outputSourcePriority(OUTPUT_SRC_MODBUS), m, w);
 }
 
 static void handleApplySaveSerialSettings() {
@@ -610,6 +610,14 @@ static void refreshInputRegisters() {
     // Diagnostics
     mb.Ireg(IR_LAST_ERROR, 0);
     setU32Ireg(IR_FREE_HEAP_LO, (uint32_t)ESP.getFreeHeap());
+    setU32Ireg(IR_HEAP_MIN_LO, heapStats.minFreeBytes);
+    setU32Ireg(IR_HEAP_LARGEST_LO, heapStats.largestBlock);
+    setU32Ireg(IR_HEAP_LARGEST_MIN_LO, heapStats.largestBlockMin);
+    mb.Ireg(IR_HEAP_FRAG_PCT, heapStats.fragmentationPct);
+    for (uint8_t i = 0; i < 2; i++) {
+        uint32_t stackFree = (i < heapStats.taskCount) ? heapStats.tasks[i].stackFreeMin : 0;
+        mb.Ireg(IR_STACK_FREE_START + i, (uint16_t)min(stackFree, (uint32_t)0xFFFF));
+    }
     mb.Ireg(IR_CPU_FREQ, (uint16_t)getCpuFrequencyMhz());
 
     // AI raw + mv (apply calibration floats to mv)
@@ -654,8 +662,8 @@ static void refreshInputRegisters() {
     mb.Ireg(IR_SENSOR_STATUS, ss);
 
     // RTC
-    if (rtcInitialized) {
-        DateTime nowdt = rtc.now();
+    DateTime nowdt;
+    if (readRtc(nowdt)) {
         uint32_t unixs = (uint32_t)nowdt.unixtime();
         setU32Ireg(IR_RTC_UNIX_LO, unixs);
         mb.Ireg(IR_RTC_YEAR, (uint16_t)nowdt.year());
@@ -700,15 +708,98 @@ static void refreshInputRegisters() {
     }
 }
 
+// Logic M bits / R registers: a master write wins over the program that scan
+static void syncLogicPoints() {
+    for (uint8_t i = 0; i < LOGIC_BITS; i++) {
+        bool coil = mb.Coil(COIL_LOGIC_BIT_START + i);
+        if (coil != g_lastLogicCoils[i]) {
+            setLogicBit(i, coil);
+            g_lastLogicCoils[i] = coil;
+        } else if (logicBit(i) != coil) {
+            mb.Coil(COIL_LOGIC_BIT_START + i, logicBit(i));
+            g_lastLogicCoils[i] = logicBit(i);
+        }
+    }
+
+    for (uint8_t i = 0; i < LOGIC_REGS; i++) {
+        int16_t reg = (int16_t)mb.Hreg(HR_LOGIC_REG_START + i);
+        if (reg != g_lastLogicRegs[i]) {
+            setLogicReg(i, reg);
+            g_lastLogicRegs[i] = reg;
+        } else if (logicReg(i) != reg) {
+            mb.Hreg(HR_LOGIC_REG_START + i, (uint16_t)logicReg(i));
+            g_lastLogicRegs[i] = logicReg(i);
+        }
+    }
+
+    const LogicStats& st = logicStats();
+    mb.Ireg(IR_LOGIC_SCAN_US, (uint16_t)min(st.lastUs, (uint32_t)0xFFFF));
+    mb.Ireg(IR_LOGIC_SCAN_MAX_US, (uint16_t)min(st.maxUs, (uint32_t)0xFFFF));
+    setU32Ireg(IR_LOGIC_SCANS_LO, st.scans);
+    mb.Ireg(IR_LOGIC_OVERRUNS, (uint16_t)min(st.overruns, (uint32_t)0xFFFF));
+}
+
+static void refreshEventLogRegs() {
+    uint32_t oldest = 0, newest = 0;
+    if (!eventLogRange(oldest, newest)) oldest = newest = 0;
+    setU32Ireg(IR_EVENT_OLDEST_LO, oldest);
+    setU32Ireg(IR_EVENT_NEWEST_LO, newest);
+}
+
+#if defined(MODBUS_FILES)
+static Modbus::ResultCode onEventFile(Modbus::FunctionCode fc, uint16_t fileNum, uint16_t recNumber,
+                                      uint16_t recLength, uint8_t* frame) {
+    if (fc != Modbus::FC_READ_FILE_REC) return Modbus::EX_ILLEGAL_FUNCTION;
+    if (fileNum == 0 || (uint32_t)recNumber + recLength > EVENT_MODBUS_FILE_EVENTS * EVENT_REGS) {
+        return Modbus::EX_ILLEGAL_ADDRESS;
+    }
+
+    EventRecord r;
+    uint32_t loaded = 0;        // seq currently in r, 0 = none
+    for (uint16_t i = 0; i < recLength; i++) {
+        const uint16_t reg = recNumber + i;
+        const uint32_t seq = (uint32_t)(fileNum - 1) * EVENT_MODBUS_FILE_EVENTS + reg / EVENT_REGS;
+        if (seq != loaded) {
+            if (!readEvent(seq, r)) memset(&r, 0, sizeof(r));
+            loaded = seq;
+        }
+
+        uint16_t word = 0;
+        switch (reg % EVENT_REGS) {
+        case 0: word = (uint16_t)r.seq; break;
+        case 1: word = (uint16_t)(r.seq >> 16); break;
+        case 2: word = (uint16_t)r.time; break;
+        case 3: word = (uint16_t)(r.time >> 16); break;
+        case 4: word = (uint16_t)((r.type << 8) | r.source); break;
+        case 5: word = (uint16_t)((r.subject << 8) | r.value); break;
+        case 6: word = r.arg; break;
+        default: break;
+        }
+        frame[i * 2] = (uint8_t)(word >> 8);
+        frame[i * 2 + 1] = (uint8_t)word;
+    }
+    return Modbus::EX_SUCCESS;
+}
+#endif
+
 void initModbusRtu() {
     // Create map memory
-    mb.addCoil(0, false, 20);   // 00001..00020 (includes reserved)
+    mb.addCoil(0, false, 164);  // 00001..00164 (includes reserved)
     mb.addIsts(0, false, 24);   // 10001..10024
-    mb.addIreg(0, 0, 43);       // 30001..30043
+    mb.addIreg(0, 0, 61);       // 30001..30061
     mb.addHreg(0, 0, 617);      // 40001..40617 (offset 0..616)
+    mb.onSetCoil(COIL_DO_START, onDoCoilWrite, 16);
 
     // Set initial coils
     syncCoilsToOutputs();
+    for (uint8_t i = 0; i < LOGIC_BITS; i++) {
+        g_lastLogicCoils[i] = logicBit(i);
+        mb.Coil(COIL_LOGIC_BIT_START + i, g_lastLogicCoils[i]);
+    }
+    for (uint8_t i = 0; i < LOGIC_REGS; i++) {
+        g_lastLogicRegs[i] = logicReg(i);
+        mb.Hreg(HR_LOGIC_REG_START + i, (uint16_t)g_lastLogicRegs[i]);
+    }
     mb.Coil(COIL_MASTER_ENABLE, outputsMasterEnable);
     mb.Coil(COIL_NIGHT_MODE, rs485NightMode);
 
@@ -724,6 +815,19 @@ void initModbusRtu() {
     mb.begin(&rs485);
     mb.slave((uint8_t)rs485DeviceAddress);
 
+    // Request counters for /metrics (requests minus successes = exception replies)
+    mb.onRequest([](Modbus::FunctionCode fc, const Modbus::RequestData) {
+        metrics.modbusRequests[((uint8_t)fc <= 16) ? (uint8_t)fc : 0]++;
+        return Modbus::EX_SUCCESS;
+    });
+    mb.onRequestSuccess([](Modbus::FunctionCode, const Modbus::RequestData) {
+        metrics.modbusSuccess++;
+        return Modbus::EX_SUCCESS;
+    });
+#if defined(MODBUS_FILES)
+    mb.onFile(onEventFile);
+#endif
+
     modbusRtuActive = true;
     g_running = true;
 
@@ -736,33 +840,19 @@ void initModbusRtu() {
 void taskModbusRtu() {
     if (!g_running) return;
 
-    // First process Modbus frames (this updates coil/register memory on writes)
+    // Coils show the current outputs before any request reads them; writes to
+    // them reach the output manager through onDoCoilWrite()
+    syncCoilsToOutputs();
+
+    // Process Modbus frames (this updates coil/register memory on writes)
     mb.task();
 
-    // --- Bidirectional sync between Modbus coils and local output state ---
-    // Rule:
-    //  - If coil image changed since last snapshot => treat as external Modbus write, apply to outputs.
-    //  - Else if local outputs changed => push local state into coil image (so web/UI won't be reverted).
-    //
-    // Master enable
+    // --- Master enable / night mode: coil written by the master vs local change ---
     bool coilME = mb.Coil(COIL_MASTER_ENABLE);
     if (coilME != g_lastMasterEnable) {
-        // External write via Modbus
+        // External write via Modbus; the output manager holds outputs off while disabled
         g_lastMasterEnable = coilME;
         outputsMasterEnable = coilME;
-
-        if (!outputsMasterEnable) {
-            bool any = false;
-            for (int i = 0; i < 16; i++) {
-                if (outputStates[i]) { outputStates[i] = false; any = true; }
-            }
-            if (any) writeOutputs();
-            // Keep coil image consistent
-            syncCoilsToOutputs();
-        } else {
-            // When enabling, apply current coil image to outputs
-            applyOutputsFromCoils();
-        }
     } else if (outputsMasterEnable != g_lastMasterEnable) {
         // Local change (e.g., web/UI) - reflect into coil image
         mb.Coil(COIL_MASTER_ENABLE, outputsMasterEnable);
@@ -779,42 +869,7 @@ void taskModbusRtu() {
         g_lastNightMode = rs485NightMode;
     }
 
-    // Digital outputs (00001..00016)
-    if (!outputsMasterEnable) {
-        // Force OFF and keep coil image OFF if disabled
-        bool any = false;
-        for (int i = 0; i < 16; i++) {
-            if (outputStates[i]) { outputStates[i] = false; any = true; }
-            if (g_lastDoCoils[i] != false) g_lastDoCoils[i] = false;
-            mb.Coil(COIL_DO_START + i, false);
-        }
-        if (any) writeOutputs();
-    } else {
-        bool needWrite = false;
-
-        for (int i = 0; i < 16; i++) {
-            bool coil = mb.Coil(COIL_DO_START + i);
-
-            if (coil != g_lastDoCoils[i]) {
-                // External Modbus write -> apply to outputs
-                g_lastDoCoils[i] = coil;
-                if (outputStates[i] != coil) {
-                    outputStates[i] = coil;
-                    needWrite = true;
-                }
-            } else if (outputStates[i] != g_lastDoCoils[i]) {
-                // Local/web change -> push to coil image
-                mb.Coil(COIL_DO_START + i, outputStates[i]);
-                g_lastDoCoils[i] = outputStates[i];
-            }
-        }
-
-        if (needWrite) {
-            writeOutputs();
-        }
-    }
-
-    // Apply outmask write helper (also syncs coils->outputs as needed)
+    // Outmask write helper (40301/40302), a command like a coil write
     applyOutmaskWriteIfNeeded();
 
     // Process holding-reg edits
@@ -823,6 +878,8 @@ void taskModbusRtu() {
     handleMacRw();
     handleApplySaveSerialSettings();
     handleSafeCommands();
+    syncLogicPoints();
+    refreshEventLogRegs();
 
     // Keep identity + snapshot updated (also overwrites any attempted writes to RO fields)
     refreshIdentityHoldingRegs();
@@ -2,6 +2,7 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../FunctionPrototypes.h"
+#include "BACnetIntegration.h"
 
 #include "Network.h"
 #include "esp_mac.h"
@@ -24,6 +25,19 @@ static uint8_t  g_dhcpKicks = 0;
 
 static bool g_networkEventsReady = false;
 
+// Non-blocking WiFi reconnect after a dropped STA connection (see serviceWiFiReconnect)
+static uint8_t  g_wifiReconnectAttempts = 0;
+static uint32_t g_wifiReconnectAtMs = 0;
+static bool     g_wifiEventsReady = false;
+
+// Connectivity manager: Ethernet is the primary uplink, WiFi STA the fallback.
+// With NET_WIFI_STANDBY the STA stays associated while Ethernet carries the
+// traffic, so losing the cable only moves the default route and re-binds
+// BACnet instead of starting a WiFi association from scratch.
+static uint8_t  g_uplink = UPLINK_NONE;
+static uint32_t g_uplinkLostAtMs = 0;       // 0 = no failover in progress
+static NetFailoverStats g_failover = {};
+
 static bool parseMac(const char *s, uint8_t mac[6]) {
     auto hexVal = [](char c)->int {
         if (c >= '0' && c <= '9') return c - '0';
@@ -211,9 +225,11 @@ static void configureLinkLocal() {
     printEthInfo("LINK-LOCAL");
 
     broadcastUpdate();
+    updateUplink();
 }
 
-// WARNING: called from another task
+// Runs in the ESP-IDF event task: only driver setup that has to happen before
+// the interface comes up is done here; state changes go through the state bus
 void onEthEvent(arduino_event_id_t event) {
     switch (event) {
         case ARDUINO_EVENT_ETH_START:
@@ -224,6 +240,22 @@ void onEthEvent(arduino_event_id_t event) {
     presetWiFiMacsNetifOnly();
             break;
 
+        case ARDUINO_EVENT_ETH_CONNECTED:
+        case ARDUINO_EVENT_ETH_GOT_IP:
+        case ARDUINO_EVENT_ETH_LOST_IP:
+        case ARDUINO_EVENT_ETH_DISCONNECTED:
+        case ARDUINO_EVENT_ETH_STOP:
+            postStateEvent(STATE_EVENT_ETH, (uint16_t)event, millis());
+            break;
+
+        default:
+            break;
+    }
+}
+
+// Main loop (via serviceStateBus)
+void applyEthEvent(arduino_event_id_t event, uint32_t atMs) {
+    switch (event) {
         case ARDUINO_EVENT_ETH_CONNECTED:
             Serial.println("[ETH] Link UP");
             g_linkUp = true;
@@ -254,12 +286,14 @@ void onEthEvent(arduino_event_id_t event) {
             ethConnected = true;
             wiredMode = true;
 
+#if !NET_WIFI_STANDBY
             // If Ethernet connected, disable WiFi client mode (but keep AP if active)
             if (wifiClientMode && !apMode) {
                 WiFi.disconnect();
                 wifiClientMode = false;
                 wifiConnected = false;
             }
+#endif
 
             mac = ETH.macAddress();
             broadcastUpdate();
@@ -270,6 +304,7 @@ void onEthEvent(arduino_event_id_t event) {
             Serial.println("[ETH] Lost IP");
             g_gotDhcpIp = false;
             ethConnected = false; // no usable IP
+            if (g_uplink == UPLINK_ETH && !g_uplinkLostAtMs) g_uplinkLostAtMs = atMs;
             broadcastUpdate();
             break;
 
@@ -280,6 +315,7 @@ void onEthEvent(arduino_event_id_t event) {
             g_usingLinkLocal = false;
             ethConnected = false;
             wiredMode = false;
+            if (g_uplink == UPLINK_ETH && !g_uplinkLostAtMs) g_uplinkLostAtMs = atMs;
             broadcastUpdate();
             break;
 
@@ -290,12 +326,15 @@ void onEthEvent(arduino_event_id_t event) {
             g_usingLinkLocal = false;
             ethConnected = false;
             wiredMode = false;
+            if (g_uplink == UPLINK_ETH && !g_uplinkLostAtMs) g_uplinkLostAtMs = atMs;
             broadcastUpdate();
             break;
 
         default:
             break;
     }
+
+    updateUplink();
 }
 
 void serviceEthernetDhcp() {
@@ -322,12 +361,17 @@ void serviceEthernetDhcp() {
         wiredMode = true;
         mac = ETH.macAddress();
         broadcastUpdate();
+        updateUplink();
     }
 }
 
-void initWiFi() {
+// Brings the STA up and starts associating; does not wait for the result
+static void beginWiFiStation() {
     // Register event handler
-    WiFi.onEvent(WiFiEvent);
+    if (!g_wifiEventsReady) {
+        WiFi.onEvent(WiFiEvent);
+        g_wifiEventsReady = true;
+    }
 
     // Configure WiFi in STA mode
     WiFi.mode(WIFI_STA);
@@ -346,14 +390,21 @@ void initWiFi() {
         WiFi.config(wifiStaIp, wifiStaGateway, wifiStaSubnet, wifiStaDns1, wifiStaDns2);
     }
 
-    // Attempt to connect if credentials exist
     if (wifiSSID.length() > 0) {
         WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
         debugPrintln("Connecting to WiFi SSID: " + wifiSSID);
+    }
+}
+
+void initWiFi() {
+    beginWiFiStation();
 
+    // Wait if credentials exist
+    if (wifiSSID.length() > 0) {
         // Wait for connection with timeout
         int connectionAttempts = 0;
         while (WiFi.status() != WL_CONNECTED && connectionAttempts < 20) {
+            serviceStateBus();
             delay(500);
             Serial.print(".");
             connectionAttempts++;
@@ -403,6 +454,109 @@ void startAPMode() {
 
     // Start DNS server for captive portal
     dnsServer.start(53, "*", WiFi.softAPIP());
+
+    updateUplink();
+}
+
+// Ethernet came up at boot: associate the STA in the background so it is
+// ready to take over (NET_WIFI_STANDBY)
+void startWiFiStandby() {
+#if NET_WIFI_STANDBY
+    if (wifiSSID.length() == 0) return;
+    debugPrintln("WiFi standby: associating behind Ethernet");
+    beginWiFiStation();
+#endif
+}
+
+// Lower is preferred, in pickUplink() order
+static uint8_t uplinkRank(uint8_t uplink) {
+    switch (uplink) {
+    case UPLINK_ETH: return 0;
+    case UPLINK_WIFI: return 1;
+    case UPLINK_AP: return 2;
+    default: return 3;
+    }
+}
+
+static uint8_t pickUplink() {
+    if (ethConnected) return UPLINK_ETH;
+    if (WiFi.status() == WL_CONNECTED) return UPLINK_WIFI;
+    if (apMode) return UPLINK_AP;
+    return UPLINK_NONE;
+}
+
+// Main loop: re-evaluates the uplink after any Ethernet/WiFi state change
+void updateUplink() {
+    const uint8_t next = pickUplink();
+    if (next == g_uplink) {
+        // The link came back before anything switched over: nothing failed over
+        if (next == UPLINK_ETH || next == UPLINK_WIFI) g_uplinkLostAtMs = 0;
+        return;
+    }
+
+    const uint8_t prev = g_uplink;
+    g_uplink = next;
+
+    // Outbound traffic follows the default netif; with both interfaces up lwIP
+    // would otherwise prefer the STA (higher route priority than Ethernet)
+    esp_netif_t *netif = nullptr;
+    if (next == UPLINK_ETH) netif = ETH.netif();
+    else if (next == UPLINK_WIFI) netif = WiFi.STA.netif();
+    if (netif) esp_netif_set_default_netif(netif);
+
+    // BACnet announces and registers with the local address; move it over.
+    // HTTP/WebSocket listen on all interfaces and need nothing.
+    BACnetIntegration::rebind();
+
+    // The failover time runs from the link-loss event to the next real
+    // uplink. Going back to a preferred interface is a failback, not a
+    // failover. A loss that shows up without an event has no known start:
+    // it is timed from now if nothing is left to carry traffic, and only
+    // counted if a fallback interface takes over straight away.
+    const bool demoted = uplinkRank(next) > uplinkRank(prev);
+    if (demoted && !g_uplinkLostAtMs && (prev == UPLINK_ETH || prev == UPLINK_WIFI) &&
+        (next == UPLINK_NONE || next == UPLINK_AP)) {
+        g_uplinkLostAtMs = millis();
+    }
+
+    if ((next == UPLINK_ETH || next == UPLINK_WIFI) && (g_uplinkLostAtMs || demoted)) {
+        g_failover.count++;
+        if (g_uplinkLostAtMs) {
+            const uint32_t ms = millis() - g_uplinkLostAtMs;
+            g_uplinkLostAtMs = 0;
+            g_failover.lastMs = ms;
+            if (ms > g_failover.maxMs) g_failover.maxMs = ms;
+            debugPrintln("Uplink " + String(uplinkName(prev)) + " -> " + uplinkName(next) + " in " + String(ms) + " ms");
+        } else {
+            debugPrintln("Uplink " + String(uplinkName(prev)) + " -> " + uplinkName(next) + " (loss time unknown)");
+        }
+    } else {
+        debugPrintln("Uplink " + String(uplinkName(prev)) + " -> " + uplinkName(next));
+    }
+
+    // Nothing left: bring the STA up if it is not already trying
+    if (next == UPLINK_NONE && wifiSSID.length() > 0 && !(WiFi.getMode() & WIFI_STA)) {
+        beginWiFiStation();
+    }
+
+    broadcastUpdate();
+}
+
+uint8_t activeUplink() {
+    return g_uplink;
+}
+
+const char* uplinkName(uint8_t uplink) {
+    switch (uplink) {
+    case UPLINK_ETH: return "ethernet";
+    case UPLINK_WIFI: return "wifi";
+    case UPLINK_AP: return "ap";
+    default: return "none";
+    }
+}
+
+const NetFailoverStats& failoverStats() {
+    return g_failover;
 }
 
 
@@ -504,6 +658,7 @@ void initEthernet() {
         const uint32_t OVERALL_TIMEOUT_MS = 45000; // includes DHCP kicks + link-local fallback window
         uint32_t startMs = millis();
         while (!ethConnected && (millis() - startMs) < OVERALL_TIMEOUT_MS) {
+            serviceStateBus();      // apply link/IP events posted meanwhile
             serviceEthernetDhcp();
             if (ETH.localIP() != IPAddress(0, 0, 0, 0)) {
                 // We have an IP now; event may have already set ethConnected
@@ -536,44 +691,68 @@ void initEthernet() {
 
 
 
+// Runs in the ESP-IDF event task
 void WiFiEvent(WiFiEvent_t event) {
+    if (event == ARDUINO_EVENT_WIFI_STA_GOT_IP || event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) {
+        postStateEvent(STATE_EVENT_WIFI, (uint16_t)event, millis());
+    }
+}
+
+// Main loop (via serviceStateBus)
+void applyWiFiEvent(arduino_event_id_t event, uint32_t atMs) {
     switch (event) {
     case ARDUINO_EVENT_WIFI_STA_GOT_IP:
         wifiConnected = true;
         wifiClientMode = true;
         apMode = false;
+        g_wifiReconnectAttempts = 0;
         debugPrintln("WiFi connected. IP: " + WiFi.localIP().toString());
         break;
     case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
-        if (wifiClientMode) {
+        // Queued events can be stale by the time they are applied
+        if (wifiClientMode && WiFi.status() != WL_CONNECTED) {
             wifiConnected = false;
             wifiClientMode = false;
             debugPrintln("WiFi connection lost");
+            if (g_uplink == UPLINK_WIFI && !g_uplinkLostAtMs) g_uplinkLostAtMs = atMs;
 
-            // If not in AP mode and Ethernet not available, start AP
+            // If not in AP mode and Ethernet not available, try reconnecting a
+            // few times (serviceWiFiReconnect), then fall back to AP mode
             if (!apMode && !wiredMode) {
-                // Try reconnecting to WiFi a few times
-                int reconnectAttempts = 0;
-                while (reconnectAttempts < 3) {
-                    WiFi.reconnect();
-                    delay(3000);
-                    if (WiFi.status() == WL_CONNECTED) {
-                        wifiConnected = true;
-                        wifiClientMode = true;
-                        debugPrintln("WiFi reconnected");
-                        return;
-                    }
-                    reconnectAttempts++;
-                }
-
-                // If reconnection fails, start AP mode
-                startAPMode();
+                WiFi.reconnect();
+                g_wifiReconnectAttempts = 1;
+                g_wifiReconnectAtMs = millis();
             }
         }
         break;
     default:
         break;
     }
+
+    updateUplink();
+}
+
+void serviceWiFiReconnect() {
+    if (g_wifiReconnectAttempts == 0 || millis() - g_wifiReconnectAtMs < 3000) return;
+
+    if (WiFi.status() == WL_CONNECTED) {
+        wifiConnected = true;
+        wifiClientMode = true;
+        g_wifiReconnectAttempts = 0;
+        debugPrintln("WiFi reconnected");
+        updateUplink();
+        return;
+    }
+    if (g_wifiReconnectAttempts < 3) {
+        WiFi.reconnect();
+        g_wifiReconnectAttempts++;
+        g_wifiReconnectAtMs = millis();
+        return;
+    }
+
+    // If reconnection fails, start AP mode
+    g_wifiReconnectAttempts = 0;
+    startAPMode();
 }
 
 
@@ -1,11 +1,334 @@
 // RFManager.cpp
-// Auto-split from original KC868_A16_Controller.ino
+// 433 MHz remotes: learned-code table, repeat suppression and a transmit queue
+//
+// A remote sends every press as a burst of identical frames, and keeps sending
+// while the button is held. The first frame of a burst runs the code's action;
+// frames with the same code less than RF_REPEAT_MS apart are counted and
+// dropped, so a press acts once and within one frame time. Learned codes are
+// found through a small open-addressing hash on the code value.
+//
+// Codes are transmitted by the RMT peripheral: a task builds the whole burst
+// (RF_TX_REPEATS frames) as RMT symbols from RCSwitch's protocol timings and
+// sleeps until it has gone out, so neither the loop nor the frame timing
+// depends on who else is running. The board's own receiver hears the burst;
+// frames arriving during and right after it are ignored.
+//
+// The table is kept in NVS (namespace "rf"): the EEPROM map has no room left.
 
 #include "../FunctionPrototypes.h"
+#include <freertos/queue.h>
+
+struct RfTxRequest {
+    uint32_t code;
+    uint8_t bits;
+    uint8_t protocol;
+};
+
+static uint8_t rfIndex[RF_HASH_SLOTS];      // learned slot + 1, 0 = empty
+static RfStats stats = {};
+
+static uint32_t lastCode = 0;               // burst in progress
+static uint32_t lastFrameMs = 0;
+static RfTxRequest lastReceived = {};
+static uint32_t lastReceivedMs = 0;
+static uint8_t virtualInputs = 0;
+
+static bool learning = false;
+static uint32_t learnStartedMs = 0;
+static RfCode learnTemplate = {};
+
+// RCSwitch's protocol table, in units of pulseUs: each symbol is the first
+// level (high, or low when inverted) for `first` pulses, then the other level
+struct RfProtocol {
+    uint16_t pulseUs;
+    uint8_t syncFirst, syncSecond;
+    uint8_t zeroFirst, zeroSecond;
+    uint8_t oneFirst, oneSecond;
+    bool inverted;
+};
+
+static const RfProtocol rfProtocols[] = {
+    { 350,  1,  31,  1,  3,  3,  1, false },   // 1
+    { 650,  1,  10,  1,  2,  2,  1, false },   // 2
+    { 100, 30,  71,  4, 11,  9,  6, false },   // 3
+    { 380,  1,   6,  1,  3,  3,  1, false },   // 4
+    { 500,  6,  14,  1,  2,  2,  1, false },   // 5
+    { 450, 23,   1,  1,  2,  2,  1, true  },   // 6 (HT6P20B)
+    { 150,  2,  62,  1,  6,  6,  1, false },   // 7 (HS2303-PT)
+    { 200,  3, 130,  7, 16,  3, 16, false },   // 8 (Conrad RS-200 RX)
+    { 200, 130,  7, 16,  7, 16,  3, true  },   // 9 (Conrad RS-200 TX)
+    { 365, 18,   1,  3,  1,  1,  3, true  },   // 10 (1ByOne doorbell)
+    { 270, 36,   1,  1,  2,  2,  1, true  },   // 11 (HT12E)
+    { 320, 36,   1,  1,  2,  2,  1, true  },   // 12 (SM5212)
+};
+static const uint8_t RF_PROTOCOL_COUNT = sizeof(rfProtocols) / sizeof(rfProtocols[0]);
+static const size_t RF_TX_MAX_SYMBOLS = (32 + 1) * RF_TX_REPEATS;    // 32 data bits + sync
+
+static QueueHandle_t txQueue = nullptr;
+static rmt_data_t txSymbols[RF_TX_MAX_SYMBOLS];     // rftx task only
+static volatile bool txActive = false;
+static volatile uint32_t txEndedMs = 0;
+
+static uint32_t hashCode(uint32_t code) {
+    return ((code * 2654435761UL) >> 16) & (RF_HASH_SLOTS - 1);
+}
+
+static void rebuildRfIndex() {
+    memset(rfIndex, 0, sizeof(rfIndex));
+    for (uint8_t i = 0; i < RF_MAX_CODES; i++) {
+        if (rfCodes[i].code == 0) continue;
+        uint32_t h = hashCode(rfCodes[i].code);
+        while (rfIndex[h]) h = (h + 1) & (RF_HASH_SLOTS - 1);
+        rfIndex[h] = i + 1;
+    }
+}
+
+int findRfCode(uint32_t code) {
+    if (code == 0) return -1;
+
+    // Never full (RF_HASH_SLOTS > RF_MAX_CODES), so the probe always ends
+    uint32_t h = hashCode(code);
+    while (rfIndex[h]) {
+        const uint8_t i = rfIndex[h] - 1;
+        if (rfCodes[i].code == code) return i;
+        h = (h + 1) & (RF_HASH_SLOTS - 1);
+    }
+    return -1;
+}
+
+void saveRfCodes() {
+    rebuildRfIndex();
+
+    Preferences prefs;
+    if (!prefs.begin("rf", false)) {
+        debugPrintln("ERROR: Failed to open RF code storage");
+        return;
+    }
+    prefs.putBytes("codes", rfCodes, sizeof(rfCodes));
+    prefs.end();
+}
+
+static void loadRfCodes() {
+    memset(rfCodes, 0, sizeof(rfCodes));
+
+    Preferences prefs;
+    if (prefs.begin("rf", true)) {
+        // Another slot count or RfCode layout leaves the table empty
+        getPrefsRecords(prefs, "codes", rfCodes, sizeof(rfCodes), 1);
+        prefs.end();
+    }
+    for (RfCode& c : rfCodes) c.name[sizeof(c.name) - 1] = '\0';
+
+    rebuildRfIndex();
+}
+
+static void rfSymbol(rmt_data_t& sym, const RfProtocol& p, uint8_t first, uint8_t second) {
+    sym.level0 = p.inverted ? 0 : 1;
+    sym.duration0 = p.pulseUs * first;
+    sym.level1 = p.inverted ? 1 : 0;
+    sym.duration1 = p.pulseUs * second;
+}
+
+// One burst as RCSwitch::send() would produce it: data bits MSB first, then
+// the sync, RF_TX_REPEATS times. Returns the symbol count; totalUs is the
+// burst length.
+static size_t encodeRfBurst(const RfTxRequest& req, uint32_t& totalUs) {
+    const RfProtocol& p = rfProtocols[(req.protocol >= 1 && req.protocol <= RF_PROTOCOL_COUNT) ? req.protocol - 1 : 0];
+    const uint8_t bits = (req.bits == 0 || req.bits > 32) ? 24 : req.bits;
+
+    size_t n = 0;
+    for (uint8_t r = 0; r < RF_TX_REPEATS; r++) {
+        for (int8_t b = bits - 1; b >= 0; b--) {
+            if (req.code & (1UL << b)) rfSymbol(txSymbols[n++], p, p.oneFirst, p.oneSecond);
+            else rfSymbol(txSymbols[n++], p, p.zeroFirst, p.zeroSecond);
+        }
+        rfSymbol(txSymbols[n++], p, p.syncFirst, p.syncSecond);
+    }
+
+    totalUs = 0;
+    for (size_t i = 0; i < n; i++) totalUs += txSymbols[i].duration0 + txSymbols[i].duration1;
+    return n;
+}
+
+// rmtWrite() waits on the transmit-done event, so the task sleeps while the
+// RMT clocks the burst out and its priority does not matter for timing
+static void rfTxTask(void*) {
+    RfTxRequest req;
+    for (;;) {
+        if (xQueueReceive(txQueue, &req, portMAX_DELAY) != pdTRUE) continue;
+
+        uint32_t burstUs = 0;
+        const size_t symbols = encodeRfBurst(req, burstUs);
+        txActive = true;
+        if (!rmtWrite(RF_TX_PIN, txSymbols, symbols, burstUs / 1000 + 100)) stats.txFailed++;
+        txEndedMs = millis();
+        txActive = false;
+    }
+}
 
 void initRF() {
     rfReceiver.enableReceive(RF_RX_PIN);
-    rfTransmitter.enableTransmit(RF_TX_PIN);
-    debugPrintln("RF receiver/transmitter initialized");
+    // 1 MHz: one tick per microsecond, the line idles low between bursts
+    if (!rmtInit(RF_TX_PIN, RMT_TX_MODE, RMT_MEM_NUM_BLOCKS_1, 1000000) || !rmtSetEOT(RF_TX_PIN, LOW)) {
+        debugPrintln("ERROR: RF transmitter RMT channel not available");
+    }
+
+    loadRfCodes();
+
+    if (!txQueue) {
+        txQueue = xQueueCreate(RF_TX_QUEUE_DEPTH, sizeof(RfTxRequest));
+        TaskHandle_t txTask = nullptr;
+        xTaskCreatePinnedToCore(rfTxTask, "rftx", RF_TX_TASK_STACK, nullptr,
+                                RF_TX_TASK_PRIORITY, &txTask, RF_TX_TASK_CORE);
+        registerMonitoredTask("rftx", txTask);
+    }
+
+    uint8_t learned = 0;
+    for (const RfCode& c : rfCodes) {
+        if (c.code) learned++;
+    }
+    debugPrintln("RF receiver/transmitter initialized, " + String(learned) + " learned code(s)");
+}
+
+// Any task; never blocks (a full queue drops the code)
+bool queueRfTransmit(uint32_t code, uint8_t bits, uint8_t protocol) {
+    if (!txQueue || code == 0) return false;
+
+    const RfTxRequest req = { code, bits, protocol };
+    if (xQueueSend(txQueue, &req, 0) != pdTRUE) {
+        stats.txDropped++;
+        return false;
+    }
+    stats.transmitted++;
+    return true;
+}
+
+bool queueLearnedRfCode(uint8_t index) {
+    if (index >= RF_MAX_CODES || rfCodes[index].code == 0) return false;
+    return queueRfTransmit(rfCodes[index].code, rfCodes[index].bits, rfCodes[index].protocol);
+}
+
+// Next new code received is stored with this action/target/name
+void startRfLearn(const RfCode& settings) {
+    learnTemplate = settings;
+    learning = true;
+    learnStartedMs = millis();
+    debugPrintln("RF learn: press the remote button");
+}
+
+static void learnRfCode(const RfTxRequest& rx) {
+    learning = false;
+
+    // Re-learning a known code updates its entry
+    int slot = findRfCode(rx.code);
+    for (uint8_t i = 0; slot < 0 && i < RF_MAX_CODES; i++) {
+        if (rfCodes[i].code == 0) slot = i;
+    }
+    if (slot < 0) {
+        debugPrintln("RF learn: code table full");
+        return;
+    }
+
+    rfCodes[slot] = learnTemplate;
+    rfCodes[slot].code = rx.code;
+    rfCodes[slot].bits = rx.bits;
+    rfCodes[slot].protocol = rx.protocol;
+    saveRfCodes();
+
+    debugPrintln("RF learn: code " + String(rx.code) + " stored in slot " + String(slot));
+    broadcastUpdate();
+}
+
+static void runRfAction(const RfCode& c) {
+    const uint16_t bit = (c.target < 16) ? (1u << c.target) : 0;
+
+    switch (c.action) {
+    case RF_ACTION_TOGGLE_OUTPUT:
+        if (bit && applyOutputs(OUTPUT_SRC_RF, bit, outputStates[c.target] ? 0 : 0xFFFF)) broadcastUpdate();
+        break;
+    case RF_ACTION_OUTPUT_ON:
+        if (bit && applyOutputs(OUTPUT_SRC_RF, bit, 0xFFFF)) broadcastUpdate();
+        break;
+    case RF_ACTION_OUTPUT_OFF:
+        if (bit && applyOutputs(OUTPUT_SRC_RF, bit, 0)) broadcastUpdate();
+        break;
+    case RF_ACTION_RUN_SCHEDULE:
+        if (c.target < MAX_SCHEDULES) executeScheduleAction(c.target);
+        break;
+    case RF_ACTION_VIRTUAL_INPUT:
+        if (c.target < RF_VIRTUAL_INPUTS) {
+            virtualInputs ^= (1u << c.target);
+            broadcastUpdate();
+        }
+        break;
+    default:
+        break;
+    }
 }
 
+// Main loop
+void serviceRf() {
+    if (learning && millis() - learnStartedMs > RF_LEARN_TIMEOUT_MS) {
+        learning = false;
+        debugPrintln("RF learn: timed out");
+    }
+
+    if (!rfReceiver.available()) return;
+
+    RfTxRequest rx;
+    rx.code = rfReceiver.getReceivedValue();
+    rx.bits = (uint8_t)rfReceiver.getReceivedBitlength();
+    rx.protocol = (uint8_t)rfReceiver.getReceivedProtocol();
+    rfReceiver.resetAvailable();
+
+    // Undecodable frame, or our own burst coming back through the receiver
+    const uint32_t now = millis();
+    if (rx.code == 0 || txActive || now - txEndedMs < RF_REPEAT_MS) return;
+
+    // Same press still being sent (or the button is held)
+    if (rx.code == lastCode && now - lastFrameMs < RF_REPEAT_MS) {
+        lastFrameMs = now;
+        stats.repeats++;
+        return;
+    }
+    lastCode = rx.code;
+    lastFrameMs = now;
+    lastReceived = rx;
+    lastReceivedMs = now;
+    stats.received++;
+
+    if (learning) {
+        learnRfCode(rx);
+        return;
+    }
+
+    const int i = findRfCode(rx.code);
+    if (i < 0) {
+        stats.unknown++;
+        debugPrintln("RF code received: " + String(rx.code) + " (not learned)");
+        return;
+    }
+    runRfAction(rfCodes[i]);
+}
+
+const RfStats& rfStats() {
+    return stats;
+}
+
+uint8_t rfVirtualInputs() {
+    return virtualInputs;
+}
+
+bool rfLearning() {
+    return learning;
+}
+
+// Last press heard; false if nothing was received yet
+bool rfLastReceived(uint32_t& code, uint8_t& bits, uint8_t& protocol, uint32_t& ageMs) {
+    if (lastReceived.code == 0) return false;
+    code = lastReceived.code;
+    bits = lastReceived.bits;
+    protocol = lastReceived.protocol;
+    ageMs = millis() - lastReceivedMs;
+    return true;
+}
@@ -0,0 +1,163 @@
+// RS485Frame.cpp
+// Framed binary requests on the RS485 console port (non-Modbus mode)
+//
+//   request: SOF ADDR LEN OP PAYLOAD[LEN] CRC_LO CRC_HI
+//   reply:   SOF ADDR LEN OP|0x80 STATUS PAYLOAD[LEN-1] CRC_LO CRC_HI
+//
+// SOF is RS485_FRAME_SOF (0xA5, never part of a text command), the CRC is
+// CRC-16/MODBUS over ADDR..PAYLOAD and multi-byte fields are big-endian.
+// ADDR is rs485DeviceAddress; 0 is a broadcast that is executed but not
+// answered. Frames for other addresses are read and ignored, so several
+// boards can share the bus. Every reply for an opcode has the same size.
+//
+//   RS485_OP_PING           -> uptime s (u32)
+//   RS485_OP_READ_STATE     -> outputs (u16), inputs 1-16 (u16), HT1-HT3 (u8),
+//                              analog 1-4 raw (4 x u16)
+//   RS485_OP_WRITE_OUTPUTS  mask (u16), value (u16) -> outputs (u16)
+
+#include "../FunctionPrototypes.h"
+
+#define FRAME_HEADER 3          // ADDR LEN OP
+
+static uint8_t rxFrame[FRAME_HEADER + RS485_FRAME_MAX_PAYLOAD + 2];
+static uint8_t rxPos = 0;
+static uint8_t rxNeed = 0;      // 0 = waiting for SOF
+static uint32_t rxLastByteMs = 0;
+
+static uint16_t crc16Modbus(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+static uint8_t putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+    return 2;
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static void sendFrameReply(uint8_t op, uint8_t status, const uint8_t* payload, uint8_t len) {
+    uint8_t tx[1 + FRAME_HEADER + 1 + RS485_FRAME_MAX_PAYLOAD + 2];
+    uint8_t n = 0;
+    tx[n++] = RS485_FRAME_SOF;
+    tx[n++] = (uint8_t)rs485DeviceAddress;
+    tx[n++] = (uint8_t)(len + 1);
+    tx[n++] = (uint8_t)(op | 0x80);
+    tx[n++] = status;
+    memcpy(tx + n, payload, len);
+    n += len;
+
+    const uint16_t crc = crc16Modbus(tx + 1, n - 1);
+    tx[n++] = (uint8_t)crc;
+    tx[n++] = (uint8_t)(crc >> 8);
+    rs485.write(tx, n);
+}
+
+static void handleFrame(uint8_t addr, uint8_t op, const uint8_t* payload, uint8_t len) {
+    uint8_t out[RS485_FRAME_MAX_PAYLOAD];
+    uint8_t outLen = 0;
+    uint8_t status = RS485_STATUS_OK;
+
+    switch (op) {
+    case RS485_OP_PING: {
+        const uint32_t uptime = millis() / 1000;
+        outLen += putU16(out, (uint16_t)(uptime >> 16));
+        outLen += putU16(out + outLen, (uint16_t)uptime);
+        break;
+    }
+
+    case RS485_OP_READ_STATE: {
+        uint16_t inputs = 0;
+        for (int i = 0; i < 16; i++) {
+            if (inputStates[i]) inputs |= (1u << i);
+        }
+        uint8_t direct = 0;
+        for (int i = 0; i < 3; i++) {
+            if (directInputStates[i]) direct |= (1u << i);
+        }
+
+        outLen += putU16(out, getOutputMask());
+        outLen += putU16(out + outLen, inputs);
+        out[outLen++] = direct;
+        for (int i = 0; i < 4; i++) outLen += putU16(out + outLen, (uint16_t)analogValues[i]);
+        break;
+    }
+
+    case RS485_OP_WRITE_OUTPUTS:
+        if (len != 4) {
+            status = RS485_STATUS_BAD_LENGTH;
+        }
+        else if (applyOutputsOnce(OUTPUT_SRC_RS485, getU16(payload), getU16(payload + 2))) {
+            broadcastUpdate();
+        }
+        else {
+            status = RS485_STATUS_IO_ERROR;
+        }
+        outLen += putU16(out, getOutputMask());
+        break;
+
+    default:
+        status = RS485_STATUS_BAD_OPCODE;
+        break;
+    }
+
+    // Broadcast writes are applied silently; only the addressed board answers
+    if (addr == RS485_FRAME_BROADCAST) return;
+    if (status == RS485_STATUS_BAD_OPCODE) outLen = 0;
+    sendFrameReply(op, status, out, outLen);
+}
+
+// Feeds one byte from the UART. Returns true while the byte belongs to a frame
+// (SOF or later); anything else is left to the text console.
+bool rs485FrameFeed(uint8_t b) {
+    const uint32_t now = millis();
+
+    // A stalled frame is abandoned; the byte is considered afresh below
+    if (rxNeed && now - rxLastByteMs > RS485_FRAME_TIMEOUT_MS) {
+        rxNeed = 0;
+        metrics.rs485FrameErrors++;
+    }
+    rxLastByteMs = now;
+
+    if (rxNeed == 0) {
+        if (b != RS485_FRAME_SOF) return false;
+        rxPos = 0;
+        rxNeed = FRAME_HEADER;
+        return true;
+    }
+
+    rxFrame[rxPos++] = b;
+    if (rxPos == 2) {
+        // LEN known: rest of the header, the payload and the CRC
+        if (b > RS485_FRAME_MAX_PAYLOAD) {
+            rxNeed = 0;
+            metrics.rs485FrameErrors++;
+            return true;
+        }
+        rxNeed = (uint8_t)(FRAME_HEADER + b + 2);
+    }
+    if (rxPos < rxNeed) return true;
+
+    // Complete frame
+    rxNeed = 0;
+    const uint8_t len = rxFrame[1];
+    const uint16_t crc = (uint16_t)(rxFrame[rxPos - 2] | (rxFrame[rxPos - 1] << 8));
+    if (crc != crc16Modbus(rxFrame, rxPos - 2)) {
+        metrics.rs485FrameErrors++;
+        return true;
+    }
+
+    const uint8_t addr = rxFrame[0];
+    if (addr != (uint8_t)rs485DeviceAddress && addr != RS485_FRAME_BROADCAST) return true;
+
+    metrics.rs485Frames++;
+    handleFrame(addr, rxFrame[2], rxFrame + FRAME_HEADER, len);
+    return true;
+}
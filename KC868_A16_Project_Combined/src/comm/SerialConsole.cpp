@@ -2,13 +2,17 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../FunctionPrototypes.h"
+#include "LineReader.h"
 
 void processSerialCommands() {
-    if (Serial.available()) {
-        String command = Serial.readStringUntil('\n');
-        command.trim();
+    static LineReader reader;
 
-        String response = processCommand(command);
+    while (reader.poll(Serial)) {
+        if (reader.overflowed()) {
+            Serial.println("ERROR: Command too long (max " + String(CONSOLE_LINE_MAX - 1) + " characters)");
+            continue;
+        }
+        String response = processCommand(reader.line());
         Serial.println(response);
     }
 }
@@ -9,15 +9,29 @@ static void reinitWebPortsIfNeeded() {
     // This is safe here because we haven't registered handlers nor called begin().
     if (httpPort < 1 || httpPort > 65535) httpPort = 80;
     if (wsPort < 1 || wsPort > 65535) wsPort = 81;
-    new (&server) WebServer((uint16_t)httpPort);
+    new (&server) HttpServer((uint16_t)httpPort);
     new (&webSocket) WebSocketsServer((uint16_t)wsPort);
 }
 
+static uint32_t restartAtMs = 0;
+
+// Restart from the loop so the HTTP response that asked for it is sent first
+void scheduleRestart(uint32_t delayMs) {
+    restartAtMs = millis() + delayMs;
+    if (restartAtMs == 0) restartAtMs = 1;
+}
+
 void appSetup() {
     // Initialize serial communication for debugging
     Serial.begin(115200);
     Serial.println("\nKC868-A16 Controller starting up...");
 
+    // Roll back a freshly updated image that keeps failing to come up
+    otaBootCheck();
+
+    // Queue for state changes reported by network callbacks (other tasks)
+    initStateBus();
+
     // Initialize EEPROM
     EEPROM.begin(EEPROM_SIZE);
 
@@ -29,9 +43,9 @@ void appSetup() {
         Serial.println("SPIFFS Mounted SUCCESSFULLY...");
     }
 
-    // Initialize I2C with custom pins
-    Wire.begin(SDA_PIN, SCL_PIN);
-    Wire.setClock(50000);  // Lower to 50kHz for more reliable communication
+    // Initialize I2C with custom pins; the bus manager starts at 50kHz and
+    // steps up while the bus stays clean
+    initI2CBus();
 
     // Initialize PCF8574 expanders
     initI2C();
@@ -59,10 +73,15 @@ void appSetup() {
     // Initialize Ethernet first to check if wired connection is available
     initEthernet();
 
-    // Initialize WiFi only if Ethernet is not connected
+    // WiFi carries the traffic if Ethernet is not connected; otherwise it
+    // associates in the background as the failover uplink
     if (!ethConnected) {
         initWiFi();
     }
+    else {
+        startWiFiStandby();
+    }
+    updateUplink();
 
     // Print MAC summary (Board/ETH/STA/AP)
     printMacSummary();
@@ -75,6 +94,9 @@ void appSetup() {
     }
 
 
+    // Flash event journal; after the RTC so the boot record has the time
+    initEventLog();
+
     // Initialize RS485 serial with current configuration
     initRS485();
 
@@ -90,6 +112,9 @@ void appSetup() {
     // Initialize RF receiver and transmitter
     initRF();
 
+    // Logic program (scans start in the main loop)
+    initLogic();
+
     // Start DNS server for captive portal if in AP mode
     if (apMode) {
         dnsServer.start(53, "*", WiFi.softAPIP());
@@ -104,7 +129,7 @@ void appSetup() {
     setupWebServer();
 
     // Initialize output states (All relays OFF)
-    writeOutputs();
+    initOutputs();
 
     // Read initial input states
     readInputs();
@@ -138,10 +163,6 @@ void appSetup() {
         Serial.println("Using Ethernet connection");
         Serial.print("IP: ");
         Serial.println(ETH.localIP());
-
-            // Start BACnet Integration (runs only after network ready)
-    BACnetIntegration::initialize();
-    BACnetIntegration::setEnabled(true);
     }
     else if (wifiClientMode) {
         Serial.println("Using WiFi Client connection");
@@ -154,21 +175,54 @@ void appSetup() {
         Serial.println(WiFi.softAPIP());
     }
 
+    // Start BACnet Integration (binds once an uplink is ready, follows failover)
+    BACnetIntegration::initialize();
+    BACnetIntegration::setEnabled(true);
 
 }
 
 void appLoop() {
+    // Loop period (entry to entry) for /metrics
+    static uint32_t lastLoopUs = 0;
+    const uint32_t loopUs = micros();
+    if (lastLoopUs != 0) {
+        const uint32_t period = loopUs - lastLoopUs;
+        metrics.loopCount++;
+        metrics.loopLastUs = period;
+        metrics.loopTotalUs += period;
+        if (period > metrics.loopMaxUs) metrics.loopMaxUs = period;
+    }
+    lastLoopUs = loopUs;
+
+    // Apply events posted by other tasks before anything reads the state
+    serviceStateBus();
+    serviceWiFiReconnect();
+
     // Handle DNS requests for captive portal if in AP mode
     if (apMode) {
         dnsServer.processNextRequest();
     }
 
     // Rest of the original loop function...
-    // Handle web server clients
+    // Run HTTP handlers for requests the server task has fully received
     server.handleClient();
 
     // Handle WebSocket events
     webSocket.loop();
+    serviceWebSocketClients();   // flush rate-limited / coalesced updates
+
+    // Keep-alives for Server-Sent Events clients
+    serviceEventStream();
+
+    // Confirm a new firmware image once it has run long enough
+    serviceOta();
+
+    // Heap / stack telemetry
+    serviceHeapMonitor();
+
+    if (restartAtMs != 0 && (int32_t)(millis() - restartAtMs) >= 0) {
+        ESP.restart();
+    }
 
 
     // Update BACnet
@@ -196,7 +250,7 @@ void appLoop() {
 
         // If inputs changed, broadcast immediately
         if (inputsChanged) {
-            broadcastUpdate();
+            broadcastUpdate(WS_TOPIC_INPUTS);
             lastWebSocketUpdate = currentMillis;
         }
     }
@@ -209,6 +263,7 @@ void appLoop() {
         for (int i = 0; i < 3; i++) {
             readSensor(i);
         }
+        checkSensorSchedules();
     }
 
     // Read analog inputs more frequently - reduced to 100ms (from 500ms) for better responsiveness
@@ -225,12 +280,12 @@ void appLoop() {
             }
         }
 
-        // If analog values changed significantly, check triggers
-        if (analogChanged) {
-            checkAnalogTriggers();
+        // Every sample: triggers are edge-driven and dwell timers must expire
+        checkAnalogTriggers();
 
+        if (analogChanged) {
             // Broadcast immediately if analog values changed
-            broadcastUpdate();
+            broadcastUpdate(WS_TOPIC_ANALOG);
             lastWebSocketUpdate = currentMillis;
         }
     }
@@ -242,16 +297,11 @@ void appLoop() {
 
         // Maintain DHCP client state for Ethernet (LAN8720.ino proven logic)
         serviceEthernetDhcp();
-        // If Ethernet was connected but now disconnected, try to reconnect WiFi
+        // Link-down event missed: updateUplink() below fails over to WiFi
         if (wiredMode && !ETH.linkUp()) {
             wiredMode = false;
             ethConnected = false;
-
-            // Try to reconnect WiFi if we have credentials
-            if (wifiSSID.length() > 0 && !wifiClientMode && !apMode) {
-                WiFi.begin(wifiSSID.c_str(), wifiPassword.c_str());
-                debugPrintln("Ethernet disconnected, trying WiFi...");
-            }
+            debugPrintln("Ethernet disconnected");
         }
 
         // If WiFi client was connected but now disconnected, try to reconnect
@@ -265,6 +315,8 @@ void appLoop() {
                 debugPrintln("WiFi disconnected, trying to reconnect...");
             }
         }
+
+        updateUplink();
     }
 
     // Broadcast periodic updates every 1 second even if no changes (reduced from 2 seconds)
@@ -294,12 +346,11 @@ void appLoop() {
         isModbusRtuRunning()) {
         taskModbusRtu();
     }
-// Check RF receiver for any signals
-    if (rfReceiver.available()) {
-        unsigned long rfCode = rfReceiver.getReceivedValue();
-        debugPrintln("RF code received: " + String(rfCode));
-        rfReceiver.resetAvailable();
-    }
+    // RF remotes: learned-code actions
+    serviceRf();
+
+    // Logic scan (fixed LOGIC_SCAN_MS period)
+    serviceLogic();
 
     // Check schedules every second
     if (currentMillis - lastTimeCheck >= 1000) {
@@ -307,6 +358,9 @@ void appLoop() {
         checkSchedules();
     }
 
+    // One coalesced expander write for everything commanded this pass
+    serviceOutputs();
+
     // Check Time stamp every 10 second
     if (currentMillis - lastNetTimeCheck >= 10000) {
         if (WiFi.status() == WL_CONNECTED || ethConnected) {
@@ -0,0 +1,548 @@
+// ConfigBackup.cpp
+// Whole-device configuration as one binary blob (GET /api/backup, POST /api/restore)
+//
+// Layout, little endian:
+//   header    magic "KCBK" u32, format version u16, flags u16, section bytes u32
+//   sections  id u8, reserved u8, length u16, payload      (repeated)
+//   trailer   CRC-32 (IEEE) of everything before it
+//
+// Table sections (schedules, triggers, interrupts, rf_codes, logic) carry a record count and the
+// record size; a size that does not match this firmware's struct is rejected
+// instead of guessed at. Unknown section ids are skipped, so a blob from newer
+// firmware still restores the parts this one understands.
+//
+// Device identity (serial number, MAC overrides) is not exported: a backup is
+// meant to be restored onto other boards. The WiFi password is only included
+// when asked for.
+//
+// A restore is validated completely before anything changes, then applied and
+// persisted with a single EEPROM commit.
+
+#include "../FunctionPrototypes.h"
+
+static const uint8_t SECTION_DEVICE = 1;
+static const uint8_t SECTION_NETWORK = 2;
+static const uint8_t SECTION_SCHEDULES = 3;
+static const uint8_t SECTION_TRIGGERS = 4;
+static const uint8_t SECTION_INTERRUPTS = 5;
+static const uint8_t SECTION_HT_SENSORS = 6;
+static const uint8_t SECTION_RF_CODES = 7;
+static const uint8_t SECTION_LOGIC = 8;
+
+static const uint16_t BACKUP_FLAG_SECRETS = 0x0001;
+static const uint8_t NETWORK_FLAG_PASSWORD = 0x01;
+static const size_t BACKUP_HEADER_BYTES = 12;
+
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+    while (len--) {
+        crc ^= *data++;
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+    }
+    return crc;
+}
+
+// ---- Encoding ----
+
+class BackupOut {
+public:
+    explicit BackupOut(Print* out) : _out(out), _crc(0xFFFFFFFFUL), _len(0) {}
+
+    void bytes(const void* data, size_t len) {
+        _crc = crc32Update(_crc, (const uint8_t*)data, len);
+        if (_out) _out->write((const uint8_t*)data, len);
+        _len += len;
+    }
+    void u8(uint8_t v) { bytes(&v, 1); }
+    void u16(uint16_t v) {
+        const uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+        bytes(b, 2);
+    }
+    void u32(uint32_t v) {
+        const uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+        bytes(b, 4);
+    }
+    void f32(float v) {
+        uint32_t bits;
+        memcpy(&bits, &v, 4);
+        u32(bits);
+    }
+    void str(const String& s) {
+        const uint8_t n = (uint8_t)min(s.length(), (unsigned int)255);
+        u8(n);
+        bytes(s.c_str(), n);
+    }
+    template <typename T>
+    void table(const T* records, uint8_t count) {
+        u8(count);
+        u8(0);
+        u16(sizeof(T));
+        bytes(records, sizeof(T) * count);
+    }
+
+    uint32_t crc() const { return ~_crc; }
+    size_t length() const { return _len; }
+
+private:
+    Print* _out;
+    uint32_t _crc;
+    size_t _len;
+};
+
+static void writeDevice(BackupOut& o, bool) {
+    o.str(deviceName);
+    o.str(boardName);
+    o.str(hardwareVersionStr);
+    o.u8(debugMode);
+    o.u8(outputsMasterEnable);
+    for (int i = 0; i < 4; i++) o.f32(analogScaleFactors[i]);
+    for (int i = 0; i < 4; i++) o.f32(analogOffsetValues[i]);
+}
+
+static void writeNetwork(BackupOut& o, bool secrets) {
+    o.u8(secrets ? NETWORK_FLAG_PASSWORD : 0);
+    o.u8(dhcpMode);
+    o.u32((uint32_t)ip);
+    o.u32((uint32_t)gateway);
+    o.u32((uint32_t)subnet);
+    o.u32((uint32_t)dns1);
+    o.u32((uint32_t)dns2);
+    o.u8(wifiDhcpMode);
+    o.u32((uint32_t)wifiStaIp);
+    o.u32((uint32_t)wifiStaGateway);
+    o.u32((uint32_t)wifiStaSubnet);
+    o.u32((uint32_t)wifiStaDns1);
+    o.u32((uint32_t)wifiStaDns2);
+    o.u16((uint16_t)httpPort);
+    o.u16((uint16_t)wsPort);
+    o.u8(bacnetFdEnabled);
+    o.u32((uint32_t)bacnetBbmdIp);
+    o.u16(bacnetBbmdPort);
+    o.u16(bacnetFdTtl);
+    o.str(wifiSSID);
+    o.str(secrets ? wifiPassword : String());
+}
+
+static void writeSchedules(BackupOut& o, bool) {
+    o.table(schedules, MAX_SCHEDULES);
+}
+
+static void writeTriggers(BackupOut& o, bool) {
+    o.table(analogTriggers, MAX_ANALOG_TRIGGERS);
+}
+
+static void writeInterrupts(BackupOut& o, bool) {
+    o.table(interruptConfigs, 16);
+}
+
+static void writeHTSensors(BackupOut& o, bool) {
+    for (int i = 0; i < 3; i++) o.u8(htSensorConfig[i].sensorType);
+}
+
+static void writeRfCodes(BackupOut& o, bool) {
+    o.table(rfCodes, RF_MAX_CODES);
+}
+
+static void writeLogic(BackupOut& o, bool) {
+    o.u8(logicRunning());
+    o.table(logicProgram(), logicProgramLength());
+}
+
+// ---- Decoding ----
+
+class BackupIn {
+public:
+    BackupIn(const uint8_t* data, size_t len) : _p(data), _end(data + len), _ok(true) {}
+
+    bool ok() const { return _ok; }
+    size_t remaining() const { return _end - _p; }
+
+    const uint8_t* bytes(size_t n) {
+        if (!_ok || remaining() < n) {
+            _ok = false;
+            return nullptr;
+        }
+        const uint8_t* p = _p;
+        _p += n;
+        return p;
+    }
+    uint8_t u8() {
+        const uint8_t* p = bytes(1);
+        return p ? p[0] : 0;
+    }
+    uint16_t u16() {
+        const uint8_t* p = bytes(2);
+        return p ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+    }
+    uint32_t u32() {
+        const uint8_t* p = bytes(4);
+        return p ? ((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24)) : 0;
+    }
+    float f32() {
+        const uint32_t bits = u32();
+        float v;
+        memcpy(&v, &bits, 4);
+        return v;
+    }
+    String str() {
+        const uint8_t n = u8();
+        const uint8_t* p = bytes(n);
+        String s;
+        if (p) s.concat((const char*)p, n);
+        return s;
+    }
+    // Returns the records, or nullptr when the layout does not match T
+    template <typename T>
+    const uint8_t* table(uint8_t maxCount, uint8_t& count) {
+        count = u8();
+        u8();
+        const uint16_t recordSize = u16();
+        if (!_ok || recordSize != sizeof(T) || count > maxCount) {
+            _ok = false;
+            return nullptr;
+        }
+        return bytes(sizeof(T) * count);
+    }
+
+private:
+    const uint8_t* _p;
+    const uint8_t* _end;
+    bool _ok;
+};
+
+// Section readers parse everything, and only touch the globals when apply is set,
+// so the same code validates (first pass) and applies (second pass).
+
+static bool readDevice(BackupIn& in, bool apply) {
+    const String name = in.str();
+    const String board = in.str();
+    const String hwVersion = in.str();
+    const bool debug = in.u8();
+    const bool masterEnable = in.u8();
+    float scale[4], offset[4];
+    for (int i = 0; i < 4; i++) scale[i] = in.f32();
+    for (int i = 0; i < 4; i++) offset[i] = in.f32();
+    if (!in.ok()) return false;
+
+    if (apply) {
+        deviceName = name;
+        boardName = board;
+        hardwareVersionStr = hwVersion;
+        debugMode = debug;
+        outputsMasterEnable = masterEnable;
+        memcpy(analogScaleFactors, scale, sizeof(scale));
+        memcpy(analogOffsetValues, offset, sizeof(offset));
+    }
+    return true;
+}
+
+static bool readNetwork(BackupIn& in, bool apply) {
+    const uint8_t flags = in.u8();
+    const bool ethDhcp = in.u8();
+    uint32_t eth[5], sta[5];
+    for (int i = 0; i < 5; i++) eth[i] = in.u32();
+    const bool staDhcp = in.u8();
+    for (int i = 0; i < 5; i++) sta[i] = in.u32();
+    const uint16_t http = in.u16();
+    const uint16_t ws = in.u16();
+    const bool fdEnabled = in.u8();
+    const uint32_t bbmdIp = in.u32();
+    const uint16_t bbmdPort = in.u16();
+    const uint16_t fdTtl = in.u16();
+    const String ssid = in.str();
+    const String pass = in.str();
+    if (!in.ok() || http == 0 || ws == 0 || http == ws) return false;
+
+    if (apply) {
+        dhcpMode = ethDhcp;
+        ip = IPAddress(eth[0]);
+        gateway = IPAddress(eth[1]);
+        subnet = IPAddress(eth[2]);
+        dns1 = IPAddress(eth[3]);
+        dns2 = IPAddress(eth[4]);
+        wifiDhcpMode = staDhcp;
+        wifiStaIp = IPAddress(sta[0]);
+        wifiStaGateway = IPAddress(sta[1]);
+        wifiStaSubnet = IPAddress(sta[2]);
+        wifiStaDns1 = IPAddress(sta[3]);
+        wifiStaDns2 = IPAddress(sta[4]);
+        httpPort = http;
+        wsPort = ws;
+        bacnetFdEnabled = fdEnabled;
+        bacnetBbmdIp = IPAddress(bbmdIp);
+        bacnetBbmdPort = bbmdPort;
+        bacnetFdTtl = fdTtl;
+        wifiSSID = ssid;
+        if (flags & NETWORK_FLAG_PASSWORD) wifiPassword = pass;
+    }
+    return true;
+}
+
+static bool readSchedules(BackupIn& in, bool apply) {
+    uint8_t count;
+    const uint8_t* records = in.table<TimeSchedule>(MAX_SCHEDULES, count);
+    if (!records) return false;
+
+    if (apply) {
+        memcpy(schedules, records, sizeof(TimeSchedule) * count);
+        for (uint8_t i = 0; i < count; i++) schedules[i].name[sizeof(schedules[i].name) - 1] = '\0';
+    }
+    return true;
+}
+
+static bool readTriggers(BackupIn& in, bool apply) {
+    uint8_t count;
+    const uint8_t* records = in.table<AnalogTrigger>(MAX_ANALOG_TRIGGERS, count);
+    if (!records) return false;
+
+    if (apply) {
+        memcpy(analogTriggers, records, sizeof(AnalogTrigger) * count);
+        for (uint8_t i = 0; i < count; i++) analogTriggers[i].name[sizeof(analogTriggers[i].name) - 1] = '\0';
+    }
+    return true;
+}
+
+static bool readInterrupts(BackupIn& in, bool apply) {
+    uint8_t count;
+    const uint8_t* records = in.table<InterruptConfig>(16, count);
+    if (!records) return false;
+
+    if (apply) {
+        memcpy(interruptConfigs, records, sizeof(InterruptConfig) * count);
+        for (uint8_t i = 0; i < count; i++) interruptConfigs[i].name[sizeof(interruptConfigs[i].name) - 1] = '\0';
+    }
+    return true;
+}
+
+static bool readHTSensors(BackupIn& in, bool apply) {
+    uint8_t types[3];
+    for (int i = 0; i < 3; i++) {
+        types[i] = in.u8();
+        if (types[i] > SENSOR_TYPE_DS18B20) return false;
+    }
+    if (!in.ok()) return false;
+
+    if (apply) {
+        for (int i = 0; i < 3; i++) htSensorConfig[i].sensorType = types[i];
+    }
+    return true;
+}
+
+static bool readRfCodes(BackupIn& in, bool apply) {
+    uint8_t count;
+    const uint8_t* records = in.table<RfCode>(RF_MAX_CODES, count);
+    if (!records) return false;
+
+    if (apply) {
+        memcpy(rfCodes, records, sizeof(RfCode) * count);
+        for (uint8_t i = 0; i < count; i++) rfCodes[i].name[sizeof(rfCodes[i].name) - 1] = '\0';
+    }
+    return true;
+}
+
+static bool readLogic(BackupIn& in, bool apply) {
+    const bool run = in.u8() != 0;
+    uint8_t count;
+    const uint8_t* records = in.table<LogicInstr>(LOGIC_MAX_INSTR, count);
+    if (!records) return false;
+
+    LogicInstr prog[LOGIC_MAX_INSTR];
+    memcpy(prog, records, sizeof(LogicInstr) * count);
+    String error;
+    if (!apply) return validateLogicProgram(prog, count, error);
+
+    installLogicProgram(prog, count, error);
+    setLogicRunning(run && count > 0);
+    return true;
+}
+
+// ---- Section table ----
+
+typedef void (*SectionWriter)(BackupOut& o, bool secrets);
+typedef bool (*SectionReader)(BackupIn& in, bool apply);
+
+struct BackupSection {
+    uint8_t id;
+    const char* name;
+    SectionWriter write;
+    SectionReader read;
+};
+
+static const BackupSection backupSections[] = {
+    { SECTION_DEVICE, "device", writeDevice, readDevice },
+    { SECTION_NETWORK, "network", writeNetwork, readNetwork },
+    { SECTION_SCHEDULES, "schedules", writeSchedules, readSchedules },
+    { SECTION_TRIGGERS, "triggers", writeTriggers, readTriggers },
+    { SECTION_INTERRUPTS, "interrupts", writeInterrupts, readInterrupts },
+    { SECTION_HT_SENSORS, "ht_sensors", writeHTSensors, readHTSensors },
+    { SECTION_RF_CODES, "rf_codes", writeRfCodes, readRfCodes },
+    { SECTION_LOGIC, "logic", writeLogic, readLogic },
+};
+
+static const uint8_t BACKUP_SECTION_COUNT = sizeof(backupSections) / sizeof(backupSections[0]);
+
+static void writeSections(BackupOut& o, bool secrets) {
+    for (const BackupSection& s : backupSections) {
+        BackupOut probe(nullptr);
+        s.write(probe, secrets);
+
+        o.u8(s.id);
+        o.u8(0);
+        o.u16((uint16_t)probe.length());
+        s.write(o, secrets);
+    }
+}
+
+size_t configBackupSize(bool includeSecrets) {
+    BackupOut probe(nullptr);
+    writeSections(probe, includeSecrets);
+    return BACKUP_HEADER_BYTES + probe.length() + 4;
+}
+
+void configBackupWrite(Print& out, bool includeSecrets) {
+    BackupOut probe(nullptr);
+    writeSections(probe, includeSecrets);
+
+    BackupOut o(&out);
+    o.u32(CONFIG_BACKUP_MAGIC);
+    o.u16(CONFIG_BACKUP_VERSION);
+    o.u16(includeSecrets ? BACKUP_FLAG_SECRETS : 0);
+    o.u32((uint32_t)probe.length());
+    writeSections(o, includeSecrets);
+
+    const uint32_t crc = o.crc();
+    const uint8_t trailer[4] = { (uint8_t)crc, (uint8_t)(crc >> 8), (uint8_t)(crc >> 16), (uint8_t)(crc >> 24) };
+    out.write(trailer, 4);
+}
+
+// Bit per entry of backupSections[]
+uint8_t configBackupSectionMask(const String& names) {
+    if (names.length() == 0) return (uint8_t)((1U << BACKUP_SECTION_COUNT) - 1);
+
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < BACKUP_SECTION_COUNT; i++) {
+        const String name = backupSections[i].name;
+        int at = names.indexOf(name);
+        while (at >= 0) {
+            const int end = at + name.length();
+            if ((at == 0 || names[at - 1] == ',') && (end == (int)names.length() || names[end] == ',')) {
+                mask |= (1U << i);
+                break;
+            }
+            at = names.indexOf(name, at + 1);
+        }
+    }
+    return mask;
+}
+
+// Walks the sections; applies the ones in sectionMask when apply is set
+static bool walkSections(const uint8_t* data, size_t len, uint8_t sectionMask, bool apply,
+                         uint8_t& found, String& error) {
+    BackupIn in(data, len);
+    found = 0;
+    while (in.remaining() > 0) {
+        const uint8_t id = in.u8();
+        in.u8();
+        const uint16_t sectionLen = in.u16();
+        const uint8_t* payload = in.bytes(sectionLen);
+        if (!payload) {
+            error = "Truncated section " + String(id);
+            return false;
+        }
+
+        for (uint8_t i = 0; i < BACKUP_SECTION_COUNT; i++) {
+            const BackupSection& s = backupSections[i];
+            if (s.id != id || !(sectionMask & (1U << i))) continue;
+
+            BackupIn section(payload, sectionLen);
+            if (!s.read(section, apply)) {
+                error = "Invalid " + String(s.name) + " section";
+                return false;
+            }
+            found |= (1U << i);
+        }
+    }
+    return true;
+}
+
+bool configRestore(const uint8_t* data, size_t len, uint8_t sectionMask, bool& restartRequired, String& error) {
+    restartRequired = false;
+
+    if (len < BACKUP_HEADER_BYTES + 4) {
+        error = "Backup too short";
+        return false;
+    }
+    const uint32_t expectedCrc = (uint32_t)data[len - 4] | ((uint32_t)data[len - 3] << 8) |
+                                 ((uint32_t)data[len - 2] << 16) | ((uint32_t)data[len - 1] << 24);
+    if ((~crc32Update(0xFFFFFFFFUL, data, len - 4)) != expectedCrc) {
+        error = "CRC mismatch";
+        return false;
+    }
+
+    BackupIn header(data, BACKUP_HEADER_BYTES);
+    const uint32_t magic = header.u32();
+    const uint16_t version = header.u16();
+    header.u16();   // flags: informational
+    const uint32_t sectionBytes = header.u32();
+    if (magic != CONFIG_BACKUP_MAGIC) {
+        error = "Not a configuration backup";
+        return false;
+    }
+    if (version > CONFIG_BACKUP_VERSION) {
+        error = "Backup format " + String(version) + " is newer than this firmware";
+        return false;
+    }
+    if (sectionBytes != len - BACKUP_HEADER_BYTES - 4) {
+        error = "Length mismatch";
+        return false;
+    }
+
+    // Validate everything first; nothing has changed if this fails
+    const uint8_t* sections = data + BACKUP_HEADER_BYTES;
+    uint8_t found;
+    if (!walkSections(sections, sectionBytes, sectionMask, false, found, error)) return false;
+    if (!found) {
+        error = "No matching sections";
+        return false;
+    }
+    walkSections(sections, sectionBytes, sectionMask, true, found, error);
+
+    // Persist with one EEPROM commit
+    beginConfigBatch();
+    for (uint8_t i = 0; i < BACKUP_SECTION_COUNT; i++) {
+        if (!(found & (1U << i))) continue;
+        switch (backupSections[i].id) {
+        case SECTION_DEVICE:
+            saveConfiguration();
+            break;
+        case SECTION_NETWORK:
+            saveNetworkSettings();
+            saveWiFiCredentials(wifiSSID, wifiPassword);
+            restartRequired = true;
+            break;
+        case SECTION_SCHEDULES:
+            saveSchedulesToEEPROM();
+            break;
+        case SECTION_INTERRUPTS:
+            saveInterruptConfigs();
+            if (inputInterruptsEnabled) setupInputInterrupts();
+            break;
+        case SECTION_HT_SENSORS:
+            saveHTSensorConfig();
+            for (uint8_t ht = 0; ht < 3; ht++) initializeSensor(ht);
+            break;
+        case SECTION_RF_CODES:
+            saveRfCodes();  // NVS, outside the EEPROM batch
+            break;
+        case SECTION_LOGIC:
+            saveLogicProgram();     // NVS as well
+            break;
+        default:
+            break;  // triggers live in RAM like the /api/analog-triggers edits
+        }
+    }
+    endConfigBatch();
+
+    logEvent(EVENT_CONFIG, 0xFF, 0, 0, found);
+    debugPrintln("Configuration restored from backup");
+    return true;
+}
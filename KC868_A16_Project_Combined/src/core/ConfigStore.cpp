@@ -3,8 +3,42 @@
 
 #include "../FunctionPrototypes.h"
 
+// Inside a config batch the save functions only stage their EEPROM writes and
+// endConfigBatch() commits once (used by the backup restore)
+static uint8_t configBatchDepth = 0;
+static bool configCommitPending = false;
+
+static void commitEEPROM() {
+    if (configBatchDepth > 0) configCommitPending = true;
+    else EEPROM.commit();
+}
+
+void beginConfigBatch() {
+    configBatchDepth++;
+}
+
+void endConfigBatch() {
+    if (configBatchDepth == 0 || --configBatchDepth > 0) return;
+    if (configCommitPending) {
+        configCommitPending = false;
+        EEPROM.commit();
+    }
+}
+
+// Structs saved raw with putBytes() (RF codes, the logic program, output
+// levels) carry no version. A blob whose size is not a whole number of
+// today's records, or more than maxRecords of them, was written by a firmware
+// with another layout: it is skipped (0 returned) rather than read into the
+// wrong fields. Otherwise returns the record count read.
+size_t getPrefsRecords(Preferences& prefs, const char* key, void* dst, size_t recordSize, size_t maxRecords) {
+    const size_t len = prefs.getBytesLength(key);
+    if (len == 0 || recordSize == 0 || len % recordSize != 0 || len / recordSize > maxRecords) return 0;
+    if (prefs.getBytes(key, dst, len) != len) return 0;
+    return len / recordSize;
+}
+
 void saveInterruptConfigs() {
-    DynamicJsonDocument doc(2048);
+    PooledJsonDocument doc(2048);
     JsonArray configArray = doc.createNestedArray("interrupts");
 
     for (int i = 0; i < 16; i++) {
@@ -29,7 +63,7 @@ void saveInterruptConfigs() {
     EEPROM.write(EEPROM_INTERRUPT_CONFIG_ADDR + n, 0);
 
     // Commit changes
-    EEPROM.commit();
+    commitEEPROM();
 
     debugPrintln("Interrupt configurations saved");
 }
@@ -51,7 +85,7 @@ void loadInterruptConfigs() {
 
     // If we read something, try to parse it
     if (i > 0) {
-        DynamicJsonDocument doc(2048);
+        PooledJsonDocument doc(2048);
         DeserializationError error = deserializeJson(doc, jsonBuffer);
 
         if (!error && doc.containsKey("interrupts")) {
@@ -136,7 +170,7 @@ static void writeNetCfgToEEPROM() {
     cfg.crc = crc16_simple((const uint8_t*)&cfg, sizeof(NetCfgEeprom) - sizeof(cfg.crc));
 
     EEPROM.put(EEPROM_NETCFG_ADDR, cfg);
-    EEPROM.commit();
+    commitEEPROM();
 }
 
 static bool readNetCfgFromEEPROM() {
@@ -197,6 +231,12 @@ void saveNetworkSettings() {
     prefs.putUShort("http", (uint16_t)httpPort);
     prefs.putUShort("ws", (uint16_t)wsPort);
 
+    // BACnet/IP foreign-device registration
+    prefs.putBool("fd_en", bacnetFdEnabled);
+    prefs.putUInt("fd_bbmd", (uint32_t)bacnetBbmdIp);
+    prefs.putUShort("fd_port", bacnetBbmdPort);
+    prefs.putUShort("fd_ttl", bacnetFdTtl);
+
     // Also persist WiFi credentials in flash as a backup to EEPROM
     prefs.putString("ssid", wifiSSID);
     prefs.putString("pass", wifiPassword);
@@ -251,6 +291,11 @@ if (hasEth) {
     httpPort = (int)prefs.getUShort("http", 80);
     wsPort = (int)prefs.getUShort("ws", 81);
 
+    bacnetFdEnabled = prefs.getBool("fd_en", false);
+    bacnetBbmdIp = IPAddress(prefs.getUInt("fd_bbmd", 0));
+    bacnetBbmdPort = prefs.getUShort("fd_port", 47808);
+    bacnetFdTtl = prefs.getUShort("fd_ttl", 300);
+
     // Restore WiFi credentials backup (if EEPROM is empty/corrupt)
     if (wifiSSID.length() == 0) {
         String ssid = prefs.getString("ssid", "");
@@ -287,7 +332,7 @@ void saveWiFiCredentials(String ssid, String password) {
         }
     }
 
-    EEPROM.commit();
+    commitEEPROM();
 
     // Update global variables
     wifiSSID = ssid;
@@ -348,7 +393,7 @@ void saveCommunicationSettings() {
         }
     }
 
-    EEPROM.commit();
+    commitEEPROM();
     debugPrintln("Saved communication protocol: " + currentCommunicationProtocol);
 }
 
@@ -379,7 +424,7 @@ void loadCommunicationSettings() {
 }
 
 void saveCommunicationConfig() {
-    DynamicJsonDocument doc(2048);
+    PooledJsonDocument doc(2048);
 
     // WiFi config
     JsonObject wifi = doc.createNestedObject("wifi");
@@ -426,7 +471,7 @@ void saveCommunicationConfig() {
     EEPROM.write(EEPROM_COMM_CONFIG_ADDR + n, 0);
 
     // Commit changes
-    EEPROM.commit();
+    commitEEPROM();
 
     debugPrintln("Saved communication protocol configuration");
 }
@@ -448,7 +493,7 @@ void loadCommunicationConfig() {
 
     // If we read something, try to parse it
     if (i > 0) {
-        DynamicJsonDocument doc(2048);
+        PooledJsonDocument doc(2048);
         DeserializationError error = deserializeJson(doc, jsonBuffer);
 
         if (!error) {
@@ -500,7 +545,7 @@ void loadCommunicationConfig() {
 }
 
 void saveConfiguration() {
-    DynamicJsonDocument doc(2048);
+    PooledJsonDocument doc(2048);
 
     // Device settings
     doc["device_name"] = deviceName;
@@ -548,7 +593,7 @@ void saveConfiguration() {
     EEPROM.write(EEPROM_CONFIG_ADDR + n, 0);
 
     // Commit changes
-    EEPROM.commit();
+    commitEEPROM();
 
     debugPrintln("Configuration saved to EEPROM");
 }
@@ -570,7 +615,7 @@ void loadConfiguration() {
 
     // If we read something, try to parse it
     if (i > 0) {
-        DynamicJsonDocument doc(2048);
+        PooledJsonDocument doc(2048);
         DeserializationError error = deserializeJson(doc, jsonBuffer);
 
         if (!error) {
@@ -703,13 +748,13 @@ void saveSchedulesToEEPROM() {
     delete[] buffer;
 
     // Commit changes to EEPROM
-    EEPROM.commit();
+    commitEEPROM();
 
     debugPrintln("Schedules saved to EEPROM");
 }
 
 void saveHTSensorConfig() {
-    DynamicJsonDocument doc(512);
+    PooledJsonDocument doc(512);
     JsonArray configArray = doc.createNestedArray("htConfig");
 
     for (int i = 0; i < 3; i++) {
@@ -732,7 +777,7 @@ void saveHTSensorConfig() {
     EEPROM.write(HT_CONFIG_ADDR + n, 0);
 
     // Commit changes
-    EEPROM.commit();
+    commitEEPROM();
 
     debugPrintln("HT sensor configuration saved to EEPROM");
 }
@@ -757,7 +802,7 @@ void loadHTSensorConfig() {
 
     // If we read something, try to parse it
     if (i > 0) {
-        DynamicJsonDocument doc(512);
+        PooledJsonDocument doc(512);
         DeserializationError error = deserializeJson(doc, jsonBuffer);
 
         if (!error && doc.containsKey("htConfig")) {
@@ -0,0 +1,181 @@
+// HeapMonitor.cpp
+// Periodic heap / stack sampling, reported by /api/debug, /api/debug/heap,
+// /metrics and Modbus input registers 30044..30052.
+//
+// Largest free block next to free heap is what shows fragmentation: free heap
+// can hold steady for weeks while the largest block shrinks until a
+// DynamicJsonDocument no longer fits.
+//
+// Allocation tracer (debug builds only): define KC868_ALLOC_TRACE and link with
+//   -Wl,--wrap=malloc -Wl,--wrap=calloc -Wl,--wrap=realloc
+// Every allocation is then counted against its caller's return address;
+// /api/debug/heap lists the busiest sites. Decode them with
+//   xtensa-esp32-elf-addr2line -pfiaC -e <firmware>.elf <address>
+
+#include "../FunctionPrototypes.h"
+#include <esp_heap_caps.h>
+
+HeapStats heapStats = {};
+
+static uint32_t lastHeapSampleMs = 0;
+
+void registerMonitoredTask(const char* name, TaskHandle_t handle) {
+    if (!handle) return;
+    for (uint8_t i = 0; i < heapStats.taskCount; i++) {
+        if (heapStats.tasks[i].handle == handle) return;
+    }
+    if (heapStats.taskCount >= HEAP_MAX_TASKS) return;
+
+    MonitoredTask& t = heapStats.tasks[heapStats.taskCount++];
+    t.name = name;
+    t.handle = handle;
+    t.stackFreeMin = UINT32_MAX;
+}
+
+void sampleHeap() {
+    const uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    const uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    heapStats.freeBytes = freeBytes;
+    heapStats.minFreeBytes = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    heapStats.largestBlock = largest;
+    if (heapStats.samples == 0 || largest < heapStats.largestBlockMin) heapStats.largestBlockMin = largest;
+    heapStats.fragmentationPct = freeBytes ? (uint8_t)(100 - (uint64_t)largest * 100 / freeBytes) : 0;
+    heapStats.samples++;
+
+    for (uint8_t i = 0; i < heapStats.taskCount; i++) {
+        MonitoredTask& t = heapStats.tasks[i];
+        // High-water mark is in bytes on ESP-IDF (words elsewhere)
+        t.stackFree = uxTaskGetStackHighWaterMark(t.handle);
+        if (t.stackFree < t.stackFreeMin) t.stackFreeMin = t.stackFree;
+    }
+}
+
+void serviceHeapMonitor() {
+    if (heapStats.samples != 0 && (uint32_t)(millis() - lastHeapSampleMs) < HEAP_SAMPLE_MS) return;
+    lastHeapSampleMs = millis();
+
+    // First call comes from the loop task
+    if (heapStats.samples == 0) {
+        registerMonitoredTask("loop", xTaskGetCurrentTaskHandle());
+        registerMonitoredTask("http", server.taskHandle());
+    }
+    sampleHeap();
+}
+
+void heapStatsJson(JsonObject obj) {
+    obj["free"] = heapStats.freeBytes;
+    obj["min_free"] = heapStats.minFreeBytes;
+    obj["largest_block"] = heapStats.largestBlock;
+    obj["largest_block_min"] = heapStats.largestBlockMin;
+    obj["fragmentation_pct"] = heapStats.fragmentationPct;
+
+    JsonArray tasks = obj.createNestedArray("tasks");
+    for (uint8_t i = 0; i < heapStats.taskCount; i++) {
+        JsonObject t = tasks.createNestedObject();
+        t["name"] = heapStats.tasks[i].name;
+        t["stack_free"] = heapStats.tasks[i].stackFree;
+        t["stack_free_min"] = heapStats.tasks[i].stackFreeMin;
+    }
+}
+
+// ---- Allocation tracer ----
+
+#ifdef KC868_ALLOC_TRACE
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+}
+
+struct AllocSite {
+    uintptr_t site;
+    uint32_t count;
+    uint32_t bytes;
+};
+
+static AllocSite allocSites[ALLOC_TRACE_SITES];
+static uint32_t allocUntracked = 0;     // table full
+static portMUX_TYPE allocMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Runs inside the allocator, from any task: no allocation, no logging
+static void IRAM_ATTR recordAlloc(void* site, size_t size) {
+    const uintptr_t key = (uintptr_t)site;
+    portENTER_CRITICAL_SAFE(&allocMux);
+    uint32_t slot = (key >> 2) % ALLOC_TRACE_SITES;
+    for (uint32_t probe = 0; probe < ALLOC_TRACE_SITES; probe++) {
+        AllocSite& s = allocSites[slot];
+        if (s.site == key || s.site == 0) {
+            s.site = key;
+            s.count++;
+            s.bytes += size;
+            portEXIT_CRITICAL_SAFE(&allocMux);
+            return;
+        }
+        slot = (slot + 1) % ALLOC_TRACE_SITES;
+    }
+    allocUntracked++;
+    portEXIT_CRITICAL_SAFE(&allocMux);
+}
+
+extern "C" void* __wrap_malloc(size_t size) {
+    recordAlloc(__builtin_return_address(0), size);
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t n, size_t size) {
+    recordAlloc(__builtin_return_address(0), n * size);
+    return __real_calloc(n, size);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+    recordAlloc(__builtin_return_address(0), size);
+    return __real_realloc(ptr, size);
+}
+
+void allocTraceJson(JsonObject obj) {
+    // Copy under the lock, then sort the top sites by bytes outside it
+    static AllocSite snapshot[ALLOC_TRACE_SITES];
+    portENTER_CRITICAL(&allocMux);
+    memcpy(snapshot, allocSites, sizeof(snapshot));
+    const uint32_t untracked = allocUntracked;
+    portEXIT_CRITICAL(&allocMux);
+
+    obj["enabled"] = true;
+    obj["untracked"] = untracked;
+    JsonArray sites = obj.createNestedArray("sites");
+    for (uint8_t n = 0; n < ALLOC_TRACE_REPORT; n++) {
+        int best = -1;
+        for (int i = 0; i < ALLOC_TRACE_SITES; i++) {
+            if (snapshot[i].site && (best < 0 || snapshot[i].bytes > snapshot[best].bytes)) best = i;
+        }
+        if (best < 0) break;
+
+        char addr[12];
+        snprintf(addr, sizeof(addr), "0x%08lx", (unsigned long)snapshot[best].site);
+        JsonObject s = sites.createNestedObject();
+        s["site"] = addr;
+        s["count"] = snapshot[best].count;
+        s["bytes"] = snapshot[best].bytes;
+        snapshot[best].site = 0;
+    }
+}
+
+#else
+
+void allocTraceJson(JsonObject obj) {
+    obj["enabled"] = false;
+}
+
+#endif
+
+void handleHeapDebug() {
+    PooledJsonDocument doc(2048);
+    heapStatsJson(doc.createNestedObject("heap"));
+    allocTraceJson(doc.createNestedObject("alloc_trace"));
+
+    String response;
+    serializeJson(doc, response);
+    server.send(200, "application/json", response);
+}
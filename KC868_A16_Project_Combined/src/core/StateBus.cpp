@@ -0,0 +1,59 @@
+// StateBus.cpp
+// Hand-off from callbacks running in other tasks to the main loop.
+//
+// Network (and any future driver) callbacks run in the ESP-IDF event task. They
+// must not touch application state (ethConnected, outputStates, ...) or call
+// broadcastUpdate(), which walks the WebSocket server the loop is using. Instead
+// they post a small StateEvent here; serviceStateBus() runs at the top of every
+// loop iteration and applies the events in order, on the task that owns the state.
+
+#include "../FunctionPrototypes.h"
+#include <freertos/queue.h>
+
+static QueueHandle_t stateQueue = nullptr;
+static volatile uint32_t stateEventsPosted = 0;
+static volatile uint32_t stateEventsDropped = 0;
+
+void initStateBus() {
+    if (!stateQueue) stateQueue = xQueueCreate(STATE_BUS_DEPTH, sizeof(StateEvent));
+}
+
+// Any task (not ISRs). Never blocks: a full queue drops the event and counts it.
+bool postStateEvent(uint8_t type, uint16_t code, uint32_t arg) {
+    if (!stateQueue) return false;
+
+    const StateEvent ev = { type, code, arg };
+    if (xQueueSend(stateQueue, &ev, 0) != pdTRUE) {
+        stateEventsDropped++;
+        return false;
+    }
+    stateEventsPosted++;
+    return true;
+}
+
+// Main loop only
+void serviceStateBus() {
+    if (!stateQueue) return;
+
+    StateEvent ev;
+    while (xQueueReceive(stateQueue, &ev, 0) == pdTRUE) {
+        switch (ev.type) {
+        case STATE_EVENT_ETH:
+            applyEthEvent((arduino_event_id_t)ev.code, ev.arg);
+            break;
+        case STATE_EVENT_WIFI:
+            applyWiFiEvent((arduino_event_id_t)ev.code, ev.arg);
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+uint32_t stateBusPosted() {
+    return stateEventsPosted;
+}
+
+uint32_t stateBusDropped() {
+    return stateEventsDropped;
+}
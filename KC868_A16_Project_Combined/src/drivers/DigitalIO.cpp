@@ -51,6 +51,37 @@ void printIOStates() {
     Serial.println("----------------------------");
 }
 
+// Bank 0 = inputs 1-8 (IC1), bank 1 = inputs 9-16 (IC2). readInputs() and
+// the interrupt and poll paths all read the banks, often in the same loop
+// pass, so a read younger than I2C_INPUT_CACHE_MS is reused.
+// Inputs are active LOW: a set bit is an input at rest.
+bool readInputBank(uint8_t bank, uint8_t& bits) {
+    static uint8_t cached[2];
+    static uint32_t readAtMs[2];
+    static bool valid[2] = { false, false };
+
+    const uint32_t now = millis();
+    if (valid[bank] && now - readAtMs[bank] < I2C_INPUT_CACHE_MS) {
+        bits = cached[bank];
+        return true;
+    }
+
+    const uint8_t address = bank ? PCF8574_INPUTS_9_16 : PCF8574_INPUTS_1_8;
+    valid[bank] = i2cRead(address, &cached[bank], 1, I2C_PRIO_HIGH);
+    if (valid[bank]) {
+        readAtMs[bank] = now;
+        bits = cached[bank];
+        return true;
+    }
+
+    const char* ic = bank ? "IC2" : "IC1";
+    i2cErrorCount++;
+    metrics.i2cErrors[bank ? METRIC_I2C_INPUTS_9_16 : METRIC_I2C_INPUTS_1_8]++;
+    lastErrorMessage = "Error reading from Input " + String(ic);
+    debugPrintln("Error reading from Input " + String(ic));
+    return false;
+}
+
 bool readInputs() {
     bool anyChanged = false;
     bool success = true;
@@ -68,61 +99,30 @@ bool readInputs() {
         prevDirectInputStates[i] = directInputStates[i];
     }
 
-    // Read from PCF8574 input expanders using the PCF8574 library
-    // Inputs 1-8 (IC1)
-    for (int i = 0; i < 8; i++) {
-        bool newState = false;
-        try {
-            newState = inputIC1.digitalRead(i);
-        }
-        catch (const std::exception& e) {
-            i2cErrorCount++;
-            lastErrorMessage = "Error reading from Input IC1";
+    // Read the PCF8574 input expanders, one byte per bank
+    for (int bank = 0; bank < 2; bank++) {
+        uint8_t bits;
+        if (!readInputBank(bank, bits)) {
             success = false;
-            debugPrintln("Error reading from Input IC1: " + String(e.what()));
             continue;
         }
 
-        // Invert because of the pull-up configuration (LOW = active/true)
-        newState = !newState;
+        for (int b = 0; b < 8; b++) {
+            const int i = bank * 8 + b;
 
-        if (inputStates[i] != newState) {
-            inputStates[i] = newState;
-            anyChanged = true;
-            debugPrintln("Input " + String(i + 1) + " changed to " + String(newState ? "HIGH" : "LOW"));
+            // Invert because of the pull-up configuration (LOW = active/true)
+            const bool newState = !(bits & (1 << b));
 
-            // Process this specific input change
-            if (inputInterruptsEnabled && interruptConfigs[i].enabled) {
-                processInputChange(i, newState);
-            }
-        }
-    }
+            if (inputStates[i] != newState) {
+                inputStates[i] = newState;
+                metrics.inputEdges[i]++;
+                anyChanged = true;
+                debugPrintln("Input " + String(i + 1) + " changed to " + String(newState ? "HIGH" : "LOW"));
 
-    // Inputs 9-16 (IC2)
-    for (int i = 0; i < 8; i++) {
-        bool newState = false;
-        try {
-            newState = inputIC2.digitalRead(i);
-        }
-        catch (const std::exception& e) {
-            i2cErrorCount++;
-            lastErrorMessage = "Error reading from Input IC2";
-            success = false;
-            debugPrintln("Error reading from Input IC2: " + String(e.what()));
-            continue;
-        }
-
-        // Invert because of the pull-up configuration (LOW = active/true)
-        newState = !newState;
-
-        if (inputStates[i + 8] != newState) {
-            inputStates[i + 8] = newState;
-            anyChanged = true;
-            debugPrintln("Input " + String(i + 9) + " changed to " + String(newState ? "HIGH" : "LOW"));
-
-            // Process this specific input change
-            if (inputInterruptsEnabled && interruptConfigs[i + 8].enabled) {
-                processInputChange(i + 8, newState);
+                // Process this specific input change
+                if (inputInterruptsEnabled && interruptConfigs[i].enabled) {
+                    processInputChange(i, newState);
+                }
             }
         }
     }
@@ -134,18 +134,21 @@ bool readInputs() {
 
     if (directInputStates[0] != ht1) {
         directInputStates[0] = ht1;
+        metrics.inputEdges[16]++;
         anyChanged = true;
         debugPrintln("HT1 changed to " + String(ht1 ? "HIGH" : "LOW"));
     }
 
     if (directInputStates[1] != ht2) {
         directInputStates[1] = ht2;
+        metrics.inputEdges[17]++;
         anyChanged = true;
         debugPrintln("HT2 changed to " + String(ht2 ? "HIGH" : "LOW"));
     }
 
     if (directInputStates[2] != ht3) {
         directInputStates[2] = ht3;
+        metrics.inputEdges[18]++;
         anyChanged = true;
         debugPrintln("HT3 changed to " + String(ht3 ? "HIGH" : "LOW"));
     }
@@ -164,36 +167,34 @@ bool readInputs() {
     return anyChanged;
 }
 
-bool writeOutputs() {
-    bool success = true;
-
-    // Set outputs 1-8 (IC4)
+// Write one output expander in a single I2C transaction.
+// Relays are active LOW, so an ON output is a 0 bit on the PCF8574.
+static bool writeOutputExpander(uint8_t address, const bool* states) {
+    uint8_t bits = 0xFF;
     for (int i = 0; i < 8; i++) {
-        try {
-            // Write HIGH when output state is false (relays are active LOW)
-            outputIC4.digitalWrite(i, outputStates[i] ? LOW : HIGH);
-        }
-        catch (const std::exception& e) {
-            i2cErrorCount++;
-            lastErrorMessage = "Failed to write to Output IC4";
-            success = false;
-            debugPrintln("Error writing to Output IC4: " + String(e.what()));
-        }
+        if (states[i]) bits &= ~(1 << i);
     }
+    return i2cWrite(address, &bits, 1, I2C_PRIO_HIGH);
+}
 
-    // Set outputs 9-16 (IC3)
-    for (int i = 0; i < 8; i++) {
-        try {
-            // Write HIGH when output state is false (relays are active LOW)
-            outputIC3.digitalWrite(i, outputStates[i + 8] ? LOW : HIGH);
-        }
-        catch (const std::exception& e) {
-            i2cErrorCount++;
-            lastErrorMessage = "Failed to write to Output IC3";
-            success = false;
-            debugPrintln("Error writing to Output IC3: " + String(e.what()));
-        }
-    }
+// Bank 0 = outputs 1-8 (IC4), bank 1 = outputs 9-16 (IC3)
+bool writeOutputBank(uint8_t bank) {
+    const uint8_t address = bank ? PCF8574_OUTPUTS_9_16 : PCF8574_OUTPUTS_1_8;
+    if (writeOutputExpander(address, &outputStates[bank ? 8 : 0])) return true;
+
+    const char* ic = bank ? "IC3" : "IC4";
+    i2cErrorCount++;
+    metrics.i2cErrors[bank ? METRIC_I2C_OUTPUTS_9_16 : METRIC_I2C_OUTPUTS_1_8]++;
+    lastErrorMessage = "Failed to write to Output " + String(ic);
+    debugPrintln("Error writing to Output " + String(ic));
+
+    // The bus manager has already cleared the bus if the error left it stuck
+    return false;
+}
+
+// Both banks from outputStates, unconditionally (start-up; see OutputManager)
+bool writeOutputs() {
+    const bool success = writeOutputBank(0) & writeOutputBank(1);
 
     if (success) {
         debugPrintln("Successfully updated all relays");
@@ -203,11 +204,7 @@ bool writeOutputs() {
     }
     else {
         debugPrintln("ERROR: Failed to write to some output expanders");
-        // Try to recover I2C bus
-        Wire.flush();
-        delay(50);
     }
 
     return success;
 }
-
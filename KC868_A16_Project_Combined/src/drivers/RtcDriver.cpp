@@ -11,6 +11,13 @@ const char* NTP2 = "time.nist.gov";
 // ====== Melbourne TZ (Australia/Melbourne) ======
 static const char* TZ_MELBOURNE = "AEST-10AEDT-11,M10.1.0/2,M4.1.0/3";
 
+// Last DS3231 reading (see readRtc)
+static DateTime rtcLast;
+static uint32_t rtcLastMs = 0;
+static uint32_t rtcAttemptMs = 0;
+static bool rtcCached = false;
+static bool rtcAttempted = false;
+
 // ====== Helpers ======
 static bool waitForSystemTime(int maxRetries = 20, int delayMs = 500) {
     time_t now = time(nullptr);
@@ -40,18 +47,22 @@ static void updateRTCFromSystemUTC() {
     struct tm tm_utc;
     gmtime_r(&now, &tm_utc);
 
+    if (!i2cBeginDevice(I2C_PRIO_HIGH)) return;
     rtc.adjust(DateTime(tm_utc.tm_year + 1900,
         tm_utc.tm_mon + 1,
         tm_utc.tm_mday,
         tm_utc.tm_hour,
         tm_utc.tm_min,
         tm_utc.tm_sec));
+    i2cEndDevice(RTC_I2C_ADDRESS, true);
+    rtcCached = rtcAttempted = false;
     debugPrintln("Updated RTC with system UTC time");
 }
 
 // If RTC exists, load system time from RTC (assumes RTC holds UTC)
 static void setSystemFromRTCUTC() {
-    DateTime r = rtc.now(); // read RTC
+    DateTime r;
+    if (!readRtc(r)) return;
     struct tm tm_utc {};
     tm_utc.tm_year = r.year() - 1900;
     tm_utc.tm_mon = r.month() - 1;
@@ -82,7 +93,9 @@ void initRTC() {
     // Always set TZ for Melbourne early so getTimeString() returns local time.
     setMelbourneTimezone();
 
+    i2cBeginDevice(I2C_PRIO_HIGH);
     rtcInitialized = rtc.begin();
+    i2cEndDevice(RTC_I2C_ADDRESS, rtcInitialized);
     if (!rtcInitialized) {
         debugPrintln("Couldn't find RTC, using ESP32 internal time");
 
@@ -93,12 +106,18 @@ void initRTC() {
 
     debugPrintln("RTC found");
 
-    if (rtc.lostPower()) {
+    i2cBeginDevice(I2C_PRIO_HIGH);
+    const bool lostPower = rtc.lostPower();
+    i2cEndDevice(RTC_I2C_ADDRESS, true);
+
+    if (lostPower) {
         debugPrintln("RTC lost power -> setting RTC to compile time (treated as UTC here), then NTP will correct.");
 
         // NOTE: Compile time is NOT UTC; it's your PC local time when compiled.
         // We set it anyway as a fallback; NTP should overwrite shortly.
+        i2cBeginDevice(I2C_PRIO_HIGH);
         rtc.adjust(DateTime(F(__DATE__), F(__TIME__)));
+        i2cEndDevice(RTC_I2C_ADDRESS, true);
 
         // Try to get accurate time from NTP and store to RTC (UTC)
         syncTimeFromNTP();
@@ -112,18 +131,63 @@ void initRTC() {
     }
 
     // Print current RTC time (as UTC) and system local time (Melbourne)
-    DateTime r = rtc.now();
-    String rtcUtc = String(r.year()) + "-" +
-        String(r.month()) + "-" +
-        String(r.day()) + " " +
-        String(r.hour()) + ":" +
-        String(r.minute()) + ":" +
-        String(r.second());
-    debugPrintln("RTC time (stored UTC): " + rtcUtc);
+    DateTime r;
+    if (readRtc(r)) {
+        String rtcUtc = String(r.year()) + "-" +
+            String(r.month()) + "-" +
+            String(r.day()) + " " +
+            String(r.hour()) + ":" +
+            String(r.minute()) + ":" +
+            String(r.second());
+        debugPrintln("RTC time (stored UTC): " + rtcUtc);
+    }
 
     debugPrintln("System local time (Melbourne): " + getTimeString());
 }
 
+// DS3231 time, read through the bus manager at low priority. A reading is
+// taken at most every RTC_READ_INTERVAL_MS and advanced by millis() in
+// between, so the schedulers and the Modbus map do not put a transaction on
+// the bus every pass. False when there is no RTC or no reading yet.
+bool readRtc(DateTime& out) {
+    if (!rtcInitialized) return false;
+
+    const uint32_t now = millis();
+    if (!rtcAttempted || now - rtcAttemptMs >= RTC_READ_INTERVAL_MS) {
+        if (i2cBeginDevice(I2C_PRIO_LOW)) {
+            rtcAttempted = true;
+            rtcAttemptMs = now;
+
+            const DateTime r = rtc.now();
+            // A failed read comes back as 0xFF bytes
+            const bool ok = r.month() >= 1 && r.month() <= 12 && r.day() >= 1 && r.day() <= 31 && r.hour() < 24;
+            i2cEndDevice(RTC_I2C_ADDRESS, ok);
+
+            if (ok) {
+                rtcLast = r;
+                rtcLastMs = now;
+                rtcCached = true;
+            }
+        }
+    }
+
+    if (!rtcCached) return false;
+    out = DateTime(rtcLast.unixtime() + (now - rtcLastMs) / 1000);
+    return true;
+}
+
+// Unix time for records kept past this boot (event journal, trend logs): the
+// system clock once NTP, a client or the RTC has set it, else the DS3231
+// directly (it may have missed the boot-time read). TIME_INVALID when neither
+// knows the time; readers leave such records out of searches by time.
+uint32_t timestampNow() {
+    const time_t now = time(nullptr);
+    if (now >= (time_t)TIME_VALID_EPOCH) return (uint32_t)now;
+
+    DateTime r;
+    if (readRtc(r) && r.unixtime() >= TIME_VALID_EPOCH) return r.unixtime();
+    return TIME_INVALID;
+}
 
 void syncTimeFromNTP() {
     debugPrintln("Syncing time from NTP (Melbourne TZ will be applied to localtime) ...");
@@ -170,6 +234,7 @@ void syncTimeFromClient(int year, int month, int day, int hour, int minute, int
 
     struct timeval now = { .tv_sec = t, .tv_usec = 0 };
     settimeofday(&now, nullptr);
+    logEvent(EVENT_TIME_SET, 0xFF, 0, 0, 0);
     debugPrintln("Updated system time with client LOCAL time (Melbourne)");
 
     if (rtcInitialized) {
@@ -1,55 +1,287 @@
 // I2CBus.cpp
-// Auto-split from original KC868_A16_Controller.ino
+// I2C bus manager: the only code that touches Wire
+//
+// Every transaction goes through i2cWrite / i2cRead / i2cProbe, or is
+// bracketed by i2cBeginDevice / i2cEndDevice for library drivers (RTClib).
+// A mutex serializes them. High-priority callers (expander I/O, scans) wait
+// for the bus; low-priority ones (RTC reads) give up at once when it is taken
+// or when it is backing off after a failed bus clear, so a stuck bus cannot
+// stall the loop on housekeeping traffic.
+//
+// Recovery: a timeout, or an error that leaves SDA or SCL low, ends Wire and
+// clears the bus by hand: wait out a stretched clock, clock out up to nine
+// bits for a slave cut off mid-byte, send a STOP, start Wire again.
+//
+// Clock: starts at I2C_CLOCK_SLOW. A window of I2C_CLEAN_WINDOW error-free
+// transactions steps it up (100 kHz, then 400 kHz); I2C_SLOW_DOWN_ERRORS
+// errors within a window step it down and hold it there for
+// I2C_SPEED_HOLD_MS, so a long or noisy cable settles on the rate it carries.
 
 #include "../FunctionPrototypes.h"
 
-void initI2C() {
+static const uint32_t clockSteps[] = { I2C_CLOCK_SLOW, I2C_CLOCK_STANDARD, I2C_CLOCK_FAST };
+static const uint8_t CLOCK_STEPS = sizeof(clockSteps) / sizeof(clockSteps[0]);
+
+static SemaphoreHandle_t busLock = nullptr;
+static I2CBusStats bus = {};
+static I2CDeviceStats devices[I2C_MAX_DEVICES];
+static uint8_t deviceCount = 0;
+
+static uint8_t clockStep = 0;
+static uint32_t windowCount = 0;
+static uint32_t windowErrors = 0;
+static bool slowed = false;             // stepped down, holding for I2C_SPEED_HOLD_MS
+static uint32_t slowedAtMs = 0;
+static bool backoff = false;            // bus clear failed, low priority refused
+static uint32_t backoffAtMs = 0;
+static uint32_t deviceStartUs = 0;
+
+static bool linesIdle() {
+    return digitalRead(SDA_PIN) == HIGH && digitalRead(SCL_PIN) == HIGH;
+}
+
+static bool backingOff() {
+    if (backoff && millis() - backoffAtMs >= I2C_BACKOFF_MS) backoff = false;
+    return backoff;
+}
+
+static void startWire() {
+    Wire.begin(SDA_PIN, SCL_PIN, clockSteps[clockStep]);
+    Wire.setTimeOut(I2C_TIMEOUT_MS);
+    bus.clockHz = clockSteps[clockStep];
+}
+
+// ---- Recovery ----
 
-    // Configure input pins (set as inputs with pull-ups)
-    for (int i = 0; i < 8; i++) {
-        inputIC1.pinMode(i, INPUT);
-        inputIC2.pinMode(i, INPUT);
+static void clearBus() {
+    bus.recoveries++;
+    Wire.end();
+
+    pinMode(SDA_PIN, INPUT_PULLUP);
+    pinMode(SCL_PIN, INPUT_PULLUP);
+
+    // A slave stretching the clock holds SCL low; give it one timeout to let go
+    const uint32_t start = millis();
+    while (digitalRead(SCL_PIN) == LOW && millis() - start < I2C_TIMEOUT_MS) {
+        delayMicroseconds(10);
     }
 
-    // Configure output pins (set as outputs)
-    for (int i = 0; i < 8; i++) {
-        outputIC3.pinMode(i, OUTPUT);
-        outputIC4.pinMode(i, OUTPUT);
+    // A slave cut off mid-byte holds SDA low until the rest of the byte is clocked out
+    pinMode(SCL_PIN, OUTPUT_OPEN_DRAIN);
+    digitalWrite(SCL_PIN, HIGH);
+    for (int i = 0; i < 9 && digitalRead(SDA_PIN) == LOW; i++) {
+        digitalWrite(SCL_PIN, LOW);
+        delayMicroseconds(5);           // ~100 kHz
+        digitalWrite(SCL_PIN, HIGH);
+        delayMicroseconds(5);
     }
 
+    // STOP: SDA rises while SCL is high
+    pinMode(SDA_PIN, OUTPUT_OPEN_DRAIN);
+    digitalWrite(SDA_PIN, LOW);
+    delayMicroseconds(5);
+    digitalWrite(SDA_PIN, HIGH);
+    delayMicroseconds(5);
+
+    pinMode(SDA_PIN, INPUT_PULLUP);
+    pinMode(SCL_PIN, INPUT_PULLUP);
+    const bool freed = linesIdle();
+
+    startWire();
+
+    if (!freed) {
+        bus.recoveryFailures++;
+        backoff = true;
+        backoffAtMs = millis();
+        i2cErrorCount++;
+        lastErrorMessage = "I2C bus held low";
+    }
+    debugPrintln(String("I2C bus cleared") + (freed ? "" : ", a line is still held low"));
+}
+
+// ---- Clock ----
+
+static void setClockStep(uint8_t step) {
+    clockStep = step;
+    Wire.setClock(clockSteps[step]);
+    bus.clockHz = clockSteps[step];
+    bus.clockChanges++;
+    debugPrintln("I2C clock " + String(bus.clockHz / 1000) + " kHz");
+}
+
+static void adaptClock() {
+    if (windowErrors >= I2C_SLOW_DOWN_ERRORS) {
+        if (clockStep > 0) setClockStep(clockStep - 1);
+        slowed = true;
+        slowedAtMs = millis();
+        windowCount = windowErrors = 0;
+    }
+    else if (windowCount >= I2C_CLEAN_WINDOW) {
+        if (slowed && millis() - slowedAtMs >= I2C_SPEED_HOLD_MS) slowed = false;
+        if (windowErrors == 0 && !slowed && clockStep + 1 < CLOCK_STEPS) setClockStep(clockStep + 1);
+        windowCount = windowErrors = 0;
+    }
+}
+
+// ---- Accounting ----
+
+static I2CDeviceStats* deviceSlot(uint8_t address) {
+    for (uint8_t i = 0; i < deviceCount; i++) {
+        if (devices[i].address == address) return &devices[i];
+    }
+    if (deviceCount == I2C_MAX_DEVICES) return nullptr;
+    I2CDeviceStats& d = devices[deviceCount++];
+    memset(&d, 0, sizeof(d));
+    d.address = address;
+    return &d;
+}
+
+// err is the Wire status: 0 ok, 2/3 NACK, 4 other, 5 timeout
+static void recordTransaction(uint8_t address, uint8_t err, uint32_t startUs) {
+    const uint32_t us = micros() - startUs;
+    bus.transactions++;
+    windowCount++;
+
+    I2CDeviceStats* d = deviceSlot(address);
+    if (d) {
+        d->transactions++;
+        d->lastUs = us;
+        if (us > d->maxUs) d->maxUs = us;
+        d->totalUs += us;
+    }
+
+    if (err != 0) {
+        bus.errors++;
+        windowErrors++;
+        if (d) {
+            d->errors++;
+            d->lastError = err;
+        }
+
+        // A NACK leaves the bus idle; a timeout or a line held low needs clearing
+        if (err == 5 || !linesIdle()) clearBus();
+    }
+
+    adaptClock();
+}
 
-    // Initialize PCF8574 ICs
-    if (!inputIC1.begin()) {
+static bool takeBus(uint8_t priority) {
+    if (!busLock) return false;
+    if (priority == I2C_PRIO_LOW) {
+        if (backingOff() || xSemaphoreTake(busLock, 0) != pdTRUE) {
+            bus.deferred++;
+            return false;
+        }
+        return true;
+    }
+    return xSemaphoreTake(busLock, portMAX_DELAY) == pdTRUE;
+}
+
+// ---- Transactions ----
+
+bool i2cWrite(uint8_t address, const uint8_t* data, size_t len, uint8_t priority) {
+    if (!takeBus(priority)) return false;
+
+    const uint32_t start = micros();
+    Wire.beginTransmission(address);
+    Wire.write(data, len);
+    const uint8_t err = Wire.endTransmission();
+    recordTransaction(address, err, start);
+
+    xSemaphoreGive(busLock);
+    return err == 0;
+}
+
+bool i2cRead(uint8_t address, uint8_t* data, size_t len, uint8_t priority) {
+    if (!takeBus(priority)) return false;
+
+    const uint32_t start = micros();
+    const size_t got = Wire.requestFrom(address, (uint8_t)len);
+    for (size_t i = 0; i < got && i < len; i++) data[i] = Wire.read();
+    // Wire gives no detail for a short read
+    recordTransaction(address, got == len ? 0 : 4, start);
+
+    xSemaphoreGive(busLock);
+    return got == len;
+}
+
+// Address-only write for scans. Absent addresses NACK, which is the answer
+// rather than an error, so probes stay out of the counters.
+bool i2cProbe(uint8_t address) {
+    if (!takeBus(I2C_PRIO_HIGH)) return false;
+    Wire.beginTransmission(address);
+    const bool found = Wire.endTransmission() == 0;
+    xSemaphoreGive(busLock);
+    return found;
+}
+
+// Library drivers that talk to Wire themselves run between these two
+bool i2cBeginDevice(uint8_t priority) {
+    if (!takeBus(priority)) return false;
+    deviceStartUs = micros();
+    return true;
+}
+
+void i2cEndDevice(uint8_t address, bool ok) {
+    recordTransaction(address, ok ? 0 : 4, deviceStartUs);
+    xSemaphoreGive(busLock);
+}
+
+// ---- Inspection ----
+
+uint8_t i2cDeviceCount() {
+    return deviceCount;
+}
+
+const I2CDeviceStats* i2cDeviceStats(uint8_t index) {
+    return index < deviceCount ? &devices[index] : nullptr;
+}
+
+const I2CBusStats& i2cBusStats() {
+    return bus;
+}
+
+// ---- Start-up ----
+
+void initI2CBus() {
+    busLock = xSemaphoreCreateMutex();
+    startWire();
+
+    // A reset in the middle of a transfer can leave a slave holding SDA
+    if (!linesIdle()) clearBus();
+
+    debugPrintln("I2C bus at " + String(bus.clockHz / 1000) + " kHz");
+}
+
+void initI2C() {
+    // A PCF8574 pin written high is released to its weak pull-up: an input,
+    // or a relay off (active low). One byte sets all eight pins.
+    const uint8_t released = 0xFF;
+
+    if (!i2cWrite(PCF8574_INPUTS_1_8, &released, 1, I2C_PRIO_HIGH)) {
         Serial.println("Error: Could not initialize Input IC1 (0x22)");
         i2cErrorCount++;
         lastErrorMessage = "Failed to initialize Input IC1";
     }
 
-    if (!inputIC2.begin()) {
+    if (!i2cWrite(PCF8574_INPUTS_9_16, &released, 1, I2C_PRIO_HIGH)) {
         Serial.println("Error: Could not initialize Input IC2 (0x21)");
         i2cErrorCount++;
         lastErrorMessage = "Failed to initialize Input IC2";
     }
 
-    if (!outputIC3.begin()) {
+    if (!i2cWrite(PCF8574_OUTPUTS_9_16, &released, 1, I2C_PRIO_HIGH)) {
         Serial.println("Error: Could not initialize Output IC3 (0x25)");
         i2cErrorCount++;
         lastErrorMessage = "Failed to initialize Output IC3";
     }
 
-    if (!outputIC4.begin()) {
+    if (!i2cWrite(PCF8574_OUTPUTS_1_8, &released, 1, I2C_PRIO_HIGH)) {
         Serial.println("Error: Could not initialize Output IC4 (0x24)");
         i2cErrorCount++;
         lastErrorMessage = "Failed to initialize Output IC4";
     }
 
-
-    // Initialize all outputs to HIGH (OFF state due to inverted logic)
-    for (int i = 0; i < 8; i++) {
-        outputIC3.digitalWrite(i, HIGH);
-        outputIC4.digitalWrite(i, HIGH);
-    }
-
     // Initialize input state arrays
     for (int i = 0; i < 16; i++) {
         inputStates[i] = true;   // Default HIGH (pull-up)
@@ -57,4 +289,3 @@ void initI2C() {
 
     debugPrintln("I2C and PCF8574 expanders initialized successfully");
 }
-
@@ -3,9 +3,20 @@
 
 #include "../FunctionPrototypes.h"
 
+static ThresholdState triggerStates[MAX_ANALOG_TRIGGERS];
+
+bool analogTriggerActive(int index) {
+    return index >= 0 && index < MAX_ANALOG_TRIGGERS && triggerStates[index].active;
+}
+
+// Runs on every analog sample; actions fire only when a trigger becomes active
 void checkAnalogTriggers() {
     for (int i = 0; i < MAX_ANALOG_TRIGGERS; i++) {
-        if (!analogTriggers[i].enabled) continue;
+        ThresholdState& state = triggerStates[i];
+        if (!analogTriggers[i].enabled) {
+            state = {};
+            continue;
+        }
 
         bool triggerConditionMet = false;
 
@@ -16,44 +27,31 @@ void checkAnalogTriggers() {
             if (sensorIndex < 3 && htSensorConfig[sensorIndex].sensorType != SENSOR_TYPE_DIGITAL) {
                 float sensorValue;
 
+                float hysteresis = analogTriggers[i].sensorHysteresis;
+
                 // Get the appropriate sensor value based on type (temperature/humidity)
                 if (analogTriggers[i].sensorTriggerType == 0) { // Temperature
                     sensorValue = htSensorConfig[sensorIndex].temperature;
+                    if (hysteresis <= 0.0f) hysteresis = TRIGGER_HYST_TEMP;
                 }
                 else { // Humidity
                     sensorValue = htSensorConfig[sensorIndex].humidity;
+                    if (hysteresis <= 0.0f) hysteresis = TRIGGER_HYST_HUMIDITY;
                 }
 
-                // Check condition
-                switch (analogTriggers[i].sensorCondition) {
-                case 0: // Above
-                    triggerConditionMet = (sensorValue > analogTriggers[i].sensorThreshold);
-                    break;
-                case 1: // Below
-                    triggerConditionMet = (sensorValue < analogTriggers[i].sensorThreshold);
-                    break;
-                case 2: // Equal (with tolerance)
-                    triggerConditionMet = (abs(sensorValue - analogTriggers[i].sensorThreshold) < 0.5);
-                    break;
-                }
+                state.level = thresholdLevel(state.level, sensorValue, analogTriggers[i].sensorThreshold,
+                                             analogTriggers[i].sensorCondition, 0.5f, hysteresis);
+                triggerConditionMet = state.level;
             }
         }
         // Standard analog input check
         else if (analogTriggers[i].analogInput < 4) {
             int value = analogValues[analogTriggers[i].analogInput];
+            const uint16_t hysteresis = analogTriggers[i].hysteresis ? analogTriggers[i].hysteresis : TRIGGER_HYST_RAW;
 
-            // Check condition
-            switch (analogTriggers[i].condition) {
-            case 0: // Above
-                triggerConditionMet = (value > analogTriggers[i].threshold);
-                break;
-            case 1: // Below
-                triggerConditionMet = (value < analogTriggers[i].threshold);
-                break;
-            case 2: // Equal (with tolerance)
-                triggerConditionMet = (abs(value - analogTriggers[i].threshold) < 50);
-                break;
-            }
+            state.level = thresholdLevel(state.level, value, analogTriggers[i].threshold,
+                                         analogTriggers[i].condition, 50, hysteresis);
+            triggerConditionMet = state.level;
         }
 
         // If this is a combined trigger, check digital inputs too
@@ -119,46 +117,22 @@ void checkAnalogTriggers() {
             triggerConditionMet = triggerConditionMet && inputConditionMet;
         }
 
-        // If all conditions are met, execute the action
-        if (triggerConditionMet) {
+        // Act once, when the trigger becomes active
+        if (updateThresholdState(state, triggerConditionMet, analogTriggers[i].minOnSec, analogTriggers[i].minOffSec) &&
+            state.active) {
             debugPrintln("Analog trigger activated: " + String(analogTriggers[i].name));
 
             // Perform the trigger action
-            if (analogTriggers[i].targetType == 0) {
+            const AnalogTrigger& t = analogTriggers[i];
+            if (t.targetType == 0) {
                 // Single output
-                uint8_t relay = analogTriggers[i].targetId;
-                if (relay < 16) {
-                    if (analogTriggers[i].action == 0) {        // OFF
-                        outputStates[relay] = false;
-                    }
-                    else if (analogTriggers[i].action == 1) { // ON
-                        outputStates[relay] = true;
-                    }
-                    else if (analogTriggers[i].action == 2) { // TOGGLE
-                        outputStates[relay] = !outputStates[relay];
-                    }
-                }
+                if (t.targetId < 16) commandOutputAction(OUTPUT_SRC_TRIGGER, 1u << t.targetId, t.action);
             }
-            else if (analogTriggers[i].targetType == 1) {
+            else if (t.targetType == 1) {
                 // Multiple outputs (using bitmask)
-                for (int j = 0; j < 16; j++) {
-                    if (analogTriggers[i].targetId & (1 << j)) {
-                        if (analogTriggers[i].action == 0) {        // OFF
-                            outputStates[j] = false;
-                        }
-                        else if (analogTriggers[i].action == 1) { // ON
-                            outputStates[j] = true;
-                        }
-                        else if (analogTriggers[i].action == 2) { // TOGGLE
-                            outputStates[j] = !outputStates[j];
-                        }
-                    }
-                }
+                commandOutputAction(OUTPUT_SRC_TRIGGER, t.targetId, t.action);
             }
 
-            // Update outputs
-            writeOutputs();
-
             // Broadcast update
             broadcastUpdate();
         }
@@ -0,0 +1,321 @@
+// EventLog.cpp
+// Append-only event journal in the "events" flash partition
+//
+// Records are EventRecord, 16 bytes each, numbered by a sequence that only
+// grows. Each 4 KB sector starts with a 16-byte header (magic, erase count,
+// sequence and time of its first record), followed by 255 record slots. Sectors
+// are filled in turn around the partition. Starting the next sector erases it,
+// so the oldest 255 records go and every sector wears at the same rate. A slot
+// is written once after an erase. Its CRC tells a write torn by a reset from a
+// finished record.
+//
+// The sector headers are the time index. At boot they are read into RAM (one
+// entry per sector). A query by time picks the last sector that started at or
+// before the wanted time and scans at most that sector's records. A query by
+// sequence goes straight to the slot.
+//
+// Records are stamped with timestampNow(): the RTC stands in until the system
+// clock is set. A record logged while neither knows the time carries
+// TIME_INVALID; queries by time skip it, and a sector it opens is left out of
+// the time index.
+//
+// logEvent() only stamps the record and queues it, so callers in the main loop
+// never wait for flash. A low-priority task does the writes (an erase takes
+// tens of ms). Readers and the writer share flashLock, so a read that comes in
+// during an erase waits for it; that happens once every 255 records.
+//
+// Without the partition (older partition table) logging is off and the API
+// reports "available": false.
+
+#include "../FunctionPrototypes.h"
+#include <esp_partition.h>
+#include <esp_system.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#define EVENT_SECTOR_MAGIC  0x4B455631UL   // "KEV1"
+#define EVENT_SEQ_NONE      0xFFFFFFFFUL
+
+struct EventSectorHeader {
+    uint32_t magic;
+    uint32_t eraseCount;
+    uint32_t firstSeq;
+    uint32_t firstTime;
+};
+
+static const uint16_t RECORDS_PER_SECTOR = (EVENT_SECTOR_SIZE - sizeof(EventSectorHeader)) / sizeof(EventRecord);
+
+static const esp_partition_t* part = nullptr;
+static uint16_t sectorCount = 0;
+static QueueHandle_t eventQueue = nullptr;
+static SemaphoreHandle_t flashLock = nullptr;
+static TaskHandle_t writerTask = nullptr;
+
+// Sparse index: first record of each sector, EVENT_SEQ_NONE when it holds none
+static uint32_t indexSeq[EVENT_MAX_SECTORS];
+static uint32_t indexTime[EVENT_MAX_SECTORS];
+
+static uint16_t headSector = 0;
+static uint16_t headSlot = RECORDS_PER_SECTOR;  // next free slot; full = start a new sector
+static uint32_t nextSeq = 1;                    // 0 is never used
+static uint32_t oldestSeq = EVENT_SEQ_NONE;
+static EventLogStats stats = {};
+
+static uint16_t crc16Modbus(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc & 1) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+static uint16_t recordCrc(const EventRecord& r) {
+    return crc16Modbus((const uint8_t*)&r, offsetof(EventRecord, crc));
+}
+
+static uint32_t slotAddress(uint16_t sector, uint16_t slot) {
+    return (uint32_t)sector * EVENT_SECTOR_SIZE + sizeof(EventSectorHeader) + (uint32_t)slot * sizeof(EventRecord);
+}
+
+static void updateOldestSeq() {
+    uint32_t oldest = EVENT_SEQ_NONE;
+    for (uint16_t s = 0; s < sectorCount; s++) {
+        if (indexSeq[s] < oldest) oldest = indexSeq[s];
+    }
+    oldestSeq = oldest;
+}
+
+// ---- Writer (event task) ----
+
+// Erase the sector after the head and open it with r as its first record
+static bool startSector(const EventRecord& r) {
+    const uint16_t sector = (headSector + 1) % sectorCount;
+
+    EventSectorHeader h;
+    uint32_t eraseCount = 1;
+    if (esp_partition_read(part, (uint32_t)sector * EVENT_SECTOR_SIZE, &h, sizeof(h)) == ESP_OK &&
+        h.magic == EVENT_SECTOR_MAGIC) {
+        eraseCount = h.eraseCount + 1;
+    }
+
+    indexSeq[sector] = EVENT_SEQ_NONE;
+    updateOldestSeq();
+    if (esp_partition_erase_range(part, (uint32_t)sector * EVENT_SECTOR_SIZE, EVENT_SECTOR_SIZE) != ESP_OK) {
+        stats.writeErrors++;
+        return false;
+    }
+    stats.sectorsErased++;
+    if (eraseCount > stats.maxEraseCount) stats.maxEraseCount = eraseCount;
+
+    h = { EVENT_SECTOR_MAGIC, eraseCount, r.seq, r.time };
+    if (esp_partition_write(part, (uint32_t)sector * EVENT_SECTOR_SIZE, &h, sizeof(h)) != ESP_OK) {
+        stats.writeErrors++;
+        return false;
+    }
+
+    indexSeq[sector] = r.seq;
+    indexTime[sector] = r.time;
+    headSector = sector;
+    headSlot = 0;
+    updateOldestSeq();
+    return true;
+}
+
+static void appendRecord(EventRecord& r) {
+    r.seq = nextSeq;
+    r.crc = recordCrc(r);
+
+    if (headSlot >= RECORDS_PER_SECTOR && !startSector(r)) return;
+
+    // The slot is used up even if the write fails; the sequence is not
+    const esp_err_t err = esp_partition_write(part, slotAddress(headSector, headSlot), &r, sizeof(r));
+    headSlot++;
+    if (err != ESP_OK) {
+        stats.writeErrors++;
+        return;
+    }
+    nextSeq++;
+    stats.logged++;
+}
+
+static void eventWriterTask(void*) {
+    EventRecord r;
+    for (;;) {
+        if (xQueueReceive(eventQueue, &r, portMAX_DELAY) != pdTRUE) continue;
+        xSemaphoreTake(flashLock, portMAX_DELAY);
+        appendRecord(r);
+        xSemaphoreGive(flashLock);
+    }
+}
+
+// ---- Mount ----
+
+static void mountEventLog() {
+    EventSectorHeader h;
+    int32_t head = -1;
+    for (uint16_t s = 0; s < sectorCount; s++) {
+        indexSeq[s] = EVENT_SEQ_NONE;
+        if (esp_partition_read(part, (uint32_t)s * EVENT_SECTOR_SIZE, &h, sizeof(h)) != ESP_OK) continue;
+        if (h.magic != EVENT_SECTOR_MAGIC || h.firstSeq == EVENT_SEQ_NONE) continue;
+
+        indexSeq[s] = h.firstSeq;
+        indexTime[s] = h.firstTime;
+        if (h.eraseCount > stats.maxEraseCount) stats.maxEraseCount = h.eraseCount;
+        if (head < 0 || h.firstSeq > indexSeq[head]) head = s;
+    }
+    updateOldestSeq();
+
+    if (head < 0) {
+        // Empty journal: the first record opens sector 0
+        headSector = sectorCount - 1;
+        headSlot = RECORDS_PER_SECTOR;
+        nextSeq = 1;
+        return;
+    }
+
+    // Find the end of the head sector. A slot that is not erased is used,
+    // even if its CRC shows a torn write.
+    headSector = head;
+    headSlot = 0;
+    nextSeq = indexSeq[head];
+    EventRecord chunk[16];
+    for (uint16_t slot = 0; slot < RECORDS_PER_SECTOR; slot += 16) {
+        const uint16_t n = min((uint16_t)16, (uint16_t)(RECORDS_PER_SECTOR - slot));
+        if (esp_partition_read(part, slotAddress(headSector, slot), chunk, n * sizeof(EventRecord)) != ESP_OK) break;
+        for (uint16_t i = 0; i < n; i++) {
+            if (chunk[i].seq == EVENT_SEQ_NONE) continue;
+            headSlot = slot + i + 1;
+            if (chunk[i].crc == recordCrc(chunk[i]) && chunk[i].seq >= nextSeq) nextSeq = chunk[i].seq + 1;
+        }
+    }
+}
+
+void initEventLog() {
+    part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, EVENT_PARTITION_LABEL);
+    if (!part) {
+        debugPrintln("Event log: no \"" EVENT_PARTITION_LABEL "\" partition, journal disabled");
+        return;
+    }
+    sectorCount = min((uint32_t)EVENT_MAX_SECTORS, part->size / EVENT_SECTOR_SIZE);
+    if (sectorCount < 2) {
+        part = nullptr;
+        return;
+    }
+
+    mountEventLog();
+
+    flashLock = xSemaphoreCreateMutex();
+    eventQueue = xQueueCreate(EVENT_QUEUE_DEPTH, sizeof(EventRecord));
+    xTaskCreatePinnedToCore(eventWriterTask, "events", EVENT_TASK_STACK, nullptr,
+                            EVENT_TASK_PRIORITY, &writerTask, EVENT_TASK_CORE);
+    registerMonitoredTask("events", writerTask);
+
+    debugPrintln("Event log: " + String(sectorCount) + " sectors, next #" + String(nextSeq));
+    logEvent(EVENT_BOOT, 0xFF, 0, 0, (uint16_t)esp_reset_reason());
+}
+
+// ---- Logging (any task, not ISRs) ----
+
+bool logEvent(uint8_t type, uint8_t source, uint8_t subject, uint8_t value, uint16_t arg) {
+    if (!eventQueue) return false;
+
+    EventRecord r;
+    r.seq = 0;
+    r.time = timestampNow();
+    r.type = type;
+    r.source = source;
+    r.subject = subject;
+    r.value = value;
+    r.arg = arg;
+    r.crc = 0;
+    if (xQueueSend(eventQueue, &r, 0) != pdTRUE) {
+        stats.dropped++;
+        return false;
+    }
+    return true;
+}
+
+// ---- Reading ----
+
+bool eventLogAvailable() {
+    return part != nullptr;
+}
+
+// Oldest and newest sequence held; false when the journal is empty. Does not
+// take the lock (an erase may be running), so it can lag the writer by a record.
+bool eventLogRange(uint32_t& oldest, uint32_t& newest) {
+    if (!part) return false;
+    oldest = oldestSeq;
+    newest = nextSeq - 1;
+    return oldest != EVENT_SEQ_NONE && newest >= oldest;
+}
+
+// Sector holding seq: the one with the highest first sequence not above it
+static int32_t sectorForSeq(uint32_t seq) {
+    int32_t best = -1;
+    for (uint16_t s = 0; s < sectorCount; s++) {
+        if (indexSeq[s] == EVENT_SEQ_NONE || indexSeq[s] > seq) continue;
+        if (best < 0 || indexSeq[s] > indexSeq[best]) best = s;
+    }
+    return best;
+}
+
+static bool readEventLocked(uint32_t seq, EventRecord& out) {
+    if (seq == 0 || seq >= nextSeq) return false;
+    const int32_t sector = sectorForSeq(seq);
+    if (sector < 0) return false;
+
+    // Normally at its own offset; a failed write shifts later records by a slot
+    const uint16_t end = (sector == headSector) ? headSlot : RECORDS_PER_SECTOR;
+    for (uint32_t slot = seq - indexSeq[sector]; slot < end; slot++) {
+        if (esp_partition_read(part, slotAddress(sector, slot), &out, sizeof(out)) != ESP_OK) return false;
+        if (out.seq == seq) return out.crc == recordCrc(out);
+        if (out.seq != EVENT_SEQ_NONE && out.seq > seq) return false;
+    }
+    return false;
+}
+
+bool readEvent(uint32_t seq, EventRecord& out) {
+    if (!part) return false;
+    xSemaphoreTake(flashLock, portMAX_DELAY);
+    const bool ok = readEventLocked(seq, out);
+    xSemaphoreGive(flashLock);
+    return ok;
+}
+
+// First sequence logged at or after since (unix seconds); nextSeq if none.
+// Assumes the clock only moves forward between the index entry and the
+// record; a clock set backwards (EVENT_TIME_SET) can hide a few records.
+uint32_t findEventSeq(uint32_t since) {
+    if (!part) return 0;
+    xSemaphoreTake(flashLock, portMAX_DELAY);
+
+    int32_t start = -1;
+    for (uint16_t s = 0; s < sectorCount; s++) {
+        if (indexSeq[s] == EVENT_SEQ_NONE || indexTime[s] == TIME_INVALID) continue;
+        if (indexTime[s] <= since && (start < 0 || indexSeq[s] > indexSeq[start])) start = s;
+    }
+
+    uint32_t seq = start >= 0 ? indexSeq[start] : oldestSeq;
+    if (seq == EVENT_SEQ_NONE) seq = nextSeq;
+    EventRecord r;
+    for (; seq < nextSeq; seq++) {
+        if (readEventLocked(seq, r) && r.time != TIME_INVALID && r.time >= since) break;
+    }
+    xSemaphoreGive(flashLock);
+    return seq;
+}
+
+const char* eventTypeName(uint8_t type) {
+    static const char* const names[] = { "none", "boot", "output", "time_set", "config", "ota", "logic" };
+    return type < sizeof(names) / sizeof(names[0]) ? names[type] : "unknown";
+}
+
+uint16_t eventLogSectors() {
+    return part ? sectorCount : 0;
+}
+
+const EventLogStats& eventLogStats() {
+    return stats;
+}
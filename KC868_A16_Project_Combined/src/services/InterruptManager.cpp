@@ -72,11 +72,14 @@ void processInputInterrupts() {
     bool currentInputs[16];
     bool anyChange = false;
 
-    // Read inputs from I2C expanders
+    // Read inputs from I2C expanders, one byte per bank (see readInputBank)
+    uint8_t bank1, bank2;
+    if (!readInputBank(0, bank1) || !readInputBank(1, bank2)) return;
+
     try {
         // Read inputs 1-8
         for (int i = 0; i < 8; i++) {
-            bool newState = !inputIC1.digitalRead(i);  // Inverted because of pull-up
+            bool newState = !(bank1 & (1 << i));  // Inverted because of pull-up
             currentInputs[i] = newState;
 
             // Determine if this input should be processed based on its trigger type
@@ -122,7 +125,7 @@ void processInputInterrupts() {
 
         // Read inputs 9-16
         for (int i = 0; i < 8; i++) {
-            bool newState = !inputIC2.digitalRead(i);  // Inverted because of pull-up
+            bool newState = !(bank2 & (1 << i));  // Inverted because of pull-up
             currentInputs[i + 8] = newState;
 
             // Determine if this input should be processed based on its trigger type
@@ -261,11 +264,14 @@ void pollNonInterruptInputs() {
     if (!anyNeedPolling) return;
 
     // Poll only the required inputs
+    uint8_t bank1, bank2;
+    if (!readInputBank(0, bank1) || !readInputBank(1, bank2)) return;
+
     try {
         // Poll inputs 1-8 if needed
         for (int i = 0; i < 8; i++) {
             if (needsPolling[i]) {
-                bool newState = !inputIC1.digitalRead(i); // Inverted because of pull-up
+                bool newState = !(bank1 & (1 << i)); // Inverted because of pull-up
                 if (newState != inputStates[i]) {
                     inputStates[i] = newState;
                     anyChanged = true;
@@ -280,7 +286,7 @@ void pollNonInterruptInputs() {
         // Poll inputs 9-16 if needed
         for (int i = 0; i < 8; i++) {
             if (needsPolling[i + 8]) {
-                bool newState = !inputIC2.digitalRead(i); // Inverted because of pull-up
+                bool newState = !(bank2 & (1 << i)); // Inverted because of pull-up
                 if (newState != inputStates[i + 8]) {
                     inputStates[i + 8] = newState;
                     anyChanged = true;
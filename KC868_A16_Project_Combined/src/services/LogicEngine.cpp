@@ -0,0 +1,609 @@
+// LogicEngine.cpp
+// PLC-style scan engine: virtual bits and registers, timers, counters, latches
+//
+// A program is a list of LogicInstr run top to bottom once every LOGIC_SCAN_MS,
+// in the manner of an IEC 61131-3 instruction list: one boolean accumulator,
+// a PUSH stack for bracketed terms, and outputs that take effect at the end of
+// the scan. For example, Q1 on after input 4 has been held 5 s while M0 is off:
+//
+//   LD I3 / ANDN M0 / TON T0 50 / ST Q0
+//
+// Each scan takes one input image and runs the program against it. The outputs
+// the program stores to (ST/STN/SET/RST Q) are commanded at OUTPUT_PRIO_LOGIC
+// when the scan changes them; the output manager writes them with everything
+// else at the end of the loop pass. Outputs the program never stores to stay
+// with the other writers. Stopping the program relinquishes its slots. A scan that starts
+// late is measured (lateMaxMs). If a whole tick is missed, that counts as an
+// overrun and the schedule re-phases instead of catching up in a burst.
+//
+// Operands: I inputs (I16-I18 = HT1-HT3), Q outputs, M bits, T timers,
+// C counters, R registers, A analog raw, V RF virtual inputs, S sensors x10.
+// Programs travel as text (one instruction per line) and are stored as
+// bytecode in NVS (namespace "logic"): the EEPROM map has no room left.
+//
+//   LD/LDN/AND/ANDN/OR/ORN x   NOT   PUSH   ANDB   ORB   RE   FE   END
+//   ST/STN/SET/RST Q|M         GT/LT/EQ x n   (loads x > n, x < n, x == n)
+//   TON/TOF/TP Tn preset       preset in LOGIC_TIMER_UNIT_MS
+//   CTU Cn preset   CTR Cn     count rising edges / reset while true
+//   MOV Rn k   ADD Rn k   CPY Rn x   (only while the accumulator is true)
+
+#include "../FunctionPrototypes.h"
+
+enum LogicOperand : uint8_t {
+    OPND_NONE,
+    OPND_READ,      // any area
+    OPND_WRITE,     // Q or M
+    OPND_TIMER,
+    OPND_COUNTER,
+    OPND_VALUE,     // any area, then a constant
+    OPND_REG,       // R, then a constant
+    OPND_REG_SRC,   // R, then a source operand
+};
+
+struct LogicOpInfo {
+    const char* name;
+    uint8_t operand;    // LogicOperand
+    bool hasArg;
+};
+
+// Indexed by LOGIC_OP_*
+static const LogicOpInfo opTable[] = {
+    { "END",  OPND_NONE,    false },
+    { "LD",   OPND_READ,    false },
+    { "LDN",  OPND_READ,    false },
+    { "AND",  OPND_READ,    false },
+    { "ANDN", OPND_READ,    false },
+    { "OR",   OPND_READ,    false },
+    { "ORN",  OPND_READ,    false },
+    { "NOT",  OPND_NONE,    false },
+    { "PUSH", OPND_NONE,    false },
+    { "ANDB", OPND_NONE,    false },
+    { "ORB",  OPND_NONE,    false },
+    { "ST",   OPND_WRITE,   false },
+    { "STN",  OPND_WRITE,   false },
+    { "SET",  OPND_WRITE,   false },
+    { "RST",  OPND_WRITE,   false },
+    { "TON",  OPND_TIMER,   true },
+    { "TOF",  OPND_TIMER,   true },
+    { "TP",   OPND_TIMER,   true },
+    { "CTU",  OPND_COUNTER, true },
+    { "CTR",  OPND_COUNTER, false },
+    { "GT",   OPND_VALUE,   true },
+    { "LT",   OPND_VALUE,   true },
+    { "EQ",   OPND_VALUE,   true },
+    { "MOV",  OPND_REG,     true },
+    { "ADD",  OPND_REG,     true },
+    { "CPY",  OPND_REG_SRC, true },
+    { "RE",   OPND_NONE,    false },
+    { "FE",   OPND_NONE,    false },
+};
+static const uint8_t LOGIC_OP_COUNT = sizeof(opTable) / sizeof(opTable[0]);
+
+// Indexed by LOGIC_AREA_*
+static const char areaLetters[] = "IQMTCRAVS";
+static const uint8_t areaSize[] = { 19, 16, LOGIC_BITS, LOGIC_TIMERS, LOGIC_COUNTERS, LOGIC_REGS, 4, RF_VIRTUAL_INPUTS, 6 };
+static const uint8_t LOGIC_AREA_COUNT = sizeof(areaSize);
+
+struct LogicTimer {
+    uint32_t startMs;
+    uint32_t elapsedMs;
+    bool in;
+    bool q;
+};
+
+struct LogicCounter {
+    int16_t count;
+    int16_t preset;
+    bool in;
+};
+
+static LogicInstr program[LOGIC_MAX_INSTR];
+static uint8_t programLength = 0;
+static bool running = false;
+
+static uint64_t bits = 0;
+static int16_t regs[LOGIC_REGS];
+static LogicTimer timers[LOGIC_TIMERS];
+static LogicCounter counters[LOGIC_COUNTERS];
+static uint8_t edgeMemory[LOGIC_MAX_INSTR / 8];    // RE/FE: accumulator last scan, per step
+
+static LogicStats stats = {};
+static uint32_t nextScanMs = 0;
+
+// Scan image
+static uint32_t scanMs = 0;
+static uint32_t inputImage = 0;
+static uint16_t outputImage = 0;
+static uint16_t qOwned = 0;         // outputs the program stores to
+static uint16_t logicQ = 0;         // what the program last commanded for them
+static bool qCommanded = false;
+
+// ---- Operands ----
+
+static int16_t clampToReg(int32_t v) {
+    return (int16_t)constrain(v, (int32_t)-32768, (int32_t)32767);
+}
+
+static int32_t sensorValue(uint8_t index) {
+    const HTSensorConfig& ht = htSensorConfig[index % 3];
+    if (ht.sensorType == SENSOR_TYPE_DIGITAL) return 0;
+    const float v = (index < 3) ? ht.temperature : ht.humidity;
+    return (isnan(v) || isinf(v)) ? 0 : lroundf(v * 10.0f);
+}
+
+static int32_t readValue(uint8_t area, uint8_t index) {
+    switch (area) {
+    case LOGIC_AREA_INPUT:   return (inputImage >> index) & 1;
+    case LOGIC_AREA_OUTPUT:  return (outputImage >> index) & 1;
+    case LOGIC_AREA_BIT:     return (bits >> index) & 1;
+    case LOGIC_AREA_TIMER:   return timers[index].elapsedMs / LOGIC_TIMER_UNIT_MS;
+    case LOGIC_AREA_COUNTER: return counters[index].count;
+    case LOGIC_AREA_REG:     return regs[index];
+    case LOGIC_AREA_ANALOG:  return analogValues[index];
+    case LOGIC_AREA_RF:      return (rfVirtualInputs() >> index) & 1;
+    case LOGIC_AREA_SENSOR:  return sensorValue(index);
+    default:                 return 0;
+    }
+}
+
+static bool readBool(uint8_t area, uint8_t index) {
+    switch (area) {
+    case LOGIC_AREA_TIMER:   return timers[index].q;
+    case LOGIC_AREA_COUNTER: return counters[index].count >= counters[index].preset;
+    default:                 return readValue(area, index) != 0;
+    }
+}
+
+static void writeBool(uint8_t area, uint8_t index, bool v) {
+    if (area == LOGIC_AREA_OUTPUT) {
+        if (v) outputImage |= (1u << index);
+        else outputImage &= ~(1u << index);
+    }
+    else if (area == LOGIC_AREA_BIT) {
+        if (v) bits |= (1ULL << index);
+        else bits &= ~(1ULL << index);
+    }
+}
+
+// ---- Function blocks ----
+
+static bool runTimer(uint8_t op, LogicTimer& t, bool in, uint32_t presetMs) {
+    const bool rising = in && !t.in;
+    const bool falling = !in && t.in;
+    t.in = in;
+
+    switch (op) {
+    case LOGIC_OP_TON:      // on after in has been true for the preset
+        if (rising) t.startMs = scanMs;
+        t.elapsedMs = in ? min(scanMs - t.startMs, presetMs) : 0;
+        t.q = in && t.elapsedMs >= presetMs;
+        break;
+    case LOGIC_OP_TOF:      // off once in has been false for the preset
+        if (falling) t.startMs = scanMs;
+        t.elapsedMs = in ? 0 : min(scanMs - t.startMs, presetMs);
+        t.q = in || (t.q && t.elapsedMs < presetMs);
+        break;
+    case LOGIC_OP_TP:       // fixed pulse from a rising edge, not retriggered
+        if (rising && !t.q) {
+            t.startMs = scanMs;
+            t.q = true;
+        }
+        t.elapsedMs = t.q ? min(scanMs - t.startMs, presetMs) : 0;
+        if (t.q && t.elapsedMs >= presetMs) t.q = false;
+        break;
+    }
+    return t.q;
+}
+
+static void resetLogicState() {
+    memset(timers, 0, sizeof(timers));
+    memset(counters, 0, sizeof(counters));
+    memset(edgeMemory, 0, sizeof(edgeMemory));
+
+    // Counter done bits are valid before the CTU step first runs
+    qOwned = 0;
+    for (uint8_t pc = 0; pc < programLength; pc++) {
+        const LogicInstr& in = program[pc];
+        if (in.op == LOGIC_OP_CTU) counters[in.index].preset = in.arg;
+        if ((in.op == LOGIC_OP_ST || in.op == LOGIC_OP_STN || in.op == LOGIC_OP_SET || in.op == LOGIC_OP_RST) &&
+            in.area == LOGIC_AREA_OUTPUT) {
+            qOwned |= 1u << in.index;
+        }
+    }
+
+    // Latches (SET/RST) start from what the outputs are now
+    logicQ = getOutputMask() & qOwned;
+    qCommanded = false;
+    nextScanMs = millis();
+}
+
+// ---- Scan ----
+
+static void executeProgram() {
+    bool acc = false;
+    bool stack[LOGIC_STACK_DEPTH];
+    uint8_t sp = 0;
+
+    for (uint8_t pc = 0; pc < programLength; pc++) {
+        const LogicInstr& in = program[pc];
+
+        switch (in.op) {
+        case LOGIC_OP_END:  return;
+        case LOGIC_OP_LD:   acc = readBool(in.area, in.index); break;
+        case LOGIC_OP_LDN:  acc = !readBool(in.area, in.index); break;
+        case LOGIC_OP_AND:  acc = acc && readBool(in.area, in.index); break;
+        case LOGIC_OP_ANDN: acc = acc && !readBool(in.area, in.index); break;
+        case LOGIC_OP_OR:   acc = acc || readBool(in.area, in.index); break;
+        case LOGIC_OP_ORN:  acc = acc || !readBool(in.area, in.index); break;
+        case LOGIC_OP_NOT:  acc = !acc; break;
+
+        // Depth is checked when the program is installed
+        case LOGIC_OP_PUSH: stack[sp++] = acc; break;
+        case LOGIC_OP_ANDB: acc = stack[--sp] && acc; break;
+        case LOGIC_OP_ORB:  acc = stack[--sp] || acc; break;
+
+        case LOGIC_OP_ST:   writeBool(in.area, in.index, acc); break;
+        case LOGIC_OP_STN:  writeBool(in.area, in.index, !acc); break;
+        case LOGIC_OP_SET:  if (acc) writeBool(in.area, in.index, true); break;
+        case LOGIC_OP_RST:  if (acc) writeBool(in.area, in.index, false); break;
+
+        case LOGIC_OP_TON:
+        case LOGIC_OP_TOF:
+        case LOGIC_OP_TP:
+            acc = runTimer(in.op, timers[in.index], acc, (uint32_t)in.arg * LOGIC_TIMER_UNIT_MS);
+            break;
+
+        case LOGIC_OP_CTU: {
+            LogicCounter& c = counters[in.index];
+            if (acc && !c.in && c.count < 32767) c.count++;
+            c.in = acc;
+            c.preset = in.arg;
+            acc = c.count >= c.preset;
+            break;
+        }
+        case LOGIC_OP_CTR:
+            if (acc) counters[in.index].count = 0;
+            break;
+
+        case LOGIC_OP_GT:   acc = readValue(in.area, in.index) > in.arg; break;
+        case LOGIC_OP_LT:   acc = readValue(in.area, in.index) < in.arg; break;
+        case LOGIC_OP_EQ:   acc = readValue(in.area, in.index) == in.arg; break;
+
+        case LOGIC_OP_MOV:  if (acc) regs[in.index] = in.arg; break;
+        case LOGIC_OP_ADD:  if (acc) regs[in.index] = clampToReg((int32_t)regs[in.index] + in.arg); break;
+        case LOGIC_OP_CPY:
+            if (acc) regs[in.index] = clampToReg(readValue((uint8_t)(in.arg >> 8), (uint8_t)in.arg));
+            break;
+
+        case LOGIC_OP_RE:
+        case LOGIC_OP_FE: {
+            const uint8_t bit = 1u << (pc & 7);
+            const bool prev = (edgeMemory[pc >> 3] & bit) != 0;
+            if (acc) edgeMemory[pc >> 3] |= bit;
+            else edgeMemory[pc >> 3] &= ~bit;
+            acc = (in.op == LOGIC_OP_RE) ? (acc && !prev) : (!acc && prev);
+            break;
+        }
+        }
+    }
+}
+
+// Main loop
+void serviceLogic() {
+    if (!running || programLength == 0) return;
+
+    const uint32_t now = millis();
+    if ((int32_t)(now - nextScanMs) < 0) return;
+
+    const uint32_t late = now - nextScanMs;
+    if (late > stats.lateMaxMs) stats.lateMaxMs = late;
+    if (late >= LOGIC_SCAN_MS) {
+        stats.overruns += late / LOGIC_SCAN_MS;
+        nextScanMs = now;
+    }
+    nextScanMs += LOGIC_SCAN_MS;
+
+    const uint32_t startUs = micros();
+    scanMs = now;
+
+    // Input image
+    inputImage = 0;
+    for (int i = 0; i < 16; i++) {
+        if (inputStates[i]) inputImage |= (1UL << i);
+    }
+    for (int i = 0; i < 3; i++) {
+        if (directInputStates[i]) inputImage |= (1UL << (16 + i));
+    }
+    outputImage = (getOutputMask() & ~qOwned) | logicQ;
+
+    executeProgram();
+
+    // Output image: only the owned outputs, and only when the scan changed them
+    const uint16_t q = outputImage & qOwned;
+    if (q != logicQ || !qCommanded) {
+        commandOutputs(OUTPUT_SRC_LOGIC, OUTPUT_PRIO_LOGIC, qOwned, q);
+        logicQ = q;
+        qCommanded = true;
+    }
+
+    stats.scans++;
+    stats.lastUs = micros() - startUs;
+    if (stats.lastUs > stats.maxUs) stats.maxUs = stats.lastUs;
+}
+
+// ---- Program ----
+
+static bool validateInstr(const LogicInstr& in, String& error) {
+    if (in.op >= LOGIC_OP_COUNT) {
+        error = "unknown opcode " + String(in.op);
+        return false;
+    }
+
+    const LogicOpInfo& info = opTable[in.op];
+    if (info.operand == OPND_NONE) return true;
+
+    if (in.area >= LOGIC_AREA_COUNT || in.index >= areaSize[in.area]) {
+        error = "operand out of range";
+        return false;
+    }
+
+    switch (info.operand) {
+    case OPND_WRITE:
+        if (in.area != LOGIC_AREA_OUTPUT && in.area != LOGIC_AREA_BIT) {
+            error = String(info.name) + " needs a Q or M operand";
+            return false;
+        }
+        break;
+    case OPND_TIMER:
+        if (in.area != LOGIC_AREA_TIMER || in.arg < 0) {
+            error = String(info.name) + " needs a T operand and a preset >= 0";
+            return false;
+        }
+        break;
+    case OPND_COUNTER:
+        if (in.area != LOGIC_AREA_COUNTER || in.arg < 0) {
+            error = String(info.name) + " needs a C operand";
+            return false;
+        }
+        break;
+    case OPND_REG:
+        if (in.area != LOGIC_AREA_REG) {
+            error = String(info.name) + " needs an R operand";
+            return false;
+        }
+        break;
+    case OPND_REG_SRC: {
+        const uint8_t srcArea = (uint8_t)(in.arg >> 8);
+        const uint8_t srcIndex = (uint8_t)in.arg;
+        if (in.area != LOGIC_AREA_REG || in.arg < 0 || srcArea >= LOGIC_AREA_COUNT || srcIndex >= areaSize[srcArea]) {
+            error = "CPY needs an R destination and a valid source";
+            return false;
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return true;
+}
+
+// Checks every step and the PUSH / ANDB / ORB nesting
+bool validateLogicProgram(const LogicInstr* prog, uint8_t count, String& error) {
+    if (count > LOGIC_MAX_INSTR) {
+        error = "program longer than " + String(LOGIC_MAX_INSTR) + " steps";
+        return false;
+    }
+
+    int depth = 0;
+    for (uint8_t pc = 0; pc < count; pc++) {
+        if (!validateInstr(prog[pc], error)) {
+            error = "step " + String(pc + 1) + ": " + error;
+            return false;
+        }
+        if (prog[pc].op == LOGIC_OP_PUSH) depth++;
+        if (prog[pc].op == LOGIC_OP_ANDB || prog[pc].op == LOGIC_OP_ORB) depth--;
+        if (depth < 0 || depth > LOGIC_STACK_DEPTH) {
+            error = "step " + String(pc + 1) + ": PUSH / ANDB / ORB unbalanced";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Replaces the running program; bits and registers keep their values
+bool installLogicProgram(const LogicInstr* prog, uint8_t count, String& error) {
+    if (!validateLogicProgram(prog, count, error)) return false;
+
+    // The new program may store to different outputs
+    relinquishOutputs(OUTPUT_PRIO_LOGIC, 0xFFFF);
+    memcpy(program, prog, sizeof(LogicInstr) * count);
+    programLength = count;
+    resetLogicState();
+    return true;
+}
+
+void saveLogicProgram() {
+    Preferences prefs;
+    if (!prefs.begin("logic", false)) {
+        debugPrintln("ERROR: Failed to open logic program storage");
+        return;
+    }
+    prefs.putBytes("prog", program, sizeof(LogicInstr) * programLength);
+    prefs.putBool("run", running);
+    prefs.end();
+}
+
+static void loadLogicProgram() {
+    Preferences prefs;
+    if (!prefs.begin("logic", true)) return;
+
+    LogicInstr stored[LOGIC_MAX_INSTR];
+    const size_t count = getPrefsRecords(prefs, "prog", stored, sizeof(LogicInstr), LOGIC_MAX_INSTR);
+    bool run = prefs.getBool("run", false);
+    prefs.end();
+
+    // No program, or one for another instruction layout: start empty. It is
+    // still checked like an uploaded one before it runs.
+    String error;
+    if (count > 0 && !installLogicProgram(stored, (uint8_t)count, error)) {
+        debugPrintln("Logic program not loaded: " + error);
+    }
+    running = run && programLength > 0;
+}
+
+void initLogic() {
+    loadLogicProgram();
+    debugPrintln("Logic engine: " + String(programLength) + " step(s), " + (running ? "running" : "stopped"));
+}
+
+void setLogicRunning(bool run) {
+    if (run && !running) resetLogicState();
+    if (!run && running) relinquishOutputs(OUTPUT_PRIO_LOGIC, 0xFFFF);
+    if (run != running) logEvent(EVENT_LOGIC, 0xFF, 0, run, programLength);
+    running = run;
+}
+
+bool logicRunning() {
+    return running;
+}
+
+uint8_t logicProgramLength() {
+    return programLength;
+}
+
+const LogicInstr* logicProgram() {
+    return program;
+}
+
+// ---- Text form ----
+
+static bool parseOperand(const String& tok, uint8_t& area, uint8_t& index) {
+    if (tok.length() < 2) return false;
+    const char* letter = strchr(areaLetters, toupper(tok[0]));
+    if (!letter || !*letter) return false;
+    for (unsigned int i = 1; i < tok.length(); i++) {
+        if (!isDigit(tok[i])) return false;
+    }
+    const long n = tok.substring(1).toInt();
+    area = (uint8_t)(letter - areaLetters);
+    if (n >= areaSize[area]) return false;
+    index = (uint8_t)n;
+    return true;
+}
+
+static bool parseConstant(const String& tok, int16_t& value) {
+    if (tok.length() == 0) return false;
+    for (unsigned int i = (tok[0] == '-') ? 1 : 0; i < tok.length(); i++) {
+        if (!isDigit(tok[i])) return false;
+    }
+    const long n = tok.toInt();
+    if (n < -32768 || n > 32767) return false;
+    value = (int16_t)n;
+    return true;
+}
+
+// "TON T0 50" -> bytecode
+bool assembleLogicLine(const String& line, LogicInstr& out, String& error) {
+    String tok[4];
+    uint8_t n = 0;
+    int pos = 0;
+    const int len = line.length();
+    while (pos < len && n < 4) {
+        while (pos < len && line[pos] == ' ') pos++;
+        const int start = pos;
+        while (pos < len && line[pos] != ' ') pos++;
+        if (pos > start) tok[n++] = line.substring(start, pos);
+        while (pos < len && line[pos] == ' ') pos++;
+    }
+    if (n == 0 || pos < len) {
+        error = "expected: OP [operand] [value]";
+        return false;
+    }
+    tok[0].toUpperCase();
+
+    out = {};
+    uint8_t op = 0;
+    while (op < LOGIC_OP_COUNT && tok[0] != opTable[op].name) op++;
+    if (op == LOGIC_OP_COUNT) {
+        error = "unknown instruction " + tok[0];
+        return false;
+    }
+    out.op = op;
+
+    const LogicOpInfo& info = opTable[op];
+    const uint8_t expected = 1 + (info.operand != OPND_NONE) + info.hasArg;
+    if (n != expected) {
+        error = String(info.name) + " takes " + String(expected - 1) + " argument(s)";
+        return false;
+    }
+    if (info.operand != OPND_NONE && !parseOperand(tok[1], out.area, out.index)) {
+        error = "bad operand " + tok[1];
+        return false;
+    }
+    if (info.operand == OPND_REG_SRC) {
+        uint8_t srcArea, srcIndex;
+        if (!parseOperand(tok[2], srcArea, srcIndex)) {
+            error = "bad operand " + tok[2];
+            return false;
+        }
+        out.arg = (int16_t)((srcArea << 8) | srcIndex);
+    }
+    else if (info.hasArg && !parseConstant(tok[2], out.arg)) {
+        error = "bad value " + tok[2];
+        return false;
+    }
+
+    return validateInstr(out, error);
+}
+
+String disassembleLogic(const LogicInstr& in) {
+    if (in.op >= LOGIC_OP_COUNT) return "?";
+
+    const LogicOpInfo& info = opTable[in.op];
+    String s = info.name;
+    if (info.operand != OPND_NONE) {
+        s += ' ';
+        s += areaLetters[in.area];
+        s += String(in.index);
+    }
+    if (info.operand == OPND_REG_SRC) {
+        s += ' ';
+        s += areaLetters[(uint8_t)(in.arg >> 8)];
+        s += String((uint8_t)in.arg);
+    }
+    else if (info.hasArg) {
+        s += ' ';
+        s += String(in.arg);
+    }
+    return s;
+}
+
+// ---- Virtual points (Modbus, BACnet, REST) ----
+
+bool logicBit(uint8_t index) {
+    return index < LOGIC_BITS && ((bits >> index) & 1);
+}
+
+void setLogicBit(uint8_t index, bool value) {
+    if (index < LOGIC_BITS) writeBool(LOGIC_AREA_BIT, index, value);
+}
+
+int16_t logicReg(uint8_t index) {
+    return index < LOGIC_REGS ? regs[index] : 0;
+}
+
+void setLogicReg(uint8_t index, int16_t value) {
+    if (index < LOGIC_REGS) regs[index] = value;
+}
+
+bool logicTimerOutput(uint8_t index) {
+    return index < LOGIC_TIMERS && timers[index].q;
+}
+
+int16_t logicCounterValue(uint8_t index) {
+    return index < LOGIC_COUNTERS ? counters[index].count : 0;
+}
+
+const LogicStats& logicStats() {
+    return stats;
+}
@@ -0,0 +1,285 @@
+// OtaService.cpp
+// Resumable firmware / filesystem image updates.
+//
+// An update is a session: begin (target, size, optional SHA-256), any number
+// of chunks written at the current offset, then finish. Chunks go straight
+// into the target partition one flash sector at a time while a SHA-256 runs
+// over the stream, so nothing is buffered whole and the main loop (Modbus,
+// BACnet) keeps running between pieces. If a transfer drops, the client asks
+// for the status and continues from "received".
+//
+// App images go to the inactive OTA slot and only become the boot partition
+// once the size and hash check out. The new image then boots on trial: it must
+// run OTA_CONFIRM_MS before it is marked valid, and if it restarts more than
+// OTA_MAX_TRIAL_BOOTS times first, the previous slot is restored.
+//
+// The filesystem image is written in place (there is only one data
+// partition); it is mounted on the next restart.
+
+#include "../FunctionPrototypes.h"
+#include <esp_ota_ops.h>
+#include <esp_partition.h>
+#include <mbedtls/sha256.h>
+
+struct OtaSession {
+    uint8_t state;                  // OTA_STATE_*
+    uint8_t target;                 // OTA_TARGET_*
+    const esp_partition_t* part;
+    uint32_t size;
+    uint32_t received;
+    uint32_t erasedTo;              // bytes [0, erasedTo) are erased
+    uint8_t expected[32];
+    bool hasExpected;
+    mbedtls_sha256_context sha;
+    String sha256;                  // computed digest (hex) once complete
+    String error;
+};
+
+static OtaSession ota = { OTA_STATE_IDLE, OTA_TARGET_APP, nullptr, 0, 0, 0, { 0 }, false };
+static bool otaTrial = false;       // running an unconfirmed image
+
+static const char* otaStateNames[] = { "idle", "receiving", "ready", "error" };
+
+static bool parseHexDigest(const String& hex, uint8_t* out) {
+    if (hex.length() != 64) return false;
+    for (int i = 0; i < 32; i++) {
+        char byteStr[3] = { hex[i * 2], hex[i * 2 + 1], 0 };
+        char* end = nullptr;
+        out[i] = (uint8_t)strtoul(byteStr, &end, 16);
+        if (*end != '\0') return false;
+    }
+    return true;
+}
+
+static String hexDigest(const uint8_t* digest) {
+    char hex[65];
+    for (int i = 0; i < 32; i++) sprintf(hex + i * 2, "%02x", digest[i]);
+    return String(hex);
+}
+
+static void otaFail(const String& message) {
+    if (ota.state == OTA_STATE_RECEIVING) mbedtls_sha256_free(&ota.sha);
+    ota.state = OTA_STATE_ERROR;
+    ota.error = message;
+    debugPrintln("OTA: " + message);
+}
+
+// ---- Session ----
+
+bool otaBegin(uint8_t target, uint32_t size, const String& sha256Hex) {
+    otaAbort();
+    ota.error = String();
+    ota.sha256 = String();
+
+    if (target == OTA_TARGET_APP) {
+        ota.part = esp_ota_get_next_update_partition(nullptr);
+    }
+    else {
+        ota.part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_DATA_SPIFFS, nullptr);
+    }
+    if (!ota.part) {
+        otaFail("No partition for this target");
+        return false;
+    }
+    if (size == 0 || size > ota.part->size) {
+        otaFail("Image size " + String(size) + " does not fit partition " + String(ota.part->label) +
+                " (" + String(ota.part->size) + " bytes)");
+        return false;
+    }
+
+    ota.hasExpected = sha256Hex.length() > 0;
+    if (ota.hasExpected && !parseHexDigest(sha256Hex, ota.expected)) {
+        otaFail("sha256 must be 64 hex characters");
+        return false;
+    }
+
+    ota.target = target;
+    ota.size = size;
+    ota.received = 0;
+    ota.erasedTo = 0;
+    mbedtls_sha256_init(&ota.sha);
+    mbedtls_sha256_starts(&ota.sha, 0);
+    ota.state = OTA_STATE_RECEIVING;
+
+    debugPrintln("OTA: receiving " + String(size) + " bytes into " + String(ota.part->label));
+    return true;
+}
+
+bool otaWrite(uint32_t offset, const uint8_t* data, size_t len) {
+    if (ota.state != OTA_STATE_RECEIVING) {
+        ota.error = "No update in progress";
+        return false;
+    }
+    if (offset != ota.received) {
+        ota.error = "Expected offset " + String(ota.received);
+        return false;
+    }
+    if (len > ota.size - ota.received) {
+        otaFail("Data past the announced image size");
+        return false;
+    }
+    if (ota.received == 0 && ota.target == OTA_TARGET_APP && len > 0 && data[0] != OTA_APP_IMAGE_MAGIC) {
+        otaFail("Not an ESP32 application image");
+        return false;
+    }
+
+    // Erase lazily, one sector ahead of the data, so no single call blocks for long
+    const uint32_t end = ota.received + len;
+    while (ota.erasedTo < end) {
+        esp_err_t err = esp_partition_erase_range(ota.part, ota.erasedTo, OTA_SECTOR_SIZE);
+        if (err != ESP_OK) {
+            otaFail("Erase failed: " + String(esp_err_to_name(err)));
+            return false;
+        }
+        ota.erasedTo += OTA_SECTOR_SIZE;
+    }
+
+    esp_err_t err = esp_partition_write(ota.part, ota.received, data, len);
+    if (err != ESP_OK) {
+        otaFail("Write failed: " + String(esp_err_to_name(err)));
+        return false;
+    }
+
+    mbedtls_sha256_update(&ota.sha, data, len);
+    ota.received = end;
+    ota.error = String();
+    return true;
+}
+
+bool otaFinish() {
+    if (ota.state != OTA_STATE_RECEIVING) {
+        if (ota.error.length() == 0) ota.error = "No update in progress";
+        return false;
+    }
+    if (ota.received != ota.size) {
+        ota.error = "Incomplete: " + String(ota.received) + " of " + String(ota.size) + " bytes";
+        return false;
+    }
+
+    uint8_t digest[32];
+    mbedtls_sha256_finish(&ota.sha, digest);
+    mbedtls_sha256_free(&ota.sha);
+    ota.sha256 = hexDigest(digest);
+    ota.state = OTA_STATE_READY;
+
+    if (ota.hasExpected && memcmp(digest, ota.expected, sizeof(digest)) != 0) {
+        otaFail("SHA-256 mismatch (got " + ota.sha256 + ")");
+        return false;
+    }
+
+    if (ota.target == OTA_TARGET_APP) {
+        // Validates the image header/checksum before switching
+        esp_err_t err = esp_ota_set_boot_partition(ota.part);
+        if (err != ESP_OK) {
+            otaFail("Image rejected: " + String(esp_err_to_name(err)));
+            return false;
+        }
+
+        // Boot the new image on trial; see otaBootCheck()
+        const esp_partition_t* running = esp_ota_get_running_partition();
+        Preferences prefs;
+        if (prefs.begin("ota", false)) {
+            prefs.putBool("trial", true);
+            prefs.putUChar("boots", 0);
+            prefs.putString("prev", running ? running->label : "");
+            prefs.end();
+        }
+    }
+
+    logEvent(EVENT_OTA, 0xFF, ota.target, 0, 0);
+    debugPrintln("OTA: " + String(ota.size) + " bytes written to " + String(ota.part->label) +
+                 ", sha256 " + ota.sha256);
+    return true;
+}
+
+void otaAbort() {
+    if (ota.state == OTA_STATE_RECEIVING) {
+        mbedtls_sha256_free(&ota.sha);
+        debugPrintln("OTA: aborted at " + String(ota.received) + " bytes");
+    }
+    ota.state = OTA_STATE_IDLE;
+    ota.part = nullptr;
+    ota.size = 0;
+    ota.received = 0;
+    ota.erasedTo = 0;
+}
+
+uint32_t otaReceived() {
+    return ota.received;
+}
+
+String otaLastError() {
+    return ota.error;
+}
+
+void otaStatusJson(JsonDocument& doc) {
+    doc["state"] = otaStateNames[ota.state];
+    doc["target"] = (ota.target == OTA_TARGET_APP) ? "app" : "fs";
+    doc["partition"] = ota.part ? ota.part->label : "";
+    doc["size"] = ota.size;
+    doc["received"] = ota.received;
+    if (ota.sha256.length()) doc["sha256"] = ota.sha256;
+    if (ota.error.length()) doc["error"] = ota.error;
+
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    const esp_partition_t* next = esp_ota_get_next_update_partition(nullptr);
+    doc["running"] = running ? running->label : "";
+    doc["next"] = next ? next->label : "";
+    doc["trial"] = otaTrial;
+}
+
+// ---- Boot-time rollback ----
+
+void otaBootCheck() {
+    Preferences prefs;
+    if (!prefs.begin("ota", false)) return;
+
+    if (prefs.getBool("trial", false)) {
+        uint8_t boots = prefs.getUChar("boots", 0) + 1;
+        if (boots > OTA_MAX_TRIAL_BOOTS) {
+            String prev = prefs.getString("prev", "");
+            prefs.putBool("trial", false);
+            prefs.end();
+
+            const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY,
+                                                                   prev.c_str());
+            Serial.println("OTA: new image failed " + String(OTA_MAX_TRIAL_BOOTS) + " trial boots, rolling back to " + prev);
+            if (part && esp_ota_set_boot_partition(part) == ESP_OK) {
+                ESP.restart();
+            }
+            return;
+        }
+        prefs.putUChar("boots", boots);
+        otaTrial = true;
+        Serial.println("OTA: running new image on trial (boot " + String(boots) + ")");
+    }
+    prefs.end();
+
+    // An image the bootloader is holding for verification is confirmed the same way
+    esp_ota_img_states_t state;
+    const esp_partition_t* running = esp_ota_get_running_partition();
+    if (running && esp_ota_get_state_partition(running, &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        otaTrial = true;
+    }
+}
+
+void serviceOta() {
+    if (!otaTrial || millis() < OTA_CONFIRM_MS) return;
+
+    // Survived long enough: keep this image (also cancels a bootloader rollback)
+    otaTrial = false;
+    esp_ota_mark_app_valid_cancel_rollback();
+
+    Preferences prefs;
+    if (prefs.begin("ota", false)) {
+        prefs.putBool("trial", false);
+        prefs.end();
+    }
+    debugPrintln("OTA: new image confirmed");
+}
+
+// Keep Arduino's startup code from confirming the image on our behalf
+bool verifyRollbackLater() {
+    return true;
+}
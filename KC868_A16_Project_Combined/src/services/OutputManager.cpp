@@ -0,0 +1,383 @@
+// OutputManager.cpp
+// Output arbitration: per-output priority array, coalesced writes, change journal
+//
+// Every writer commands a slot instead of setting outputStates. Each output
+// has OUTPUT_PRIORITY_LEVELS slots, as in a BACnet priority array. A slot is
+// either empty (relinquished) or holds ON/OFF plus the source that wrote it.
+// The output follows the highest-priority (lowest-numbered) slot that is set,
+// or stays off when all slots are empty. Writers of the same level share the
+// slot, so the latest command there wins.
+//
+//   1  interlock      master enable off holds every output off
+//   7  logic          a running logic program, for the outputs it writes
+//   8  manual         POST /api/outputs, and its pulses
+//  10  modbus         Modbus coil writes
+//  12  automation     schedules, analog triggers, RF remotes
+//  16  bacnet         BACnet writes without a priority (the standard default)
+//   1-16              BACnet writes that carry a priority
+//
+// POST /api/outputs holds an output against Modbus and automation until it
+// is released ("release" in the same request), and Modbus holds it against
+// automation. The one-shot writers that predate the array (/api/relay, the
+// WebSocket relay commands, console RELAY, RS485 frames) do not hold
+// anything: applyOutputsOnce() rewrites the slots at and below their level,
+// so the next schedule, trigger, RF or Modbus command wins again. The levels
+// of every source except logic and the interlock can be changed with
+// POST /api/outputs/priority and are kept in NVS; giving sources the same
+// level brings back last-writer-wins between them.
+//
+// commandOutputs() only updates slots. flushOutputs() works out the resulting
+// image, journals the changed outputs, mirrors them into outputStates and
+// writes only the expander banks that changed. serviceOutputs() flushes once
+// per main-loop pass, so commands from any number of sources in one pass cost
+// at most one transaction per bank. Interactive callers use applyOutputs()
+// when they need the I2C result for their reply.
+
+#include "../FunctionPrototypes.h"
+
+static uint16_t slotSet[OUTPUT_PRIORITY_LEVELS];     // bit i: output i has a value at this level
+static uint16_t slotValue[OUTPUT_PRIORITY_LEVELS];
+static uint8_t slotSource[OUTPUT_PRIORITY_LEVELS][16];
+
+static uint16_t writtenMask = 0;        // what the expanders hold
+static uint8_t bankDirty = 0x03;        // bit b: bank b must be rewritten
+static uint32_t retryAtMs = 0;
+static bool interlocked = false;
+
+static OutputChange journal[OUTPUT_JOURNAL_SIZE];
+static uint32_t journalCount = 0;
+static OutputStats stats = {};
+
+static uint16_t pulsePending = 0;       // bit i: output i has a pulse running
+static uint16_t pulseRevert = 0;        // bit i: state to restore when it ends
+static uint32_t pulseDueMs[16];
+static uint8_t pulseLevel[16];          // priority the pulse was commanded at
+
+// Level each source commands at, indexed by OUTPUT_SRC_*
+static const uint8_t defaultSourcePriority[OUTPUT_SRC_COUNT] = {
+    OUTPUT_PRIO_MANUAL,         // web
+    OUTPUT_PRIO_MANUAL,         // websocket
+    OUTPUT_PRIO_MANUAL,         // console
+    OUTPUT_PRIO_MANUAL,         // rs485
+    OUTPUT_PRIO_MODBUS,         // modbus
+    OUTPUT_PRIO_BACNET,         // bacnet, writes without a priority
+    OUTPUT_PRIO_AUTOMATION,     // schedule
+    OUTPUT_PRIO_AUTOMATION,     // trigger
+    OUTPUT_PRIO_AUTOMATION,     // rf
+    OUTPUT_PRIO_LOGIC,          // logic (fixed)
+    OUTPUT_PRIO_MANUAL,         // pulse: ends at the level it was started at
+    OUTPUT_PRIO_INTERLOCK,      // interlock (fixed)
+};
+static uint8_t sourcePriority[OUTPUT_SRC_COUNT];
+
+static const char* const sourceNames[] = {
+    "web", "websocket", "console", "rs485", "modbus", "bacnet",
+    "schedule", "trigger", "rf", "logic", "pulse", "interlock",
+};
+
+static void loadOutputSourcePriorities();
+
+// ---- Slots ----
+
+// Highest slot holding output i; 0 when relinquished
+static uint8_t winningPriority(uint8_t output) {
+    const uint16_t bit = 1u << output;
+    for (uint8_t p = 0; p < OUTPUT_PRIORITY_LEVELS; p++) {
+        if (slotSet[p] & bit) return p + 1;
+    }
+    return 0;
+}
+
+static uint16_t resolveOutputs() {
+    uint16_t image = 0;
+    uint16_t decided = 0;
+    for (uint8_t p = 0; p < OUTPUT_PRIORITY_LEVELS && decided != 0xFFFF; p++) {
+        const uint16_t fresh = slotSet[p] & ~decided;
+        image |= slotValue[p] & fresh;
+        decided |= fresh;
+    }
+    return image;
+}
+
+bool commandOutputs(uint8_t source, uint8_t priority, uint16_t mask, uint16_t value) {
+    if (mask == 0 || priority < 1 || priority > OUTPUT_PRIORITY_LEVELS) return false;
+
+    const uint16_t before = resolveOutputs();
+    const uint8_t p = priority - 1;
+    slotSet[p] |= mask;
+    slotValue[p] = (slotValue[p] & ~mask) | (value & mask);
+    for (uint8_t i = 0; i < 16; i++) {
+        if (mask & (1u << i)) slotSource[p][i] = source;
+    }
+
+    // An explicit command at a pulse's level overrides the pulse still running
+    if (source != OUTPUT_SRC_PULSE && (pulsePending & mask)) {
+        for (uint8_t i = 0; i < 16; i++) {
+            if ((pulsePending & mask & (1u << i)) && pulseLevel[i] == priority) pulsePending &= ~(1u << i);
+        }
+    }
+
+    stats.commands++;
+    return resolveOutputs() != before;
+}
+
+void relinquishOutputs(uint8_t priority, uint16_t mask) {
+    if (mask == 0 || priority < 1 || priority > OUTPUT_PRIORITY_LEVELS) return;
+    slotSet[priority - 1] &= ~mask;
+    stats.commands++;
+}
+
+// Schedule / trigger action: 0 = off, 1 = on, 2 = toggle
+void commandOutputAction(uint8_t source, uint16_t mask, uint8_t action) {
+    uint16_t value = 0;
+    if (action == 1) value = 0xFFFF;
+    else if (action == 2) value = ~getOutputMask();
+    else if (action != 0) return;
+
+    debugPrintln("Outputs 0x" + String(mask, HEX) + " -> " + (action == 0 ? "OFF" : action == 1 ? "ON" : "TOGGLE"));
+    commandOutputs(source, outputSourcePriority(source), mask, value);
+}
+
+// ---- Hardware ----
+
+static void journalChange(uint8_t output, bool state) {
+    OutputChange& e = journal[journalCount % OUTPUT_JOURNAL_SIZE];
+    e.ms = millis();
+    e.output = output;
+    e.state = state;
+    e.priority = winningPriority(output);
+    e.source = e.priority ? slotSource[e.priority - 1][output] : 0xFF;
+    journalCount++;
+    stats.changes++;
+
+    // Durable copy in the flash journal (see services/EventLog.cpp)
+    logEvent(EVENT_OUTPUT, e.source, output, state, e.priority);
+}
+
+// Returns false if a bank could not be written (it is retried later)
+bool flushOutputs() {
+    const uint16_t image = resolveOutputs();
+    const uint16_t changed = image ^ getOutputMask();
+
+    for (uint8_t i = 0; i < 16; i++) {
+        if (!(changed & (1u << i))) continue;
+        outputStates[i] = (image >> i) & 1;
+        journalChange(i, outputStates[i]);
+    }
+
+    const uint16_t stale = image ^ writtenMask;
+    if (stale & 0x00FF) bankDirty |= 0x01;
+    if (stale & 0xFF00) bankDirty |= 0x02;
+    if (bankDirty == 0) return true;
+
+    // After an error the bus gets a rest unless something new has to go out
+    if (changed == 0 && retryAtMs && (int32_t)(millis() - retryAtMs) < 0) return false;
+
+    bool ok = true;
+    for (uint8_t bank = 0; bank < 2; bank++) {
+        if (!(bankDirty & (1u << bank))) continue;
+        const uint16_t bankMask = bank ? 0xFF00 : 0x00FF;
+        stats.writes++;
+        if (writeOutputBank(bank)) {
+            writtenMask = (writtenMask & ~bankMask) | (image & bankMask);
+            bankDirty &= ~(1u << bank);
+        }
+        else {
+            stats.writeErrors++;
+            ok = false;
+        }
+    }
+    retryAtMs = ok ? 0 : millis() + OUTPUT_RETRY_MS;
+
+    if (changed && debugMode) printIOStates();
+    return ok;
+}
+
+// POST /api/outputs, RF: command (held at the source level) and write now
+bool applyOutputs(uint8_t source, uint16_t mask, uint16_t value) {
+    if (mask == 0) return true;
+    commandOutputs(source, outputSourcePriority(source), mask, value);
+    return flushOutputs();
+}
+
+// One-shot command (see the header comment): last writer wins against every
+// source at or below `source`'s level, and no hold is left behind. An output
+// no such slot holds takes the value in the lowest slot, where any command
+// replaces it. Higher levels (logic, the interlock, prioritised BACnet
+// writes) still win.
+bool applyOutputsOnce(uint8_t source, uint16_t mask, uint16_t value) {
+    if (mask == 0) return true;
+    uint16_t covered = 0;
+    for (uint8_t p = outputSourcePriority(source); p <= OUTPUT_PRIORITY_LEVELS; p++) {
+        const uint16_t held = slotSet[p - 1] & mask;
+        if (held) commandOutputs(source, p, held, value);
+        covered |= held;
+    }
+    if (mask & ~covered) commandOutputs(source, OUTPUT_PRIORITY_LEVELS, mask & ~covered, value);
+    return flushOutputs();
+}
+
+uint16_t getOutputMask() {
+    uint16_t bits = 0;
+    for (int i = 0; i < 16; i++) {
+        if (outputStates[i]) bits |= (1u << i);
+    }
+    return bits;
+}
+
+void initOutputs() {
+    loadOutputSourcePriorities();
+    memset(slotSet, 0, sizeof(slotSet));
+    memset(outputStates, 0, sizeof(bool) * 16);
+    writtenMask = 0;
+    bankDirty = 0;
+    if (!writeOutputs()) {
+        bankDirty = 0x03;
+        retryAtMs = millis() + OUTPUT_RETRY_MS;
+    }
+}
+
+// ---- Timed pulses ----
+
+uint16_t getPendingPulseMask() {
+    return pulsePending;
+}
+
+// priority: the level the pulse was commanded at; it ends there too
+void scheduleOutputPulse(uint8_t relay, uint32_t durationMs, uint8_t priority) {
+    if (relay >= 16 || durationMs == 0 || priority < 1 || priority > OUTPUT_PRIORITY_LEVELS) return;
+    const uint16_t bit = 1u << relay;
+
+    // The pulse ends by returning the output to the opposite of its pulsed state
+    if (outputStates[relay]) pulseRevert &= ~bit;
+    else pulseRevert |= bit;
+    pulseDueMs[relay] = millis() + durationMs;
+    pulseLevel[relay] = priority;
+    pulsePending |= bit;
+}
+
+static void serviceOutputPulses() {
+    if (pulsePending == 0) return;
+
+    const uint32_t now = millis();
+    uint16_t due = 0;
+    for (int i = 0; i < 16; i++) {
+        const uint16_t bit = 1u << i;
+        if ((pulsePending & bit) && (int32_t)(now - pulseDueMs[i]) >= 0) {
+            due |= bit;
+        }
+    }
+    if (due == 0) return;
+
+    // A pulse is finished even if outputs were disabled after it started
+    pulsePending &= ~due;
+    for (uint8_t i = 0; i < 16; i++) {
+        const uint16_t bit = 1u << i;
+        if (due & bit) commandOutputs(OUTPUT_SRC_PULSE, pulseLevel[i], bit, pulseRevert);
+    }
+}
+
+// Main loop, after every writer has had its turn
+void serviceOutputs() {
+    // Master enable off holds everything off. The slots below are kept (a
+    // BACnet or Modbus master expects its command to stand), so enabling
+    // again returns each output to what is commanded. Running pulses end now
+    // rather than leaving their pulsed state behind.
+    if (!outputsMasterEnable && !interlocked) {
+        commandOutputs(OUTPUT_SRC_INTERLOCK, OUTPUT_PRIO_INTERLOCK, 0xFFFF, 0);
+        for (uint8_t i = 0; i < 16; i++) {
+            const uint16_t bit = 1u << i;
+            if (pulsePending & bit) commandOutputs(OUTPUT_SRC_PULSE, pulseLevel[i], bit, pulseRevert);
+        }
+        pulsePending = 0;
+        interlocked = true;
+    }
+    else if (outputsMasterEnable && interlocked) {
+        relinquishOutputs(OUTPUT_PRIO_INTERLOCK, 0xFFFF);
+        interlocked = false;
+    }
+
+    serviceOutputPulses();
+
+    const uint16_t before = getOutputMask();
+    flushOutputs();
+    if (getOutputMask() != before) broadcastUpdate(WS_TOPIC_OUTPUTS);
+}
+
+// ---- Inspection ----
+
+// Slot at priority (1..16) for an output; false when relinquished
+bool outputSlot(uint8_t output, uint8_t priority, bool& value, uint8_t& source) {
+    if (output >= 16 || priority < 1 || priority > OUTPUT_PRIORITY_LEVELS) return false;
+    const uint8_t p = priority - 1;
+    if (!(slotSet[p] & (1u << output))) return false;
+    value = (slotValue[p] >> output) & 1;
+    source = slotSource[p][output];
+    return true;
+}
+
+uint8_t outputActivePriority(uint8_t output) {
+    return output < 16 ? winningPriority(output) : 0;
+}
+
+const char* outputSourceName(uint8_t source) {
+    return source < sizeof(sourceNames) / sizeof(sourceNames[0]) ? sourceNames[source] : "default";
+}
+
+// ---- Source levels ----
+
+uint8_t outputSourcePriority(uint8_t source) {
+    return source < OUTPUT_SRC_COUNT ? sourcePriority[source] : OUTPUT_PRIO_MANUAL;
+}
+
+// Logic, pulses and the interlock keep their levels; 1 belongs to the interlock
+bool setOutputSourcePriority(uint8_t source, uint8_t priority) {
+    if (source >= OUTPUT_SRC_COUNT || source == OUTPUT_SRC_LOGIC ||
+        source == OUTPUT_SRC_PULSE || source == OUTPUT_SRC_INTERLOCK) return false;
+    if (priority < 2 || priority > OUTPUT_PRIORITY_LEVELS) return false;
+    sourcePriority[source] = priority;
+    return true;
+}
+
+void resetOutputSourcePriorities() {
+    memcpy(sourcePriority, defaultSourcePriority, sizeof(sourcePriority));
+}
+
+void saveOutputSourcePriorities() {
+    Preferences prefs;
+    if (!prefs.begin("outputs", false)) {
+        debugPrintln("ERROR: Failed to open output priority storage");
+        return;
+    }
+    prefs.putBytes("levels", sourcePriority, sizeof(sourcePriority));
+    prefs.end();
+}
+
+static void loadOutputSourcePriorities() {
+    resetOutputSourcePriorities();
+
+    uint8_t stored[OUTPUT_SRC_COUNT];
+    Preferences prefs;
+    if (!prefs.begin("outputs", true)) return;
+    // Saved with another source count: keep the defaults
+    const bool ok = getPrefsRecords(prefs, "levels", stored, sizeof(stored), 1) == 1;
+    prefs.end();
+    if (!ok) return;
+
+    for (uint8_t i = 0; i < OUTPUT_SRC_COUNT; i++) setOutputSourcePriority(i, stored[i]);
+}
+
+// age 0 = most recent change
+bool outputJournalEntry(uint32_t age, OutputChange& out) {
+    if (age >= journalCount || age >= OUTPUT_JOURNAL_SIZE) return false;
+    out = journal[(journalCount - 1 - age) % OUTPUT_JOURNAL_SIZE];
+    return true;
+}
+
+uint32_t outputJournalCount() {
+    return journalCount;
+}
+
+const OutputStats& outputStats() {
+    return stats;
+}
@@ -3,6 +3,25 @@
 
 #include "../FunctionPrototypes.h"
 
+// Outputs go through the output manager and reach the expanders at the end
+// of the loop pass, together with anything else commanded in it
+static void runScheduleTarget(const TimeSchedule& s, uint16_t targetId) {
+    if (s.targetType == 0) {
+        // Single output - targetId is a relay index
+        if (targetId < 16) commandOutputAction(OUTPUT_SRC_SCHEDULE, 1u << targetId, s.action);
+    }
+    else if (s.targetType == 1) {
+        // Multiple outputs (bitmask)
+        commandOutputAction(OUTPUT_SRC_SCHEDULE, targetId, s.action);
+    }
+    else if (s.targetType == 2) {
+        // Learned RF code (targetId = slot)
+        if (!queueLearnedRfCode(targetId)) {
+            debugPrintln("ERROR: RF code " + String(targetId) + " not learned or transmit queue full");
+        }
+    }
+}
+
 void checkInputBasedSchedules() {
     // Calculate current state of all inputs as a single 32-bit value
     uint32_t currentInputState = 0;
@@ -25,22 +44,19 @@ void checkInputBasedSchedules() {
     for (int i = 0; i < MAX_SCHEDULES; i++) {
         if (!schedules[i].enabled) continue;
 
-        // We now care about input-based, combined, and sensor-based schedules
-        if (schedules[i].triggerType != 1 && schedules[i].triggerType != 2 && schedules[i].triggerType != 3) continue;
+        // Input-based and combined schedules; sensor-based ones run from checkSensorSchedules()
+        if (schedules[i].triggerType != 1 && schedules[i].triggerType != 2) continue;
 
         // Skip if this is an input-based schedule with no inputs
-        if ((schedules[i].triggerType == 1 || schedules[i].triggerType == 2) && schedules[i].inputMask == 0) continue;
+        if (schedules[i].inputMask == 0) continue;
 
         bool conditionMet = false;
-        bool timeConditionMet = true;  // Default true for input-based/sensor-based, will check for combined
+        bool timeConditionMet = true;  // Default true for input-based, will check for combined
 
         if (schedules[i].triggerType == 2) { // Combined type
             // Get current time
             DateTime now;
-            if (rtcInitialized) {
-                now = rtc.now();
-            }
-            else {
+            if (!readRtc(now)) {
                 // Use ESP32 time if RTC not available
                 time_t nowTime;
                 struct tm timeinfo;
@@ -72,119 +88,57 @@ void checkInputBasedSchedules() {
         uint16_t highMatchingInputs = 0;
         uint16_t lowMatchingInputs = 0;
 
-        // Check conditions based on trigger type
-        if (schedules[i].triggerType == 3) { // Sensor-based
-            // Get the sensor index and ensure it's valid
-            uint8_t sensorIndex = schedules[i].sensorIndex;
-            if (sensorIndex >= 3) continue; // Invalid sensor index
-
-            // Skip if sensor is configured as digital input
-            if (htSensorConfig[sensorIndex].sensorType == SENSOR_TYPE_DIGITAL) continue;
-
-            bool sensorConditionMet = false;
-
-            // Check temperature threshold
-            if (schedules[i].sensorTriggerType == 0) { // Temperature
-                float currentTemp = htSensorConfig[sensorIndex].temperature;
-                float threshold = schedules[i].sensorThreshold;
-
-                switch (schedules[i].sensorCondition) {
-                case 0: // Above
-                    sensorConditionMet = (currentTemp > threshold);
-                    break;
-                case 1: // Below
-                    sensorConditionMet = (currentTemp < threshold);
-                    break;
-                case 2: // Equal (with tolerance)
-                    sensorConditionMet = (abs(currentTemp - threshold) < 0.5f);
-                    break;
-                }
-            }
-            // Check humidity threshold (only for DHT sensors)
-            else if (schedules[i].sensorTriggerType == 1 &&
-                (htSensorConfig[sensorIndex].sensorType == SENSOR_TYPE_DHT11 ||
-                    htSensorConfig[sensorIndex].sensorType == SENSOR_TYPE_DHT22)) {
-
-                float currentHumidity = htSensorConfig[sensorIndex].humidity;
-                float threshold = schedules[i].sensorThreshold;
-
-                switch (schedules[i].sensorCondition) {
-                case 0: // Above
-                    sensorConditionMet = (currentHumidity > threshold);
-                    break;
-                case 1: // Below
-                    sensorConditionMet = (currentHumidity < threshold);
-                    break;
-                case 2: // Equal (with tolerance)
-                    sensorConditionMet = (abs(currentHumidity - threshold) < 2.0f);
-                    break;
-                }
-            }
+        // Evaluate input conditions based on logic type
+        if (schedules[i].logic == 0) {  // AND logic
+            // All conditions must be met
+            conditionMet = true;  // Start with true for AND logic
 
-            conditionMet = sensorConditionMet;
+            for (int bitPos = 0; bitPos < 19; bitPos++) {
+                uint32_t bitMask = 1UL << bitPos;
 
-            // For sensor conditions, we'll use the targetId for the true condition
-            // and targetIdLow for the false condition (like high and low for digital inputs)
-            if (sensorConditionMet) {
-                highMatchingInputs = 1; // Just a non-zero value to trigger the action
-            }
-            else {
-                lowMatchingInputs = 1;
-            }
-        }
-        else { // Input-based or combined with input
-            // Evaluate input conditions based on logic type
-            if (schedules[i].logic == 0) {  // AND logic
-                // All conditions must be met
-                conditionMet = true;  // Start with true for AND logic
-
-                for (int bitPos = 0; bitPos < 19; bitPos++) {
-                    uint32_t bitMask = 1UL << bitPos;
-
-                    // If this bit is part of our input mask, check its state
-                    if (schedules[i].inputMask & bitMask) {
-                        bool desiredState = (schedules[i].inputStates & bitMask) != 0;
-                        bool currentState = (currentInputState & bitMask) != 0;
+                // If this bit is part of our input mask, check its state
+                if (schedules[i].inputMask & bitMask) {
+                    bool desiredState = (schedules[i].inputStates & bitMask) != 0;
+                    bool currentState = (currentInputState & bitMask) != 0;
 
-                        if (currentState != desiredState) {
-                            conditionMet = false;
-                            break; // Break early for AND logic if one condition fails
-                        }
+                    if (currentState != desiredState) {
+                        conditionMet = false;
+                        break; // Break early for AND logic if one condition fails
+                    }
 
-                        // Track which inputs match which state for relay control
-                        if (currentState) {
-                            highMatchingInputs |= bitMask;
-                        }
-                        else {
-                            lowMatchingInputs |= bitMask;
-                        }
+                    // Track which inputs match which state for relay control
+                    if (currentState) {
+                        highMatchingInputs |= bitMask;
+                    }
+                    else {
+                        lowMatchingInputs |= bitMask;
                     }
                 }
             }
-            else {  // OR logic
-                // Any condition can trigger
-                conditionMet = false;  // Start with false for OR logic
+        }
+        else {  // OR logic
+            // Any condition can trigger
+            conditionMet = false;  // Start with false for OR logic
 
-                for (int bitPos = 0; bitPos < 19; bitPos++) {
-                    uint32_t bitMask = 1UL << bitPos;
+            for (int bitPos = 0; bitPos < 19; bitPos++) {
+                uint32_t bitMask = 1UL << bitPos;
 
-                    // If this bit is part of our input mask, check its state
-                    if (schedules[i].inputMask & bitMask) {
-                        bool desiredState = (schedules[i].inputStates & bitMask) != 0;
-                        bool currentState = (currentInputState & bitMask) != 0;
+                // If this bit is part of our input mask, check its state
+                if (schedules[i].inputMask & bitMask) {
+                    bool desiredState = (schedules[i].inputStates & bitMask) != 0;
+                    bool currentState = (currentInputState & bitMask) != 0;
 
-                        // Track which inputs match which state for relay control
-                        if (currentState) {
-                            highMatchingInputs |= bitMask;
-                        }
-                        else {
-                            lowMatchingInputs |= bitMask;
-                        }
+                    // Track which inputs match which state for relay control
+                    if (currentState) {
+                        highMatchingInputs |= bitMask;
+                    }
+                    else {
+                        lowMatchingInputs |= bitMask;
+                    }
 
-                        if (currentState == desiredState) {
-                            conditionMet = true;
-                            // Don't break early for OR logic - we need to track all matching inputs
-                        }
+                    if (currentState == desiredState) {
+                        conditionMet = true;
+                        // Don't break early for OR logic - we need to track all matching inputs
                     }
                 }
             }
@@ -207,60 +161,68 @@ void checkInputBasedSchedules() {
     }
 }
 
-void executeScheduleAction(int scheduleIndex, uint16_t targetId) {
-    if (scheduleIndex < 0 || scheduleIndex >= MAX_SCHEDULES) return;
+static ThresholdState sensorScheduleStates[MAX_SCHEDULES];
 
-    debugPrintln("Executing schedule: " + String(schedules[scheduleIndex].name));
+bool sensorScheduleActive(int index) {
+    return index >= 0 && index < MAX_SCHEDULES && sensorScheduleStates[index].active;
+}
 
-    // Perform the scheduled action
-    if (schedules[scheduleIndex].targetType == 0) {
-        // Single output - targetId should be a relay index
-        uint8_t relay = targetId;
-        if (relay < 16) {
-            debugPrintln("Setting single relay " + String(relay) + " to " +
-                (schedules[scheduleIndex].action == 0 ? "OFF" :
-                    schedules[scheduleIndex].action == 1 ? "ON" : "TOGGLE"));
-
-            if (schedules[scheduleIndex].action == 0) {        // OFF
-                outputStates[relay] = false;
-            }
-            else if (schedules[scheduleIndex].action == 1) {   // ON
-                outputStates[relay] = true;
-            }
-            else if (schedules[scheduleIndex].action == 2) {   // TOGGLE
-                outputStates[relay] = !outputStates[relay];
-            }
+// Sensor-based schedules (type 3), after each sensor read. targetId runs when the
+// condition becomes true, targetIdLow when it releases; nothing runs while it holds.
+void checkSensorSchedules() {
+    for (int i = 0; i < MAX_SCHEDULES; i++) {
+        ThresholdState& state = sensorScheduleStates[i];
+        if (!schedules[i].enabled || schedules[i].triggerType != 3) {
+            state = {};
+            continue;
         }
-    }
-    else if (schedules[scheduleIndex].targetType == 1) {
-        // Multiple outputs (using bitmask)
-        debugPrintln("Setting multiple relays with mask: " + String(targetId, BIN));
-
-        for (int j = 0; j < 16; j++) {
-            if (targetId & (1 << j)) {
-                debugPrintln("Setting relay " + String(j) + " to " +
-                    (schedules[scheduleIndex].action == 0 ? "OFF" :
-                        schedules[scheduleIndex].action == 1 ? "ON" : "TOGGLE"));
-
-                if (schedules[scheduleIndex].action == 0) {        // OFF
-                    outputStates[j] = false;
-                }
-                else if (schedules[scheduleIndex].action == 1) {   // ON
-                    outputStates[j] = true;
-                }
-                else if (schedules[scheduleIndex].action == 2) {   // TOGGLE
-                    outputStates[j] = !outputStates[j];
-                }
-            }
+
+        // Get the sensor index and ensure it's valid
+        uint8_t sensorIndex = schedules[i].sensorIndex;
+        if (sensorIndex >= 3) continue; // Invalid sensor index
+
+        // Skip if sensor is configured as digital input
+        if (htSensorConfig[sensorIndex].sensorType == SENSOR_TYPE_DIGITAL) continue;
+
+        float value, tolerance, hysteresis = schedules[i].sensorHysteresis;
+        if (schedules[i].sensorTriggerType == 0) { // Temperature
+            value = htSensorConfig[sensorIndex].temperature;
+            tolerance = 0.5f;
+            if (hysteresis <= 0.0f) hysteresis = TRIGGER_HYST_TEMP;
         }
-    }
+        // Humidity (only for DHT sensors)
+        else if (schedules[i].sensorTriggerType == 1 &&
+            (htSensorConfig[sensorIndex].sensorType == SENSOR_TYPE_DHT11 ||
+                htSensorConfig[sensorIndex].sensorType == SENSOR_TYPE_DHT22)) {
+            value = htSensorConfig[sensorIndex].humidity;
+            tolerance = 2.0f;
+            if (hysteresis <= 0.0f) hysteresis = TRIGGER_HYST_HUMIDITY;
+        }
+        else {
+            continue;
+        }
+
+        state.level = thresholdLevel(state.level, value, schedules[i].sensorThreshold,
+                                     schedules[i].sensorCondition, tolerance, hysteresis);
+        if (!updateThresholdState(state, state.level, schedules[i].minOnSec, schedules[i].minOffSec)) continue;
 
-    // Update outputs
-    if (!writeOutputs()) {
-        debugPrintln("ERROR: Failed to write outputs when executing schedule");
+        debugPrintln("Sensor condition " + String(state.active ? "met" : "released") +
+            " for schedule " + String(i) + ": " + String(schedules[i].name));
+
+        const uint16_t target = state.active ? schedules[i].targetId : schedules[i].targetIdLow;
+        if (target > 0) executeScheduleAction(i, target);
     }
+}
+
+void executeScheduleAction(int scheduleIndex, uint16_t targetId) {
+    if (scheduleIndex < 0 || scheduleIndex >= MAX_SCHEDULES) return;
+
+    debugPrintln("Executing schedule: " + String(schedules[scheduleIndex].name));
+
+    runScheduleTarget(schedules[scheduleIndex], targetId);
 
     // Broadcast update to UI
+    publishScheduleEvent(scheduleIndex);
     broadcastUpdate();
 }
 
@@ -311,10 +273,7 @@ void checkInputBasedSchedules(int changedInputIndex, bool newState) {
 
         if (schedules[i].triggerType == 2) { // Combined type
             DateTime now;
-            if (rtcInitialized) {
-                now = rtc.now();
-            }
-            else {
+            if (!readRtc(now)) {
                 // Use ESP32 time if RTC not available
                 time_t nowTime;
                 struct tm timeinfo;
@@ -393,55 +352,10 @@ void checkInputBasedSchedules(int changedInputIndex, bool newState) {
         if (inputConditionMet) {
             debugPrintln("Executing schedule: " + String(schedules[i].name));
 
-            // Perform the scheduled action
-            if (schedules[i].targetType == 0) {
-                // Single output
-                uint8_t relay = schedules[i].targetId;
-                if (relay < 16) {
-                    debugPrintln("Setting single relay " + String(relay) + " to " +
-                        (schedules[i].action == 0 ? "OFF" :
-                            schedules[i].action == 1 ? "ON" : "TOGGLE"));
-
-                    if (schedules[i].action == 0) {        // OFF
-                        outputStates[relay] = false;
-                    }
-                    else if (schedules[i].action == 1) {   // ON
-                        outputStates[relay] = true;
-                    }
-                    else if (schedules[i].action == 2) {   // TOGGLE
-                        outputStates[relay] = !outputStates[relay];
-                    }
-                }
-            }
-            else if (schedules[i].targetType == 1) {
-                // Multiple outputs (using bitmask)
-                debugPrintln("Setting multiple relays with mask: " + String(schedules[i].targetId, BIN));
-
-                for (int j = 0; j < 16; j++) {
-                    if (schedules[i].targetId & (1 << j)) {
-                        debugPrintln("Setting relay " + String(j) + " to " +
-                            (schedules[i].action == 0 ? "OFF" :
-                                schedules[i].action == 1 ? "ON" : "TOGGLE"));
-
-                        if (schedules[i].action == 0) {        // OFF
-                            outputStates[j] = false;
-                        }
-                        else if (schedules[i].action == 1) {   // ON
-                            outputStates[j] = true;
-                        }
-                        else if (schedules[i].action == 2) {   // TOGGLE
-                            outputStates[j] = !outputStates[j];
-                        }
-                    }
-                }
-            }
-
-            // Update outputs
-            if (!writeOutputs()) {
-                debugPrintln("ERROR: Failed to write outputs when executing schedule");
-            }
+            runScheduleTarget(schedules[i], schedules[i].targetId);
 
             // Broadcast update
+            publishScheduleEvent(i);
             broadcastUpdate();
         }
     }
@@ -450,10 +364,7 @@ void checkInputBasedSchedules(int changedInputIndex, bool newState) {
 void checkSchedules() {
     // Get current time
     DateTime now;
-    if (rtcInitialized) {
-        now = rtc.now();
-    }
-    else {
+    if (!readRtc(now)) {
         // Use ESP32 time if RTC not available
         time_t nowTime;
         struct tm timeinfo;
@@ -517,55 +428,10 @@ void executeSchedule(int scheduleIndex) {
 
     debugPrintln("Executing schedule: " + String(schedules[scheduleIndex].name));
 
-    // Perform the scheduled action
-    if (schedules[scheduleIndex].targetType == 0) {
-        // Single output
-        uint8_t relay = schedules[scheduleIndex].targetId;
-        if (relay < 16) {
-            debugPrintln("Setting single relay " + String(relay) + " to " +
-                (schedules[scheduleIndex].action == 0 ? "OFF" :
-                    schedules[scheduleIndex].action == 1 ? "ON" : "TOGGLE"));
-
-            if (schedules[scheduleIndex].action == 0) {        // OFF
-                outputStates[relay] = false;
-            }
-            else if (schedules[scheduleIndex].action == 1) {   // ON
-                outputStates[relay] = true;
-            }
-            else if (schedules[scheduleIndex].action == 2) {   // TOGGLE
-                outputStates[relay] = !outputStates[relay];
-            }
-        }
-    }
-    else if (schedules[scheduleIndex].targetType == 1) {
-        // Multiple outputs (using bitmask)
-        debugPrintln("Setting multiple relays with mask: " + String(schedules[scheduleIndex].targetId, BIN));
-
-        for (int j = 0; j < 16; j++) {
-            if (schedules[scheduleIndex].targetId & (1 << j)) {
-                debugPrintln("Setting relay " + String(j) + " to " +
-                    (schedules[scheduleIndex].action == 0 ? "OFF" :
-                        schedules[scheduleIndex].action == 1 ? "ON" : "TOGGLE"));
-
-                if (schedules[scheduleIndex].action == 0) {        // OFF
-                    outputStates[j] = false;
-                }
-                else if (schedules[scheduleIndex].action == 1) {   // ON
-                    outputStates[j] = true;
-                }
-                else if (schedules[scheduleIndex].action == 2) {   // TOGGLE
-                    outputStates[j] = !outputStates[j];
-                }
-            }
-        }
-    }
-
-    // Update outputs
-    if (!writeOutputs()) {
-        debugPrintln("ERROR: Failed to write outputs when executing schedule");
-    }
+    runScheduleTarget(schedules[scheduleIndex], schedules[scheduleIndex].targetId);
 
     // Broadcast update
+    publishScheduleEvent(scheduleIndex);
     broadcastUpdate();
 }
 
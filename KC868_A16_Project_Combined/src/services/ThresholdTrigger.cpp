@@ -0,0 +1,46 @@
+// ThresholdTrigger.cpp
+// Hysteresis and dwell for analog triggers and sensor schedules
+//
+// A reading that sits on a threshold used to satisfy the condition on one
+// sample and miss it on the next, and the action ran on every evaluation in
+// between. Each trigger now runs in two stages:
+//
+//   level   the comparator. It turns on at the threshold and only turns off
+//           once the value is back past it by the hysteresis band
+//           (Above: on > T, off <= T - H; Below: on < T, off >= T + H;
+//           Equal: on within the tolerance, off outside tolerance + H).
+//   active  level after the dwell times. It must have been inactive for
+//           minOffSec before it can turn on, and active for minOnSec before it
+//           can turn off.
+//
+// Callers act only on changes of active, so a held condition does nothing.
+
+#include "../FunctionPrototypes.h"
+
+bool thresholdLevel(bool wasOn, float value, float threshold, uint8_t condition,
+                    float tolerance, float hysteresis) {
+    switch (condition) {
+    case 0: // Above
+        return wasOn ? value > threshold - hysteresis : value > threshold;
+    case 1: // Below
+        return wasOn ? value < threshold + hysteresis : value < threshold;
+    case 2: // Equal (with tolerance)
+        return fabsf(value - threshold) < (wasOn ? tolerance + hysteresis : tolerance);
+    default:
+        return false;
+    }
+}
+
+// Returns true when active changed
+bool updateThresholdState(ThresholdState& st, bool condition, uint16_t minOnSec, uint16_t minOffSec) {
+    if (condition == st.active) return false;
+
+    const uint32_t now = millis();
+    const uint32_t dwellMs = (uint32_t)(st.active ? minOnSec : minOffSec) * 1000UL;
+    if (st.changedMs != 0 && now - st.changedMs < dwellMs) return false;
+
+    st.active = condition;
+    st.changedMs = now ? now : 1;
+    metrics.triggerEdges++;
+    return true;
+}
@@ -0,0 +1,263 @@
+// EventStream.cpp
+// Server-Sent Events on the HTTP port: GET /api/events
+//
+// A read-only alternative to the WebSocket server for kiosks and Node-RED.
+// Changes announced through broadcastUpdate() are diffed against the last
+// published state and sent as small typed events:
+//
+//   id: 1234
+//   event: output
+//   data: {"id":3,"state":true}
+//
+// Event types: output, input, analog, sensor, schedule. The last
+// SSE_REPLAY_EVENTS events are kept so a client reconnecting with
+// Last-Event-ID only receives what it missed. When its id has already left
+// the buffer (or belongs to a previous boot) it gets a "resync" event and
+// should re-read /api/status.
+
+#include "../FunctionPrototypes.h"
+#include <esp_system.h>
+
+enum SseEventType : uint8_t {
+    SSE_OUTPUT = 0,
+    SSE_INPUT,
+    SSE_ANALOG,
+    SSE_SENSOR,
+    SSE_SCHEDULE,
+};
+
+static const char* const sseEventNames[] = { "output", "input", "analog", "sensor", "schedule" };
+
+struct SseEvent {
+    uint32_t id;
+    uint8_t type;
+    char data[SSE_EVENT_DATA_LEN];
+};
+
+static SseEvent sseRing[SSE_REPLAY_EVENTS];
+static uint8_t sseHead = 0;             // next slot to write
+static uint8_t sseCount = 0;
+static uint32_t sseLastId = 0;          // random base per boot, see initEventFeed()
+
+static int sseStreams[HTTP_MAX_STREAMS];
+static uint32_t sseLastWriteMs = 0;
+
+// Last published state, for turning broadcastUpdate() calls into change events
+static bool feedPrimed = false;
+static bool lastOutputs[16];
+static bool lastInputs[16];
+static bool lastDirect[3];
+static int lastAnalogPct[4];
+static float lastTemperature[3];
+static float lastHumidity[3];
+
+static void initEventFeed() {
+    static bool initialized = false;
+    if (initialized) return;
+    initialized = true;
+
+    // Ids from a previous boot then almost never fall inside the replay window
+    sseLastId = esp_random() & 0x3FFFFFFF;
+    for (auto& s : sseStreams) s = -1;
+}
+
+// ---- Output ----
+
+static size_t formatEvent(const SseEvent& e, char* buf, size_t size) {
+    int n = snprintf(buf, size, "id: %lu\nevent: %s\ndata: %s\n\n",
+                     (unsigned long)e.id, sseEventNames[e.type], e.data);
+    return (n > 0) ? min((size_t)n, size - 1) : 0;
+}
+
+static void writeToStreams(const char* text, size_t len) {
+    for (auto& s : sseStreams) {
+        if (s < 0) continue;
+        if (!server.streamWrite(s, text, len)) s = -1;     // client gone or too slow
+    }
+    sseLastWriteMs = millis();
+}
+
+static void publishEvent(SseEventType type, JsonDocument& doc) {
+    initEventFeed();
+
+    SseEvent& e = sseRing[sseHead];
+    e.id = ++sseLastId;
+    e.type = type;
+    serializeJson(doc, e.data, sizeof(e.data));
+
+    sseHead = (sseHead + 1) % SSE_REPLAY_EVENTS;
+    if (sseCount < SSE_REPLAY_EVENTS) sseCount++;
+
+    char text[SSE_EVENT_DATA_LEN + 48];
+    writeToStreams(text, formatEvent(e, text, sizeof(text)));
+}
+
+// ---- Change feed ----
+
+static bool sensorChanged(float a, float b) {
+    if (isnan(a) || isnan(b)) return isnan(a) != isnan(b);
+    return fabsf(a - b) >= SSE_SENSOR_DEADBAND;
+}
+
+void publishStateEvents(uint8_t topics) {
+    // Prime on the first call so a new feed does not report every input as changed
+    if (!feedPrimed) {
+        feedPrimed = true;
+        for (int i = 0; i < 16; i++) {
+            lastOutputs[i] = outputStates[i];
+            lastInputs[i] = inputStates[i];
+        }
+        for (int i = 0; i < 3; i++) {
+            lastDirect[i] = directInputStates[i];
+            lastTemperature[i] = htSensorConfig[i].temperature;
+            lastHumidity[i] = htSensorConfig[i].humidity;
+        }
+        for (int i = 0; i < 4; i++) {
+            lastAnalogPct[i] = calculatePercentage(analogVoltages[i]);
+        }
+        return;
+    }
+
+    StaticJsonDocument<128> doc;
+
+    if (topics & WS_TOPIC_OUTPUTS) {
+        for (int i = 0; i < 16; i++) {
+            if (outputStates[i] == lastOutputs[i]) continue;
+            lastOutputs[i] = outputStates[i];
+            doc.clear();
+            doc["id"] = i;
+            doc["state"] = outputStates[i];
+            publishEvent(SSE_OUTPUT, doc);
+        }
+    }
+
+    if (topics & WS_TOPIC_INPUTS) {
+        for (int i = 0; i < 16; i++) {
+            if (inputStates[i] == lastInputs[i]) continue;
+            lastInputs[i] = inputStates[i];
+            doc.clear();
+            doc["id"] = i;
+            doc["state"] = inputStates[i];
+            publishEvent(SSE_INPUT, doc);
+        }
+        for (int i = 0; i < 3; i++) {
+            if (directInputStates[i] == lastDirect[i]) continue;
+            lastDirect[i] = directInputStates[i];
+            doc.clear();
+            doc["id"] = "HT" + String(i + 1);
+            doc["state"] = directInputStates[i];
+            publishEvent(SSE_INPUT, doc);
+        }
+    }
+
+    if (topics & WS_TOPIC_ANALOG) {
+        for (int i = 0; i < 4; i++) {
+            // Whole percent steps keep ADC noise out of the feed
+            const int pct = calculatePercentage(analogVoltages[i]);
+            if (pct == lastAnalogPct[i]) continue;
+            lastAnalogPct[i] = pct;
+            doc.clear();
+            doc["id"] = i;
+            doc["value"] = analogValues[i];
+            doc["voltage"] = analogVoltages[i];
+            doc["percentage"] = pct;
+            publishEvent(SSE_ANALOG, doc);
+        }
+    }
+
+    if (topics & WS_TOPIC_SENSORS) {
+        for (int i = 0; i < 3; i++) {
+            const HTSensorConfig& cfg = htSensorConfig[i];
+            if (cfg.sensorType == SENSOR_TYPE_DIGITAL) continue;
+            if (!sensorChanged(cfg.temperature, lastTemperature[i]) &&
+                !sensorChanged(cfg.humidity, lastHumidity[i])) continue;
+            lastTemperature[i] = cfg.temperature;
+            lastHumidity[i] = cfg.humidity;
+            doc.clear();
+            doc["index"] = i;
+            doc["temperature"] = cfg.temperature;
+            if (cfg.sensorType != SENSOR_TYPE_DS18B20) doc["humidity"] = cfg.humidity;
+            publishEvent(SSE_SENSOR, doc);
+        }
+    }
+}
+
+void publishScheduleEvent(int scheduleIndex) {
+    if (scheduleIndex < 0 || scheduleIndex >= MAX_SCHEDULES) return;
+    const TimeSchedule& s = schedules[scheduleIndex];
+
+    StaticJsonDocument<128> doc;
+    doc["id"] = scheduleIndex;
+    doc["name"] = s.name;
+    doc["action"] = s.action;
+    doc["targetType"] = s.targetType;
+    doc["targetId"] = s.targetId;
+    publishEvent(SSE_SCHEDULE, doc);
+}
+
+// ---- Clients ----
+
+void handleEventStream() {
+    initEventFeed();
+
+    // Forget streams whose clients left since the last event (a zero-length write only checks)
+    int slot = -1;
+    for (int i = 0; i < HTTP_MAX_STREAMS; i++) {
+        if (sseStreams[i] >= 0 && !server.streamWrite(sseStreams[i], "", 0)) sseStreams[i] = -1;
+        if (sseStreams[i] < 0 && slot < 0) slot = i;
+    }
+
+    server.sendHeader("Cache-Control", "no-cache");
+    server.sendHeader("X-Accel-Buffering", "no");
+    const int id = (slot >= 0) ? server.beginStream("text/event-stream") : -1;
+    if (id < 0) {
+        server.send(503, "text/plain", "Too many event streams");
+        return;
+    }
+    sseStreams[slot] = id;
+
+    // EventSource sends Last-Event-ID on reconnect; ?lastEventId= covers polyfills
+    String resume = server.header("Last-Event-ID");
+    if (resume.length() == 0) resume = server.arg("lastEventId");
+
+    char text[SSE_EVENT_DATA_LEN + 48];
+    int n = snprintf(text, sizeof(text), "retry: %d\n\n", SSE_RETRY_MS);
+    server.streamWrite(id, text, n);
+
+    if (resume.length() > 0) {
+        const uint32_t last = strtoul(resume.c_str(), nullptr, 10);
+        const uint32_t missed = sseLastId - last;     // huge when the id is from another boot
+
+        if (missed == 0) {
+            // Up to date
+        }
+        else if (missed <= sseCount) {
+            for (uint8_t k = sseCount - missed; k < sseCount; k++) {
+                const SseEvent& e = sseRing[(sseHead + SSE_REPLAY_EVENTS - sseCount + k) % SSE_REPLAY_EVENTS];
+                if (!server.streamWrite(id, text, formatEvent(e, text, sizeof(text)))) {
+                    sseStreams[slot] = -1;
+                    return;
+                }
+            }
+        }
+        else {
+            n = snprintf(text, sizeof(text), "id: %lu\nevent: resync\ndata: {}\n\n", (unsigned long)sseLastId);
+            server.streamWrite(id, text, n);
+        }
+    }
+
+    debugPrintln("SSE client connected" + (resume.length() ? " (resume from " + resume + ")" : String("")));
+}
+
+// Keep-alive comments let proxies and clients notice a dead connection
+void serviceEventStream() {
+    initEventFeed();
+    if ((uint32_t)(millis() - sseLastWriteMs) < SSE_KEEPALIVE_MS) return;
+
+    bool any = false;
+    for (int s : sseStreams) {
+        if (s >= 0) any = true;
+    }
+    if (any) writeToStreams(": ping\n\n", 8);
+    else sseLastWriteMs = millis();
+}
@@ -0,0 +1,1368 @@
+// HttpServer.cpp
+// Event-driven HTTP/1.1 server (see HttpServer.h)
+
+#include "HttpServer.h"
+#include <lwip/sockets.h>
+
+// ---- Helpers ----
+
+static int findBytes(const char* hay, size_t hayLen, const char* needle, size_t needleLen) {
+    if (needleLen == 0 || hayLen < needleLen) return -1;
+    for (size_t i = 0; i + needleLen <= hayLen; i++) {
+        if (hay[i] == needle[0] && memcmp(hay + i, needle, needleLen) == 0) return (int)i;
+    }
+    return -1;
+}
+
+static String makeString(const char* p, size_t len) {
+    String s;
+    s.concat(p, len);
+    return s;
+}
+
+static String trimmed(const char* p, size_t len) {
+    while (len > 0 && (*p == ' ' || *p == '\t')) { p++; len--; }
+    while (len > 0 && (p[len - 1] == ' ' || p[len - 1] == '\t' || p[len - 1] == '\r')) len--;
+    return makeString(p, len);
+}
+
+static int hexValue(char ch) {
+    if (ch >= '0' && ch <= '9') return ch - '0';
+    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+    return -1;
+}
+
+static String urlDecode(const char* p, size_t len) {
+    String out;
+    out.reserve(len);
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] == '+') {
+            out += ' ';
+        }
+        else if (p[i] == '%' && i + 2 < len && hexValue(p[i + 1]) >= 0 && hexValue(p[i + 2]) >= 0) {
+            out += (char)((hexValue(p[i + 1]) << 4) | hexValue(p[i + 2]));
+            i += 2;
+        }
+        else {
+            out += p[i];
+        }
+    }
+    return out;
+}
+
+static const char* statusText(int code) {
+    switch (code) {
+    case 100: return "Continue";
+    case 200: return "OK";
+    case 201: return "Created";
+    case 204: return "No Content";
+    case 301: return "Moved Permanently";
+    case 302: return "Found";
+    case 304: return "Not Modified";
+    case 400: return "Bad Request";
+    case 401: return "Unauthorized";
+    case 403: return "Forbidden";
+    case 404: return "Not Found";
+    case 405: return "Method Not Allowed";
+    case 408: return "Request Timeout";
+    case 409: return "Conflict";
+    case 411: return "Length Required";
+    case 413: return "Payload Too Large";
+    case 429: return "Too Many Requests";
+    case 431: return "Request Header Fields Too Large";
+    case 500: return "Internal Server Error";
+    case 501: return "Not Implemented";
+    case 503: return "Service Unavailable";
+    default:  return "";
+    }
+}
+
+static bool parseMethod(const char* p, size_t len, HTTPMethod& out) {
+    static const struct { const char* name; HTTPMethod method; } methods[] = {
+        { "GET", HTTP_GET }, { "POST", HTTP_POST }, { "PUT", HTTP_PUT },
+        { "DELETE", HTTP_DELETE }, { "PATCH", HTTP_PATCH }, { "HEAD", HTTP_HEAD },
+        { "OPTIONS", HTTP_OPTIONS },
+    };
+    for (const auto& m : methods) {
+        if (strlen(m.name) == len && memcmp(m.name, p, len) == 0) {
+            out = m.method;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void consume(char* buf, size_t& len, size_t n) {
+    if (n >= len) { len = 0; return; }
+    memmove(buf, buf + n, len - n);
+    len -= n;
+}
+
+static bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+// ---- Lifecycle ----
+
+HttpServer::HttpServer(int port)
+    : _port(port),
+      _listenFd(-1),
+      _task(nullptr),
+      _lock(nullptr),
+      _notFound(nullptr),
+      _collectedCount(0),
+      _current(nullptr),
+      _arenaUsed(0),
+      _requests(0) {
+    for (auto& c : _conns) {
+        c.body = nullptr;
+        c.chunk = nullptr;
+        c.outHead = nullptr;
+        c.generation = 0;
+        resetConn(c);
+    }
+}
+
+void HttpServer::begin() {
+    if (_listenFd >= 0) return;
+
+    if (!_lock) _lock = xSemaphoreCreateMutex();
+
+    _listenFd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (_listenFd < 0) {
+        Serial.printf("[HTTP] socket() failed: %d\n", errno);
+        return;
+    }
+
+    int one = 1;
+    setsockopt(_listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)_port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (bind(_listenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        listen(_listenFd, HTTP_MAX_CONNECTIONS) < 0) {
+        Serial.printf("[HTTP] bind/listen on port %d failed: %d\n", _port, errno);
+        ::close(_listenFd);
+        _listenFd = -1;
+        return;
+    }
+    fcntl(_listenFd, F_SETFL, fcntl(_listenFd, F_GETFL, 0) | O_NONBLOCK);
+
+    if (!_task) {
+        xTaskCreatePinnedToCore(taskEntry, "http", HTTP_TASK_STACK, this,
+                                HTTP_TASK_PRIORITY, &_task, HTTP_TASK_CORE);
+    }
+
+    Serial.printf("[HTTP] Listening on port %d (%d connections)\n", _port, HTTP_MAX_CONNECTIONS);
+}
+
+// From the main loop, not from a handler. The task stays up and idles.
+void HttpServer::stop() {
+    lock();
+    if (_listenFd >= 0) {
+        ::close(_listenFd);
+        _listenFd = -1;
+    }
+    for (auto& c : _conns) {
+        if (c.fd >= 0) closeConn(c);
+    }
+    unlock();
+}
+
+void HttpServer::lock() {
+    if (_lock) xSemaphoreTake(_lock, portMAX_DELAY);
+}
+
+void HttpServer::unlock() {
+    if (_lock) xSemaphoreGive(_lock);
+}
+
+// ---- Routing ----
+
+void HttpServer::on(const String& uri, THandlerFunction fn) {
+    on(uri, HTTP_ANY, fn, nullptr);
+}
+
+void HttpServer::on(const String& uri, HTTPMethod method, THandlerFunction fn) {
+    on(uri, method, fn, nullptr);
+}
+
+void HttpServer::on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn) {
+    lock();
+    _routes.push_back({ uri, method, fn, ufn });
+    unlock();
+}
+
+void HttpServer::onNotFound(THandlerFunction fn) {
+    _notFound = fn;
+}
+
+void HttpServer::collectHeaders(const char* headerKeys[], const size_t headerKeysCount) {
+    _collectedCount = 0;
+    for (size_t i = 0; i < headerKeysCount && _collectedCount < HTTP_MAX_COLLECTED_HEADERS; i++) {
+        _collected[_collectedCount++] = headerKeys[i];
+    }
+}
+
+// ---- Connection bookkeeping ----
+
+void HttpServer::freeBody(Conn& c) {
+    if (c.body) {
+        free(c.body);
+        c.body = nullptr;
+        _arenaUsed -= c.contentLength;
+    }
+}
+
+void HttpServer::resetRequest(Conn& c) {
+    freeBody(c);
+    if (c.chunk) {
+        free(c.chunk);
+        c.chunk = nullptr;
+    }
+
+    c.requestStartMs = 0;
+    c.method = HTTP_GET;
+    c.uri = String();
+    c.host = String();
+    c.contentType = String();
+    c.http10 = false;
+    c.keepAlive = true;
+    c.expectContinue = false;
+    c.route = -1;
+    for (uint8_t i = 0; i < c.argCount; i++) {
+        c.argNames[i] = String();
+        c.argValues[i] = String();
+    }
+    c.argCount = 0;
+    for (auto& v : c.headerValues) v = String();
+
+    c.contentLength = 0;
+    c.bodyReceived = 0;
+
+    c.multipart = false;
+    c.mpState = MP_PREAMBLE;
+    c.boundary = String();
+    c.mpFile = false;
+    c.uploadOpen = false;
+    c.mpField = String();
+    c.mpValue = String();
+
+    freeOut(c);
+    c.file = File();
+    c.chunkLen = 0;
+    c.chunkSent = 0;
+    c.headersSent = false;
+    c.chunked = false;
+    c.closeAfter = false;
+    c.broken = false;
+    c.draining = false;
+    c.lengthSet = false;
+    c.streaming = false;
+    c.responseLength = 0;
+    c.extraHeaders = String();
+    c.pump = nullptr;
+}
+
+void HttpServer::resetConn(Conn& c) {
+    c.fd = -1;
+    c.state = CONN_FREE;
+    c.lastActivityMs = 0;
+    c.in = nullptr;
+    c.inLen = 0;
+    c.upload = nullptr;
+    c.closing = false;
+    c.argCount = HTTP_MAX_ARGS;     // clear every slot once
+    resetRequest(c);
+}
+
+void HttpServer::releaseConn(Conn& c) {
+    free(c.in);
+    delete c.upload;
+    resetConn(c);
+}
+
+void HttpServer::closeConn(Conn& c) {
+    if (c.fd >= 0) {
+        ::close(c.fd);
+        c.fd = -1;
+    }
+    if (c.file) c.file.close();
+    c.file = File();
+    if (c.chunk) {
+        free(c.chunk);
+        c.chunk = nullptr;
+    }
+    freeBody(c);
+    freeOut(c);
+
+    // Let the upload handler clean up (close its file) before the slot is reused
+    if (c.uploadOpen && c.upload && c.route >= 0 && _routes[c.route].ufn) {
+        c.uploadOpen = false;
+        c.upload->status = UPLOAD_FILE_ABORTED;
+        c.upload->currentSize = 0;
+        c.closing = true;
+        c.state = CONN_UPLOAD_WAIT;
+        return;
+    }
+
+    // A pump may hold a writer bound to this server; only the loop destroys it
+    if (c.pump) {
+        c.closing = true;
+        return;
+    }
+
+    releaseConn(c);
+}
+
+void HttpServer::acceptClient() {
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    int fd = accept(_listenFd, (struct sockaddr*)&addr, &len);
+    if (fd < 0) return;
+
+    Conn* slot = nullptr;
+    for (auto& c : _conns) {
+        if (c.state == CONN_FREE) { slot = &c; break; }
+    }
+    if (!slot) {
+        ::close(fd);
+        return;
+    }
+
+    slot->in = (char*)malloc(HTTP_MAX_HEADER_BYTES + 1);
+    if (!slot->in) {
+        ::close(fd);
+        return;
+    }
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    slot->fd = fd;
+    slot->generation++;
+    slot->inLen = 0;
+    slot->state = CONN_READ_HEADERS;
+    slot->lastActivityMs = millis();
+}
+
+uint8_t HttpServer::activeConnections() const {
+    uint8_t n = 0;
+    for (const auto& c : _conns) {
+        if (c.state != CONN_FREE) n++;
+    }
+    return n;
+}
+
+// ---- Socket task ----
+
+void HttpServer::taskEntry(void* arg) {
+    static_cast<HttpServer*>(arg)->taskLoop();
+}
+
+void HttpServer::taskLoop() {
+    for (;;) {
+        fd_set rfds;
+        fd_set wfds;
+        FD_ZERO(&rfds);
+        FD_ZERO(&wfds);
+        int maxFd = -1;
+
+        lock();
+        const uint32_t now = millis();
+        bool hasFree = false;
+        for (auto& c : _conns) {
+            if (c.state == CONN_FREE) { hasFree = true; continue; }
+            if (c.fd < 0) continue;
+
+            const uint32_t idle = now - c.lastActivityMs;
+            const bool idleKeepAlive = (c.state == CONN_READ_HEADERS && c.inLen == 0);
+            const bool streamBacklog = (c.state == CONN_STREAMING && c.outPending > 0);
+            const bool handlerBacklog = (c.state == CONN_DISPATCHING && c.draining && c.outPending > 0);
+            const bool pumpWait = (c.state == CONN_RESPONDING && c.pump && c.outPending == 0);
+            const bool ioState = (c.state == CONN_READ_HEADERS || c.state == CONN_READ_BODY ||
+                                  c.state == CONN_RESPONDING || streamBacklog);
+            if ((idleKeepAlive && idle > HTTP_KEEPALIVE_MS) || (ioState && idle > HTTP_REQUEST_TIMEOUT_MS)) {
+                closeConn(c);
+                continue;
+            }
+
+            if (c.state == CONN_READ_HEADERS || c.state == CONN_READ_BODY) {
+                FD_SET(c.fd, &rfds);
+                if (c.fd > maxFd) maxFd = c.fd;
+            }
+            else if (c.state == CONN_RESPONDING && !pumpWait) {
+                FD_SET(c.fd, &wfds);
+                if (c.fd > maxFd) maxFd = c.fd;
+            }
+            else if (c.state == CONN_STREAMING) {
+                // Readable only matters for noticing the client hang up
+                FD_SET(c.fd, &rfds);
+                if (streamBacklog) FD_SET(c.fd, &wfds);
+                if (c.fd > maxFd) maxFd = c.fd;
+            }
+            else if (handlerBacklog) {
+                FD_SET(c.fd, &wfds);
+                if (c.fd > maxFd) maxFd = c.fd;
+            }
+        }
+        // Full: leave new connections in the listen backlog
+        if (hasFree && _listenFd >= 0) {
+            FD_SET(_listenFd, &rfds);
+            if (_listenFd > maxFd) maxFd = _listenFd;
+        }
+        unlock();
+
+        if (maxFd < 0) {
+            vTaskDelay(pdMS_TO_TICKS(20));
+            continue;
+        }
+
+        struct timeval tv = { 0, 20000 };
+        const int n = select(maxFd + 1, &rfds, &wfds, nullptr, &tv);
+        if (n < 0) {
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        if (n == 0) continue;
+
+        lock();
+        if (_listenFd >= 0 && FD_ISSET(_listenFd, &rfds)) acceptClient();
+        for (auto& c : _conns) {
+            if (c.fd < 0) continue;
+            if (FD_ISSET(c.fd, &rfds) && (c.state == CONN_READ_HEADERS || c.state == CONN_READ_BODY)) {
+                readConn(c);
+            }
+            else if (FD_ISSET(c.fd, &wfds) && c.state == CONN_RESPONDING) {
+                writeConn(c);
+            }
+            else if (c.state == CONN_STREAMING) {
+                if (FD_ISSET(c.fd, &rfds)) readStream(c);
+                if (c.fd >= 0 && c.state == CONN_STREAMING && FD_ISSET(c.fd, &wfds)) writeConn(c);
+            }
+            else if (FD_ISSET(c.fd, &wfds) && c.state == CONN_DISPATCHING && c.draining) {
+                sendPending(c);     // the loop still owns the connection; it closes it if broken
+            }
+        }
+        unlock();
+    }
+}
+
+// ---- Request input ----
+
+void HttpServer::readConn(Conn& c) {
+    if (c.state == CONN_READ_BODY && !c.multipart) {
+        const int n = recv(c.fd, c.body + c.bodyReceived, c.contentLength - c.bodyReceived, 0);
+        if (n == 0 || (n < 0 && !wouldBlock())) { closeConn(c); return; }
+        if (n < 0) return;
+
+        c.bodyReceived += n;
+        c.lastActivityMs = millis();
+        if (c.bodyReceived >= c.contentLength) finishBody(c);
+        return;
+    }
+
+    size_t room = HTTP_MAX_HEADER_BYTES - c.inLen;
+    if (c.state == CONN_READ_BODY) {
+        room = min(room, c.contentLength - c.bodyReceived);
+        if (room == 0) {
+            // Buffer full and the multipart parser cannot make progress
+            sendError(c, 400, "Malformed multipart body");
+            return;
+        }
+    }
+    else if (room == 0) {
+        sendError(c, 431, "Request header too large");
+        return;
+    }
+
+    const int n = recv(c.fd, c.in + c.inLen, room, 0);
+    if (n == 0 || (n < 0 && !wouldBlock())) { closeConn(c); return; }
+    if (n < 0) return;
+
+    c.inLen += n;
+    if (c.state == CONN_READ_BODY) c.bodyReceived += n;
+    c.lastActivityMs = millis();
+    processInput(c);
+}
+
+void HttpServer::processInput(Conn& c) {
+    if (c.state == CONN_READ_BODY && c.multipart) {
+        parseMultipart(c);
+        return;
+    }
+    if (c.state != CONN_READ_HEADERS) return;
+
+    const int end = findBytes(c.in, c.inLen, "\r\n\r\n", 4);
+    if (end < 0) {
+        if (c.inLen >= HTTP_MAX_HEADER_BYTES) sendError(c, 431, "Request header too large");
+        return;
+    }
+
+    const size_t headerLen = (size_t)end + 4;
+    const int err = parseHeaders(c, headerLen);
+    consume(c.in, c.inLen, headerLen);
+    if (err) {
+        sendError(c, err, statusText(err));
+        return;
+    }
+
+    startBody(c);
+}
+
+int HttpServer::parseHeaders(Conn& c, size_t headerLen) {
+    c.requestStartMs = millis();
+
+    const char* line = c.in;
+    const char* limit = c.in + headerLen;
+    bool requestLine = true;
+    bool connClose = false;
+    bool connKeepAlive = false;
+
+    while (line < limit) {
+        const char* eol = (const char*)memchr(line, '\n', limit - line);
+        if (!eol) break;
+        size_t len = eol - line;
+        if (len > 0 && line[len - 1] == '\r') len--;
+        const char* next = eol + 1;
+
+        if (len == 0) break;
+
+        if (requestLine) {
+            requestLine = false;
+            const char* sp1 = (const char*)memchr(line, ' ', len);
+            if (!sp1) return 400;
+            const char* sp2 = (const char*)memchr(sp1 + 1, ' ', line + len - (sp1 + 1));
+            if (!sp2) return 400;
+
+            if (!parseMethod(line, sp1 - line, c.method)) return 501;
+
+            const char* target = sp1 + 1;
+            const size_t targetLen = sp2 - target;
+            const char* q = (const char*)memchr(target, '?', targetLen);
+            if (q) {
+                c.uri = makeString(target, q - target);
+                parseArgs(c, q + 1, target + targetLen - (q + 1));
+            }
+            else {
+                c.uri = makeString(target, targetLen);
+            }
+
+            c.http10 = (line + len - (sp2 + 1) == 8) && memcmp(sp2 + 1, "HTTP/1.0", 8) == 0;
+        }
+        else {
+            const char* colon = (const char*)memchr(line, ':', len);
+            if (colon) {
+                const String name = trimmed(line, colon - line);
+                const String value = trimmed(colon + 1, line + len - (colon + 1));
+
+                if (name.equalsIgnoreCase("Host")) {
+                    c.host = value;
+                }
+                else if (name.equalsIgnoreCase("Content-Type")) {
+                    c.contentType = value;
+                }
+                else if (name.equalsIgnoreCase("Content-Length")) {
+                    char* endp = nullptr;
+                    const unsigned long v = strtoul(value.c_str(), &endp, 10);
+                    if (value.length() == 0 || (endp && *endp)) return 400;
+                    c.contentLength = v;
+                }
+                else if (name.equalsIgnoreCase("Connection")) {
+                    String v = value;
+                    v.toLowerCase();
+                    connClose = v.indexOf("close") >= 0;
+                    connKeepAlive = v.indexOf("keep-alive") >= 0;
+                }
+                else if (name.equalsIgnoreCase("Expect")) {
+                    c.expectContinue = value.equalsIgnoreCase("100-continue");
+                }
+                else if (name.equalsIgnoreCase("Transfer-Encoding")) {
+                    // Chunked request bodies are not accepted; every client used here sends a length
+                    if (!value.equalsIgnoreCase("identity")) return 411;
+                }
+
+                for (uint8_t i = 0; i < _collectedCount; i++) {
+                    if (name.equalsIgnoreCase(_collected[i])) c.headerValues[i] = value;
+                }
+            }
+        }
+        line = next;
+    }
+
+    if (requestLine) return 400;
+
+    c.keepAlive = c.http10 ? connKeepAlive : !connClose;
+
+    c.route = -1;
+    for (size_t i = 0; i < _routes.size(); i++) {
+        const Route& r = _routes[i];
+        if (r.uri == c.uri && (r.method == HTTP_ANY || r.method == c.method)) {
+            c.route = (int)i;
+            break;
+        }
+    }
+    return 0;
+}
+
+void HttpServer::startBody(Conn& c) {
+    if (c.contentLength == 0) {
+        c.state = CONN_READY;
+        return;
+    }
+
+    if (c.contentType.startsWith("multipart/form-data")) {
+        const int b = c.contentType.indexOf("boundary=");
+        if (b < 0) {
+            sendError(c, 400, "Missing multipart boundary");
+            return;
+        }
+        c.boundary = c.contentType.substring(b + 9);
+        if (c.boundary.startsWith("\"") && c.boundary.endsWith("\"") && c.boundary.length() >= 2) {
+            c.boundary = c.boundary.substring(1, c.boundary.length() - 1);
+        }
+
+        // Streamed straight to the upload handler; does not draw on the arena
+        c.multipart = true;
+        c.mpState = MP_PREAMBLE;
+        if (c.inLen > c.contentLength) c.inLen = c.contentLength;
+        c.bodyReceived = c.inLen;
+        c.state = CONN_READ_BODY;
+    }
+    else {
+        if (c.contentLength > HTTP_MAX_BODY_BYTES) {
+            sendError(c, 413, "Request body too large");
+            return;
+        }
+        if (_arenaUsed + c.contentLength > HTTP_BODY_ARENA_BYTES) {
+            sendError(c, 503, "Server busy");
+            return;
+        }
+        c.body = (char*)malloc(c.contentLength + 1);
+        if (!c.body) {
+            sendError(c, 503, "Out of memory");
+            return;
+        }
+        _arenaUsed += c.contentLength;
+
+        // Bytes beyond the body stay in the input buffer (pipelined request)
+        const size_t take = min(c.inLen, c.contentLength);
+        memcpy(c.body, c.in, take);
+        consume(c.in, c.inLen, take);
+        c.bodyReceived = take;
+        c.state = CONN_READ_BODY;
+    }
+
+    if (c.expectContinue && c.bodyReceived < c.contentLength) {
+        static const char cont[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        ::send(c.fd, cont, sizeof(cont) - 1, 0);
+    }
+
+    if (c.multipart) {
+        parseMultipart(c);
+    }
+    else if (c.bodyReceived >= c.contentLength) {
+        finishBody(c);
+    }
+}
+
+void HttpServer::finishBody(Conn& c) {
+    c.body[c.contentLength] = '\0';
+    if (c.contentType.startsWith("application/x-www-form-urlencoded")) {
+        parseArgs(c, c.body, c.contentLength);
+    }
+    else {
+        addArg(c, "plain", String(c.body));
+    }
+    c.state = CONN_READY;
+}
+
+void HttpServer::parseArgs(Conn& c, const char* query, size_t len) {
+    const char* p = query;
+    const char* end = query + len;
+    while (p < end) {
+        const char* amp = (const char*)memchr(p, '&', end - p);
+        const char* stop = amp ? amp : end;
+        const char* eq = (const char*)memchr(p, '=', stop - p);
+        if (stop > p) {
+            if (eq) addArg(c, urlDecode(p, eq - p), urlDecode(eq + 1, stop - (eq + 1)));
+            else addArg(c, urlDecode(p, stop - p), String());
+        }
+        p = stop + 1;
+    }
+}
+
+void HttpServer::addArg(Conn& c, const String& name, const String& value) {
+    if (c.argCount >= HTTP_MAX_ARGS) return;
+    c.argNames[c.argCount] = name;
+    c.argValues[c.argCount] = value;
+    c.argCount++;
+}
+
+bool HttpServer::emitUpload(Conn& c, HTTPUploadStatus status) {
+    if (c.route < 0 || !_routes[c.route].ufn) return false;
+    c.upload->status = status;
+    c.state = CONN_UPLOAD_WAIT;
+    return true;
+}
+
+void HttpServer::parseMultipart(Conn& c) {
+    const String dash = "--" + c.boundary;
+    const String delim = "\r\n--" + c.boundary;
+
+    for (;;) {
+        if (c.mpState == MP_PREAMBLE) {
+            const int p = findBytes(c.in, c.inLen, dash.c_str(), dash.length());
+            if (p < 0) {
+                // Keep only what could be the start of a split boundary
+                if (c.inLen > dash.length()) consume(c.in, c.inLen, c.inLen - dash.length());
+                break;
+            }
+            if (c.inLen < (size_t)p + dash.length() + 2) break;
+
+            const char* tail = c.in + p + dash.length();
+            const bool last = (tail[0] == '-' && tail[1] == '-');
+            consume(c.in, c.inLen, p + dash.length() + 2);
+            c.mpState = last ? MP_EPILOGUE : MP_HEADERS;
+            continue;
+        }
+
+        if (c.mpState == MP_HEADERS) {
+            const int end = findBytes(c.in, c.inLen, "\r\n\r\n", 4);
+            if (end < 0) {
+                if (c.inLen >= HTTP_MAX_HEADER_BYTES) {
+                    sendError(c, 400, "Multipart header too large");
+                    return;
+                }
+                break;
+            }
+
+            String name;
+            String filename;
+            String type;
+            bool hasFilename = false;
+
+            const char* line = c.in;
+            const char* limit = c.in + end + 2;
+            while (line < limit) {
+                const char* eol = (const char*)memchr(line, '\n', limit - line);
+                if (!eol) break;
+                const String h = trimmed(line, eol - line);
+                line = eol + 1;
+
+                const int colon = h.indexOf(':');
+                if (colon < 0) continue;
+                const String key = h.substring(0, colon);
+                const String value = h.substring(colon + 1);
+
+                if (key.equalsIgnoreCase("Content-Disposition")) {
+                    int n = value.indexOf("name=\"");
+                    // "filename=" also contains "name="; take the one not preceded by "file"
+                    while (n > 0 && value.charAt(n - 1) != ' ' && value.charAt(n - 1) != ';') {
+                        n = value.indexOf("name=\"", n + 1);
+                    }
+                    if (n >= 0) name = value.substring(n + 6, value.indexOf('"', n + 6));
+
+                    const int f = value.indexOf("filename=\"");
+                    if (f >= 0) {
+                        hasFilename = true;
+                        filename = value.substring(f + 10, value.indexOf('"', f + 10));
+                    }
+                }
+                else if (key.equalsIgnoreCase("Content-Type")) {
+                    type = value;
+                    type.trim();
+                }
+            }
+            consume(c.in, c.inLen, end + 4);
+            c.mpState = MP_DATA;
+            c.mpFile = hasFilename;
+
+            if (c.mpFile) {
+                if (!c.upload) c.upload = new HTTPUpload();
+                c.upload->filename = filename;
+                c.upload->name = name;
+                c.upload->type = type;
+                c.upload->totalSize = 0;
+                c.upload->currentSize = 0;
+                c.uploadOpen = true;
+                if (emitUpload(c, UPLOAD_FILE_START)) return;
+            }
+            else {
+                c.mpField = name;
+                c.mpValue = String();
+            }
+            continue;
+        }
+
+        if (c.mpState == MP_DATA) {
+            const int p = findBytes(c.in, c.inLen, delim.c_str(), delim.length());
+            const size_t avail = (p >= 0) ? (size_t)p
+                                          : (c.inLen > delim.length() ? c.inLen - delim.length() : 0);
+
+            if (avail > 0) {
+                if (c.mpFile) {
+                    const size_t n = min(avail, (size_t)HTTP_UPLOAD_BUFLEN);
+                    memcpy(c.upload->buf, c.in, n);
+                    c.upload->currentSize = n;
+                    c.upload->totalSize += n;
+                    consume(c.in, c.inLen, n);
+                    if (emitUpload(c, UPLOAD_FILE_WRITE)) return;
+                }
+                else {
+                    // Form fields are short; cap what is kept
+                    const size_t keep = (c.mpValue.length() < 512) ? min(avail, 512 - (size_t)c.mpValue.length()) : 0;
+                    c.mpValue.concat(c.in, keep);
+                    consume(c.in, c.inLen, avail);
+                }
+                continue;
+            }
+
+            if (p != 0 || c.inLen < delim.length() + 2) break;   // need more data
+
+            const char* tail = c.in + delim.length();
+            const bool last = (tail[0] == '-' && tail[1] == '-');
+            consume(c.in, c.inLen, delim.length() + 2);
+            c.mpState = last ? MP_EPILOGUE : MP_HEADERS;
+
+            if (c.mpFile) {
+                c.mpFile = false;
+                c.uploadOpen = false;
+                c.upload->currentSize = 0;
+                if (emitUpload(c, UPLOAD_FILE_END)) return;
+            }
+            else {
+                addArg(c, c.mpField, c.mpValue);
+            }
+            continue;
+        }
+
+        // MP_EPILOGUE
+        c.inLen = 0;
+        break;
+    }
+
+    if (c.bodyReceived >= c.contentLength) {
+        if (c.mpState == MP_EPILOGUE) {
+            c.inLen = 0;
+            c.state = CONN_READY;
+        }
+        else {
+            sendError(c, 400, "Malformed multipart body");
+        }
+    }
+}
+
+void HttpServer::sendError(Conn& c, int code, const char* message) {
+    freeBody(c);
+    const String body = String(message) + "\n";
+    const String response = "HTTP/1.1 " + String(code) + " " + statusText(code) + "\r\n" +
+                            "Content-Type: text/plain\r\n" +
+                            "Content-Length: " + String(body.length()) + "\r\n" +
+                            "Connection: close\r\n\r\n" + body;
+    freeOut(c);
+    if (!appendOut(c, response.c_str(), response.length())) {
+        closeConn(c);
+        return;
+    }
+    c.closeAfter = true;
+    c.state = CONN_RESPONDING;
+    c.lastActivityMs = millis();
+    writeConn(c);
+}
+
+// ---- Dispatch (main loop) ----
+
+void HttpServer::handleClient() {
+    for (auto& c : _conns) {
+        lock();
+
+        // Upload pieces: a few per call keeps uploads moving without starving the loop
+        for (uint8_t guard = 0; guard < 8 && c.state == CONN_UPLOAD_WAIT; guard++) {
+            c.state = CONN_DISPATCHING;
+            unlock();
+
+            _current = &c;
+            if (c.route >= 0 && _routes[c.route].ufn) _routes[c.route].ufn();
+            _current = nullptr;
+
+            lock();
+            if (c.closing) {
+                releaseConn(c);
+                break;
+            }
+            c.state = CONN_READ_BODY;
+            parseMultipart(c);
+        }
+
+        if (c.state == CONN_READY) {
+            c.state = CONN_DISPATCHING;
+            unlock();
+            dispatch(c);
+            lock();
+            finishResponse(c);
+        }
+
+        if (c.pump && (c.closing || c.state == CONN_RESPONDING)) pumpConn(c);
+
+        unlock();
+    }
+}
+
+void HttpServer::dispatch(Conn& c) {
+    _current = &c;
+
+    if (c.route >= 0) {
+        _routes[c.route].fn();
+    }
+    else if (_notFound) {
+        _notFound();
+    }
+    else {
+        send(404, "text/plain", "Not found");
+    }
+
+    if (!c.headersSent) send(500, "text/plain", "No response");
+    if (c.chunked && !c.streaming && !c.pump) {
+        lock();
+        if (!c.broken && !appendOut(c, "0\r\n\r\n", 5)) c.broken = true;
+        unlock();
+    }
+
+    _current = nullptr;
+    _requests++;
+}
+
+void HttpServer::finishResponse(Conn& c) {
+    freeBody(c);
+    if (c.broken) {
+        closeConn(c);
+        return;
+    }
+    c.state = c.streaming ? CONN_STREAMING : CONN_RESPONDING;
+    c.lastActivityMs = millis();
+    writeConn(c);   // small responses leave right away; the task drains the rest
+}
+
+// With the lock held, from handleClient(). A few pieces per call while the
+// backlog is low, as for uploads; the task sends them in between.
+void HttpServer::pumpConn(Conn& c) {
+    for (uint8_t guard = 0; guard < 8 && c.pump && c.state == CONN_RESPONDING && !c.closing &&
+                            c.outPending < HTTP_OUT_HIGH_WATER; guard++) {
+        c.state = CONN_DISPATCHING;
+        unlock();
+
+        _current = &c;
+        if (!c.pump() || c.broken) {
+            c.pump = nullptr;
+            if (c.chunked && !c.broken) {
+                lock();
+                if (!appendOut(c, "0\r\n\r\n", 5)) c.broken = true;
+                unlock();
+            }
+        }
+        _current = nullptr;
+
+        lock();
+        finishResponse(c);
+    }
+
+    // Closed under the pump: drop it here, then the slot
+    if (c.pump && c.closing) {
+        c.state = CONN_DISPATCHING;
+        unlock();
+        c.pump = nullptr;
+        lock();
+        releaseConn(c);
+    }
+}
+
+bool HttpServer::writeConn(Conn& c) {
+    for (;;) {
+        if (c.outHead) {
+            if (!sendOut(c)) {
+                closeConn(c);
+                return false;
+            }
+            if (c.outHead) return true;     // socket full
+        }
+
+        if (c.chunkSent < c.chunkLen) {
+            const int n = ::send(c.fd, c.chunk + c.chunkSent, c.chunkLen - c.chunkSent, MSG_DONTWAIT);
+            if (n < 0) {
+                if (wouldBlock()) return true;
+                closeConn(c);
+                return false;
+            }
+            c.chunkSent += n;
+            c.lastActivityMs = millis();
+            continue;
+        }
+
+        if (c.file) {
+            if (!c.chunk) c.chunk = (uint8_t*)malloc(HTTP_FILE_CHUNK);
+            if (!c.chunk) {
+                closeConn(c);
+                return false;
+            }
+            c.chunkLen = c.file.read(c.chunk, HTTP_FILE_CHUNK);
+            c.chunkSent = 0;
+            if (c.chunkLen > 0) continue;
+            c.file.close();
+            c.file = File();
+        }
+
+        // A stream stays open until the client or endStream() closes it
+        if (c.state == CONN_STREAMING) return true;
+
+        // The loop writes the next piece (pumpConn)
+        if (c.pump) return true;
+
+        // Response complete
+        if (c.closeAfter || !c.keepAlive) {
+            closeConn(c);
+            return false;
+        }
+        resetRequest(c);
+        c.state = CONN_READ_HEADERS;
+        c.lastActivityMs = millis();
+        if (c.inLen > 0) processInput(c);     // pipelined request already buffered
+        return true;
+    }
+}
+
+// Response bytes written while the handler runs: send what the socket takes
+// now, never wait. Called with the lock held from either side. False once the
+// client is gone; the loop closes the connection when the handler returns.
+bool HttpServer::sendPending(Conn& c) {
+    if (sendOut(c)) return true;
+    c.broken = true;
+    freeOut(c);
+    return false;
+}
+
+// The out queue: fixed blocks, appended at the tail and freed from the head as
+// they are sent, so queued bytes are never reallocated or moved. Whoever owns
+// the connection (the loop while dispatching, else the task) holds the lock.
+bool HttpServer::appendOut(Conn& c, const char* data, size_t len) {
+    while (len > 0) {
+        OutBlock* b = c.outTail;
+        if (!b || b->len == HTTP_OUT_BLOCK) {
+            b = (OutBlock*)malloc(sizeof(OutBlock));
+            if (!b) return false;
+            b->next = nullptr;
+            b->len = 0;
+            b->sent = 0;
+            if (c.outTail) c.outTail->next = b;
+            else c.outHead = b;
+            c.outTail = b;
+        }
+
+        const size_t take = min(len, (size_t)(HTTP_OUT_BLOCK - b->len));
+        memcpy(b->data + b->len, data, take);
+        b->len += take;
+        c.outPending += take;
+        data += take;
+        len -= take;
+    }
+    return true;
+}
+
+// Until the socket is full or the queue empty; false once the client is gone
+bool HttpServer::sendOut(Conn& c) {
+    while (c.outHead) {
+        OutBlock* b = c.outHead;
+        const int n = ::send(c.fd, b->data + b->sent, b->len - b->sent, MSG_DONTWAIT);
+        if (n < 0) return wouldBlock();
+
+        b->sent += n;
+        c.outPending -= n;
+        c.lastActivityMs = millis();
+        if (b->sent < b->len) continue;
+
+        c.outHead = b->next;
+        if (!c.outHead) c.outTail = nullptr;
+        free(b);
+    }
+    return true;
+}
+
+void HttpServer::freeOut(Conn& c) {
+    while (c.outHead) {
+        OutBlock* b = c.outHead;
+        c.outHead = b->next;
+        free(b);
+    }
+    c.outTail = nullptr;
+    c.outPending = 0;
+}
+
+// ---- Request accessors ----
+
+String HttpServer::uri() const {
+    return _current ? _current->uri : String();
+}
+
+HTTPMethod HttpServer::method() const {
+    return _current ? _current->method : HTTP_GET;
+}
+
+const uint8_t* HttpServer::rawBody(size_t& len) const {
+    len = 0;
+    if (!_current || _current->multipart || !_current->body) return nullptr;
+    len = _current->contentLength;
+    return (const uint8_t*)_current->body;
+}
+
+String HttpServer::arg(const String& name) const {
+    if (!_current) return String();
+    for (uint8_t i = 0; i < _current->argCount; i++) {
+        if (_current->argNames[i] == name) return _current->argValues[i];
+    }
+    return String();
+}
+
+String HttpServer::arg(int i) const {
+    if (!_current || i < 0 || i >= _current->argCount) return String();
+    return _current->argValues[i];
+}
+
+String HttpServer::argName(int i) const {
+    if (!_current || i < 0 || i >= _current->argCount) return String();
+    return _current->argNames[i];
+}
+
+int HttpServer::args() const {
+    return _current ? _current->argCount : 0;
+}
+
+bool HttpServer::hasArg(const String& name) const {
+    if (!_current) return false;
+    for (uint8_t i = 0; i < _current->argCount; i++) {
+        if (_current->argNames[i] == name) return true;
+    }
+    return false;
+}
+
+String HttpServer::header(const String& name) const {
+    if (!_current) return String();
+    for (uint8_t i = 0; i < _collectedCount; i++) {
+        if (name.equalsIgnoreCase(_collected[i])) return _current->headerValues[i];
+    }
+    return String();
+}
+
+bool HttpServer::hasHeader(const String& name) const {
+    return header(name).length() > 0;
+}
+
+String HttpServer::hostHeader() const {
+    return _current ? _current->host : String();
+}
+
+HTTPUpload& HttpServer::upload() {
+    static HTTPUpload empty;
+    return (_current && _current->upload) ? *_current->upload : empty;
+}
+
+// ---- Response ----
+
+void HttpServer::sendHeader(const String& name, const String& value, bool first) {
+    if (!_current) return;
+    const String line = name + ": " + value + "\r\n";
+    if (first) _current->extraHeaders = line + _current->extraHeaders;
+    else _current->extraHeaders += line;
+}
+
+void HttpServer::setContentLength(const size_t contentLength) {
+    if (!_current) return;
+    _current->responseLength = contentLength;
+    _current->lengthSet = true;
+}
+
+void HttpServer::send(int code, const String& contentType, const String& content) {
+    send(code, contentType.c_str(), content);
+}
+
+void HttpServer::send(int code, const char* contentType, const String& content) {
+    Conn* c = _current;
+    if (!c || c->headersSent) return;
+
+    const bool hasBody = !(c->method == HTTP_HEAD || code == 204 || code == 304);
+
+    String head = "HTTP/1.1 " + String(code) + " " + statusText(code) + "\r\n";
+    if (contentType && *contentType) head += "Content-Type: " + String(contentType) + "\r\n";
+    head += c->extraHeaders;
+
+    if (c->streaming) {
+        // No length and no chunking: the body runs until the connection closes
+    }
+    else if (c->lengthSet && c->responseLength == CONTENT_LENGTH_UNKNOWN) {
+        if (c->http10) {
+            c->closeAfter = true;       // body ends when the connection closes
+        }
+        else {
+            head += "Transfer-Encoding: chunked\r\n";
+            c->chunked = hasBody;
+        }
+    }
+    else if (code != 204 && code != 304) {
+        const size_t len = c->lengthSet ? c->responseLength : content.length();
+        head += "Content-Length: " + String((unsigned long)len) + "\r\n";
+    }
+
+    head += (c->closeAfter || !c->keepAlive) ? "Connection: close\r\n\r\n" : "Connection: keep-alive\r\n\r\n";
+
+    if (!appendOut(*c, head.c_str(), head.length())) c->broken = true;
+    c->headersSent = true;
+    c->extraHeaders = String();
+
+    if (hasBody && content.length() > 0) {
+        sendContent(content);
+    }
+}
+
+void HttpServer::sendContent(const String& content) {
+    sendContent(content.c_str(), content.length());
+}
+
+void HttpServer::sendContent(const char* content, size_t size) {
+    Conn* c = _current;
+    if (!c || !c->headersSent || size == 0 || c->method == HTTP_HEAD) return;
+
+    // The task may be sending this buffer (draining) or marking it broken
+    lock();
+    if (c->broken) {
+        unlock();
+        return;
+    }
+
+    bool queued;
+    if (c->chunked) {
+        char len[12];
+        const int n = snprintf(len, sizeof(len), "%X\r\n", (unsigned)size);
+        queued = appendOut(*c, len, n) && appendOut(*c, content, size) && appendOut(*c, "\r\n", 2);
+    }
+    else {
+        queued = appendOut(*c, content, size);
+    }
+
+    // Large responses: the task sends while the handler keeps writing, so the
+    // loop never waits on the client. A fixed-length body was sized by the
+    // handler and may all be held; a chunked one that falls too far behind is
+    // dropped (long ones are pumped and never get there).
+    size_t limit = HTTP_OUT_MAX_BUFFERED;
+    if (c->lengthSet && c->responseLength != CONTENT_LENGTH_UNKNOWN) {
+        limit = max(limit, c->responseLength + HTTP_MAX_HEADER_BYTES);
+    }
+    if (!queued || c->outPending > limit) {
+        c->broken = true;
+        freeOut(*c);
+    }
+    else if (c->outPending > HTTP_OUT_HIGH_WATER) {
+        c->draining = true;
+        sendPending(*c);
+    }
+    unlock();
+}
+
+size_t HttpServer::streamFile(File& file, const String& contentType, const int code) {
+    Conn* c = _current;
+    if (!c || !file) return 0;
+
+    const size_t size = file.size();
+    setContentLength(size);
+
+    const String name = file.name();
+    if (name.endsWith(".gz") && contentType != "application/x-gzip" && contentType != "application/octet-stream") {
+        sendHeader("Content-Encoding", "gzip");
+    }
+    send(code, contentType.c_str(), String());
+
+    // The task streams it; the handle is closed once sent
+    if (c->method != HTTP_HEAD) c->file = file;
+    return size;
+}
+
+void HttpServer::pumpContent(TContentPump fn) {
+    Conn* c = _current;
+    if (!c || !c->headersSent || c->streaming || c->method == HTTP_HEAD) return;
+    c->pump = fn;
+}
+
+// ---- Streams ----
+
+int HttpServer::beginStream(const char* contentType) {
+    Conn* c = _current;
+    if (!c || c->headersSent) return -1;
+
+    lock();
+    uint8_t streams = 0;
+    for (const auto& other : _conns) {
+        if (other.state == CONN_STREAMING) streams++;
+    }
+    unlock();
+    if (streams >= HTTP_MAX_STREAMS) return -1;
+
+    c->streaming = true;
+    c->closeAfter = true;
+    send(200, contentType, String());
+    return ((int)c->generation << 8) | (int)(c - _conns);
+}
+
+HttpServer::Conn* HttpServer::streamConn(int id) {
+    if (id < 0) return nullptr;
+    const int index = id & 0xFF;
+    if (index >= HTTP_MAX_CONNECTIONS) return nullptr;
+
+    Conn& c = _conns[index];
+    if (c.generation != (uint8_t)(id >> 8) || c.fd < 0) return nullptr;
+    // Still inside the handler (DISPATCHING) counts: writes queue behind the headers
+    if (!c.streaming || (c.state != CONN_STREAMING && c.state != CONN_DISPATCHING)) return nullptr;
+    return &c;
+}
+
+bool HttpServer::streamWrite(int id, const char* data, size_t len) {
+    lock();
+    Conn* c = streamConn(id);
+    if (!c) {
+        unlock();
+        return false;
+    }
+
+    if (c->outPending + len > HTTP_STREAM_MAX_BACKLOG || !appendOut(*c, data, len)) {
+        // The client is not keeping up (or the heap is out); drop it and let it resume from its last id
+        if (c->state == CONN_STREAMING) closeConn(*c);
+        else c->broken = true;
+        unlock();
+        return false;
+    }
+
+    if (c->state == CONN_STREAMING) writeConn(*c);
+    const bool ok = (streamConn(id) != nullptr);
+    unlock();
+    return ok;
+}
+
+void HttpServer::endStream(int id) {
+    lock();
+    Conn* c = streamConn(id);
+    if (c) {
+        if (c->state == CONN_STREAMING) closeConn(*c);
+        else c->broken = true;
+    }
+    unlock();
+}
+
+void HttpServer::readStream(Conn& c) {
+    // Anything the client sends on a stream is ignored; EOF or an error ends it
+    char scratch[64];
+    const int n = recv(c.fd, scratch, sizeof(scratch), 0);
+    if (n == 0 || (n < 0 && !wouldBlock())) closeConn(c);
+}
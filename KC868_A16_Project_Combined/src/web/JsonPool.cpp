@@ -0,0 +1,92 @@
+// JsonPool.cpp
+// Slot leasing behind PooledJsonDocument (see JsonPool.h)
+
+#include "JsonPool.h"
+#include <Arduino.h>
+
+struct JsonPoolClass {
+    uint8_t* arena;
+    size_t slotSize;
+    uint8_t slots;
+    uint32_t leased;            // bit per slot
+};
+
+alignas(8) static uint8_t smallArena[JSON_POOL_SMALL_SLOTS * JSON_POOL_SMALL_SIZE];
+alignas(8) static uint8_t largeArena[JSON_POOL_LARGE_SLOTS * JSON_POOL_LARGE_SIZE];
+
+static JsonPoolClass poolClasses[] = {
+    { smallArena, JSON_POOL_SMALL_SIZE, JSON_POOL_SMALL_SLOTS, 0 },
+    { largeArena, JSON_POOL_LARGE_SIZE, JSON_POOL_LARGE_SLOTS, 0 },
+};
+
+static JsonPoolStats poolStats = {};
+
+// Handlers run in the loop task, but nothing stops a callback task from building a document
+static portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+
+static JsonPoolClass* classOf(void* ptr) {
+    const uint8_t* p = (const uint8_t*)ptr;
+    for (JsonPoolClass& pc : poolClasses) {
+        if (p >= pc.arena && p < pc.arena + pc.slotSize * pc.slots) return &pc;
+    }
+    return nullptr;
+}
+
+void* JsonPoolAllocator::allocate(size_t size) {
+    void* slot = nullptr;
+
+    portENTER_CRITICAL(&poolMux);
+    for (JsonPoolClass& pc : poolClasses) {
+        if (size > pc.slotSize) continue;
+        for (uint8_t i = 0; i < pc.slots && !slot; i++) {
+            if (pc.leased & (1UL << i)) continue;
+            pc.leased |= (1UL << i);
+            slot = pc.arena + i * pc.slotSize;
+        }
+        if (slot) break;
+    }
+    poolStats.leases++;
+    if (slot) {
+        poolStats.inUse++;
+        if (poolStats.inUse > poolStats.inUseMax) poolStats.inUseMax = poolStats.inUse;
+    }
+    else {
+        poolStats.exhausted++;
+    }
+    portEXIT_CRITICAL(&poolMux);
+
+    return slot ? slot : malloc(size);
+}
+
+void JsonPoolAllocator::deallocate(void* ptr) {
+    if (!ptr) return;
+
+    JsonPoolClass* pc = classOf(ptr);
+    if (!pc) {
+        free(ptr);
+        return;
+    }
+
+    portENTER_CRITICAL(&poolMux);
+    pc->leased &= ~(1UL << (((uint8_t*)ptr - pc->arena) / pc->slotSize));
+    poolStats.inUse--;
+    portEXIT_CRITICAL(&poolMux);
+}
+
+// ArduinoJson only reallocates to shrink (shrinkToFit); a slot keeps its size
+void* JsonPoolAllocator::reallocate(void* ptr, size_t newSize) {
+    JsonPoolClass* pc = classOf(ptr);
+    if (!pc) return realloc(ptr, newSize);
+    if (newSize <= pc->slotSize) return ptr;
+
+    void* grown = malloc(newSize);
+    if (grown) {
+        memcpy(grown, ptr, pc->slotSize);
+        deallocate(ptr);
+    }
+    return grown;
+}
+
+const JsonPoolStats& jsonPoolStats() {
+    return poolStats;
+}
@@ -0,0 +1,40 @@
+#pragma once
+/**
+ * JsonPool.h
+ * Preallocated memory for the JSON documents built by HTTP / WebSocket handlers.
+ *
+ * PooledJsonDocument behaves like DynamicJsonDocument, but its memory is leased
+ * from a few static slots instead of the heap and handed back when the document
+ * goes out of scope:
+ *
+ *   PooledJsonDocument doc(1024);
+ *
+ * The capacity picks the slot class (up to JSON_POOL_SMALL_SIZE or up to
+ * JSON_POOL_LARGE_SIZE; a small request takes a large slot when the small ones
+ * are busy). Bigger documents, or any request while every suitable slot is
+ * leased, fall back to malloc and are counted as "exhausted".
+ */
+
+#include <ArduinoJson.h>
+
+#define JSON_POOL_SMALL_SIZE   1024
+#define JSON_POOL_SMALL_SLOTS  4
+#define JSON_POOL_LARGE_SIZE   4096
+#define JSON_POOL_LARGE_SLOTS  2
+
+struct JsonPoolStats {
+    uint32_t leases;
+    uint32_t exhausted;         // served from the heap instead of a slot
+    uint8_t inUse;
+    uint8_t inUseMax;
+};
+
+struct JsonPoolAllocator {
+    void* allocate(size_t size);
+    void deallocate(void* ptr);
+    void* reallocate(void* ptr, size_t newSize);
+};
+
+typedef BasicJsonDocument<JsonPoolAllocator> PooledJsonDocument;
+
+const JsonPoolStats& jsonPoolStats();
@@ -0,0 +1,197 @@
+// JsonStreamWriter.cpp
+// Chunked JSON response writer (see JsonStreamWriter.h)
+
+#include "JsonStreamWriter.h"
+#include <math.h>
+#include <stdarg.h>
+
+JsonStreamWriter::JsonStreamWriter(HttpServer& server)
+    : _server(server),
+      _len(0),
+      _depth(0),
+      _started(false),
+      _ended(false) {
+    _first[0] = true;
+}
+
+JsonStreamWriter::~JsonStreamWriter() {
+    end();
+}
+
+void JsonStreamWriter::begin(int code) {
+    if (_started) return;
+    _started = true;
+    _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _server.send(code, "application/json", "");
+}
+
+void JsonStreamWriter::end() {
+    if (!_started || _ended) return;
+    _ended = true;
+    flush();
+}
+
+// ---- Structure ----
+
+JsonStreamWriter& JsonStreamWriter::beginObject(const char* k) {
+    key(k);
+    putChar('{');
+    if (_depth + 1 < JSON_STREAM_MAX_DEPTH) _first[++_depth] = true;
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::endObject() {
+    putChar('}');
+    if (_depth > 0) _depth--;
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::beginArray(const char* k) {
+    key(k);
+    putChar('[');
+    if (_depth + 1 < JSON_STREAM_MAX_DEPTH) _first[++_depth] = true;
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::endArray() {
+    putChar(']');
+    if (_depth > 0) _depth--;
+    return *this;
+}
+
+// ---- Values ----
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, const char* v) {
+    key(k);
+    if (v) putString(v);
+    else put("null");
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, const String& v) {
+    return field(k, v.c_str());
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, bool v) {
+    key(k);
+    put(v ? "true" : "false");
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, int v) {
+    key(k);
+    number("%d", v);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, unsigned int v) {
+    key(k);
+    number("%u", v);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, long v) {
+    key(k);
+    number("%ld", v);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, unsigned long v) {
+    key(k);
+    number("%lu", v);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, long long v) {
+    key(k);
+    number("%lld", v);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, unsigned long long v) {
+    key(k);
+    number("%llu", v);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, float v) {
+    key(k);
+    // Same as ArduinoJson: NaN/Inf are not valid JSON
+    if (isnan(v) || isinf(v)) put("null");
+    else number("%.7g", (double)v);
+    return *this;
+}
+
+JsonStreamWriter& JsonStreamWriter::field(const char* k, double v) {
+    key(k);
+    if (isnan(v) || isinf(v)) put("null");
+    else number("%.15g", v);
+    return *this;
+}
+
+// ---- Output ----
+
+void JsonStreamWriter::key(const char* k) {
+    if (!_first[_depth]) putChar(',');
+    _first[_depth] = false;
+    if (k) {
+        putString(k);
+        putChar(':');
+    }
+}
+
+void JsonStreamWriter::putString(const char* s) {
+    putChar('"');
+    for (; *s; s++) {
+        const unsigned char ch = (unsigned char)*s;
+        switch (ch) {
+        case '"':  put("\\\"", 2); break;
+        case '\\': put("\\\\", 2); break;
+        case '\n': put("\\n", 2); break;
+        case '\r': put("\\r", 2); break;
+        case '\t': put("\\t", 2); break;
+        default:
+            if (ch < 0x20) {
+                char esc[7];
+                snprintf(esc, sizeof(esc), "\\u%04x", ch);
+                put(esc, 6);
+            }
+            else {
+                putChar((char)ch);
+            }
+        }
+    }
+    putChar('"');
+}
+
+void JsonStreamWriter::number(const char* fmt, ...) {
+    char tmp[32];
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(tmp, sizeof(tmp), fmt, args);
+    va_end(args);
+    if (n > 0) put(tmp, min((size_t)n, sizeof(tmp) - 1));
+}
+
+void JsonStreamWriter::putChar(char ch) {
+    if (_len >= sizeof(_buf)) flush();
+    _buf[_len++] = ch;
+}
+
+void JsonStreamWriter::put(const char* s, size_t n) {
+    while (n > 0) {
+        if (_len >= sizeof(_buf)) flush();
+        const size_t take = min(n, sizeof(_buf) - _len);
+        memcpy(_buf + _len, s, take);
+        _len += take;
+        s += take;
+        n -= take;
+    }
+}
+
+void JsonStreamWriter::flush() {
+    if (_len == 0) return;
+    if (!_started) begin();
+    _server.sendContent(_buf, _len);
+    _len = 0;
+}
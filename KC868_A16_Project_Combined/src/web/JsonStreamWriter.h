@@ -0,0 +1,78 @@
+#pragma once
+/**
+ * JsonStreamWriter.h
+ * Writes a JSON response straight into the HTTP connection as it is produced.
+ *
+ * The response is sent with chunked transfer encoding through a small fixed
+ * buffer, so large tables (schedules, triggers, status) go out without a
+ * DynamicJsonDocument, a serialized String and a copy in the send path.
+ * Each full buffer goes to sendContent(), which copies it into the
+ * connection's fixed HTTP_OUT_BLOCK blocks; the HTTP task sends and frees
+ * them, so no response buffer grows, is reallocated or is compacted. It never
+ * waits on the client: past HTTP_OUT_HIGH_WATER the task sends while the
+ * handler writes on, so a large table does not hold up the main loop. A table
+ * that can outgrow HTTP_OUT_MAX_BUFFERED is written from a content pump
+ * instead, a few rows per call (ApiJournal.cpp).
+ *
+ *   JsonStreamWriter json(server);
+ *   json.begin();
+ *   json.beginObject();
+ *   json.beginArray("outputs");
+ *   json.beginObject().field("id", 0).field("state", true).endObject();
+ *   json.endArray();
+ *   json.endObject();
+ *   json.end();
+ *
+ * Keys are only given inside objects; inside arrays pass nullptr (or use value()).
+ */
+
+#include "HttpServer.h"
+
+#define JSON_STREAM_BUFFER     512
+#define JSON_STREAM_MAX_DEPTH  8
+
+class JsonStreamWriter {
+public:
+    explicit JsonStreamWriter(HttpServer& server);
+    ~JsonStreamWriter();
+
+    void begin(int code = 200);
+    void end();
+
+    JsonStreamWriter& beginObject(const char* key = nullptr);
+    JsonStreamWriter& endObject();
+    JsonStreamWriter& beginArray(const char* key = nullptr);
+    JsonStreamWriter& endArray();
+
+    JsonStreamWriter& field(const char* key, const char* v);
+    JsonStreamWriter& field(const char* key, const String& v);
+    JsonStreamWriter& field(const char* key, bool v);
+    JsonStreamWriter& field(const char* key, int v);
+    JsonStreamWriter& field(const char* key, unsigned int v);
+    JsonStreamWriter& field(const char* key, long v);
+    JsonStreamWriter& field(const char* key, unsigned long v);
+    JsonStreamWriter& field(const char* key, long long v);
+    JsonStreamWriter& field(const char* key, unsigned long long v);
+    JsonStreamWriter& field(const char* key, float v);
+    JsonStreamWriter& field(const char* key, double v);
+
+    template <typename T>
+    JsonStreamWriter& value(T v) { return field(nullptr, v); }
+
+private:
+    HttpServer& _server;
+    char _buf[JSON_STREAM_BUFFER];
+    size_t _len;
+    uint8_t _depth;
+    bool _first[JSON_STREAM_MAX_DEPTH];
+    bool _started;
+    bool _ended;
+
+    void put(const char* s, size_t n);
+    void put(const char* s) { put(s, strlen(s)); }
+    void putChar(char ch);
+    void putString(const char* s);
+    void key(const char* k);
+    void number(const char* fmt, ...);
+    void flush();
+};
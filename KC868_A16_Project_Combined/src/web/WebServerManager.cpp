@@ -3,16 +3,116 @@
 
 #include "../FunctionPrototypes.h"
 
+// Static UI assets. tools/build_web_assets.py writes <name>.gz plus an
+// /assets.json manifest (ETag + hashed-URL flag); plain files still work.
+struct WebAsset {
+    const char* uri;
+    const char* path;
+    const char* contentType;
+    String gzPath;
+    String etag;
+    bool immutable;
+};
+
+static WebAsset webAssets[] = {
+    { "/index.html", "/index.html", "text/html", "", "", false },
+    { "/style.css",  "/style.css",  "text/css", "", "", false },
+    { "/script.js",  "/script.js",  "application/javascript", "", "", false },
+};
+
+static void loadWebAssetManifest() {
+    for (auto& a : webAssets) {
+        a.gzPath = SPIFFS.exists(String(a.path) + ".gz") ? String(a.path) + ".gz" : "";
+        a.etag = "";
+        a.immutable = false;
+    }
+
+    File f = SPIFFS.open("/assets.json", FILE_READ);
+    if (!f) {
+        debugPrintln("Web assets: no manifest, serving without validators");
+        return;
+    }
+
+    PooledJsonDocument doc(1024);
+    DeserializationError error = deserializeJson(doc, f);
+    f.close();
+    if (error) {
+        debugPrintln("Web assets: invalid manifest: " + String(error.c_str()));
+        return;
+    }
+
+    for (auto& a : webAssets) {
+        JsonObject entry = doc["assets"][a.uri];
+        if (entry.isNull()) continue;
+
+        const char* file = entry["file"];
+        if (file && SPIFFS.exists(file)) a.gzPath = file;
+        a.etag = entry["etag"] | "";
+        a.immutable = entry["immutable"] | false;
+    }
+    debugPrintln("Web assets: manifest loaded");
+}
+
+static void serveWebAsset(const WebAsset& a) {
+    // Hashed URLs (?v=...) never change content; the page itself revalidates
+    const char* cacheControl = a.immutable ? "public, max-age=31536000, immutable" : "no-cache";
+
+    if (a.etag.length() > 0) {
+        server.sendHeader("ETag", a.etag);
+        server.sendHeader("Cache-Control", cacheControl);
+
+        if (server.header("If-None-Match") == a.etag) {
+            server.send(304, a.contentType, "");
+            return;
+        }
+    }
+    else {
+        server.sendHeader("Cache-Control", "no-cache");
+    }
+
+    const bool acceptsGzip = server.header("Accept-Encoding").indexOf("gzip") >= 0;
+    const bool plainExists = SPIFFS.exists(a.path);
+
+    // Browsers always accept gzip; only fall back when a plain copy exists
+    File file;
+    if (a.gzPath.length() > 0 && (acceptsGzip || !plainExists)) {
+        file = SPIFFS.open(a.gzPath, FILE_READ);
+    }
+    else if (plainExists) {
+        file = SPIFFS.open(a.path, FILE_READ);
+    }
+
+    if (!file) {
+        handleNotFound();
+        return;
+    }
+
+    // streamFile() adds "Content-Encoding: gzip" for *.gz files; the server
+    // task streams the file and closes it once sent
+    server.streamFile(file, a.contentType);
+}
+
 void setupWebServer() {
-    // Serve static files from SPIFFS
-    server.serveStatic("/", SPIFFS, "/index.html");
-    server.serveStatic("/style.css", SPIFFS, "/style.css");
-    server.serveStatic("/script.js", SPIFFS, "/script.js");
+    // Serve static files from SPIFFS (pre-compressed when available)
+    static const char* collected[] = { "If-None-Match", "Accept-Encoding", "Last-Event-ID" };
+    server.collectHeaders(collected, 3);
+    loadWebAssetManifest();
+
+    server.on("/", HTTP_GET, []() { serveWebAsset(webAssets[0]); });
+    for (const auto& a : webAssets) {
+        server.on(a.uri, HTTP_GET, [&a]() { serveWebAsset(a); });
+    }
 
     // API endpoints
-    server.on("/", HTTP_GET, handleWebRoot);
     server.on("/api/status", HTTP_GET, handleSystemStatus);
     server.on("/api/relay", HTTP_POST, handleRelayControl);
+    server.on("/api/outputs", HTTP_GET, handleGetOutputs);
+    server.on("/api/outputs", HTTP_POST, handleSetOutputs);
+    server.on("/api/outputs/priority", HTTP_GET, handleGetOutputPriority);
+    server.on("/api/outputs/priority", HTTP_POST, handleSetOutputPriority);
+    server.on("/api/events", HTTP_GET, handleEventStream);
+    server.on("/api/journal", HTTP_GET, handleGetJournal);
+    server.on("/metrics", HTTP_GET, handleMetrics);
     server.on("/api/schedules", HTTP_GET, handleSchedules);
     server.on("/api/schedules", HTTP_POST, handleUpdateSchedule);
     server.on("/api/evaluate-input-schedules", HTTP_GET, handleEvaluateInputSchedules);
@@ -22,8 +122,15 @@ void setupWebServer() {
     server.on("/api/ht-sensors", HTTP_POST, handleUpdateHTSensor);
     server.on("/api/config", HTTP_GET, handleConfig);
     server.on("/api/config", HTTP_POST, handleUpdateConfig);
+    server.on("/api/rf", HTTP_GET, handleGetRf);
+    server.on("/api/rf", HTTP_POST, handleSetRf);
+    server.on("/api/logic", HTTP_GET, handleGetLogic);
+    server.on("/api/logic", HTTP_POST, handleSetLogic);
+    server.on("/api/backup", HTTP_GET, handleBackup);
+    server.on("/api/restore", HTTP_POST, handleRestore);
     server.on("/api/debug", HTTP_GET, handleDebug);
     server.on("/api/debug", HTTP_POST, handleDebugCommand);
+    server.on("/api/debug/heap", HTTP_GET, handleHeapDebug);
     server.on("/api/reboot", HTTP_POST, handleReboot);
 
     // Communication endpoints
@@ -38,6 +145,7 @@ void setupWebServer() {
 
     // Diagnostic endpoints
     server.on("/api/i2c/scan", HTTP_GET, handleI2CScan);
+    server.on("/api/i2c/stats", HTTP_GET, handleGetI2CStats);
 
     // Network settings endpoints
     server.on("/api/network/settings", HTTP_GET, handleNetworkSettings);
@@ -48,9 +156,14 @@ void setupWebServer() {
     server.on("/api/interrupts", HTTP_POST, handleUpdateInterrupts);
 
     // File upload handler
-    server.on("/api/upload", HTTP_POST, []() {
-        server.send(200, "text/plain", "File upload complete");
-        }, handleFileUpload);
+    server.on("/api/upload", HTTP_POST, handleFileUploadDone, handleFileUpload);
+
+    // Firmware / filesystem image updates
+    server.on("/api/ota/status", HTTP_GET, handleOtaStatus);
+    server.on("/api/ota/begin", HTTP_POST, handleOtaBegin);
+    server.on("/api/ota/chunk", HTTP_POST, handleOtaChunk, handleOtaChunkUpload);
+    server.on("/api/ota/finish", HTTP_POST, handleOtaFinish);
+    server.on("/api/ota/abort", HTTP_POST, handleOtaAbort);
 
     // Not found handler
     server.onNotFound(handleNotFound);
@@ -89,27 +202,59 @@ void handleNotFound() {
     server.send(404, "text/plain", message);
 }
 
+// Uploads go to "<name>.tmp" and replace the real file only once complete,
+// so a dropped or oversized upload never leaves a truncated file behind.
+static String uploadPath;
+static String uploadError;
+
 void handleFileUpload() {
     HTTPUpload& upload = server.upload();
 
     if (upload.status == UPLOAD_FILE_START) {
-        String filename = upload.filename;
-        if (!filename.startsWith("/")) {
-            filename = "/" + filename;
+        uploadPath = upload.filename;
+        if (!uploadPath.startsWith("/")) {
+            uploadPath = "/" + uploadPath;
         }
-        debugPrintln("File upload start: " + filename);
-        fsUploadFile = SPIFFS.open(filename, FILE_WRITE);
+        uploadError = String();
+        debugPrintln("File upload start: " + uploadPath);
+        fsUploadFile = SPIFFS.open(uploadPath + ".tmp", FILE_WRITE);
+        if (!fsUploadFile) uploadError = "Cannot create file";
     }
     else if (upload.status == UPLOAD_FILE_WRITE) {
-        if (fsUploadFile) {
-            fsUploadFile.write(upload.buf, upload.currentSize);
+        if (fsUploadFile && fsUploadFile.write(upload.buf, upload.currentSize) != upload.currentSize) {
+            fsUploadFile.close();
+            SPIFFS.remove(uploadPath + ".tmp");
+            uploadError = "Not enough space on the file system";
         }
     }
     else if (upload.status == UPLOAD_FILE_END) {
         if (fsUploadFile) {
             fsUploadFile.close();
+            SPIFFS.remove(uploadPath);
+            if (!SPIFFS.rename(uploadPath + ".tmp", uploadPath)) {
+                uploadError = "Rename failed";
+                return;
+            }
             debugPrintln("File upload complete: " + String(upload.totalSize) + " bytes");
+
+            // Pick up new ETags / .gz files without a reboot
+            if (upload.filename.endsWith("assets.json") || upload.filename.endsWith(".gz")) {
+                loadWebAssetManifest();
+            }
         }
     }
+    else if (upload.status == UPLOAD_FILE_ABORTED) {
+        if (fsUploadFile) fsUploadFile.close();
+        SPIFFS.remove(uploadPath + ".tmp");
+        debugPrintln("File upload aborted: " + uploadPath);
+    }
+}
+
+void handleFileUploadDone() {
+    if (uploadError.length() > 0) {
+        server.send(500, "text/plain", "File upload failed: " + uploadError);
+        return;
+    }
+    server.send(200, "text/plain", "File upload complete");
 }
 
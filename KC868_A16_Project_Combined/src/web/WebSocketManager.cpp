@@ -2,32 +2,224 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../FunctionPrototypes.h"
+#include "WsBinaryProtocol.h"
+
+// Per-client connection state (indexed by WebSocketsServer client number)
+struct WsClientState {
+    bool connected;
+    bool binary;            // negotiated at connect via "/bin" URL path
+    uint8_t topics;         // subscribed WS_TOPIC_* mask
+    uint8_t pending;        // topics changed since the last send (coalesced)
+    uint16_t minIntervalMs; // per-client rate cap
+    uint16_t backoffMs;     // extra delay while the client is congested
+    uint32_t lastSendMs;
+    uint32_t coalesced;     // updates folded into a later send
+    uint32_t slowSends;
+};
+
+static WsClientState wsClients[WEBSOCKETS_SERVER_CLIENT_MAX];
+
+// All sends go through these so /metrics can count traffic
+static bool wsSendText(uint8_t num, String& message) {
+    const bool ok = webSocket.sendTXT(num, message);
+    if (ok) {
+        metrics.wsMessagesSent++;
+        metrics.wsBytesSent += message.length();
+    }
+    return ok;
+}
+
+static bool wsSendBinary(uint8_t num, const uint8_t* data, size_t len) {
+    const bool ok = webSocket.sendBIN(num, data, len);
+    if (ok) {
+        metrics.wsMessagesSent++;
+        metrics.wsBytesSent += len;
+    }
+    return ok;
+}
+static uint16_t wsBinSeq = 0;
+
+static void buildBinaryStatus(WsBinStatusFrame& f) {
+    memset(&f, 0, sizeof(f));
+    f.type = WS_BIN_STATUS;
+    f.version = WS_BIN_PROTOCOL_VERSION;
+    f.seq = wsBinSeq++;
+    f.uptimeMs = millis();
+
+    for (int i = 0; i < 16; i++) {
+        if (outputStates[i]) f.outputs |= (uint16_t)(1u << i);
+        if (inputStates[i]) f.inputs |= (uint16_t)(1u << i);
+    }
+    for (int i = 0; i < 3; i++) {
+        if (directInputStates[i]) f.directInputs |= (uint8_t)(1u << i);
+    }
+
+    if (ethConnected) f.flags |= WS_BIN_FLAG_ETH;
+    if (wifiConnected) f.flags |= WS_BIN_FLAG_WIFI;
+    if (apMode) f.flags |= WS_BIN_FLAG_AP;
+    if (outputsMasterEnable) f.flags |= WS_BIN_FLAG_OUTPUTS_ENABLED;
+
+    for (int i = 0; i < 4; i++) {
+        f.analogMv[i] = (int16_t)lroundf(analogVoltages[i] * 1000.0f);
+    }
+
+    for (int i = 0; i < 3; i++) {
+        const uint8_t t = htSensorConfig[i].sensorType;
+        const bool hasTemp = (t == SENSOR_TYPE_DHT11 || t == SENSOR_TYPE_DHT22 || t == SENSOR_TYPE_DS18B20) &&
+                             !isnan(htSensorConfig[i].temperature);
+        const bool hasHum = (t == SENSOR_TYPE_DHT11 || t == SENSOR_TYPE_DHT22) &&
+                            !isnan(htSensorConfig[i].humidity);
+        f.tempDeciC[i] = hasTemp ? (int16_t)lroundf(htSensorConfig[i].temperature * 10.0f) : WS_BIN_TEMP_NA;
+        f.humDeciPct[i] = hasHum ? (uint16_t)lroundf(htSensorConfig[i].humidity * 10.0f) : WS_BIN_HUM_NA;
+    }
+
+    f.i2cErrors = (i2cErrorCount > 0xFFFF) ? 0xFFFF : (uint16_t)i2cErrorCount;
+}
+
+static const struct {
+    const char* name;
+    uint8_t bit;
+} wsTopicNames[] = {
+    { "outputs", WS_TOPIC_OUTPUTS },
+    { "inputs",  WS_TOPIC_INPUTS },
+    { "analog",  WS_TOPIC_ANALOG },
+    { "sensors", WS_TOPIC_SENSORS },
+    { "system",  WS_TOPIC_SYSTEM },
+};
+
+// Topic list from a subscribe/unsubscribe command; missing list = all topics
+static uint8_t parseTopics(JsonVariantConst topics) {
+    if (topics.isNull()) return WS_TOPIC_ALL;
+
+    uint8_t mask = 0;
+    for (JsonVariantConst t : topics.as<JsonArrayConst>()) {
+        const char* name = t.as<const char*>();
+        if (!name) continue;
+        for (const auto& entry : wsTopicNames) {
+            if (strcmp(name, entry.name) == 0) mask |= entry.bit;
+        }
+    }
+    return mask;
+}
+
+static void sendSubscriptionState(uint8_t num) {
+    PooledJsonDocument doc(256);
+    doc["type"] = "subscription";
+    JsonArray topics = doc.createNestedArray("topics");
+    for (const auto& entry : wsTopicNames) {
+        if (wsClients[num].topics & entry.bit) topics.add(entry.name);
+    }
+    doc["min_interval_ms"] = wsClients[num].minIntervalMs;
+
+    String message;
+    serializeJson(doc, message);
+    wsSendText(num, message);
+}
+
+static void sendBinaryAck(uint8_t num, uint8_t opcode, uint8_t result) {
+    const uint8_t ack[3] = { WS_BIN_ACK, opcode, result };
+    wsSendBinary(num, ack, sizeof(ack));
+}
+
+// Typed command frames: fixed offsets, no JSON parsing
+static void handleBinaryCommand(uint8_t num, const uint8_t* payload, size_t length) {
+    if (length < 1) return;
+    const uint8_t op = payload[0];
+
+    if (op == WS_BIN_CMD_GET_STATUS) {
+        WsBinStatusFrame f;
+        buildBinaryStatus(f);
+        wsSendBinary(num, (const uint8_t*)&f, sizeof(f));
+        return;
+    }
+
+    uint16_t mask = 0;
+    uint16_t value = 0;
+
+    switch (op) {
+    case WS_BIN_CMD_TOGGLE_RELAY:
+        if (length < 3) { sendBinaryAck(num, op, WS_BIN_ERR_LENGTH); return; }
+        if (payload[1] >= 16) { sendBinaryAck(num, op, WS_BIN_ERR_RANGE); return; }
+        mask = (uint16_t)(1u << payload[1]);
+        value = payload[2] ? mask : 0;
+        break;
+
+    case WS_BIN_CMD_SET_ALL:
+        if (length < 2) { sendBinaryAck(num, op, WS_BIN_ERR_LENGTH); return; }
+        mask = 0xFFFF;
+        value = payload[1] ? 0xFFFF : 0;
+        break;
+
+    case WS_BIN_CMD_SET_MASK:
+        if (length < 5) { sendBinaryAck(num, op, WS_BIN_ERR_LENGTH); return; }
+        mask = (uint16_t)(payload[1] | (payload[2] << 8));
+        value = (uint16_t)(payload[3] | (payload[4] << 8));
+        break;
+
+    default:
+        sendBinaryAck(num, op, WS_BIN_ERR_OPCODE);
+        return;
+    }
+
+    if (!outputsMasterEnable) {
+        sendBinaryAck(num, op, WS_BIN_ERR_DISABLED);
+        return;
+    }
+
+    if (!applyOutputsOnce(OUTPUT_SRC_WEBSOCKET, mask, value)) {
+        sendBinaryAck(num, op, WS_BIN_ERR_IO);
+        return;
+    }
+
+    sendBinaryAck(num, op, WS_BIN_OK);
+    broadcastUpdate(WS_TOPIC_OUTPUTS);
+}
 
 void handleWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
+    if (num >= WEBSOCKETS_SERVER_CLIENT_MAX) return;
+
     switch (type) {
     case WStype_DISCONNECTED:
         debugPrintln("WebSocket client disconnected");
         webSocketClients[num] = false;
+        memset(&wsClients[num], 0, sizeof(wsClients[num]));
         break;
     case WStype_CONNECTED:
     {
         IPAddress ip = webSocket.remoteIP(num);
-        debugPrintln("WebSocket client connected: " + ip.toString());
+
+        // Payload is the request URL; "/bin..." selects the binary frames
+        const bool binary = (payload && length >= 4 && strncmp((const char*)payload, "/bin", 4) == 0);
+        debugPrintln("WebSocket client connected: " + ip.toString() + (binary ? " (binary)" : ""));
 
         // Mark client as subscribed
         webSocketClients[num] = true;
+        memset(&wsClients[num], 0, sizeof(wsClients[num]));
+        wsClients[num].connected = true;
+        wsClients[num].binary = binary;
+        wsClients[num].topics = WS_TOPIC_ALL;
+        wsClients[num].minIntervalMs = WS_DEFAULT_MIN_INTERVAL_MS;
+
+        if (binary) {
+            WsBinStatusFrame f;
+            buildBinaryStatus(f);
+            wsSendBinary(num, (const uint8_t*)&f, sizeof(f));
+            wsClients[num].lastSendMs = millis();
+            break;
+        }
 
         // Send initial status update
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         doc["type"] = "status";
         doc["connected"] = true;
 
         String message;
         serializeJson(doc, message);
-        webSocket.sendTXT(num, message);
+        wsSendText(num, message);
 
         // Send current state of all relays and inputs
-        broadcastUpdate();
+        wsClients[num].pending = WS_TOPIC_ALL;
+        serviceWebSocketClients();
     }
     break;
     case WStype_TEXT:
@@ -36,21 +228,40 @@ void handleWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t l
         debugPrintln("WebSocket received: " + text);
 
         // Process WebSocket command
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         DeserializationError error = deserializeJson(doc, text);
 
         if (!error) {
             String cmd = doc["command"];
 
             if (cmd == "subscribe") {
-                // Subscribe to real-time updates
-                webSocketClients[num] = true;
+                // Subscribe to real-time updates, optionally by topic and rate:
+                // {"command":"subscribe","topics":["outputs","inputs"],"min_interval_ms":250}
+                const uint8_t topics = parseTopics(doc["topics"]);
+                wsClients[num].topics |= topics;
+                wsClients[num].pending |= topics;
+
+                if (doc.containsKey("min_interval_ms")) {
+                    wsClients[num].minIntervalMs = constrain(doc["min_interval_ms"].as<int>(), 0, 60000);
+                }
+                else if (doc.containsKey("max_rate_hz")) {
+                    const float hz = doc["max_rate_hz"].as<float>();
+                    wsClients[num].minIntervalMs = (hz > 0.0f) ? constrain((int)(1000.0f / hz), 0, 60000) : WS_DEFAULT_MIN_INTERVAL_MS;
+                }
+
+                webSocketClients[num] = wsClients[num].topics != 0;
                 debugPrintln("Client subscribed to updates");
+                sendSubscriptionState(num);
             }
             else if (cmd == "unsubscribe") {
-                // Unsubscribe from updates
-                webSocketClients[num] = false;
+                // Unsubscribe from the listed topics (all when no list given)
+                const uint8_t topics = parseTopics(doc["topics"]);
+                wsClients[num].topics &= ~topics;
+                wsClients[num].pending &= ~topics;
+
+                webSocketClients[num] = wsClients[num].topics != 0;
                 debugPrintln("Client unsubscribed from updates");
+                sendSubscriptionState(num);
             }
             else if (cmd == "toggle_relay") {
                 // Toggle relay command
@@ -60,33 +271,31 @@ void handleWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t l
                 debugPrintln("WebSocket: Toggling relay " + String(relay) + " to " + String(state ? "ON" : "OFF"));
 
                 if (relay >= 0 && relay < 16) {
-                    outputStates[relay] = state;
-
-                    if (writeOutputs()) {
+                    if (applyOutputsOnce(OUTPUT_SRC_WEBSOCKET, 1u << relay, state ? 0xFFFF : 0)) {
                         debugPrintln("Relay toggled successfully via WebSocket");
 
                         // Send response
-                        DynamicJsonDocument responseDoc(512);
+                        PooledJsonDocument responseDoc(512);
                         responseDoc["type"] = "relay_update";
                         responseDoc["relay"] = relay;
                         responseDoc["state"] = outputStates[relay];
 
                         String response;
                         serializeJson(responseDoc, response);
-                        webSocket.sendTXT(num, response);
+                        wsSendText(num, response);
 
                         // Broadcast update to all subscribed clients
-                        broadcastUpdate();
+                        broadcastUpdate(WS_TOPIC_OUTPUTS);
                     }
                     else {
                         // Send error response
-                        DynamicJsonDocument errorDoc(512);
+                        PooledJsonDocument errorDoc(512);
                         errorDoc["type"] = "error";
                         errorDoc["message"] = "Failed to write to relay";
 
                         String errorResponse;
                         serializeJson(errorDoc, errorResponse);
-                        webSocket.sendTXT(num, errorResponse);
+                        wsSendText(num, errorResponse);
 
                         debugPrintln("ERROR: Failed to toggle relay via WebSocket");
                     }
@@ -99,7 +308,7 @@ void handleWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t l
                 // Get protocol-specific configuration
                 String protocol = doc["protocol"];
 
-                DynamicJsonDocument responseDoc(1024);
+                PooledJsonDocument responseDoc(1024);
                 responseDoc["type"] = "protocol_config";
                 responseDoc["protocol"] = protocol;
 
@@ -152,7 +361,7 @@ void handleWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t l
 
                 String response;
                 serializeJson(responseDoc, response);
-                webSocket.sendTXT(num, response);
+                wsSendText(num, response);
             }
         }
         else {
@@ -160,118 +369,215 @@ void handleWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t l
         }
     }
     break;
+    case WStype_BIN:
+        handleBinaryCommand(num, payload, length);
+        break;
+    default:
+        break;
     }
 }
 
-void broadcastUpdate() {
-    DynamicJsonDocument doc(4096);
+// Build the status_update document for a topic mask
+static void buildStatusJson(uint8_t topics, String& out) {
+    PooledJsonDocument doc(4096);
     doc["type"] = "status_update";
     doc["time"] = getTimeString();
     doc["timestamp"] = millis(); // Add timestamp for freshness checking
 
-    // Add output states
-    JsonArray outputs = doc.createNestedArray("outputs");
-    for (int i = 0; i < 16; i++) {
-        JsonObject output = outputs.createNestedObject();
-        output["id"] = i;
-        output["state"] = outputStates[i];
+    if (topics & WS_TOPIC_OUTPUTS) {
+        // Add output states
+        JsonArray outputs = doc.createNestedArray("outputs");
+        for (int i = 0; i < 16; i++) {
+            JsonObject output = outputs.createNestedObject();
+            output["id"] = i;
+            output["state"] = outputStates[i];
+        }
     }
 
-    // Add input states
-    JsonArray inputs = doc.createNestedArray("inputs");
-    for (int i = 0; i < 16; i++) {
-        JsonObject input = inputs.createNestedObject();
-        input["id"] = i;
-        input["state"] = inputStates[i];
-    }
+    if (topics & WS_TOPIC_INPUTS) {
+        // Add input states
+        JsonArray inputs = doc.createNestedArray("inputs");
+        for (int i = 0; i < 16; i++) {
+            JsonObject input = inputs.createNestedObject();
+            input["id"] = i;
+            input["state"] = inputStates[i];
+        }
 
-    // Add direct input states (HT1-HT3)
-    JsonArray directInputs = doc.createNestedArray("direct_inputs");
-    for (int i = 0; i < 3; i++) {
-        JsonObject input = directInputs.createNestedObject();
-        input["id"] = i;
-        input["state"] = directInputStates[i];
+        // Add direct input states (HT1-HT3)
+        JsonArray directInputs = doc.createNestedArray("direct_inputs");
+        for (int i = 0; i < 3; i++) {
+            JsonObject input = directInputs.createNestedObject();
+            input["id"] = i;
+            input["state"] = directInputStates[i];
+        }
     }
 
-    // Add HT sensors data
-    JsonArray htSensors = doc.createNestedArray("htSensors");
-    for (int i = 0; i < 3; i++) {
-        JsonObject sensor = htSensors.createNestedObject();
-        sensor["index"] = i;
-        sensor["pin"] = "HT" + String(i + 1);
-        sensor["sensorType"] = htSensorConfig[i].sensorType;
-
-        const char* sensorTypeNames[] = {
-            "Digital Input", "DHT11", "DHT22", "DS18B20"
-        };
-        sensor["sensorTypeName"] = sensorTypeNames[htSensorConfig[i].sensorType];
-
-        switch (htSensorConfig[i].sensorType) {
-        case SENSOR_TYPE_DIGITAL:
-            sensor["value"] = directInputStates[i] ? "HIGH" : "LOW";
-            break;
+    if (topics & WS_TOPIC_SENSORS) {
+        // Add HT sensors data
+        JsonArray htSensors = doc.createNestedArray("htSensors");
+        for (int i = 0; i < 3; i++) {
+            JsonObject sensor = htSensors.createNestedObject();
+            sensor["index"] = i;
+            sensor["pin"] = "HT" + String(i + 1);
+            sensor["sensorType"] = htSensorConfig[i].sensorType;
+
+            const char* sensorTypeNames[] = {
+                "Digital Input", "DHT11", "DHT22", "DS18B20"
+            };
+            sensor["sensorTypeName"] = sensorTypeNames[htSensorConfig[i].sensorType];
+
+            switch (htSensorConfig[i].sensorType) {
+            case SENSOR_TYPE_DIGITAL:
+                sensor["value"] = directInputStates[i] ? "HIGH" : "LOW";
+                break;
+
+            case SENSOR_TYPE_DHT11:
+            case SENSOR_TYPE_DHT22:
+                sensor["temperature"] = htSensorConfig[i].temperature;
+                sensor["humidity"] = htSensorConfig[i].humidity;
+                break;
+
+            case SENSOR_TYPE_DS18B20:
+                sensor["temperature"] = htSensorConfig[i].temperature;
+                break;
+            }
+        }
+    }
 
-        case SENSOR_TYPE_DHT11:
-        case SENSOR_TYPE_DHT22:
-            sensor["temperature"] = htSensorConfig[i].temperature;
-            sensor["humidity"] = htSensorConfig[i].humidity;
-            break;
+    if (topics & WS_TOPIC_ANALOG) {
+        // Add analog inputs
+        JsonArray analog = doc.createNestedArray("analog");
+        for (int i = 0; i < 4; i++) {
+            JsonObject analogInput = analog.createNestedObject();
+            analogInput["id"] = i;
+            analogInput["value"] = analogValues[i];
+            analogInput["voltage"] = analogVoltages[i];
+            analogInput["percentage"] = calculatePercentage(analogVoltages[i]);
+        }
+    }
 
-        case SENSOR_TYPE_DS18B20:
-            sensor["temperature"] = htSensorConfig[i].temperature;
-            break;
+    if (topics & WS_TOPIC_SYSTEM) {
+        // Add system information
+        doc["device"] = deviceName;
+        doc["wifi_connected"] = wifiConnected;
+        doc["wifi_client_mode"] = wifiClientMode;
+        doc["wifi_ap_mode"] = apMode;
+        doc["wifi_rssi"] = WiFi.RSSI();
+
+        // Make sure to correctly set the WiFi IP address
+        String wifiIpAddress = wifiClientMode ? WiFi.localIP().toString() : (apMode ? WiFi.softAPIP().toString() : "Not connected");
+        doc["wifi_ip"] = wifiIpAddress;
+
+        doc["eth_connected"] = ethConnected;
+        doc["eth_ip"] = ethConnected ? ETH.localIP().toString() : "Not connected";
+
+        // Set MAC address from appropriate source
+        String macAddress = "";
+        if (ethConnected) {
+            macAddress = ETH.macAddress();
+        }
+        else if (wifiConnected) {
+            macAddress = wifiClientMode ? WiFi.macAddress() : WiFi.softAPmacAddress();
         }
+        doc["mac"] = macAddress;
+
+        doc["uptime"] = getUptimeString();
+        doc["active_protocol"] = getActiveProtocolName();
+        doc["firmware_version"] = FIRMWARE_VERSION;
+        doc["i2c_errors"] = i2cErrorCount;
+        doc["free_heap"] = ESP.getFreeHeap();
+        doc["cpu_freq"] = ESP.getCpuFreqMHz();
+        doc["last_error"] = lastErrorMessage;
+
+        // Add additional network info for better dashboard display
+        doc["network"] = true;  // Flag to indicate network info is available
     }
 
-    // Add analog inputs
-    JsonArray analog = doc.createNestedArray("analog");
-    for (int i = 0; i < 4; i++) {
-        JsonObject analogInput = analog.createNestedObject();
-        analogInput["id"] = i;
-        analogInput["value"] = analogValues[i];
-        analogInput["voltage"] = analogVoltages[i];
-        analogInput["percentage"] = calculatePercentage(analogVoltages[i]);
+    serializeJson(doc, out);
+}
+
+// Mark topics as changed for every subscribed client and push what is due.
+// Clients inside their rate window keep the topics pending; the next send
+// carries the current state, so a slow client never builds up a backlog.
+void broadcastUpdate(uint8_t topics) {
+    // Same change feed drives the /api/events stream
+    publishStateEvents(topics);
+
+    for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        WsClientState& c = wsClients[i];
+        if (!c.connected) continue;
+
+        const uint8_t wanted = topics & c.topics;
+        if (!wanted) continue;
+        if (c.pending) c.coalesced++;
+        c.pending |= wanted;
     }
 
-    // Add system information
-    doc["device"] = deviceName;
-    doc["wifi_connected"] = wifiConnected;
-    doc["wifi_client_mode"] = wifiClientMode;
-    doc["wifi_ap_mode"] = apMode;
-    doc["wifi_rssi"] = WiFi.RSSI();
+    serviceWebSocketClients();
+}
 
-    // Make sure to correctly set the WiFi IP address
-    String wifiIpAddress = wifiClientMode ? WiFi.localIP().toString() : (apMode ? WiFi.softAPIP().toString() : "Not connected");
-    doc["wifi_ip"] = wifiIpAddress;
+// Flush pending updates; called from broadcastUpdate() and from the main loop
+void serviceWebSocketClients() {
+    const uint32_t now = millis();
 
-    doc["eth_connected"] = ethConnected;
-    doc["eth_ip"] = ethConnected ? ETH.localIP().toString() : "Not connected";
+    // Documents built this pass, shared by clients with the same topic mask
+    static const uint8_t CACHE_SIZE = 4;
+    uint8_t cacheMask[CACHE_SIZE];
+    String cacheJson[CACHE_SIZE];
+    uint8_t cacheCount = 0;
 
-    // Set MAC address from appropriate source
-    String macAddress = "";
-    if (ethConnected) {
-        macAddress = ETH.macAddress();
-    }
-    else if (wifiConnected) {
-        macAddress = wifiClientMode ? WiFi.macAddress() : WiFi.softAPmacAddress();
-    }
-    doc["mac"] = macAddress;
+    bool binaryBuilt = false;
+    WsBinStatusFrame frame;
 
-    doc["uptime"] = getUptimeString();
-    doc["active_protocol"] = getActiveProtocolName();
-    doc["firmware_version"] = FIRMWARE_VERSION;
-    doc["i2c_errors"] = i2cErrorCount;
-    doc["free_heap"] = ESP.getFreeHeap();
-    doc["cpu_freq"] = ESP.getCpuFreqMHz();
-    doc["last_error"] = lastErrorMessage;
+    for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+        WsClientState& c = wsClients[i];
+        if (!c.connected || !c.pending) continue;
+        if ((uint32_t)(now - c.lastSendMs) < (uint32_t)c.minIntervalMs + c.backoffMs) continue;
 
-    // Add additional network info for better dashboard display
-    doc["network"] = true;  // Flag to indicate network info is available
+        const uint32_t t0 = millis();
+        bool ok;
+
+        if (c.binary) {
+            if (!binaryBuilt) {
+                buildBinaryStatus(frame);
+                binaryBuilt = true;
+            }
+            ok = wsSendBinary(i, (const uint8_t*)&frame, sizeof(frame));
+        }
+        else {
+            // Full state for the subscribed topics, so the dashboard can render
+            // any message on its own
+            const uint8_t mask = c.topics;
+            String* json = nullptr;
+            for (uint8_t k = 0; k < cacheCount; k++) {
+                if (cacheMask[k] == mask) { json = &cacheJson[k]; break; }
+            }
+            String local;
+            if (!json) {
+                if (cacheCount < CACHE_SIZE) {
+                    cacheMask[cacheCount] = mask;
+                    json = &cacheJson[cacheCount++];
+                }
+                else {
+                    json = &local;
+                }
+                buildStatusJson(mask, *json);
+            }
+            ok = wsSendText(i, *json);
+        }
 
-    String jsonString;
-    serializeJson(doc, jsonString);
+        const uint32_t elapsed = millis() - t0;
+        c.lastSendMs = millis();
 
-    // Send to all WebSocket clients
-    webSocket.broadcastTXT(jsonString);
+        if (!ok || elapsed > WS_SLOW_SEND_MS) {
+            // Congested: back off exponentially; a failed send stays pending
+            c.backoffMs = (uint16_t)constrain((int)(c.backoffMs ? c.backoffMs * 2 : 250), 250, WS_MAX_BACKOFF_MS);
+            c.slowSends++;
+            if (ok) c.pending = 0;
+        }
+        else {
+            c.backoffMs = 0;
+            c.pending = 0;
+        }
+    }
 }
-
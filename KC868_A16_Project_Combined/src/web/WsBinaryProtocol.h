@@ -0,0 +1,68 @@
+#pragma once
+/**
+ * WsBinaryProtocol.h
+ * Compact binary WebSocket frames for dashboards / HMIs.
+ *
+ * A client selects the binary format by connecting to a URL path that
+ * starts with "/bin" (e.g. ws://<ip>:81/bin). All other paths keep the
+ * JSON text protocol. All multi-byte fields are little-endian.
+ *
+ * Server -> client
+ *   WS_BIN_STATUS   WsBinStatusFrame (36 bytes)
+ *   WS_BIN_ACK      [type, opcode, result]            result: 0 = ok, else WS_BIN_ERR_*
+ *
+ * Client -> server
+ *   WS_BIN_CMD_TOGGLE_RELAY  [op, relay 0..15, state 0/1]
+ *   WS_BIN_CMD_SET_ALL       [op, state 0/1]
+ *   WS_BIN_CMD_SET_MASK      [op, mask u16, value u16]   outputs in mask take the value bit
+ *   WS_BIN_CMD_GET_STATUS    [op]
+ */
+
+#include <stdint.h>
+
+// Frame types (server -> client)
+#define WS_BIN_STATUS               0x01
+#define WS_BIN_ACK                  0x02
+
+// Command opcodes (client -> server)
+#define WS_BIN_CMD_TOGGLE_RELAY     0x10
+#define WS_BIN_CMD_SET_ALL          0x11
+#define WS_BIN_CMD_SET_MASK         0x12
+#define WS_BIN_CMD_GET_STATUS       0x13
+
+// ACK result codes
+#define WS_BIN_OK                   0x00
+#define WS_BIN_ERR_LENGTH           0x01
+#define WS_BIN_ERR_RANGE            0x02
+#define WS_BIN_ERR_IO               0x03
+#define WS_BIN_ERR_OPCODE           0x04
+#define WS_BIN_ERR_DISABLED         0x05
+
+#define WS_BIN_PROTOCOL_VERSION     1
+
+// Status flags
+#define WS_BIN_FLAG_ETH             0x01
+#define WS_BIN_FLAG_WIFI            0x02
+#define WS_BIN_FLAG_AP              0x04
+#define WS_BIN_FLAG_OUTPUTS_ENABLED 0x08
+
+// Sentinels for sensors that are not fitted / not readable
+#define WS_BIN_TEMP_NA              ((int16_t)-32768)
+#define WS_BIN_HUM_NA               ((uint16_t)0xFFFF)
+
+struct __attribute__((packed)) WsBinStatusFrame {
+    uint8_t  type;              // WS_BIN_STATUS
+    uint8_t  version;           // WS_BIN_PROTOCOL_VERSION
+    uint16_t seq;               // increments per frame built
+    uint32_t uptimeMs;
+    uint16_t outputs;           // bit n = output n+1
+    uint16_t inputs;            // bit n = input n+1
+    uint8_t  directInputs;      // HT1..HT3 digital level
+    uint8_t  flags;             // WS_BIN_FLAG_*
+    int16_t  analogMv[4];       // A1..A4 in millivolts
+    int16_t  tempDeciC[3];      // HT1..HT3, 0.1 degC
+    uint16_t humDeciPct[3];     // HT1..HT3, 0.1 %RH
+    uint16_t i2cErrors;         // saturating
+};
+
+static_assert(sizeof(WsBinStatusFrame) == 36, "WsBinStatusFrame layout changed");
@@ -2,27 +2,45 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
 
 void handleAnalogTriggers() {
-    DynamicJsonDocument doc(4096);
-    JsonArray triggersArray = doc.createNestedArray("triggers");
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.beginArray("triggers");
 
     for (int i = 0; i < MAX_ANALOG_TRIGGERS; i++) {
-        JsonObject trigger = triggersArray.createNestedObject();
-        trigger["id"] = i;
-        trigger["enabled"] = analogTriggers[i].enabled;
-        trigger["name"] = analogTriggers[i].name;
-        trigger["analogInput"] = analogTriggers[i].analogInput;
-        trigger["threshold"] = analogTriggers[i].threshold;
-        trigger["condition"] = analogTriggers[i].condition;
-        trigger["action"] = analogTriggers[i].action;
-        trigger["targetType"] = analogTriggers[i].targetType;
-        trigger["targetId"] = analogTriggers[i].targetId;
+        const AnalogTrigger& t = analogTriggers[i];
+        json.beginObject();
+        json.field("id", i);
+        json.field("enabled", t.enabled);
+        json.field("name", t.name);
+        json.field("analogInput", t.analogInput);
+        json.field("threshold", t.threshold);
+        json.field("condition", t.condition);
+        json.field("action", t.action);
+        json.field("targetType", t.targetType);
+        json.field("targetId", t.targetId);
+        json.field("combinedMode", t.combinedMode);
+        json.field("inputMask", t.inputMask);
+        json.field("inputStates", t.inputStates);
+        json.field("logic", t.logic);
+        json.field("htSensorIndex", t.htSensorIndex);
+        json.field("sensorTriggerType", t.sensorTriggerType);
+        json.field("sensorCondition", t.sensorCondition);
+        json.field("sensorThreshold", t.sensorThreshold);
+        json.field("hysteresis", t.hysteresis);
+        json.field("sensorHysteresis", t.sensorHysteresis);
+        json.field("minOnSec", t.minOnSec);
+        json.field("minOffSec", t.minOffSec);
+        json.field("active", analogTriggerActive(i));
+        json.endObject();
     }
 
-    String response;
-    serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    json.endArray();
+    json.endObject();
+    json.end();
 }
 
 void handleUpdateAnalogTriggers() {
@@ -30,7 +48,7 @@ void handleUpdateAnalogTriggers() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error && doc.containsKey("trigger")) {
@@ -65,6 +83,12 @@ void handleUpdateAnalogTriggers() {
                     analogTriggers[id].sensorThreshold = triggerJson["sensorThreshold"];
                 }
 
+                // Hysteresis and dwell (0 = default band / no dwell)
+                analogTriggers[id].hysteresis = triggerJson["hysteresis"] | 0;
+                analogTriggers[id].sensorHysteresis = triggerJson["sensorHysteresis"] | 0.0f;
+                analogTriggers[id].minOnSec = triggerJson["minOnSec"] | 0;
+                analogTriggers[id].minOffSec = triggerJson["minOffSec"] | 0;
+
                 saveConfiguration();
                 response = "{\"status\":\"success\"}";
             }
@@ -104,6 +128,10 @@ void handleUpdateAnalogTriggers() {
                 analogTriggers[id].sensorTriggerType = 0;
                 analogTriggers[id].sensorCondition = 0;
                 analogTriggers[id].sensorThreshold = 25.0;
+                analogTriggers[id].hysteresis = 0;
+                analogTriggers[id].sensorHysteresis = 0.0f;
+                analogTriggers[id].minOnSec = 0;
+                analogTriggers[id].minOffSec = 0;
 
                 snprintf(analogTriggers[id].name, 32, "Trigger %d", id + 1);
 
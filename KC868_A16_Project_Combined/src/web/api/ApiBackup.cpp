@@ -0,0 +1,90 @@
+// ApiBackup.cpp
+// Full configuration export / import (see core/ConfigBackup.cpp)
+//
+//   GET  /api/backup[?secrets=1]    binary blob; secrets=1 includes the WiFi password
+//   POST /api/restore[?sections=schedules,triggers][&reboot=1]
+//        body: the blob as application/octet-stream, e.g.
+//        curl --data-binary @kc868.bin -H "Content-Type: application/octet-stream" http://<ip>/api/restore
+//
+// Sections: device, network, schedules, triggers, interrupts, ht_sensors, rf_codes, logic (default: all)
+
+#include "../../FunctionPrototypes.h"
+
+#define BACKUP_SEND_BUFFER 512
+
+// Collects the blob into HTTP body writes of a useful size
+class BackupSender : public Print {
+public:
+    BackupSender() : _len(0) {}
+    ~BackupSender() { flush(); }
+
+    size_t write(uint8_t b) override {
+        return write(&b, 1);
+    }
+
+    size_t write(const uint8_t* data, size_t len) override {
+        for (size_t i = 0; i < len; i++) {
+            if (_len == sizeof(_buf)) flush();
+            _buf[_len++] = data[i];
+        }
+        return len;
+    }
+
+    void flush() override {
+        if (_len == 0) return;
+        server.sendContent((const char*)_buf, _len);
+        _len = 0;
+    }
+
+private:
+    uint8_t _buf[BACKUP_SEND_BUFFER];
+    size_t _len;
+};
+
+void handleBackup() {
+    const bool secrets = server.arg("secrets") == "1";
+
+    server.sendHeader("Content-Disposition", "attachment; filename=\"kc868-config.bin\"");
+    server.sendHeader("Cache-Control", "no-store");
+    server.setContentLength(configBackupSize(secrets));
+    server.send(200, "application/octet-stream", "");
+
+    BackupSender out;
+    configBackupWrite(out, secrets);
+}
+
+void handleRestore() {
+    size_t len = 0;
+    const uint8_t* body = server.rawBody(len);
+    if (!body || len == 0) {
+        server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Send the backup as the request body\"}");
+        return;
+    }
+
+    const uint8_t mask = configBackupSectionMask(server.arg("sections"));
+    bool restartRequired = false;
+    String error;
+    if (!mask || !configRestore(body, len, mask, restartRequired, error)) {
+        PooledJsonDocument doc(256);
+        doc["status"] = "error";
+        doc["message"] = mask ? error : String("Unknown section name");
+
+        String response;
+        serializeJson(doc, response);
+        server.send(400, "application/json", response);
+        return;
+    }
+
+    const bool reboot = restartRequired && server.arg("reboot") == "1";
+    PooledJsonDocument doc(256);
+    doc["status"] = "success";
+    doc["restart_required"] = restartRequired && !reboot;
+    doc["rebooting"] = reboot;
+
+    String response;
+    serializeJson(doc, response);
+    server.send(200, "application/json", response);
+
+    broadcastUpdate();
+    if (reboot) scheduleRestart(1000);
+}
@@ -4,7 +4,7 @@
 #include "../../FunctionPrototypes.h"
 
 void handleCommunicationStatus() {
-    DynamicJsonDocument doc(1024);
+    PooledJsonDocument doc(1024);
 
     doc["usb_available"] = true;  // Serial is always available on ESP32
     doc["wifi_connected"] = wifiConnected;
@@ -49,7 +49,7 @@ void handleSetCommunication() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error) {
@@ -79,7 +79,7 @@ void handleSetCommunication() {
 }
 
 void handleCommunicationConfig() {
-    DynamicJsonDocument doc(2048);
+    PooledJsonDocument doc(2048);
 
     // Get protocol from query string
     String protocol = server.hasArg("protocol") ? server.arg("protocol") : currentCommunicationProtocol;
@@ -209,7 +209,7 @@ void handleUpdateCommunicationConfig() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(2048);
+        PooledJsonDocument doc(2048);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error && doc.containsKey("protocol")) {
@@ -4,7 +4,7 @@
 #include "../../FunctionPrototypes.h"
 
 void handleConfig() {
-    DynamicJsonDocument doc(1024);
+    PooledJsonDocument doc(1024);
 
     doc["device_name"] = deviceName;
     doc["dhcp_mode"] = dhcpMode;
@@ -30,7 +30,7 @@ void handleUpdateConfig() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error) {
@@ -94,8 +94,7 @@ void handleUpdateConfig() {
 
     // Restart if needed
     if (restartRequired) {
-        delay(1000);
-        ESP.restart();
+        scheduleRestart(1000);
     }
 }
 
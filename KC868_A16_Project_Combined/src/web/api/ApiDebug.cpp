@@ -2,25 +2,97 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../../FunctionPrototypes.h"
+#include "../../comm/BACnetDriver.h"
+#include "../JsonStreamWriter.h"
 
 void handleDebug() {
-    DynamicJsonDocument doc(4096);
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
 
-    doc["i2c_errors"] = i2cErrorCount;
-    doc["last_error"] = lastErrorMessage;
-    doc["uptime_ms"] = millis();
-    doc["free_heap"] = ESP.getFreeHeap();
-    doc["cpu_freq"] = ESP.getCpuFreqMHz();
-    doc["firmware_version"] = firmwareVersion;
+    json.field("i2c_errors", i2cErrorCount);
+    json.field("last_error", lastErrorMessage);
+    json.field("uptime_ms", millis());
+    json.field("free_heap", ESP.getFreeHeap());
+    json.field("cpu_freq", ESP.getCpuFreqMHz());
+    json.field("firmware_version", firmwareVersion);
 
     // Check internet connectivity
     time_t now;
     time(&now);
-    doc["internet_connected"] = (now > 1600000000);  // Reasonable timestamp indicates NTP sync worked
+    json.field("internet_connected", (now > (time_t)TIME_VALID_EPOCH));  // Reasonable timestamp indicates NTP sync worked
 
-    String response;
-    serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    // BACnet/IP service counters
+    const BACnetStats& bs = bacnetDriver.stats();
+    json.beginObject("bacnet");
+    json.field("running", bacnetDriver.isRunning());
+    json.field("rx_packets", bs.rxPackets);
+    json.field("rx_malformed", bs.rxMalformed);
+    json.field("rx_ignored", bs.rxIgnored);
+    json.field("who_is", bs.whoIs);
+    json.field("read_property", bs.readProperty);
+    json.field("write_property", bs.writeProperty);
+    json.field("read_range", bs.readRange);
+    json.field("unsupported", bs.unsupported);
+    json.field("errors_sent", bs.errorsSent);
+    json.field("tx_packets", bs.txPackets);
+    json.field("last_service_us", bs.lastServiceUs);
+    json.field("max_service_us", bs.maxServiceUs);
+    const uint32_t handled = bs.rxPackets - bs.rxMalformed;
+    json.field("avg_service_us", handled ? (uint32_t)(bs.totalServiceUs / handled) : (uint32_t)0);
+    json.endObject();
+
+    // Heap and task stacks (sampled every HEAP_SAMPLE_MS)
+    json.beginObject("heap");
+    json.field("free", heapStats.freeBytes);
+    json.field("min_free", heapStats.minFreeBytes);
+    json.field("largest_block", heapStats.largestBlock);
+    json.field("largest_block_min", heapStats.largestBlockMin);
+    json.field("fragmentation_pct", heapStats.fragmentationPct);
+    json.beginArray("tasks");
+    for (uint8_t i = 0; i < heapStats.taskCount; i++) {
+        json.beginObject();
+        json.field("name", heapStats.tasks[i].name);
+        json.field("stack_free", heapStats.tasks[i].stackFree);
+        json.field("stack_free_min", heapStats.tasks[i].stackFreeMin);
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+
+    // JSON document pool
+    const JsonPoolStats& jp = jsonPoolStats();
+    json.beginObject("json_pool");
+    json.field("leases", jp.leases);
+    json.field("exhausted", jp.exhausted);
+    json.field("in_use", jp.inUse);
+    json.field("in_use_max", jp.inUseMax);
+    json.endObject();
+
+    // Connectivity manager
+    const NetFailoverStats& fo = failoverStats();
+    json.beginObject("uplink");
+    json.field("active", uplinkName(activeUplink()));
+    json.field("wifi_standby", NET_WIFI_STANDBY != 0);
+    json.field("failovers", fo.count);
+    json.field("failover_last_ms", fo.lastMs);
+    json.field("failover_max_ms", fo.maxMs);
+    json.endObject();
+
+    // Network callback -> loop hand-off
+    json.beginObject("state_bus");
+    json.field("posted", stateBusPosted());
+    json.field("dropped", stateBusDropped());
+    json.endObject();
+
+    // HTTP server
+    json.beginObject("http");
+    json.field("connections", server.activeConnections());
+    json.field("requests", server.requestCount());
+    json.endObject();
+
+    json.endObject();
+    json.end();
 }
 
 void handleDebugCommand() {
@@ -28,14 +100,14 @@ void handleDebugCommand() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(512);
+        PooledJsonDocument doc(512);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error && doc.containsKey("command")) {
             String command = doc["command"].as<String>();
             String commandResponse = processCommand(command);
 
-            DynamicJsonDocument responseDoc(1024);
+            PooledJsonDocument responseDoc(1024);
             responseDoc["status"] = "success";
             responseDoc["response"] = commandResponse;
 
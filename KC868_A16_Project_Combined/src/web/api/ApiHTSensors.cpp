@@ -4,7 +4,7 @@
 #include "../../FunctionPrototypes.h"
 
 void handleHTSensors() {
-    DynamicJsonDocument doc(1024);
+    PooledJsonDocument doc(1024);
     JsonArray sensorsArray = doc.createNestedArray("htSensors");
 
     const char* sensorTypeNames[] = {
@@ -44,7 +44,7 @@ void handleUpdateHTSensor() {
         String body = server.arg("plain");
         debugPrintln("Received HT sensor update request: " + body); // Add debug output
 
-        DynamicJsonDocument doc(512);
+        PooledJsonDocument doc(512);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error && doc.containsKey("sensor")) {
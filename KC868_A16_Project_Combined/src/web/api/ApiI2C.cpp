@@ -2,17 +2,15 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
 
 void handleI2CScan() {
-    DynamicJsonDocument doc(1024);
+    PooledJsonDocument doc(1024);
     JsonArray devices = doc.createNestedArray("devices");
 
     // Scan I2C bus
     for (uint8_t address = 1; address < 127; address++) {
-        Wire.beginTransmission(address);
-        uint8_t error = Wire.endTransmission();
-
-        if (error == 0) {
+        if (i2cProbe(address)) {
             JsonObject device = devices.createNestedObject();
             device["address"] = "0x" + String(address, HEX);
 
@@ -29,7 +27,7 @@ void handleI2CScan() {
             else if (address == PCF8574_OUTPUTS_9_16) {
                 device["name"] = "PCF8574 Outputs 9-16";
             }
-            else if (address == 0x68) {
+            else if (address == RTC_I2C_ADDRESS) {
                 device["name"] = "DS3231 RTC";
             }
             else {
@@ -45,3 +43,37 @@ void handleI2CScan() {
     server.send(200, "application/json", response);
 }
 
+
+// GET /api/i2c/stats: bus manager clock, recoveries and per-address counters
+void handleGetI2CStats() {
+    const I2CBusStats& st = i2cBusStats();
+
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.field("clock_hz", (unsigned long)st.clockHz);
+    json.field("transactions", (unsigned long)st.transactions);
+    json.field("errors", (unsigned long)st.errors);
+    json.field("recoveries", (unsigned long)st.recoveries);
+    json.field("recovery_failures", (unsigned long)st.recoveryFailures);
+    json.field("clock_changes", (unsigned long)st.clockChanges);
+    json.field("deferred", (unsigned long)st.deferred);
+
+    json.beginArray("devices");
+    for (uint8_t i = 0; i < i2cDeviceCount(); i++) {
+        const I2CDeviceStats* d = i2cDeviceStats(i);
+        json.beginObject();
+        json.field("address", "0x" + String(d->address, HEX));
+        json.field("transactions", (unsigned long)d->transactions);
+        json.field("errors", (unsigned long)d->errors);
+        json.field("last_error", d->lastError);
+        json.field("last_us", (unsigned long)d->lastUs);
+        json.field("max_us", (unsigned long)d->maxUs);
+        json.field("avg_us", (unsigned long)(d->transactions ? d->totalUs / d->transactions : 0));
+        json.endObject();
+    }
+    json.endArray();
+
+    json.endObject();
+    json.end();
+}
@@ -4,7 +4,7 @@
 #include "../../FunctionPrototypes.h"
 
 void handleInterrupts() {
-    DynamicJsonDocument doc(4096);
+    PooledJsonDocument doc(4096);
     JsonArray interruptsArray = doc.createNestedArray("interrupts");
 
     for (int i = 0; i < 16; i++) {
@@ -27,7 +27,7 @@ void handleUpdateInterrupts() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error && doc.containsKey("interrupt")) {
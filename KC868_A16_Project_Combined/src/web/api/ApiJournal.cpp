@@ -0,0 +1,102 @@
+// ApiJournal.cpp
+// Flash event journal (see services/EventLog.cpp)
+//
+//   GET /api/journal                   the newest records
+//   GET /api/journal?since=1767225600  from the first record at or after a unix time
+//   GET /api/journal?seq=1200          from a sequence number
+//       &limit=n                       at most n records (EVENT_QUERY_MAX)
+//
+// Records come oldest first. "next" is the seq to ask for to continue.
+// A record logged before either clock knew the time has "time": null and is
+// never matched by since.
+// /api/events is the live Server-Sent Events stream (web/EventStream.cpp).
+
+#include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
+#include <memory>
+
+#define JOURNAL_PUMP_RECORDS 8  // records written per call of the HTTP pump
+
+// One /api/journal response, written a few records at a time from the loop
+struct JournalQuery {
+    JournalQuery() : json(server), seq(0), newest(0), limit(0), sent(0), any(false) {}
+
+    JsonStreamWriter json;
+    uint32_t seq;
+    uint32_t newest;
+    uint32_t limit;
+    uint32_t sent;
+    bool any;
+};
+
+static void endJournal(JournalQuery& q) {
+    JsonStreamWriter& json = q.json;
+    const EventLogStats& st = eventLogStats();
+
+    json.endArray();
+    json.field("next", (unsigned long)(q.any ? q.seq : 0));
+
+    json.beginObject("stats");
+    json.field("sectors", eventLogSectors());
+    json.field("logged", (unsigned long)st.logged);
+    json.field("dropped", (unsigned long)st.dropped);
+    json.field("write_errors", (unsigned long)st.writeErrors);
+    json.field("sectors_erased", (unsigned long)st.sectorsErased);
+    json.field("max_erase_count", (unsigned long)st.maxEraseCount);
+    json.endObject();
+
+    json.endObject();
+    json.end();
+}
+
+static bool pumpJournal(JournalQuery& q) {
+    JsonStreamWriter& json = q.json;
+    EventRecord r;
+    for (uint8_t n = 0; n < JOURNAL_PUMP_RECORDS; n++) {
+        if (!q.any || q.seq > q.newest || q.sent >= q.limit) {
+            endJournal(q);
+            return false;
+        }
+        if (!readEvent(q.seq++, r)) continue;   // torn write or overwritten meanwhile
+        json.beginObject();
+        json.field("seq", (unsigned long)r.seq);
+        if (r.time != TIME_INVALID) json.field("time", (unsigned long)r.time);
+        else json.field("time", (const char*)nullptr);
+        json.field("type", eventTypeName(r.type));
+        if (r.type == EVENT_OUTPUT) json.field("source", outputSourceName(r.source));
+        json.field("subject", r.subject);
+        json.field("value", r.value);
+        json.field("arg", r.arg);
+        json.endObject();
+        q.sent++;
+    }
+    return true;
+}
+
+void handleGetJournal() {
+    std::shared_ptr<JournalQuery> q(new JournalQuery());
+
+    q->limit = EVENT_QUERY_MAX;
+    if (server.hasArg("limit")) q->limit = constrain(server.arg("limit").toInt(), 1L, (long)EVENT_QUERY_MAX);
+
+    uint32_t oldest = 0;
+    q->any = eventLogRange(oldest, q->newest);
+
+    q->seq = oldest;
+    if (q->any) {
+        if (server.hasArg("seq")) q->seq = max((uint32_t)strtoul(server.arg("seq").c_str(), nullptr, 10), oldest);
+        else if (server.hasArg("since")) q->seq = findEventSeq((uint32_t)strtoul(server.arg("since").c_str(), nullptr, 10));
+        else if (q->newest - oldest + 1 > q->limit) q->seq = q->newest - q->limit + 1;
+    }
+
+    JsonStreamWriter& json = q->json;
+    json.begin();
+    json.beginObject();
+    json.field("available", eventLogAvailable());
+    json.field("oldest", (unsigned long)(q->any ? oldest : 0));
+    json.field("newest", (unsigned long)(q->any ? q->newest : 0));
+    json.beginArray("events");
+
+    // Up to EVENT_QUERY_MAX records: the rest goes out as the client reads it
+    server.pumpContent([q]() { return pumpJournal(*q); });
+}
@@ -0,0 +1,122 @@
+// ApiLogic.cpp
+// Logic program and virtual points (see services/LogicEngine.cpp)
+//
+//   GET  /api/logic   program text, run state, M bits, R registers, timers,
+//                     counters and scan statistics
+//   POST /api/logic   {"program":["LD I0","TON T0 50","ST Q0"]}   replace and save
+//                     {"running":true}
+//                     {"bit":{"index":n,"value":true}}
+//                     {"reg":{"index":n,"value":123}}
+//
+// A program with any bad line is rejected as a whole; the error names the line.
+
+#include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
+
+void handleGetLogic() {
+    const LogicStats& st = logicStats();
+    const LogicInstr* prog = logicProgram();
+
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.field("running", logicRunning());
+    json.field("scan_ms", LOGIC_SCAN_MS);
+
+    json.beginArray("program");
+    for (uint8_t i = 0; i < logicProgramLength(); i++) json.value(disassembleLogic(prog[i]));
+    json.endArray();
+
+    char bitText[LOGIC_BITS + 1];
+    for (uint8_t i = 0; i < LOGIC_BITS; i++) bitText[i] = logicBit(i) ? '1' : '0';
+    bitText[LOGIC_BITS] = '\0';
+    json.field("bits", (const char*)bitText);
+
+    json.beginArray("registers");
+    for (uint8_t i = 0; i < LOGIC_REGS; i++) json.value((int)logicReg(i));
+    json.endArray();
+
+    json.beginArray("timers");
+    for (uint8_t i = 0; i < LOGIC_TIMERS; i++) json.value(logicTimerOutput(i));
+    json.endArray();
+
+    json.beginArray("counters");
+    for (uint8_t i = 0; i < LOGIC_COUNTERS; i++) json.value((int)logicCounterValue(i));
+    json.endArray();
+
+    json.beginObject("stats");
+    json.field("scans", (unsigned long)st.scans);
+    json.field("last_us", (unsigned long)st.lastUs);
+    json.field("max_us", (unsigned long)st.maxUs);
+    json.field("late_max_ms", (unsigned long)st.lateMaxMs);
+    json.field("overruns", (unsigned long)st.overruns);
+    json.endObject();
+
+    json.endObject();
+    json.end();
+}
+
+static String assembleLogicProgram(JsonArray lines) {
+    if (lines.size() > LOGIC_MAX_INSTR) {
+        return "program longer than " + String(LOGIC_MAX_INSTR) + " steps";
+    }
+
+    LogicInstr prog[LOGIC_MAX_INSTR];
+    uint8_t count = 0;
+    String error;
+    for (JsonVariant line : lines) {
+        if (!assembleLogicLine(line.as<String>(), prog[count], error)) {
+            return "line " + String(count + 1) + ": " + error;
+        }
+        count++;
+    }
+
+    if (!installLogicProgram(prog, count, error)) return error;
+    saveLogicProgram();
+    return "";
+}
+
+void handleSetLogic() {
+    String response = "{\"status\":\"error\",\"message\":\"Invalid request\"}";
+
+    if (server.hasArg("plain")) {
+        // A full program is up to LOGIC_MAX_INSTR short strings
+        PooledJsonDocument doc(6144);
+        DeserializationError error = deserializeJson(doc, server.arg("plain"));
+
+        if (!error && doc.containsKey("program")) {
+            const String message = assembleLogicProgram(doc["program"].as<JsonArray>());
+            if (message.length() == 0) {
+                response = "{\"status\":\"success\",\"steps\":" + String(logicProgramLength()) + "}";
+            }
+            else {
+                PooledJsonDocument reply(256);
+                reply["status"] = "error";
+                reply["message"] = message;
+                response = "";
+                serializeJson(reply, response);
+            }
+        }
+        else if (!error && doc.containsKey("running")) {
+            setLogicRunning(doc["running"].as<bool>() && logicProgramLength() > 0);
+            saveLogicProgram();
+            response = "{\"status\":\"success\",\"running\":" + String(logicRunning() ? "true" : "false") + "}";
+        }
+        else if (!error && doc.containsKey("bit")) {
+            const int index = doc["bit"]["index"] | -1;
+            if (index >= 0 && index < LOGIC_BITS) {
+                setLogicBit(index, doc["bit"]["value"].as<bool>());
+                response = "{\"status\":\"success\"}";
+            }
+        }
+        else if (!error && doc.containsKey("reg")) {
+            const int index = doc["reg"]["index"] | -1;
+            if (index >= 0 && index < LOGIC_REGS) {
+                setLogicReg(index, (int16_t)constrain(doc["reg"]["value"].as<long>(), -32768L, 32767L));
+                response = "{\"status\":\"success\"}";
+            }
+        }
+    }
+
+    server.send(200, "application/json", response);
+}
@@ -0,0 +1,447 @@
+// ApiMetrics.cpp
+// Prometheus text exposition (format 0.0.4) at /metrics
+//
+// Metric families live in a static table; each one reads globals/counters and
+// formats its samples into a fixed buffer that is flushed as HTTP chunks, so a
+// scrape allocates no document and no per-sample Strings. The families are
+// pumped one at a time (HttpServer::pumpContent), so a slow scraper never
+// makes the server buffer the whole exposition.
+
+#include "../../FunctionPrototypes.h"
+#include "../../comm/BACnetDriver.h"
+#include "../../comm/ModbusRtuManager.h"
+#include <memory>
+#include <stdarg.h>
+
+#define METRICS_BUFFER 512
+
+class MetricsWriter {
+public:
+    MetricsWriter() : _len(0) {}
+    ~MetricsWriter() { flush(); }
+
+    void family(const char* name, const char* type, const char* help) {
+        append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+    }
+
+    void sample(const char* name, const char* labels, uint64_t value) {
+        if (labels) append("%s{%s} %llu\n", name, labels, (unsigned long long)value);
+        else append("%s %llu\n", name, (unsigned long long)value);
+    }
+
+    void sample(const char* name, const char* labels, double value) {
+        if (labels) append("%s{%s} %.6g\n", name, labels, value);
+        else append("%s %.6g\n", name, value);
+    }
+
+    void flush() {
+        if (_len == 0) return;
+        server.sendContent(_buf, _len);
+        _len = 0;
+    }
+
+private:
+    char _buf[METRICS_BUFFER];
+    size_t _len;
+
+    void append(const char* fmt, ...) {
+        char line[160];
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(line, sizeof(line), fmt, args);
+        va_end(args);
+        if (n <= 0) return;
+        n = min(n, (int)sizeof(line) - 1);
+
+        if (_len + n > sizeof(_buf)) flush();
+        memcpy(_buf + _len, line, n);
+        _len += n;
+    }
+};
+
+typedef void (*MetricEmitter)(MetricsWriter& w, const char* name);
+
+struct MetricFamily {
+    const char* name;
+    const char* type;
+    const char* help;
+    MetricEmitter emit;
+};
+
+// ---- Emitters ----
+
+static void emitUptime(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)(millis() / 1000));
+}
+
+static void emitHeapFree(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)ESP.getFreeHeap());
+}
+
+static void emitHeapMinFree(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)ESP.getMinFreeHeap());
+}
+
+static void emitHeapLargest(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)ESP.getMaxAllocHeap());
+}
+
+static void emitHeapLargestMin(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)heapStats.largestBlockMin);
+}
+
+static void emitHeapFragmentation(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)heapStats.fragmentationPct);
+}
+
+static void emitTaskStackFree(MetricsWriter& w, const char* name) {
+    char label[32];
+    for (uint8_t i = 0; i < heapStats.taskCount; i++) {
+        snprintf(label, sizeof(label), "task=\"%s\"", heapStats.tasks[i].name);
+        w.sample(name, label, (uint64_t)heapStats.tasks[i].stackFreeMin);
+    }
+}
+
+static void emitJsonPoolLeases(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)jsonPoolStats().leases);
+}
+
+static void emitJsonPoolExhausted(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)jsonPoolStats().exhausted);
+}
+
+static void emitJsonPoolInUseMax(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)jsonPoolStats().inUseMax);
+}
+
+static void emitLoopCount(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)metrics.loopCount);
+}
+
+static void emitLoopTotal(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, metrics.loopTotalUs / 1e6);
+}
+
+static void emitLoopLast(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)metrics.loopLastUs);
+}
+
+static void emitLoopMax(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)metrics.loopMaxUs);
+}
+
+static void emitI2cErrors(MetricsWriter& w, const char* name) {
+    static const char* const labels[] = {
+        "expander=\"inputs_1_8\",address=\"0x22\"",
+        "expander=\"inputs_9_16\",address=\"0x21\"",
+        "expander=\"outputs_9_16\",address=\"0x25\"",
+        "expander=\"outputs_1_8\",address=\"0x24\"",
+    };
+    for (int i = 0; i < 4; i++) w.sample(name, labels[i], (uint64_t)metrics.i2cErrors[i]);
+}
+
+static void emitI2cDeviceTransactions(MetricsWriter& w, const char* name) {
+    char label[24];
+    for (uint8_t i = 0; i < i2cDeviceCount(); i++) {
+        const I2CDeviceStats* d = i2cDeviceStats(i);
+        snprintf(label, sizeof(label), "address=\"0x%02x\"", d->address);
+        w.sample(name, label, (uint64_t)d->transactions);
+    }
+}
+
+static void emitI2cDeviceErrors(MetricsWriter& w, const char* name) {
+    char label[24];
+    for (uint8_t i = 0; i < i2cDeviceCount(); i++) {
+        const I2CDeviceStats* d = i2cDeviceStats(i);
+        snprintf(label, sizeof(label), "address=\"0x%02x\"", d->address);
+        w.sample(name, label, (uint64_t)d->errors);
+    }
+}
+
+static void emitI2cDeviceLatencyMax(MetricsWriter& w, const char* name) {
+    char label[24];
+    for (uint8_t i = 0; i < i2cDeviceCount(); i++) {
+        const I2CDeviceStats* d = i2cDeviceStats(i);
+        snprintf(label, sizeof(label), "address=\"0x%02x\"", d->address);
+        w.sample(name, label, (uint64_t)d->maxUs);
+    }
+}
+
+static void emitI2cRecoveries(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)i2cBusStats().recoveries);
+}
+
+static void emitI2cClock(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)i2cBusStats().clockHz);
+}
+
+static void emitInputEdges(MetricsWriter& w, const char* name) {
+    char label[24];
+    for (int i = 0; i < 19; i++) {
+        if (i < 16) snprintf(label, sizeof(label), "input=\"%d\"", i + 1);
+        else snprintf(label, sizeof(label), "input=\"HT%d\"", i - 15);
+        w.sample(name, label, (uint64_t)metrics.inputEdges[i]);
+    }
+}
+
+static void emitOutputState(MetricsWriter& w, const char* name) {
+    char label[16];
+    for (int i = 0; i < 16; i++) {
+        snprintf(label, sizeof(label), "output=\"%d\"", i + 1);
+        w.sample(name, label, (uint64_t)(outputStates[i] ? 1 : 0));
+    }
+}
+
+static void emitOutputCommands(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)outputStats().commands);
+}
+
+static void emitOutputChanges(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)outputStats().changes);
+}
+
+static void emitOutputWrites(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)outputStats().writes);
+}
+
+static void emitOutputWriteErrors(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)outputStats().writeErrors);
+}
+
+static void emitEventsLogged(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)eventLogStats().logged);
+}
+
+static void emitEventsDropped(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)eventLogStats().dropped);
+}
+
+static void emitEventSectorWear(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)eventLogStats().maxEraseCount);
+}
+
+static void emitModbusRequests(MetricsWriter& w, const char* name) {
+    // Function codes the slave map serves; anything else is reported as "other"
+    static const uint8_t codes[] = { 1, 2, 3, 4, 5, 6, 15, 16 };
+    char label[24];
+    for (uint8_t fc : codes) {
+        snprintf(label, sizeof(label), "function=\"%u\"", fc);
+        w.sample(name, label, (uint64_t)metrics.modbusRequests[fc]);
+    }
+    uint32_t other = metrics.modbusRequests[0];
+    for (int fc = 7; fc <= 14; fc++) other += metrics.modbusRequests[fc];
+    w.sample(name, "function=\"other\"", (uint64_t)other);
+}
+
+static void emitModbusExceptions(MetricsWriter& w, const char* name) {
+    uint32_t total = 0;
+    for (uint32_t n : metrics.modbusRequests) total += n;
+    w.sample(name, nullptr, (uint64_t)(total - min(total, metrics.modbusSuccess)));
+}
+
+static void emitModbusRunning(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)(isModbusRtuRunning() ? 1 : 0));
+}
+
+static void emitRs485Frames(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)metrics.rs485Frames);
+}
+
+static void emitRs485FrameErrors(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)metrics.rs485FrameErrors);
+}
+
+static void emitTriggerEdges(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)metrics.triggerEdges);
+}
+
+static void emitBacnetPackets(MetricsWriter& w, const char* name) {
+    const BACnetStats& bs = bacnetDriver.stats();
+    w.sample(name, "direction=\"rx\"", (uint64_t)bs.rxPackets);
+    w.sample(name, "direction=\"tx\"", (uint64_t)bs.txPackets);
+}
+
+static void emitBacnetMalformed(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)bacnetDriver.stats().rxMalformed);
+}
+
+static void emitBacnetIgnored(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)bacnetDriver.stats().rxIgnored);
+}
+
+static void emitBacnetRequests(MetricsWriter& w, const char* name) {
+    const BACnetStats& bs = bacnetDriver.stats();
+    w.sample(name, "service=\"who_is\"", (uint64_t)bs.whoIs);
+    w.sample(name, "service=\"read_property\"", (uint64_t)bs.readProperty);
+    w.sample(name, "service=\"write_property\"", (uint64_t)bs.writeProperty);
+    w.sample(name, "service=\"read_range\"", (uint64_t)bs.readRange);
+    w.sample(name, "service=\"unsupported\"", (uint64_t)bs.unsupported);
+}
+
+static void emitBacnetErrors(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)bacnetDriver.stats().errorsSent);
+}
+
+static void emitBacnetServiceMax(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)bacnetDriver.stats().maxServiceUs);
+}
+
+static void emitWsClients(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)webSocket.connectedClients());
+}
+
+static void emitWsMessages(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)metrics.wsMessagesSent);
+}
+
+static void emitWsBytes(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, metrics.wsBytesSent);
+}
+
+static void emitHttpConnections(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)server.activeConnections());
+}
+
+static void emitHttpRequests(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)server.requestCount());
+}
+
+static void emitNetUplink(MetricsWriter& w, const char* name) {
+    static const uint8_t uplinks[] = { UPLINK_ETH, UPLINK_WIFI, UPLINK_AP };
+    char label[32];
+    for (uint8_t u : uplinks) {
+        snprintf(label, sizeof(label), "interface=\"%s\"", uplinkName(u));
+        w.sample(name, label, (uint64_t)(activeUplink() == u ? 1 : 0));
+    }
+}
+
+static void emitNetFailovers(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)failoverStats().count);
+}
+
+static void emitNetFailoverLast(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)failoverStats().lastMs);
+}
+
+static void emitNetFailoverMax(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)failoverStats().maxMs);
+}
+
+static void emitRfPresses(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)rfStats().received);
+}
+
+static void emitRfRepeats(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)rfStats().repeats);
+}
+
+static void emitRfUnknown(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)rfStats().unknown);
+}
+
+static void emitRfTransmitted(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)rfStats().transmitted);
+}
+
+static void emitLogicScans(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)logicStats().scans);
+}
+
+static void emitLogicScanLast(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)logicStats().lastUs);
+}
+
+static void emitLogicScanMax(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)logicStats().maxUs);
+}
+
+static void emitLogicOverruns(MetricsWriter& w, const char* name) {
+    w.sample(name, nullptr, (uint64_t)logicStats().overruns);
+}
+
+// ---- Registry ----
+
+static const MetricFamily metricFamilies[] = {
+    { "kc868_uptime_seconds", "gauge", "Seconds since boot", emitUptime },
+    { "kc868_heap_free_bytes", "gauge", "Free heap", emitHeapFree },
+    { "kc868_heap_min_free_bytes", "gauge", "Lowest free heap since boot", emitHeapMinFree },
+    { "kc868_heap_largest_block_bytes", "gauge", "Largest allocatable heap block", emitHeapLargest },
+    { "kc868_heap_largest_block_min_bytes", "gauge", "Smallest sampled largest heap block since boot", emitHeapLargestMin },
+    { "kc868_heap_fragmentation_percent", "gauge", "Free heap not usable as one block", emitHeapFragmentation },
+    { "kc868_task_stack_free_min_bytes", "gauge", "Task stack high-water mark (bytes never used)", emitTaskStackFree },
+    { "kc868_json_pool_leases_total", "counter", "JSON documents allocated", emitJsonPoolLeases },
+    { "kc868_json_pool_exhausted_total", "counter", "JSON documents that fell back to the heap", emitJsonPoolExhausted },
+    { "kc868_json_pool_in_use_max", "gauge", "Most pooled JSON documents leased at once", emitJsonPoolInUseMax },
+    { "kc868_loop_iterations_total", "counter", "Main loop iterations", emitLoopCount },
+    { "kc868_loop_seconds_total", "counter", "Time spent in main loop iterations", emitLoopTotal },
+    { "kc868_loop_period_last_us", "gauge", "Duration of the last main loop iteration", emitLoopLast },
+    { "kc868_loop_period_max_us", "gauge", "Longest main loop iteration since boot", emitLoopMax },
+    { "kc868_i2c_errors_total", "counter", "I2C transfer errors per PCF8574 expander", emitI2cErrors },
+    { "kc868_i2c_transactions_total", "counter", "I2C transactions per device address", emitI2cDeviceTransactions },
+    { "kc868_i2c_device_errors_total", "counter", "Failed I2C transactions per device address", emitI2cDeviceErrors },
+    { "kc868_i2c_latency_max_us", "gauge", "Slowest I2C transaction per device address", emitI2cDeviceLatencyMax },
+    { "kc868_i2c_recoveries_total", "counter", "I2C bus clears after a stuck line or timeout", emitI2cRecoveries },
+    { "kc868_i2c_clock_hz", "gauge", "Current I2C bus clock", emitI2cClock },
+    { "kc868_input_edges_total", "counter", "State changes seen per digital input", emitInputEdges },
+    { "kc868_output_state", "gauge", "Relay output state (1 = on)", emitOutputState },
+    { "kc868_output_commands_total", "counter", "Output priority slot writes and releases", emitOutputCommands },
+    { "kc868_output_changes_total", "counter", "Output state changes journaled", emitOutputChanges },
+    { "kc868_output_writes_total", "counter", "Output expander bank writes", emitOutputWrites },
+    { "kc868_output_write_errors_total", "counter", "Output expander bank writes that failed", emitOutputWriteErrors },
+    { "kc868_events_logged_total", "counter", "Event journal records written to flash", emitEventsLogged },
+    { "kc868_events_dropped_total", "counter", "Event journal records lost to a full queue", emitEventsDropped },
+    { "kc868_event_sector_erase_max", "gauge", "Erase count of the most-worn event journal sector", emitEventSectorWear },
+    { "kc868_modbus_requests_total", "counter", "Modbus RTU requests addressed to this slave", emitModbusRequests },
+    { "kc868_modbus_exceptions_total", "counter", "Modbus RTU requests answered with an exception", emitModbusExceptions },
+    { "kc868_modbus_running", "gauge", "Modbus RTU slave active", emitModbusRunning },
+    { "kc868_rs485_frames_total", "counter", "Binary RS485 frames handled", emitRs485Frames },
+    { "kc868_rs485_frame_errors_total", "counter", "Binary RS485 frames dropped (CRC, length, timeout)", emitRs485FrameErrors },
+    { "kc868_trigger_edges_total", "counter", "Analog trigger / sensor schedule state changes", emitTriggerEdges },
+    { "kc868_bacnet_packets_total", "counter", "BACnet/IP packets", emitBacnetPackets },
+    { "kc868_bacnet_malformed_total", "counter", "BACnet/IP packets rejected as malformed", emitBacnetMalformed },
+    { "kc868_bacnet_ignored_total", "counter", "Well-formed BACnet/IP packets not meant for this device", emitBacnetIgnored },
+    { "kc868_bacnet_requests_total", "counter", "BACnet requests by service", emitBacnetRequests },
+    { "kc868_bacnet_errors_sent_total", "counter", "BACnet error/reject replies sent", emitBacnetErrors },
+    { "kc868_bacnet_service_max_us", "gauge", "Slowest BACnet request handling since boot", emitBacnetServiceMax },
+    { "kc868_ws_clients", "gauge", "Connected WebSocket clients", emitWsClients },
+    { "kc868_ws_messages_sent_total", "counter", "WebSocket messages sent", emitWsMessages },
+    { "kc868_ws_bytes_sent_total", "counter", "WebSocket payload bytes sent", emitWsBytes },
+    { "kc868_http_connections", "gauge", "Open HTTP connections", emitHttpConnections },
+    { "kc868_http_requests_total", "counter", "HTTP requests handled", emitHttpRequests },
+    { "kc868_net_uplink", "gauge", "Interface carrying the traffic (1 = active)", emitNetUplink },
+    { "kc868_net_failovers_total", "counter", "Uplink failovers completed", emitNetFailovers },
+    { "kc868_net_failover_last_ms", "gauge", "Uplink loss to services re-bound, last failover", emitNetFailoverLast },
+    { "kc868_net_failover_max_ms", "gauge", "Slowest failover since boot", emitNetFailoverMax },
+    { "kc868_rf_presses_total", "counter", "433 MHz remote presses received", emitRfPresses },
+    { "kc868_rf_repeats_suppressed_total", "counter", "Repeat RF frames of a press ignored", emitRfRepeats },
+    { "kc868_rf_unknown_total", "counter", "RF presses with no learned code", emitRfUnknown },
+    { "kc868_rf_transmitted_total", "counter", "RF codes queued for transmission", emitRfTransmitted },
+    { "kc868_logic_scans_total", "counter", "Logic program scans run", emitLogicScans },
+    { "kc868_logic_scan_last_us", "gauge", "Duration of the last logic scan", emitLogicScanLast },
+    { "kc868_logic_scan_max_us", "gauge", "Longest logic scan since boot", emitLogicScanMax },
+    { "kc868_logic_overruns_total", "counter", "Logic scan periods missed", emitLogicOverruns },
+};
+
+static const size_t METRIC_FAMILY_COUNT = sizeof(metricFamilies) / sizeof(metricFamilies[0]);
+
+// One scrape; the HTTP pump takes a family per call
+struct MetricsScrape {
+    MetricsScrape() : next(0) {}
+    MetricsWriter w;
+    size_t next;
+};
+
+void handleMetrics() {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/plain; version=0.0.4; charset=utf-8", "");
+
+    std::shared_ptr<MetricsScrape> scrape(new MetricsScrape());
+    server.pumpContent([scrape]() {
+        const MetricFamily& f = metricFamilies[scrape->next++];
+        scrape->w.family(f.name, f.type, f.help);
+        f.emit(scrape->w, f.name);
+        if (scrape->next < METRIC_FAMILY_COUNT) return true;
+        scrape->w.flush();
+        return false;
+    });
+}
@@ -3,6 +3,7 @@
 
 #include "../../FunctionPrototypes.h"
 #include "esp_mac.h"
+#include "../../comm/BACnetDriver.h"
 
 
 static String macBytesToString(const uint8_t m[6]) {
@@ -21,7 +22,7 @@ static String readMacString(esp_mac_type_t type, const char* fallbackStr) {
 }
 
 void handleNetworkSettings() {
-    DynamicJsonDocument doc(2048);
+    PooledJsonDocument doc(2048);
 
     // -----------------------------
     // Persisted configuration
@@ -45,6 +46,11 @@ void handleNetworkSettings() {
     doc["http_port"] = httpPort;
     doc["ws_port"] = wsPort;
 
+    doc["bacnet_fd_enabled"] = bacnetFdEnabled;
+    doc["bacnet_bbmd_ip"] = bacnetBbmdIp.toString();
+    doc["bacnet_bbmd_port"] = bacnetBbmdPort;
+    doc["bacnet_fd_ttl"] = bacnetFdTtl;
+
     // -----------------------------
     // Live status
     // -----------------------------
@@ -76,6 +82,9 @@ if (ETH.linkUp()) {
         doc["eth_dns2"] = "0.0.0.0";
     }
 
+    doc["bacnet_fd_registered"] = bacnetDriver.isForeignDeviceRegistered();
+    doc["bacnet_broadcast"] = bacnetDriver.isRunning() ? bacnetDriver.getBroadcastAddress().toString() : String("0.0.0.0");
+
     doc["wifi_connected"] = wifiConnected;
     doc["wifi_client_mode"] = wifiClientMode;
     doc["wifi_ap_mode"] = apMode;
@@ -109,7 +118,7 @@ if (wifiClientMode) {
 }
 
 void handleUpdateNetworkSettings() {
-    DynamicJsonDocument resp(512);
+    PooledJsonDocument resp(512);
     resp["status"] = "error";
     resp["message"] = "Invalid request";
 
@@ -124,7 +133,7 @@ void handleUpdateNetworkSettings() {
         return;
     }
 
-    DynamicJsonDocument doc(2048);
+    PooledJsonDocument doc(2048);
     DeserializationError error = deserializeJson(doc, server.arg("plain"));
     if (error) {
         resp["message"] = "JSON parse error";
@@ -251,6 +260,45 @@ void handleUpdateNetworkSettings() {
         }
     }
 
+    // -----------------------------
+    // BACnet foreign-device registration (applied live, no restart)
+    // -----------------------------
+    bool fdChanged = false;
+    if (doc.containsKey("bacnet_fd_enabled")) {
+        bool en = doc["bacnet_fd_enabled"].as<bool>();
+        if (en != bacnetFdEnabled) {
+            bacnetFdEnabled = en;
+            fdChanged = true;
+        }
+    }
+    if (doc.containsKey("bacnet_bbmd_ip")) {
+        String s = doc["bacnet_bbmd_ip"].as<String>();
+        IPAddress bbmd;
+        if (s.length() > 0 && bbmd.fromString(s) && bbmd != bacnetBbmdIp) {
+            bacnetBbmdIp = bbmd;
+            fdChanged = true;
+        }
+    }
+    if (doc.containsKey("bacnet_bbmd_port")) {
+        int p = doc["bacnet_bbmd_port"].as<int>();
+        if (p >= 1 && p <= 65535 && p != bacnetBbmdPort) {
+            bacnetBbmdPort = (uint16_t)p;
+            fdChanged = true;
+        }
+    }
+    if (doc.containsKey("bacnet_fd_ttl")) {
+        int t = doc["bacnet_fd_ttl"].as<int>();
+        if (t >= BACNET_FD_MIN_TTL_S && t <= 65535 && t != bacnetFdTtl) {
+            bacnetFdTtl = (uint16_t)t;
+            fdChanged = true;
+        }
+    }
+    if (fdChanged) {
+        bacnetDriver.setForeignDevice(bacnetFdEnabled ? bacnetBbmdIp : IPAddress((uint32_t)0),
+                                      bacnetBbmdPort, bacnetFdTtl);
+        changed = true;
+    }
+
     if (changed) {
         saveNetworkSettings();
         resp["status"] = "success";
@@ -278,8 +326,7 @@ void handleUpdateNetworkSettings() {
     server.send(200, "application/json", out);
 
     if (restartRequired) {
-        delay(1000);
-        ESP.restart();
+        scheduleRestart(1000);
     }
 }
 
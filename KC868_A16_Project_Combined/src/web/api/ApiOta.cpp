@@ -0,0 +1,93 @@
+// ApiOta.cpp
+// Firmware / filesystem update endpoints (see services/OtaService.cpp)
+//
+//   POST /api/ota/begin   {"target":"app"|"fs", "size":N, "sha256":"<hex>"}
+//   POST /api/ota/chunk?offset=N   multipart file, any size, at the current offset
+//   GET  /api/ota/status  -> "received" is where to resume after a dropped transfer
+//   POST /api/ota/finish  {"reboot":true}
+//   POST /api/ota/abort
+
+#include "../../FunctionPrototypes.h"
+
+static bool chunkAccepted = false;
+static bool chunkMisplaced = false;     // offset did not match what has been received
+static uint32_t chunkOffset = 0;
+
+static void sendOtaStatus(int code) {
+    PooledJsonDocument doc(512);
+    doc["status"] = (code == 200) ? "success" : "error";
+    otaStatusJson(doc);
+
+    String response;
+    serializeJson(doc, response);
+    server.send(code, "application/json", response);
+}
+
+void handleOtaStatus() {
+    sendOtaStatus(200);
+}
+
+void handleOtaBegin() {
+    PooledJsonDocument doc(256);
+    if (!server.hasArg("plain") || deserializeJson(doc, server.arg("plain"))) {
+        server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+        return;
+    }
+
+    const String target = doc["target"] | "app";
+    if (target != "app" && target != "fs") {
+        server.send(400, "application/json", "{\"status\":\"error\",\"message\":\"target must be app or fs\"}");
+        return;
+    }
+
+    const bool ok = otaBegin(target == "app" ? OTA_TARGET_APP : OTA_TARGET_FS,
+                             doc["size"] | 0UL, doc["sha256"] | "");
+    sendOtaStatus(ok ? 200 : 400);
+}
+
+// Upload pieces are written as they arrive; the loop keeps running in between
+void handleOtaChunkUpload() {
+    HTTPUpload& upload = server.upload();
+
+    if (upload.status == UPLOAD_FILE_START) {
+        chunkOffset = strtoul(server.arg("offset").c_str(), nullptr, 10);
+        chunkMisplaced = (chunkOffset != otaReceived());
+        chunkAccepted = !chunkMisplaced;
+    }
+    else if (upload.status == UPLOAD_FILE_WRITE) {
+        if (chunkAccepted) {
+            chunkAccepted = otaWrite(chunkOffset, upload.buf, upload.currentSize);
+            chunkOffset += upload.currentSize;
+        }
+    }
+    // UPLOAD_FILE_ABORTED: whatever was written stays; the client resumes from "received"
+}
+
+void handleOtaChunk() {
+    // 409 tells the client to continue from "received" instead
+    const int code = chunkMisplaced ? 409 : (chunkAccepted ? 200 : 400);
+    chunkAccepted = false;
+    chunkMisplaced = false;
+    sendOtaStatus(code);
+}
+
+void handleOtaFinish() {
+    bool reboot = false;
+    if (server.hasArg("plain")) {
+        PooledJsonDocument doc(128);
+        if (!deserializeJson(doc, server.arg("plain"))) reboot = doc["reboot"] | false;
+    }
+
+    if (!otaFinish()) {
+        sendOtaStatus(400);
+        return;
+    }
+
+    sendOtaStatus(200);
+    if (reboot) scheduleRestart(1000);
+}
+
+void handleOtaAbort() {
+    otaAbort();
+    sendOtaStatus(200);
+}
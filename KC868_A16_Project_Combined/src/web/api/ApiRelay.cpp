@@ -2,6 +2,7 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
 
 void handleRelayControl() {
     String response = "{\"status\":\"error\",\"message\":\"Invalid request\"}";
@@ -10,7 +11,7 @@ void handleRelayControl() {
         String body = server.arg("plain");
         debugPrintln("Relay control request body: " + body);
 
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error) {
@@ -21,14 +22,13 @@ void handleRelayControl() {
                 debugPrintln("Request to set relay " + String(relay) + " to " + String(state ? "ON" : "OFF"));
 
                 if (relay >= 0 && relay < 16) {
-                    outputStates[relay] = state;
-                    if (writeOutputs()) {
+                    if (applyOutputsOnce(OUTPUT_SRC_WEB, 1u << relay, state ? 0xFFFF : 0)) {
                         debugPrintln("Relay control successful");
                         response = "{\"status\":\"success\",\"relay\":" + String(relay) +
-                            ",\"state\":" + String(state ? "true" : "false") + "}";
+                            ",\"state\":" + String(outputStates[relay] ? "true" : "false") + "}";
 
                         // Broadcast update
-                        broadcastUpdate();
+                        broadcastUpdate(WS_TOPIC_OUTPUTS);
                     }
                     else {
                         debugPrintln("Failed to write to relay");
@@ -38,15 +38,12 @@ void handleRelayControl() {
                 else if (relay == 99) {  // Special case for all relays
                     debugPrintln("Setting all relays to " + String(state ? "ON" : "OFF"));
 
-                    for (int i = 0; i < 16; i++) {
-                        outputStates[i] = state;
-                    }
-                    if (writeOutputs()) {
+                    if (applyOutputsOnce(OUTPUT_SRC_WEB, 0xFFFF, state ? 0xFFFF : 0)) {
                         response = "{\"status\":\"success\",\"relay\":\"all\",\"state\":" +
                             String(state ? "true" : "false") + "}";
 
                         // Broadcast update
-                        broadcastUpdate();
+                        broadcastUpdate(WS_TOPIC_OUTPUTS);
                     }
                     else {
                         debugPrintln("Failed to write to relays");
@@ -72,3 +69,246 @@ void handleRelayControl() {
     server.send(200, "application/json", response);
 }
 
+
+// Parse a 16-bit mask given as a number or as a string ("0x00FF", "255")
+static bool parseOutputBits(JsonVariantConst v, uint16_t& out) {
+    if (v.is<const char*>()) {
+        const char* str = v.as<const char*>();
+        char* end = nullptr;
+        unsigned long bits = strtoul(str, &end, 0);
+        if (end == str || *end != '\0' || bits > 0xFFFF) return false;
+        out = (uint16_t)bits;
+        return true;
+    }
+    if (v.is<unsigned long>()) {
+        unsigned long bits = v.as<unsigned long>();
+        if (bits > 0xFFFF) return false;
+        out = (uint16_t)bits;
+        return true;
+    }
+    return false;
+}
+
+static String outputsResponse(const char* status) {
+    String response = "{\"status\":\"" + String(status) + "\",\"value\":" + String(getOutputMask()) +
+        ",\"pulses\":" + String(getPendingPulseMask()) + ",\"states\":[";
+    for (int i = 0; i < 16; i++) {
+        if (i) response += ",";
+        response += outputStates[i] ? "true" : "false";
+    }
+    response += "]}";
+    return response;
+}
+
+void handleGetOutputs() {
+    server.send(200, "application/json", outputsResponse("success"));
+}
+
+// POST /api/outputs
+//   {"mask": 65535, "value": 255}                          set several outputs at once
+//   {"outputs": [{"relay": 0, "state": true, "pulse_ms": 500}, ...]}
+//   {"release": 255}                                       relinquish the web level
+// The forms may be combined. The request is validated as a whole and then
+// applied in one expander write with one WebSocket broadcast; an output with
+// pulse_ms returns to the opposite state once the pulse has elapsed.
+void handleSetOutputs() {
+    if (!server.hasArg("plain")) {
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"No request body\"}");
+        return;
+    }
+
+    PooledJsonDocument doc(2048);
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        debugPrintln("Invalid JSON in outputs request: " + String(error.c_str()));
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+        return;
+    }
+
+    if (!outputsMasterEnable) {
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Outputs disabled\"}");
+        return;
+    }
+
+    uint16_t mask = 0;
+    uint16_t value = 0;
+    uint16_t release = 0;
+    uint32_t pulseMs[16] = { 0 };
+
+    if (doc.containsKey("release") && !parseOutputBits(doc["release"], release)) {
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"release must be a 16-bit number\"}");
+        return;
+    }
+
+    if (doc.containsKey("mask") || doc.containsKey("value")) {
+        if (!parseOutputBits(doc["mask"], mask) || !parseOutputBits(doc["value"], value)) {
+            server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"mask and value must be 16-bit numbers\"}");
+            return;
+        }
+    }
+
+    if (doc.containsKey("outputs")) {
+        JsonArrayConst list = doc["outputs"].as<JsonArrayConst>();
+        if (list.isNull()) {
+            server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"outputs must be an array\"}");
+            return;
+        }
+
+        for (JsonObjectConst item : list) {
+            if (!item.containsKey("relay") || !item.containsKey("state")) {
+                server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Each output needs relay and state\"}");
+                return;
+            }
+            int relay = item["relay"] | -1;
+            if (relay < 0 || relay >= 16) {
+                server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Invalid relay number: " + String(relay) + "\"}");
+                return;
+            }
+            uint32_t pulse = item["pulse_ms"] | 0UL;
+            if (pulse > OUTPUT_PULSE_MAX_MS) {
+                server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"pulse_ms too long\"}");
+                return;
+            }
+
+            const uint16_t bit = 1u << relay;
+            mask |= bit;
+            if (item["state"].as<bool>()) value |= bit;
+            else value &= ~bit;
+            pulseMs[relay] = pulse;
+        }
+    }
+
+    if (mask == 0 && release == 0) {
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Nothing to change\"}");
+        return;
+    }
+
+    debugPrintln("Applying outputs mask=0x" + String(mask, HEX) + " value=0x" + String(value & mask, HEX) +
+                 " release=0x" + String(release, HEX));
+
+    // Released outputs fall back to the next priority that holds them, or off
+    const uint8_t level = outputSourcePriority(OUTPUT_SRC_WEB);
+    relinquishOutputs(level, release & ~mask);
+    if (!(mask ? applyOutputs(OUTPUT_SRC_WEB, mask, value) : flushOutputs())) {
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Failed to write to relays\"}");
+        return;
+    }
+
+    for (uint8_t i = 0; i < 16; i++) {
+        if (pulseMs[i]) scheduleOutputPulse(i, pulseMs[i], level);
+    }
+
+    broadcastUpdate(WS_TOPIC_OUTPUTS);
+    server.send(200, "application/json", outputsResponse("success"));
+}
+
+// GET /api/outputs/priority
+// Per output: state, the priority and source in control, and every slot that
+// is set. Then the level each source commands at, the change journal (newest
+// first) and the write counters.
+void handleGetOutputPriority() {
+    const OutputStats& st = outputStats();
+
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
+
+    json.beginArray("outputs");
+    for (uint8_t i = 0; i < 16; i++) {
+        const uint8_t active = outputActivePriority(i);
+        bool value;
+        uint8_t source = 0xFF;
+        outputSlot(i, active, value, source);
+        json.beginObject();
+        json.field("relay", i);
+        json.field("state", outputStates[i]);
+        json.field("priority", active);
+        json.field("source", outputSourceName(source));
+        json.beginArray("slots");
+        for (uint8_t p = 1; p <= OUTPUT_PRIORITY_LEVELS; p++) {
+            if (!outputSlot(i, p, value, source)) continue;
+            json.beginObject();
+            json.field("priority", p);
+            json.field("state", value);
+            json.field("source", outputSourceName(source));
+            json.endObject();
+        }
+        json.endArray();
+        json.endObject();
+    }
+    json.endArray();
+
+    json.beginObject("levels");
+    for (uint8_t src = 0; src < OUTPUT_SRC_COUNT; src++) {
+        json.field(outputSourceName(src), outputSourcePriority(src));
+    }
+    json.endObject();
+
+    json.beginArray("journal");
+    OutputChange e;
+    for (uint32_t age = 0; outputJournalEntry(age, e); age++) {
+        json.beginObject();
+        json.field("ms", (unsigned long)e.ms);
+        json.field("relay", e.output);
+        json.field("state", (bool)e.state);
+        json.field("priority", e.priority);
+        json.field("source", outputSourceName(e.source));
+        json.endObject();
+    }
+    json.endArray();
+
+    json.beginObject("stats");
+    json.field("commands", (unsigned long)st.commands);
+    json.field("changes", (unsigned long)st.changes);
+    json.field("writes", (unsigned long)st.writes);
+    json.field("write_errors", (unsigned long)st.writeErrors);
+    json.endObject();
+
+    json.endObject();
+    json.end();
+}
+
+// POST /api/outputs/priority
+//   {"levels": {"modbus": 9, "schedule": 14}}     change the level of sources
+//   {"defaults": true}                            back to the built-in levels
+// Levels are 2-16; logic, pulse and interlock keep theirs. Saved to NVS.
+// Commands already held keep the level they were made at until released.
+void handleSetOutputPriority() {
+    if (!server.hasArg("plain")) {
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"No request body\"}");
+        return;
+    }
+
+    PooledJsonDocument doc(1024);
+    DeserializationError error = deserializeJson(doc, server.arg("plain"));
+    if (error) {
+        server.send(200, "application/json", "{\"status\":\"error\",\"message\":\"Invalid JSON\"}");
+        return;
+    }
+
+    // Validate everything before changing anything
+    uint8_t levels[OUTPUT_SRC_COUNT] = { 0 };
+
+    JsonObjectConst requested = doc["levels"].as<JsonObjectConst>();
+    for (JsonPairConst kv : requested) {
+        uint8_t src = 0;
+        while (src < OUTPUT_SRC_COUNT && strcmp(outputSourceName(src), kv.key().c_str()) != 0) src++;
+        const int level = kv.value() | 0;
+        if (src == OUTPUT_SRC_COUNT || src == OUTPUT_SRC_LOGIC || src == OUTPUT_SRC_PULSE ||
+            src == OUTPUT_SRC_INTERLOCK || level < 2 || level > OUTPUT_PRIORITY_LEVELS) {
+            server.send(200, "application/json",
+                        "{\"status\":\"error\",\"message\":\"Invalid level for " + String(kv.key().c_str()) + "\"}");
+            return;
+        }
+        levels[src] = level;
+    }
+
+    if (doc["defaults"] | false) resetOutputSourcePriorities();
+    for (uint8_t src = 0; src < OUTPUT_SRC_COUNT; src++) {
+        if (levels[src]) setOutputSourcePriority(src, levels[src]);
+    }
+    saveOutputSourcePriorities();
+    debugPrintln("Output source levels updated");
+
+    server.send(200, "application/json", "{\"status\":\"success\"}");
+}
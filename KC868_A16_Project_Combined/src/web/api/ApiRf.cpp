@@ -0,0 +1,132 @@
+// ApiRf.cpp
+// 433 MHz learned codes (see comm/RFManager.cpp)
+//
+//   GET  /api/rf      learned codes, last press heard, learn state, virtual inputs
+//   POST /api/rf      {"code":{"id":n,"code":..,"bits":24,"protocol":1,"action":1,"target":0,"name":".."}}
+//                     {"learn":{"action":1,"target":0,"name":".."}}   store the next press
+//                     {"id":n,"delete":true}
+//                     {"send":{"id":n}} or {"send":{"code":..,"bits":24,"protocol":1}}
+//
+// A "code" entry without an id goes to the slot already holding that code, or
+// the first free one.
+
+#include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
+
+void handleGetRf() {
+    const RfStats& st = rfStats();
+
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.beginArray("codes");
+    for (int i = 0; i < RF_MAX_CODES; i++) {
+        const RfCode& c = rfCodes[i];
+        if (c.code == 0) continue;
+        json.beginObject();
+        json.field("id", i);
+        json.field("code", (unsigned long)c.code);
+        json.field("bits", c.bits);
+        json.field("protocol", c.protocol);
+        json.field("action", c.action);
+        json.field("target", c.target);
+        json.field("name", c.name);
+        json.endObject();
+    }
+    json.endArray();
+
+    uint32_t code, ageMs;
+    uint8_t bits, protocol;
+    if (rfLastReceived(code, bits, protocol, ageMs)) {
+        json.beginObject("last");
+        json.field("code", (unsigned long)code);
+        json.field("bits", bits);
+        json.field("protocol", protocol);
+        json.field("age_ms", (unsigned long)ageMs);
+        json.field("learned", findRfCode(code) >= 0);
+        json.endObject();
+    }
+
+    json.field("learning", rfLearning());
+    json.field("virtual_inputs", rfVirtualInputs());
+
+    json.beginObject("stats");
+    json.field("presses", (unsigned long)st.received);
+    json.field("repeats_suppressed", (unsigned long)st.repeats);
+    json.field("unknown", (unsigned long)st.unknown);
+    json.field("transmitted", (unsigned long)st.transmitted);
+    json.field("tx_dropped", (unsigned long)st.txDropped);
+    json.field("tx_failed", (unsigned long)st.txFailed);
+    json.endObject();
+
+    json.endObject();
+    json.end();
+}
+
+static void readRfSettings(JsonObject src, RfCode& dst) {
+    dst.action = src["action"] | RF_ACTION_NONE;
+    dst.target = src["target"] | 0;
+    strlcpy(dst.name, src["name"] | "Remote", sizeof(dst.name));
+}
+
+void handleSetRf() {
+    String response = "{\"status\":\"error\",\"message\":\"Invalid request\"}";
+
+    if (server.hasArg("plain")) {
+        PooledJsonDocument doc(512);
+        DeserializationError error = deserializeJson(doc, server.arg("plain"));
+
+        if (!error && doc.containsKey("code")) {
+            JsonObject codeJson = doc["code"];
+            const uint32_t code = codeJson["code"] | 0UL;
+
+            int id = codeJson.containsKey("id") ? codeJson["id"].as<int>() : findRfCode(code);
+            for (int i = 0; id < 0 && i < RF_MAX_CODES; i++) {
+                if (rfCodes[i].code == 0) id = i;
+            }
+
+            if (code != 0 && id >= 0 && id < RF_MAX_CODES) {
+                // The code may already sit in another slot; keep it unique
+                const int existing = findRfCode(code);
+                if (existing >= 0 && existing != id) memset(&rfCodes[existing], 0, sizeof(RfCode));
+
+                rfCodes[id].code = code;
+                rfCodes[id].bits = codeJson["bits"] | 24;
+                rfCodes[id].protocol = codeJson["protocol"] | 1;
+                readRfSettings(codeJson, rfCodes[id]);
+                saveRfCodes();
+
+                response = "{\"status\":\"success\",\"id\":" + String(id) + "}";
+            }
+        }
+        else if (!error && doc.containsKey("learn")) {
+            RfCode settings = {};
+            readRfSettings(doc["learn"], settings);
+            startRfLearn(settings);
+            response = "{\"status\":\"success\",\"learning\":true}";
+        }
+        else if (!error && doc.containsKey("id") && doc.containsKey("delete")) {
+            int id = doc["id"].as<int>();
+
+            if (id >= 0 && id < RF_MAX_CODES && doc["delete"].as<bool>()) {
+                memset(&rfCodes[id], 0, sizeof(RfCode));
+                saveRfCodes();
+                response = "{\"status\":\"success\"}";
+            }
+        }
+        else if (!error && doc.containsKey("send")) {
+            JsonObject sendJson = doc["send"];
+            bool queued;
+            if (sendJson.containsKey("id")) {
+                queued = queueLearnedRfCode(sendJson["id"].as<uint8_t>());
+            }
+            else {
+                queued = queueRfTransmit(sendJson["code"] | 0UL, sendJson["bits"] | 24, sendJson["protocol"] | 1);
+            }
+            response = queued ? "{\"status\":\"success\"}"
+                               : "{\"status\":\"error\",\"message\":\"Unknown code or transmit queue full\"}";
+        }
+    }
+
+    server.send(200, "application/json", response);
+}
@@ -2,31 +2,46 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
 
 void handleSchedules() {
-    DynamicJsonDocument doc(4096);
-    JsonArray schedulesArray = doc.createNestedArray("schedules");
+    // Streamed: the full table no longer has to fit a 4 KB document
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
+    json.beginArray("schedules");
 
     for (int i = 0; i < MAX_SCHEDULES; i++) {
-        JsonObject schedule = schedulesArray.createNestedObject();
-        schedule["id"] = i;
-        schedule["enabled"] = schedules[i].enabled;
-        schedule["name"] = schedules[i].name;
-        schedule["triggerType"] = schedules[i].triggerType;
-        schedule["days"] = schedules[i].days;
-        schedule["hour"] = schedules[i].hour;
-        schedule["minute"] = schedules[i].minute;
-        schedule["inputMask"] = schedules[i].inputMask;
-        schedule["inputStates"] = schedules[i].inputStates;
-        schedule["logic"] = schedules[i].logic;
-        schedule["action"] = schedules[i].action;
-        schedule["targetType"] = schedules[i].targetType;
-        schedule["targetId"] = schedules[i].targetId;
+        const TimeSchedule& s = schedules[i];
+        json.beginObject();
+        json.field("id", i);
+        json.field("enabled", s.enabled);
+        json.field("name", s.name);
+        json.field("triggerType", s.triggerType);
+        json.field("days", s.days);
+        json.field("hour", s.hour);
+        json.field("minute", s.minute);
+        json.field("inputMask", s.inputMask);
+        json.field("inputStates", s.inputStates);
+        json.field("logic", s.logic);
+        json.field("action", s.action);
+        json.field("targetType", s.targetType);
+        json.field("targetId", s.targetId);
+        json.field("targetIdLow", s.targetIdLow);
+        json.field("sensorIndex", s.sensorIndex);
+        json.field("sensorTriggerType", s.sensorTriggerType);
+        json.field("sensorCondition", s.sensorCondition);
+        json.field("sensorThreshold", s.sensorThreshold);
+        json.field("sensorHysteresis", s.sensorHysteresis);
+        json.field("minOnSec", s.minOnSec);
+        json.field("minOffSec", s.minOffSec);
+        json.field("active", sensorScheduleActive(i));
+        json.endObject();
     }
 
-    String response;
-    serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    json.endArray();
+    json.endObject();
+    json.end();
 }
 
 void handleUpdateSchedule() {
@@ -34,7 +49,7 @@ void handleUpdateSchedule() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(1024);
+        PooledJsonDocument doc(1024);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error && doc.containsKey("schedule")) {
@@ -70,6 +85,9 @@ void handleUpdateSchedule() {
                     schedules[id].sensorTriggerType = scheduleJson["sensorTriggerType"] | 0;
                     schedules[id].sensorCondition = scheduleJson["sensorCondition"] | 0;
                     schedules[id].sensorThreshold = scheduleJson["sensorThreshold"] | 25.0f;
+                    schedules[id].sensorHysteresis = scheduleJson["sensorHysteresis"] | 0.0f;
+                    schedules[id].minOnSec = scheduleJson["minOnSec"] | 0;
+                    schedules[id].minOffSec = scheduleJson["minOffSec"] | 0;
                 }
 
                 // Save schedules to EEPROM
@@ -112,6 +130,9 @@ void handleUpdateSchedule() {
                 schedules[id].sensorTriggerType = 0;
                 schedules[id].sensorCondition = 0;
                 schedules[id].sensorThreshold = 25.0f;
+                schedules[id].sensorHysteresis = 0.0f;
+                schedules[id].minOnSec = 0;
+                schedules[id].minOffSec = 0;
                 snprintf(schedules[id].name, 32, "Schedule %d", id + 1);
 
                 saveSchedulesToEEPROM();
@@ -2,6 +2,7 @@
 // Auto-split from original KC868_A16_Controller.ino
 
 #include "../../FunctionPrototypes.h"
+#include "../JsonStreamWriter.h"
 #include "esp_mac.h"
 
 
@@ -32,92 +33,96 @@ static String boardEfuseMacString() {
 }
 
 void handleSystemStatus() {
-    DynamicJsonDocument doc(4096);
+    // Streamed straight to the socket; no 4 KB document or String copy
+    JsonStreamWriter json(server);
+    json.begin();
+    json.beginObject();
 
     // Add output states
-    JsonArray outputs = doc.createNestedArray("outputs");
+    json.beginArray("outputs");
     for (int i = 0; i < 16; i++) {
-        JsonObject output = outputs.createNestedObject();
-        output["id"] = i;
-        output["state"] = outputStates[i];
+        json.beginObject().field("id", i).field("state", outputStates[i]).endObject();
     }
+    json.endArray();
 
     // Add input states
-    JsonArray inputs = doc.createNestedArray("inputs");
+    json.beginArray("inputs");
     for (int i = 0; i < 16; i++) {
-        JsonObject input = inputs.createNestedObject();
-        input["id"] = i;
-        input["state"] = inputStates[i];
+        json.beginObject().field("id", i).field("state", inputStates[i]).endObject();
     }
+    json.endArray();
 
     // Add direct input states (HT1-HT3)
-    JsonArray directInputs = doc.createNestedArray("direct_inputs");
+    json.beginArray("direct_inputs");
     for (int i = 0; i < 3; i++) {
-        JsonObject input = directInputs.createNestedObject();
-        input["id"] = i;
-        input["state"] = directInputStates[i];
+        json.beginObject().field("id", i).field("state", directInputStates[i]).endObject();
     }
+    json.endArray();
 
     // Add HT sensors data
-    JsonArray htSensorsData = doc.createNestedArray("htSensors");
+    json.beginArray("htSensors");
     for (int i = 0; i < 3; i++) {
-        JsonObject sensor = htSensorsData.createNestedObject();
-        sensor["index"] = i;
-        sensor["pin"] = "HT" + String(i + 1);
-        sensor["sensorType"] = htSensorConfig[i].sensorType;
+        json.beginObject();
+        json.field("index", i);
+        json.field("pin", "HT" + String(i + 1));
+        json.field("sensorType", htSensorConfig[i].sensorType);
 
         const char* sensorTypeNames[] = {
             "Digital Input", "DHT11", "DHT22", "DS18B20"
         };
-        sensor["sensorTypeName"] = sensorTypeNames[htSensorConfig[i].sensorType];
+        json.field("sensorTypeName", sensorTypeNames[htSensorConfig[i].sensorType]);
 
         switch (htSensorConfig[i].sensorType) {
         case SENSOR_TYPE_DIGITAL:
-            sensor["value"] = directInputStates[i] ? "HIGH" : "LOW";
+            json.field("value", directInputStates[i] ? "HIGH" : "LOW");
             break;
 
         case SENSOR_TYPE_DHT11:
         case SENSOR_TYPE_DHT22:
-            sensor["temperature"] = htSensorConfig[i].temperature;
-            sensor["humidity"] = htSensorConfig[i].humidity;
+            json.field("temperature", htSensorConfig[i].temperature);
+            json.field("humidity", htSensorConfig[i].humidity);
             break;
 
         case SENSOR_TYPE_DS18B20:
-            sensor["temperature"] = htSensorConfig[i].temperature;
+            json.field("temperature", htSensorConfig[i].temperature);
             break;
         }
+        json.endObject();
     }
+    json.endArray();
 
     // Add analog inputs
-    JsonArray analog = doc.createNestedArray("analog");
+    json.beginArray("analog");
     for (int i = 0; i < 4; i++) {
-        JsonObject analogInput = analog.createNestedObject();
-        analogInput["id"] = i;
-        analogInput["value"] = analogValues[i];
-        analogInput["voltage"] = analogVoltages[i];
-        analogInput["percentage"] = calculatePercentage(analogVoltages[i]);
+        json.beginObject();
+        json.field("id", i);
+        json.field("value", analogValues[i]);
+        json.field("voltage", analogVoltages[i]);
+        json.field("percentage", calculatePercentage(analogVoltages[i]));
+        json.endObject();
     }
+    json.endArray();
 
     // Add system information
-    doc["device"] = deviceName;
-    doc["dhcp_mode"] = dhcpMode;
+    json.field("device", deviceName);
+    json.field("dhcp_mode", dhcpMode);
 
     // Add detailed network information
-    doc["wifi_connected"] = wifiConnected;
-    doc["wifi_client_mode"] = wifiClientMode;
-    doc["wifi_ap_mode"] = apMode;
-    doc["eth_connected"] = ethConnected;
-    doc["wifi_ssid"] = wifiSSID;
-    doc["wifi_rssi"] = WiFi.RSSI();
+    json.field("wifi_connected", wifiConnected);
+    json.field("wifi_client_mode", wifiClientMode);
+    json.field("wifi_ap_mode", apMode);
+    json.field("eth_connected", ethConnected);
+    json.field("wifi_ssid", wifiSSID);
+    json.field("wifi_rssi", (int)WiFi.RSSI());
 
     // Ethernet status split into "link" vs "has IP"
     bool ethLinkUp = ETH.linkUp();
-    doc["eth_link_up"] = ethLinkUp;
+    json.field("eth_link_up", ethLinkUp);
 
     // Make sure to correctly set the WiFi IP address
     String wifiIpAddress = wifiClientMode ? WiFi.localIP().toString() : (apMode ? WiFi.softAPIP().toString() : "Not connected");
-    doc["wifi_ip"] = wifiIpAddress;
-    doc["eth_ip"] = ethConnected ? ETH.localIP().toString() : (ethLinkUp ? "Link up (no IP yet)" : "Not connected");
+    json.field("wifi_ip", wifiIpAddress);
+    json.field("eth_ip", ethConnected ? ETH.localIP().toString() : (ethLinkUp ? "Link up (no IP yet)" : "Not connected"));
 
     // Set MAC address from appropriate source
     String macAddress = "";
@@ -127,8 +132,8 @@ void handleSystemStatus() {
     else if (wifiConnected) {
         macAddress = wifiClientMode ? WiFi.macAddress() : WiFi.softAPmacAddress();
     }
-        doc["board_mac"] = boardEfuseMacString();
-doc["mac"] = macAddress;
+    json.field("board_mac", boardEfuseMacString());
+    json.field("mac", macAddress);
 
     // Generate device ID from MAC (like in the JavaScript function)
     String deviceId = "unknown";
@@ -139,7 +144,7 @@ doc["mac"] = macAddress;
         deviceId = deviceId.substring(deviceId.length() - 6);
         deviceId.toUpperCase();
     }
-    doc["device_id"] = deviceId;
+    json.field("device_id", deviceId);
 
     // Generate serial number
     time_t now;
@@ -149,65 +154,64 @@ doc["mac"] = macAddress;
     char dateStr[9];
     sprintf(dateStr, "%02d%02d%02d", (timeinfo.tm_year + 1900) % 100, timeinfo.tm_mon + 1, timeinfo.tm_mday);
     String serialNumber = /*String("KC868-A16-") +*/ String(dateStr) + "-" + deviceId;
-    doc["serial_number"] = serialNumber;
+    json.field("serial_number", serialNumber);
 
-    doc["uptime"] = getUptimeString();
-    doc["active_protocol"] = getActiveProtocolName();
-    doc["firmware_version"] = FIRMWARE_VERSION;
-    doc["i2c_errors"] = i2cErrorCount;
-    doc["free_heap"] = ESP.getFreeHeap();
-    doc["cpu_freq"] = ESP.getCpuFreqMHz();
-    doc["last_error"] = lastErrorMessage;
+    json.field("uptime", getUptimeString());
+    json.field("active_protocol", getActiveProtocolName());
+    json.field("firmware_version", FIRMWARE_VERSION);
+    json.field("i2c_errors", i2cErrorCount);
+    json.field("free_heap", ESP.getFreeHeap());
+    json.field("cpu_freq", ESP.getCpuFreqMHz());
+    json.field("last_error", lastErrorMessage);
 
     // Network details in a nested object
-    JsonObject networkDetails = doc.createNestedObject("network");
-    networkDetails["dhcp_mode"] = dhcpMode;
-    networkDetails["http_port"] = httpPort;
-    networkDetails["ws_port"] = wsPort;
+    json.beginObject("network");
+    json.field("dhcp_mode", dhcpMode);
+    json.field("http_port", httpPort);
+    json.field("ws_port", wsPort);
 
     // WiFi details
     if (wifiConnected) {
         if (wifiClientMode) {
-            networkDetails["wifi_ip"] = WiFi.localIP().toString();
-            networkDetails["wifi_gateway"] = WiFi.gatewayIP().toString();
-            networkDetails["wifi_subnet"] = WiFi.subnetMask().toString();
-            networkDetails["wifi_dns1"] = WiFi.dnsIP(0).toString();
-            networkDetails["wifi_dns2"] = WiFi.dnsIP(1).toString();
-            networkDetails["wifi_rssi"] = WiFi.RSSI();
-            networkDetails["wifi_mac"] = readMacString(ESP_MAC_WIFI_STA, WIFI_STA_MAC);
-            networkDetails["wifi_ssid"] = wifiSSID;
+            json.field("wifi_ip", WiFi.localIP().toString());
+            json.field("wifi_gateway", WiFi.gatewayIP().toString());
+            json.field("wifi_subnet", WiFi.subnetMask().toString());
+            json.field("wifi_dns1", WiFi.dnsIP(0).toString());
+            json.field("wifi_dns2", WiFi.dnsIP(1).toString());
+            json.field("wifi_rssi", (int)WiFi.RSSI());
+            json.field("wifi_mac", readMacString(ESP_MAC_WIFI_STA, WIFI_STA_MAC));
+            json.field("wifi_ssid", wifiSSID);
         }
         else if (apMode) {
-            networkDetails["wifi_mode"] = "Access Point";
-            networkDetails["wifi_ap_ip"] = WiFi.softAPIP().toString();
-            networkDetails["wifi_ap_mac"] = readMacString(ESP_MAC_WIFI_SOFTAP, WIFI_AP_MAC);
-            networkDetails["wifi_ap_ssid"] = ap_ssid;
+            json.field("wifi_mode", "Access Point");
+            json.field("wifi_ap_ip", WiFi.softAPIP().toString());
+            json.field("wifi_ap_mac", readMacString(ESP_MAC_WIFI_SOFTAP, WIFI_AP_MAC));
+            json.field("wifi_ap_ssid", ap_ssid);
         }
     }
 
     // Ethernet details
     if (ethConnected) {
-        networkDetails["eth_ip"] = ETH.localIP().toString();
-        networkDetails["eth_gateway"] = ETH.gatewayIP().toString();
-        networkDetails["eth_subnet"] = ETH.subnetMask().toString();
-        networkDetails["eth_dns1"] = ETH.dnsIP(0).toString();
-        networkDetails["eth_dns2"] = ETH.dnsIP(1).toString();
-        networkDetails["eth_mac"] = readMacString(ESP_MAC_ETH, ETHERNET_MAC);
-        networkDetails["eth_speed"] = String(ETH.linkSpeed()) + " Mbps";
-        networkDetails["eth_duplex"] = ETH.fullDuplex() ? "Full" : "Half";
+        json.field("eth_ip", ETH.localIP().toString());
+        json.field("eth_gateway", ETH.gatewayIP().toString());
+        json.field("eth_subnet", ETH.subnetMask().toString());
+        json.field("eth_dns1", ETH.dnsIP(0).toString());
+        json.field("eth_dns2", ETH.dnsIP(1).toString());
+        json.field("eth_mac", readMacString(ESP_MAC_ETH, ETHERNET_MAC));
+        json.field("eth_speed", String(ETH.linkSpeed()) + " Mbps");
+        json.field("eth_duplex", ETH.fullDuplex() ? "Full" : "Half");
     }
+    json.endObject();
 
     // Add flag indicating network info is available
-    doc["rtc_initialized"] = rtcInitialized;
-    doc["network_available"] = true;
+    json.field("rtc_initialized", rtcInitialized);
+    json.field("network_available", true);
 
     // Convenience top-level MACs for UI
-    doc["eth_mac"] = readMacString(ESP_MAC_ETH, ETHERNET_MAC);
-doc["wifi_sta_mac"] = readMacString(ESP_MAC_WIFI_STA, WIFI_STA_MAC);
-doc["wifi_ap_mac"] = readMacString(ESP_MAC_WIFI_SOFTAP, WIFI_AP_MAC);
-String jsonResponse;
-    serializeJson(doc, jsonResponse);
+    json.field("eth_mac", readMacString(ESP_MAC_ETH, ETHERNET_MAC));
+    json.field("wifi_sta_mac", readMacString(ESP_MAC_WIFI_STA, WIFI_STA_MAC));
+    json.field("wifi_ap_mac", readMacString(ESP_MAC_WIFI_SOFTAP, WIFI_AP_MAC));
 
-    server.send(200, "application/json", jsonResponse);
+    json.endObject();
+    json.end();
 }
-
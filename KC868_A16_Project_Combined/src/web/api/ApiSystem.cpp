@@ -5,7 +5,6 @@
 
 void handleReboot() {
     server.send(200, "application/json", "{\"status\":\"success\",\"message\":\"Rebooting device...\"}");
-    delay(500);
-    ESP.restart();
+    scheduleRestart(500);
 }
 
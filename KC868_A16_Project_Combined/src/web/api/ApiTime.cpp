@@ -4,7 +4,7 @@
 #include "../../FunctionPrototypes.h"
 
 void handleGetTime() {
-    DynamicJsonDocument doc(256);
+    PooledJsonDocument doc(256);
 
     time_t now;
     struct tm timeinfo;
@@ -31,7 +31,7 @@ void handleSetTime() {
 
     if (server.hasArg("plain")) {
         String body = server.arg("plain");
-        DynamicJsonDocument doc(512);
+        PooledJsonDocument doc(512);
         DeserializationError error = deserializeJson(doc, body);
 
         if (!error) {
@@ -0,0 +1,168 @@
+// fuzz_bacnet.cpp
+// Fuzz target for the BACnet driver's receive path
+//
+// Each input is one UDP datagram from the client, delivered through the
+// WiFiUDP shim and picked up by BACnetDriver::task() as in the main loop
+// (parsePacket, remoteIP/remotePort, read, then processPacket).
+//
+// With clang the CMake build links this against libFuzzer
+// (-fsanitize=fuzzer,address,undefined). Without it BACNET_LIBFUZZER is not
+// defined and the main() below runs the same target under ASan/UBSan:
+//   fuzz_bacnet                  seeds, then 200000 mutated datagrams
+//   fuzz_bacnet <iterations>     seeds, then that many
+//   fuzz_bacnet <file>...        replay saved inputs (e.g. libFuzzer crashes)
+// Mutations come from a fixed seed, so a failing run repeats exactly.
+
+#include "host.h"
+#include "packets.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    static bool started = false;
+    if (!started) {
+        hostSetup(64);
+        started = true;
+    }
+    if (!hostDeliver(data, size, HOST_CLIENT_IP, HOST_CLIENT_PORT)) return 0;
+    bacnetDriver.task();
+
+    // Consume commands so every write is seen as new
+    bool active, relinquish;
+    uint8_t priority;
+    for (uint8_t ch = 0; ch < BACNET_MAX_BO; ch++) {
+        bacnetDriver.getBinaryOutputCommand(ch, active, priority, relinquish);
+        bacnetDriver.getBinaryValueCommand(ch, active);
+    }
+    return 0;
+}
+
+#ifndef BACNET_LIBFUZZER
+
+typedef std::vector<uint8_t> Packet;
+
+static std::vector<Packet> seeds() {
+    std::vector<Packet> out;
+    uint8_t buf[BACNET_PACKET_MAX];
+
+    out.push_back(Packet(buf, buf + packets::whoIs(buf)));
+    out.push_back(Packet(buf, buf + packets::readProperty(buf, 1, OBJECT_DEVICE, BACNET_DEVICE_ID, PROP_OBJECT_LIST)));
+    out.push_back(Packet(buf, buf + packets::readProperty(buf, 2, OBJECT_DEVICE, BACNET_DEVICE_ID, PROP_OBJECT_NAME)));
+    out.push_back(Packet(buf, buf + packets::readProperty(buf, 3, OBJECT_DEVICE, BACNET_DEVICE_ID, PROP_MESA_DEVICE_DATETIME)));
+    out.push_back(Packet(buf, buf + packets::readProperty(buf, 4, OBJECT_ANALOG_INPUT, 1, PROP_PRESENT_VALUE)));
+    out.push_back(Packet(buf, buf + packets::readProperty(buf, 5, OBJECT_ANALOG_INPUT, 101, PROP_UNITS)));
+    out.push_back(Packet(buf, buf + packets::readProperty(buf, 6, OBJECT_BINARY_OUTPUT, 1, PROP_PRIORITY_ARRAY)));
+    out.push_back(Packet(buf, buf + packets::readProperty(buf, 7, OBJECT_TREND_LOG, 1, PROP_RECORD_COUNT)));
+    out.push_back(Packet(buf, buf + packets::writeBinary(buf, 8, OBJECT_BINARY_OUTPUT, 1, true, 8)));
+    out.push_back(Packet(buf, buf + packets::writeBinary(buf, 9, OBJECT_BINARY_VALUE, 3, true, 0)));
+    out.push_back(Packet(buf, buf + packets::relinquish(buf, 10, OBJECT_BINARY_OUTPUT, 1, 8)));
+    out.push_back(Packet(buf, buf + packets::readRangeByPosition(buf, 11, 1, 1, 10)));
+    out.push_back(Packet(buf, buf + packets::readRangeByPosition(buf, 12, 8, 64, -20)));
+    out.push_back(Packet(buf, buf + packets::readRangeByTime(buf, 13, 2, 5)));
+
+    // Who-Is forwarded by a BBMD on behalf of 10.0.0.9:47808
+    const uint8_t forwarded[] = { 0x81, 0x04, 0x00, 0x0E, 10, 0, 0, 9, 0xBA, 0xC0, 0x01, 0x00, 0x10, 0x08 };
+    out.push_back(Packet(forwarded, forwarded + sizeof(forwarded)));
+
+    // BVLL-Result (Register-Foreign-Device NAK) and a network layer message
+    const uint8_t result[] = { 0x81, 0x00, 0x00, 0x06, 0x00, 0x30 };
+    out.push_back(Packet(result, result + sizeof(result)));
+    const uint8_t network[] = { 0x81, 0x0A, 0x00, 0x07, 0x01, 0x80, 0x00 };
+    out.push_back(Packet(network, network + sizeof(network)));
+
+    return out;
+}
+
+static uint32_t rngState = 0x2545F491u;
+
+static uint32_t rng() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static void mutate(Packet& p) {
+    const uint32_t edits = 1 + rng() % 4;
+    for (uint32_t i = 0; i < edits; i++) {
+        switch (rng() % 6) {
+        case 0:                                         // flip a bit
+            if (!p.empty()) p[rng() % p.size()] ^= (uint8_t)(1u << (rng() % 8));
+            break;
+        case 1:                                         // random byte
+            if (!p.empty()) p[rng() % p.size()] = (uint8_t)rng();
+            break;
+        case 2:                                         // boundary byte
+            if (!p.empty()) {
+                static const uint8_t edge[] = { 0x00, 0x01, 0x7F, 0x80, 0xFE, 0xFF };
+                p[rng() % p.size()] = edge[rng() % sizeof(edge)];
+            }
+            break;
+        case 3:                                         // truncate
+            if (!p.empty()) p.resize(rng() % p.size());
+            break;
+        case 4:                                         // insert
+            p.insert(p.begin() + (p.empty() ? 0 : rng() % (p.size() + 1)), (uint8_t)rng());
+            break;
+        default:                                        // grow past the BVLL length
+            p.resize(p.size() + rng() % 32, (uint8_t)rng());
+            break;
+        }
+    }
+}
+
+static bool runFile(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    Packet p;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) p.insert(p.end(), buf, buf + n);
+    fclose(f);
+    LLVMFuzzerTestOneInput(nullptr, 0);     // set-up, quietly
+    hostSerialEcho = true;
+    LLVMFuzzerTestOneInput(p.data(), p.size());
+    hostSerialEcho = false;
+    printf("%s: %u bytes ok\n", path, (unsigned)p.size());
+    return true;
+}
+
+int main(int argc, char** argv) {
+    unsigned long iterations = 200000;
+
+    if (argc > 1) {
+        char* end = nullptr;
+        const unsigned long n = strtoul(argv[1], &end, 10);
+        if (*end == '\0') {
+            iterations = n;
+        } else {
+            for (int i = 1; i < argc; i++) {
+                if (!runFile(argv[i])) {
+                    fprintf(stderr, "cannot read %s\n", argv[i]);
+                    return 1;
+                }
+            }
+            return 0;
+        }
+    }
+
+    const std::vector<Packet> corpus = seeds();
+    for (const Packet& p : corpus) LLVMFuzzerTestOneInput(p.data(), p.size());
+
+    for (unsigned long i = 0; i < iterations; i++) {
+        Packet p = corpus[rng() % corpus.size()];
+        mutate(p);
+        LLVMFuzzerTestOneInput(p.data(), p.size());
+    }
+
+    const BACnetStats& st = bacnetDriver.stats();
+    printf("%lu inputs: %lu malformed, %lu ignored, %lu replies, %lu unsupported, max %lu us\n",
+           (unsigned long)st.rxPackets, (unsigned long)st.rxMalformed, (unsigned long)st.rxIgnored,
+           (unsigned long)hostReplies.count, (unsigned long)st.unsupported, (unsigned long)st.maxServiceUs);
+    return 0;
+}
+
+#endif // BACNET_LIBFUZZER
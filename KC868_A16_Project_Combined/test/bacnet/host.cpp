@@ -0,0 +1,270 @@
+// host.cpp
+// Arduino core, WiFiUDP shim and firmware globals for the host build of the
+// BACnet driver. Only what BACnetDriver.cpp and BACnetTrendLog.cpp link
+// against is defined; the declarations live in stubs/.
+
+#include "host.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../src/Globals.h"
+#include "../../src/FunctionPrototypes.h"
+
+// ---- Clock ----
+
+static const auto hostStart = std::chrono::steady_clock::now();
+static uint32_t hostOffsetMs = 0;
+
+unsigned long micros() {
+    const auto d = std::chrono::steady_clock::now() - hostStart;
+    return (unsigned long)(uint32_t)(std::chrono::duration_cast<std::chrono::microseconds>(d).count() +
+                                     (uint64_t)hostOffsetMs * 1000);
+}
+
+unsigned long millis() {
+    const auto d = std::chrono::steady_clock::now() - hostStart;
+    return (unsigned long)(uint32_t)(std::chrono::duration_cast<std::chrono::milliseconds>(d).count() + hostOffsetMs);
+}
+
+void hostAdvanceMs(uint32_t ms) {
+    hostOffsetMs += ms;
+}
+
+// ---- Memory ----
+
+bool psramFound() {
+    return false;
+}
+
+void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+// ---- String ----
+
+String::String(const char* s) : _s(s ? s : "") {}
+String::String(const String& other) : _s(other._s) {}
+String& String::operator=(const String& other) { _s = other._s; return *this; }
+String& String::operator=(const char* s) { _s = s ? s : ""; return *this; }
+String& String::operator+=(char c) { _s += c; return *this; }
+const char* String::c_str() const { return _s.c_str(); }
+unsigned String::length() const { return (unsigned)_s.size(); }
+bool String::reserve(unsigned size) { _s.reserve(size); return true; }
+
+// ---- IPAddress (ESP32 layout: first octet in the low byte) ----
+
+IPAddress::IPAddress() : _b{ 0, 0, 0, 0 } {}
+IPAddress::IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _b{ a, b, c, d } {}
+IPAddress::IPAddress(uint32_t raw) { memcpy(_b, &raw, 4); }
+IPAddress::operator uint32_t() const { uint32_t raw; memcpy(&raw, _b, 4); return raw; }
+uint8_t IPAddress::operator[](int i) const { return _b[i]; }
+uint8_t& IPAddress::operator[](int i) { return _b[i]; }
+bool IPAddress::operator==(const IPAddress& other) const { return memcmp(_b, other._b, 4) == 0; }
+bool IPAddress::operator!=(const IPAddress& other) const { return !(*this == other); }
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _b[0], _b[1], _b[2], _b[3]);
+    return String(buf);
+}
+
+// ---- Print / Stream / Serial (Serial goes to stdout) ----
+
+bool hostSerialEcho = true;
+
+size_t Print::write(uint8_t c) {
+    if (!hostSerialEcho) return 1;
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+size_t Print::write(const uint8_t* buf, size_t len) {
+    size_t n = 0;
+    while (n < len && write(buf[n])) n++;
+    return n;
+}
+void Print::flush() { fflush(stdout); }
+
+size_t Print::println(const char* s) {
+    const size_t n = write((const uint8_t*)s, strlen(s));
+    return n + write((uint8_t)'\n');
+}
+
+size_t Print::printf(const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n <= 0) return 0;
+    return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? (size_t)n : sizeof(buf) - 1);
+}
+
+int Stream::available() { return 0; }
+int Stream::read() { return -1; }
+int Stream::peek() { return -1; }
+
+HardwareSerial::HardwareSerial(int) {}
+HardwareSerial Serial(0);
+
+// ---- WiFiUDP: one inbound datagram at a time, replies are recorded ----
+
+HostReplies hostReplies;
+static uint16_t replyLen = 0;
+
+static uint8_t inbound[HOST_UDP_MAX];
+static size_t inboundLen = 0;
+static bool inboundQueued = false;
+static IPAddress inboundIP;
+static uint16_t inboundPort = 0;
+
+// The datagram parsePacket() made current
+static size_t rxLen = 0;
+static size_t rxPos = 0;
+static IPAddress rxIP;
+static uint16_t rxPort = 0;
+
+bool hostDeliver(const uint8_t* data, size_t len, IPAddress remoteIP, uint16_t remotePort) {
+    if (len > HOST_UDP_MAX) return false;
+    if (len) memcpy(inbound, data, len);
+    inboundLen = len;
+    inboundIP = remoteIP;
+    inboundPort = remotePort;
+    inboundQueued = true;
+    return true;
+}
+
+void hostResetReplies() {
+    memset(&hostReplies, 0, sizeof(hostReplies));
+}
+
+uint8_t WiFiUDP::begin(uint16_t) { return 1; }
+
+void WiFiUDP::stop() {
+    inboundQueued = false;
+    rxLen = rxPos = 0;
+}
+
+// Like the core: the size of the next datagram (0 when there is none), which
+// then becomes the one read() and remoteIP() refer to
+int WiFiUDP::parsePacket() {
+    rxLen = rxPos = 0;
+    if (!inboundQueued) return 0;
+    inboundQueued = false;
+    rxLen = inboundLen;
+    rxIP = inboundIP;
+    rxPort = inboundPort;
+    return (int)rxLen;
+}
+
+IPAddress WiFiUDP::remoteIP() { return rxIP; }
+uint16_t WiFiUDP::remotePort() { return rxPort; }
+
+int WiFiUDP::read(uint8_t* buf, size_t len) {
+    const size_t n = std::min(len, rxLen - rxPos);
+    memcpy(buf, &inbound[rxPos], n);
+    rxPos += n;
+    return (int)n;
+}
+
+int WiFiUDP::read() {
+    return rxPos < rxLen ? inbound[rxPos++] : -1;
+}
+
+int WiFiUDP::beginPacket(IPAddress, uint16_t) {
+    replyLen = 0;
+    return 1;
+}
+
+size_t WiFiUDP::write(const uint8_t* buf, size_t len) {
+    if (replyLen + len > sizeof(hostReplies.last)) len = sizeof(hostReplies.last) - replyLen;
+    memcpy(&hostReplies.last[replyLen], buf, len);
+    replyLen += len;
+    return len;
+}
+
+size_t WiFiUDP::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+int WiFiUDP::endPacket() {
+    hostReplies.count++;
+    hostReplies.bytes += replyLen;
+    hostReplies.lastLen = replyLen;
+    return 1;
+}
+
+// ---- Firmware globals and services the driver reads ----
+
+const char* ap_ssid = "KC868-A16";
+const char* ap_password = "12345678";
+const String firmwareVersion = "host";
+const String deviceNameStr = "KC868-A16";
+const String manufacturerStr = "Microcode";
+const String yearOfDevelopmentStr = "2025";
+String hardwareVersionStr = "host";
+IPAddress wifiStaGateway(192, 168, 1, 1);
+IPAddress wifiStaSubnet(255, 255, 255, 0);
+IPAddress wifiStaDns1(192, 168, 1, 1);
+
+String getBoardMacString() {
+    return String("02:00:00:00:00:01");
+}
+
+String getDeviceSerialNumber() {
+    return String("HOST-0001");
+}
+
+String getTimeString() {
+    const time_t now = time(nullptr);
+    struct tm tm;
+    localtime_r(&now, &tm);
+    char buf[30];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm);
+    return String(buf);
+}
+
+void syncTimeFromClient(int, int, int, int, int, int) {
+    // Never touch the host clock
+}
+
+uint32_t timestampNow() {
+    return (uint32_t)time(nullptr);
+}
+
+// No other source holds an output, so Priority_Array reads are all NULL
+bool outputSlot(uint8_t, uint8_t, bool&, uint8_t&) {
+    return false;
+}
+
+// ---- Harness set-up ----
+
+const IPAddress HOST_CLIENT_IP(192, 168, 1, 20);
+const uint16_t HOST_CLIENT_PORT = BACNET_UDP_PORT;
+
+void hostSetup(uint32_t samples) {
+    bacnetDriver.setDeviceID(BACNET_DEVICE_ID);
+    bacnetTrendLogs.begin();
+    bacnetDriver.begin(IPAddress(192, 168, 1, 50), IPAddress(192, 168, 1, 1), IPAddress(255, 255, 255, 0));
+
+    // A minute per sample fills the polled logs; input 1 toggles for the COV log
+    for (uint32_t i = 0; i < samples; i++) {
+        hostAdvanceMs(60000);
+        for (uint8_t ch = 0; ch < BACNET_MAX_AI_MAIN; ch++) {
+            bacnetDriver.updateAnalogInput(ch, (float)((i + ch) % 100) / 10.0f);
+        }
+        bacnetDriver.updateSensorAnalog(101, 20.0f + (i % 50) / 10.0f, UNITS_DEGREES_CELSIUS, "DHT1 Temperature");
+        bacnetDriver.updateSensorAnalog(103, 21.0f + (i % 50) / 10.0f, UNITS_DEGREES_CELSIUS, "DHT2 Temperature");
+        bacnetDriver.updateSensorAnalog(105, 19.0f + (i % 50) / 10.0f, UNITS_DEGREES_CELSIUS, "DS18B20 Temperature");
+        bacnetDriver.updateBinaryInput(0, i & 1);
+    }
+    // The clock moved past the I-Am interval: let that announcement go now,
+    // not as a reply to the first request
+    bacnetDriver.task();
+    hostResetReplies();
+    hostSerialEcho = false;
+}
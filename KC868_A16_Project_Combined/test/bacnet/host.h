@@ -0,0 +1,45 @@
+// host.h
+// Host build of the BACnet driver: what the fuzz and bench mains share
+//
+// host.cpp defines the Arduino core pieces, a WiFiUDP shim and the firmware
+// globals BACnetDriver.cpp reads. The shim hands the driver one datagram
+// given to hostDeliver() through parsePacket()/read(), as lwIP would, and
+// records replies instead of sending them.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../src/comm/BACnetDriver.h"
+
+// Replies the driver handed to WiFiUDP since the last hostResetReplies()
+struct HostReplies {
+    uint32_t count;
+    uint32_t bytes;
+    uint16_t lastLen;
+    uint8_t last[BACNET_TX_BUFFER_SIZE];
+};
+
+// Largest UDP payload; bigger inputs are not deliverable
+#define HOST_UDP_MAX 65507
+
+// Queue one datagram for the next parsePacket(); false when too large
+bool hostDeliver(const uint8_t* data, size_t len, IPAddress remoteIP, uint16_t remotePort);
+
+extern HostReplies hostReplies;
+void hostResetReplies();
+
+// millis() runs on a virtual clock so polled trend logs can be filled fast
+void hostAdvanceMs(uint32_t ms);
+
+// Serial output goes to stdout while set; the driver logs every write, which
+// would swamp a fuzz run or a benchmark
+extern bool hostSerialEcho;
+
+// Start the driver on 192.168.1.50/24 and put `samples` records in every
+// default trend log (so ReadRange has something to walk). Turns the Serial
+// echo off once done.
+void hostSetup(uint32_t samples);
+
+extern const IPAddress HOST_CLIENT_IP;
+extern const uint16_t HOST_CLIENT_PORT;
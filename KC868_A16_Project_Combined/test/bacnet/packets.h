@@ -0,0 +1,150 @@
+// packets.h
+// BACnet/IP request encoders for the fuzz seeds and the benchmark
+//
+// Each encoder writes a complete datagram (BVLL + NPDU + APDU) into buf and
+// returns its length. buf must hold BACNET_PACKET_MAX bytes.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../../src/comm/BACnetDriver.h"
+
+#define BACNET_PACKET_MAX 64
+
+namespace packets {
+
+// Original-Unicast-NPDU, expecting a reply, confirmed request header
+inline size_t confirmedHeader(uint8_t* buf, uint8_t invokeId, uint8_t service) {
+    size_t n = 0;
+    buf[n++] = BVLL_TYPE_BACNET_IP;
+    buf[n++] = BVLL_FUNC_ORIGINAL_UNICAST_NPDU;
+    buf[n++] = 0;                        // length, set by finish()
+    buf[n++] = 0;
+    buf[n++] = 0x01;                     // protocol version
+    buf[n++] = 0x04;                     // expecting reply
+    buf[n++] = PDU_TYPE_CONFIRMED_SERVICE_REQUEST;
+    buf[n++] = 0x05;                     // unsegmented, max APDU 1476
+    buf[n++] = invokeId;
+    buf[n++] = service;
+    return n;
+}
+
+inline size_t finish(uint8_t* buf, size_t n) {
+    buf[2] = (uint8_t)(n >> 8);
+    buf[3] = (uint8_t)n;
+    return n;
+}
+
+// Context tag 0: BACnetObjectIdentifier
+inline size_t objectId(uint8_t* buf, uint8_t type, uint32_t instance) {
+    const uint32_t id = ((uint32_t)type << 22) | (instance & 0x3FFFFF);
+    buf[0] = 0x0C;
+    buf[1] = (uint8_t)(id >> 24);
+    buf[2] = (uint8_t)(id >> 16);
+    buf[3] = (uint8_t)(id >> 8);
+    buf[4] = (uint8_t)id;
+    return 5;
+}
+
+// Context tag 1: property identifier
+inline size_t propertyId(uint8_t* buf, uint32_t property) {
+    if (property < 0x100) {
+        buf[0] = 0x19;
+        buf[1] = (uint8_t)property;
+        return 2;
+    }
+    buf[0] = 0x1A;
+    buf[1] = (uint8_t)(property >> 8);
+    buf[2] = (uint8_t)property;
+    return 3;
+}
+
+inline size_t whoIs(uint8_t* buf) {
+    size_t n = 0;
+    buf[n++] = BVLL_TYPE_BACNET_IP;
+    buf[n++] = BVLL_FUNC_ORIGINAL_BROADCAST_NPDU;
+    buf[n++] = 0;
+    buf[n++] = 0;
+    buf[n++] = 0x01;
+    buf[n++] = 0x00;
+    buf[n++] = PDU_TYPE_UNCONFIRMED_SERVICE_REQUEST;
+    buf[n++] = SERVICE_UNCONFIRMED_WHO_IS;
+    return finish(buf, n);
+}
+
+inline size_t readProperty(uint8_t* buf, uint8_t invokeId, uint8_t type, uint32_t instance, uint32_t property) {
+    size_t n = confirmedHeader(buf, invokeId, SERVICE_CONFIRMED_READ_PROPERTY);
+    n += objectId(&buf[n], type, instance);
+    n += propertyId(&buf[n], property);
+    return finish(buf, n);
+}
+
+// Present_Value active/inactive at a priority (0 = none given)
+inline size_t writeBinary(uint8_t* buf, uint8_t invokeId, uint8_t type, uint32_t instance,
+                          bool active, uint8_t priority) {
+    size_t n = confirmedHeader(buf, invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY);
+    n += objectId(&buf[n], type, instance);
+    n += propertyId(&buf[n], PROP_PRESENT_VALUE);
+    buf[n++] = 0x3E;                     // opening tag 3
+    buf[n++] = 0x91;                     // enumerated, 1 octet
+    buf[n++] = active ? 1 : 0;
+    buf[n++] = 0x3F;                     // closing tag 3
+    if (priority) {
+        buf[n++] = 0x49;                 // context tag 4, 1 octet
+        buf[n++] = priority;
+    }
+    return finish(buf, n);
+}
+
+// Present_Value NULL: relinquish the level
+inline size_t relinquish(uint8_t* buf, uint8_t invokeId, uint8_t type, uint32_t instance, uint8_t priority) {
+    size_t n = confirmedHeader(buf, invokeId, SERVICE_CONFIRMED_WRITE_PROPERTY);
+    n += objectId(&buf[n], type, instance);
+    n += propertyId(&buf[n], PROP_PRESENT_VALUE);
+    buf[n++] = 0x3E;
+    buf[n++] = 0x00;                     // NULL
+    buf[n++] = 0x3F;
+    buf[n++] = 0x49;
+    buf[n++] = priority;
+    return finish(buf, n);
+}
+
+// Log_Buffer by position: `count` records from `index` (negative reads backwards)
+inline size_t readRangeByPosition(uint8_t* buf, uint8_t invokeId, uint32_t instance, uint16_t index, int8_t count) {
+    size_t n = confirmedHeader(buf, invokeId, SERVICE_CONFIRMED_READ_RANGE);
+    n += objectId(&buf[n], OBJECT_TREND_LOG, instance);
+    n += propertyId(&buf[n], PROP_LOG_BUFFER);
+    buf[n++] = 0x3E;                     // opening tag 3 (byPosition)
+    buf[n++] = 0x22;                     // unsigned, 2 octets
+    buf[n++] = (uint8_t)(index >> 8);
+    buf[n++] = (uint8_t)index;
+    buf[n++] = 0x31;                     // signed, 1 octet
+    buf[n++] = (uint8_t)count;
+    buf[n++] = 0x3F;
+    return finish(buf, n);
+}
+
+// Log_Buffer by time: `count` records after 2025-01-01 00:00
+inline size_t readRangeByTime(uint8_t* buf, uint8_t invokeId, uint32_t instance, int8_t count) {
+    size_t n = confirmedHeader(buf, invokeId, SERVICE_CONFIRMED_READ_RANGE);
+    n += objectId(&buf[n], OBJECT_TREND_LOG, instance);
+    n += propertyId(&buf[n], PROP_LOG_BUFFER);
+    buf[n++] = 0x7E;                     // opening tag 7 (byTime)
+    buf[n++] = 0xA4;                     // date
+    buf[n++] = 125;
+    buf[n++] = 1;
+    buf[n++] = 1;
+    buf[n++] = 0xFF;
+    buf[n++] = 0xB4;                     // time
+    buf[n++] = 0;
+    buf[n++] = 0;
+    buf[n++] = 0;
+    buf[n++] = 0;
+    buf[n++] = 0x31;
+    buf[n++] = (uint8_t)count;
+    buf[n++] = 0x7F;
+    return finish(buf, n);
+}
+
+} // namespace packets
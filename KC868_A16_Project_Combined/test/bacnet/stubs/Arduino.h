@@ -0,0 +1,88 @@
+#pragma once
+// Host stand-ins for the ESP32 Arduino core and the libraries Definitions.h
+// pulls in. Declarations only, enough for the BACnet sources to compile on a
+// PC; ../host.cpp defines the part the driver actually links against.
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <ctype.h>
+inline bool isDigit(int c) { return isdigit(c) != 0; }
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include "freertos/FreeRTOS.h"
+#include "esp_heap_caps.h"
+typedef bool boolean; typedef uint8_t byte;
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define OUTPUT_OPEN_DRAIN 0x12
+#define F(x) x
+#define BIN 2
+#define HEX 16
+#define DEC 10
+extern "C" size_t strlcpy(char*, const char*, size_t);
+
+#define PROGMEM
+#define IRAM_ATTR
+#define FPSTR(x) x
+class __FlashStringHelper;
+unsigned long millis(); unsigned long micros(); void delay(unsigned long); void delayMicroseconds(unsigned);
+void pinMode(int,int); int digitalRead(int); void digitalWrite(int,int); int analogRead(int);
+bool psramFound(); long random(long); long random(long,long);
+void yield();
+class String {
+public:
+  String(const char* s=""); String(const String&); String(char c); String(int, unsigned char base=10); String(unsigned, unsigned char base=10); String(long, unsigned char base=10); String(unsigned long, unsigned char base=10); String(float, unsigned d=2); String(double, unsigned d=2);
+  String& operator=(const String&); String& operator=(const char*);
+  String& operator+=(const String&); String& operator+=(const char*); String& operator+=(char); String& operator+=(int); String& operator+=(unsigned); String& operator+=(long); String& operator+=(unsigned long);
+  friend String operator+(const String&, const String&); friend String operator+(const String&, const char*); friend String operator+(const char*, const String&);
+  friend String operator+(const String&, char); friend String operator+(const String&, int); friend String operator+(const String&, unsigned long);
+  bool operator==(const String&) const; bool operator==(const char*) const; bool operator!=(const String&) const; bool operator!=(const char*) const; bool operator<(const String&) const;
+  char operator[](unsigned) const; char& operator[](unsigned);
+  const char* c_str() const; unsigned length() const; bool reserve(unsigned);
+  bool startsWith(const String&) const; bool startsWith(const char*) const; bool endsWith(const String&) const; bool equals(const String&) const; bool equalsIgnoreCase(const String&) const;
+  int indexOf(char, unsigned from=0) const; int indexOf(const String&, unsigned from=0) const; int lastIndexOf(char) const;
+  String substring(unsigned, unsigned) const; String substring(unsigned) const;
+  void trim(); void toUpperCase(); void toLowerCase(); void replace(const String&, const String&); void remove(unsigned, unsigned n=1);
+  long toInt() const; float toFloat() const; bool isEmpty() const; char charAt(unsigned) const; void concat(const char*, unsigned);
+private:
+  std::string _s;
+};
+class Print { public:
+  size_t print(const String&); size_t print(const char*); size_t print(char); size_t print(int, int b=10); size_t print(unsigned, int b=10); size_t print(long, int b=10); size_t print(unsigned long, int b=10); size_t print(double, int d=2);
+  size_t println(const String&); size_t println(const char*); size_t println(char); size_t println(int, int b=10); size_t println(unsigned, int b=10); size_t println(long, int b=10); size_t println(unsigned long, int b=10); size_t println(double, int d=2); size_t println();
+  size_t printf(const char*, ...) __attribute__((format(printf,2,3)));
+  virtual size_t write(uint8_t); virtual size_t write(const uint8_t*, size_t); size_t write(const char* s);
+  virtual void flush();
+};
+class Stream : public Print { public:
+  virtual int available(); virtual int read(); virtual int peek(); size_t readBytes(uint8_t*, size_t); size_t readBytes(char*, size_t);
+  String readStringUntil(char); String readString(); void setTimeout(unsigned long);
+};
+class HardwareSerial : public Stream { public: HardwareSerial(int); void begin(unsigned long, uint32_t cfg=0, int rx=-1, int tx=-1); void end(); int availableForWrite(); operator bool() const; };
+extern HardwareSerial Serial;
+#define SERIAL_8N1 0x800001c
+#define SERIAL_8E1 0x800001e
+#define SERIAL_8O1 0x800001f
+#define SERIAL_7N1 0x8000018
+#define SERIAL_8N2 0x800003c
+#define SERIAL_8O2 1
+#define SERIAL_8E2 2
+#define SERIAL_7N2 3
+#define SERIAL_7O1 4
+#define SERIAL_7O2 5
+#define SERIAL_7E1 6
+#define SERIAL_7E2 7
+uint32_t getCpuFrequencyMhz(); void configTime(long, int, const char*, const char* s2=nullptr, const char* s3=nullptr); void configTzTime(const char*, const char*, const char* s2=nullptr, const char* s3=nullptr);
+#include "IPAddress.h"
+#include "Esp.h"
+template<class T> T constrain(T a, T b, T c){return a<b?b:(a>c?c:a);}
+using std::min; using std::max;
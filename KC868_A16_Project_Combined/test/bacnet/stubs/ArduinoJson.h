@@ -0,0 +1,29 @@
+#pragma once
+#include "Arduino.h"
+class JsonArray; class JsonObject; class JsonVariant;
+struct JsonString { const char* c_str() const; operator const char*() const; };
+struct JsonPair { JsonString key() const; JsonVariant value() const; };
+class JsonVariantConst { public: template<class T> T as() const; template<class T> bool is() const; template<class T> operator T() const; JsonVariantConst operator[](const char*) const; JsonVariantConst operator[](int) const; bool isNull() const; size_t size() const; bool containsKey(const char*) const; };
+class JsonVariant { public:
+  template<class T> T as() const; template<class T> bool is() const; template<class T> operator T() const;
+  template<class T> JsonVariant& operator=(const T&); JsonVariant operator[](const char*) const; JsonVariant operator[](const String&) const; JsonVariant operator[](int) const;
+  bool isNull() const; size_t size() const; bool containsKey(const char*) const; bool containsKey(const String&) const; JsonArray createNestedArray(const char* k=nullptr); JsonObject createNestedObject(const char* k=nullptr); template<class T> bool add(const T&); template<class T> T to(); template<class T> bool set(const T&); template<class T> T operator|(const T&) const; const char* operator|(const char*) const; template<class T> bool operator==(const T&) const; template<class T> bool operator!=(const T&) const;
+};
+class JsonArray : public JsonVariant { public: JsonVariant* begin() const; JsonVariant* end() const; JsonObject createNestedObject(); JsonArray createNestedArray(); template<class T> bool add(const T&); JsonVariant add(); };
+class JsonObject : public JsonVariant { public: JsonPair* begin() const; JsonPair* end() const; };
+typedef JsonArray JsonArrayConst; typedef JsonObject JsonObjectConst; typedef JsonPair JsonPairConst;
+class JsonDocument : public JsonVariant { public: void clear(); size_t memoryUsage() const; size_t capacity() const; bool overflowed() const; JsonObject as_object(); template<class T> T to(); void shrinkToFit(); void garbageCollect(); };
+class DynamicJsonDocument : public JsonDocument { public: DynamicJsonDocument(size_t); };
+template<class A> class BasicJsonDocument : A, public JsonDocument { public: explicit BasicJsonDocument(size_t); };
+template<size_t N> class StaticJsonDocument : public JsonDocument { };
+struct DeserializationError { enum Code { Ok, EmptyInput, IncompleteInput, InvalidInput, NoMemory, TooDeep }; operator bool() const; const char* c_str() const; Code code() const; bool operator==(Code) const; bool operator!=(Code) const; };
+template<class D, class I> DeserializationError deserializeJson(D&, const I&);
+template<class D> DeserializationError deserializeJson(D&, const char*, size_t);
+template<class D> DeserializationError deserializeJson(D&, const uint8_t*, size_t);
+template<class D> DeserializationError deserializeJson(D&, char*, size_t);
+template<class D> size_t serializeJson(const D&, String&);
+template<class D> size_t serializeJson(const D&, char*, size_t);
+template<class D, size_t N> size_t serializeJson(const D&, char (&)[N]);
+template<class D> size_t serializeJson(const D&, Print&);
+template<class D> size_t measureJson(const D&);
+template<class D> size_t serializeJsonPretty(const D&, String&);
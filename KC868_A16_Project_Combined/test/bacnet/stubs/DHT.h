@@ -0,0 +1,5 @@
+#pragma once
+#include "Arduino.h"
+#define DHT11 11
+#define DHT22 22
+class DHT { public: DHT(uint8_t, uint8_t); void begin(); float readTemperature(bool f=false); float readHumidity(); };
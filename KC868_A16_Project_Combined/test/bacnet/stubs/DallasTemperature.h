@@ -0,0 +1,4 @@
+#pragma once
+#include "OneWire.h"
+#define DEVICE_DISCONNECTED_C -127
+class DallasTemperature { public: DallasTemperature(OneWire*); void begin(); void requestTemperatures(); float getTempCByIndex(uint8_t); uint8_t getDeviceCount(); void setWaitForConversion(bool); };
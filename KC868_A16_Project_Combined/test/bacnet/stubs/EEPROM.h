@@ -0,0 +1,4 @@
+#pragma once
+#include "Arduino.h"
+class EEPROMClass { public: bool begin(size_t); uint8_t read(int); void write(int, uint8_t); bool commit(); template<class T> T& get(int, T&); template<class T> const T& put(int, const T&); uint8_t* getDataPtr(); size_t length(); size_t readBytes(int, void*, size_t); size_t writeBytes(int, const void*, size_t); };
+extern EEPROMClass EEPROM;
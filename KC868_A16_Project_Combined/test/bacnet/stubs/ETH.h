@@ -0,0 +1,7 @@
+#pragma once
+#include "WiFi.h"
+#include "esp_netif.h"
+typedef enum { ETH_PHY_LAN8720, ETH_PHY_TLK110, ETH_PHY_RTL8201, ETH_PHY_IP101 } eth_phy_type_t;
+typedef enum { ETH_CLOCK_GPIO0_IN, ETH_CLOCK_GPIO17_OUT } eth_clock_mode_t;
+class ETHClass { public: bool begin(eth_phy_type_t t=ETH_PHY_LAN8720, int32_t a=0, int m=23, int d=18, int p=-1, eth_clock_mode_t c=ETH_CLOCK_GPIO17_OUT); bool config(IPAddress, IPAddress, IPAddress, IPAddress d1=IPAddress(), IPAddress d2=IPAddress()); IPAddress localIP(); IPAddress gatewayIP(); IPAddress subnetMask(); IPAddress dnsIP(uint8_t i=0); bool linkUp(); uint8_t linkSpeed(); bool fullDuplex(); String macAddress(); bool setHostname(const char*); const char* getHostname(); bool connected(); bool hasIP(); void end(); esp_netif_t* netif(); };
+extern ETHClass ETH;
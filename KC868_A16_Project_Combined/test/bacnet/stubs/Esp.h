@@ -0,0 +1,3 @@
+#pragma once
+class EspClass { public: uint32_t getFreeHeap(); uint32_t getMinFreeHeap(); uint32_t getMaxAllocHeap(); uint32_t getHeapSize(); uint32_t getCpuFreqMHz(); uint64_t getEfuseMac(); void restart(); uint32_t getFlashChipSize(); uint32_t getSketchSize(); uint32_t getFreeSketchSpace(); uint32_t getFreePsram(); const char* getChipModel(); uint8_t getChipRevision(); const char* getSdkVersion(); };
+extern EspClass ESP;
@@ -0,0 +1,8 @@
+#pragma once
+#include "Arduino.h"
+class File : public Stream { public: File(); operator bool() const; size_t size() const; void close(); const char* name() const; const char* path() const; size_t write(uint8_t) override; size_t write(const uint8_t*, size_t) override; int read() override; size_t read(uint8_t*, size_t); bool seek(uint32_t); size_t position() const; bool isDirectory(); File openNextFile(); int available() override; time_t getLastWrite(); };
+namespace fs { class FS { public: File open(const char*, const char* m="r"); File open(const String&, const char* m="r"); bool exists(const char*); bool exists(const String&); bool remove(const char*); bool remove(const String&); bool rename(const char*, const char*); bool rename(const String&, const String&); bool mkdir(const char*); }; }
+using fs::FS;
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
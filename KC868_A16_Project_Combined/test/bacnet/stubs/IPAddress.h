@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+class String;
+class IPAddress { public: IPAddress(); IPAddress(uint8_t,uint8_t,uint8_t,uint8_t); IPAddress(uint32_t); operator uint32_t() const; uint8_t operator[](int) const; uint8_t& operator[](int);
+  bool operator==(const IPAddress&) const; bool operator!=(const IPAddress&) const; String toString() const; bool fromString(const char*); bool fromString(const String&);
+private:
+  uint8_t _b[4]; };
+extern const IPAddress INADDR_NONE;
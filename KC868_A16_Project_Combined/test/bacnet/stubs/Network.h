@@ -0,0 +1,8 @@
+#pragma once
+#include <stdint.h>
+typedef enum { ARDUINO_EVENT_ETH_START, ARDUINO_EVENT_ETH_STOP, ARDUINO_EVENT_ETH_CONNECTED, ARDUINO_EVENT_ETH_DISCONNECTED, ARDUINO_EVENT_ETH_GOT_IP, ARDUINO_EVENT_ETH_LOST_IP, ARDUINO_EVENT_WIFI_STA_START, ARDUINO_EVENT_WIFI_STA_CONNECTED, ARDUINO_EVENT_WIFI_STA_DISCONNECTED, ARDUINO_EVENT_WIFI_STA_GOT_IP, ARDUINO_EVENT_WIFI_STA_LOST_IP, ARDUINO_EVENT_WIFI_AP_START, ARDUINO_EVENT_WIFI_AP_STOP, ARDUINO_EVENT_WIFI_AP_STACONNECTED, ARDUINO_EVENT_WIFI_AP_STADISCONNECTED, ARDUINO_EVENT_WIFI_SCAN_DONE, ARDUINO_EVENT_WIFI_READY, ARDUINO_EVENT_WIFI_STA_STOP } arduino_event_id_t;
+typedef arduino_event_id_t WiFiEvent_t;
+typedef struct { struct { uint8_t reason; } wifi_sta_disconnected; } arduino_event_info_t;
+typedef struct { arduino_event_id_t event_id; arduino_event_info_t event_info; } arduino_event_t;
+class NetworkClass { public: bool begin(); int onEvent(void(*)(arduino_event_id_t)); int onEvent(void(*)(arduino_event_id_t, arduino_event_info_t)); };
+extern NetworkClass Network;
@@ -0,0 +1,5 @@
+#pragma once
+#include "Arduino.h"
+class Preferences { public: bool begin(const char*, bool ro=false); void end(); bool isKey(const char*); bool clear(); bool remove(const char*);
+ size_t putBool(const char*, bool); size_t putUInt(const char*, uint32_t); size_t putUShort(const char*, uint16_t); size_t putUChar(const char*, uint8_t); size_t putInt(const char*, int32_t); size_t putString(const char*, const String&); size_t putBytes(const char*, const void*, size_t); size_t putFloat(const char*, float); size_t putULong(const char*, uint32_t);
+ bool getBool(const char*, bool d=false); uint32_t getUInt(const char*, uint32_t d=0); uint16_t getUShort(const char*, uint16_t d=0); uint8_t getUChar(const char*, uint8_t d=0); int32_t getInt(const char*, int32_t d=0); String getString(const char*, const String& d=String()); size_t getBytes(const char*, void*, size_t); size_t getBytesLength(const char*); float getFloat(const char*, float d=0); uint32_t getULong(const char*, uint32_t d=0); };
@@ -0,0 +1,3 @@
+#pragma once
+#include "Arduino.h"
+class RCSwitch { public: RCSwitch(); void enableReceive(int); void enableTransmit(int); bool available(); void resetAvailable(); unsigned long getReceivedValue(); unsigned getReceivedBitlength(); unsigned getReceivedProtocol(); unsigned getReceivedDelay(); void send(unsigned long, unsigned); void setProtocol(int); void setRepeatTransmit(int); void setPulseLength(int); };
@@ -0,0 +1,4 @@
+#pragma once
+#include "Arduino.h"
+class DateTime { public: DateTime(uint32_t t=0); DateTime(const char*, const char*); DateTime(uint16_t,uint8_t,uint8_t,uint8_t h=0,uint8_t m=0,uint8_t s=0); uint16_t year() const; uint8_t month() const; uint8_t day() const; uint8_t hour() const; uint8_t minute() const; uint8_t second() const; uint8_t dayOfTheWeek() const; uint32_t unixtime() const; };
+class RTC_DS3231 { public: bool begin(); DateTime now(); void adjust(const DateTime&); bool lostPower(); float getTemperature(); };
@@ -0,0 +1,4 @@
+#pragma once
+#include "FS.h"
+class SPIFFSFS : public fs::FS { public: bool begin(bool f=false, const char* b="/spiffs", uint8_t m=10, const char* l=nullptr); void end(); size_t totalBytes(); size_t usedBytes(); bool format(); };
+extern SPIFFSFS SPIFFS;
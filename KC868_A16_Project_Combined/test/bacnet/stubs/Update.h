@@ -0,0 +1,7 @@
+#pragma once
+#include "Arduino.h"
+#define U_FLASH 0
+#define U_SPIFFS 100
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+class UpdateClass { public: bool begin(size_t s=UPDATE_SIZE_UNKNOWN, int c=U_FLASH); size_t write(uint8_t*, size_t); bool end(bool e=false); bool hasError(); void printError(Print&); const char* errorString(); bool isFinished(); void abort(); size_t progress(); size_t size(); };
+extern UpdateClass Update;
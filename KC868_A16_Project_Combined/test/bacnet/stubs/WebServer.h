@@ -0,0 +1,12 @@
+#pragma once
+#include "WiFi.h"
+#include "FS.h"
+#include "HTTP_Method.h"
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+#define HTTP_UPLOAD_BUFLEN 1436
+typedef struct { HTTPUploadStatus status; String filename; String name; String type; size_t totalSize; size_t currentSize; uint8_t buf[HTTP_UPLOAD_BUFLEN]; } HTTPUpload;
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+class WebServer { public: typedef std::function<void(void)> THandlerFunction; WebServer(int port=80); void begin(); void handleClient(); void close(); void stop();
+ void on(const String&, THandlerFunction); void on(const String&, HTTPMethod, THandlerFunction); void on(const String&, HTTPMethod, THandlerFunction, THandlerFunction); void onNotFound(THandlerFunction); void serveStatic(const char*, fs::FS&, const char*, const char* c=nullptr);
+ String uri(); HTTPMethod method(); String arg(const String&); String arg(int); String argName(int); int args(); bool hasArg(const String&); String header(const String&); bool hasHeader(const String&); void collectHeaders(const char**, size_t); String hostHeader(); HTTPUpload& upload(); WiFiClient client();
+ void send(int, const char*, const String&); void send(int, const char* t=nullptr, const char* c=nullptr); void send(int, const String&, const String&); void send_P(int, const char*, const char*, size_t); void sendHeader(const String&, const String&, bool f=false); void setContentLength(size_t); void sendContent(const String&); void sendContent(const char*, size_t); template<class T> size_t streamFile(T&, const String&, int code=200); };
@@ -0,0 +1,7 @@
+#pragma once
+#include "Arduino.h"
+#define WEBSOCKETS_SERVER_CLIENT_MAX 4
+typedef enum { WStype_ERROR, WStype_DISCONNECTED, WStype_CONNECTED, WStype_TEXT, WStype_BIN, WStype_FRAGMENT_TEXT_START, WStype_FRAGMENT_BIN_START, WStype_FRAGMENT, WStype_FRAGMENT_FIN, WStype_PING, WStype_PONG } WStype_t;
+class WebSocketsServer { public: typedef std::function<void(uint8_t, WStype_t, uint8_t*, size_t)> WebSocketServerEvent; WebSocketsServer(uint16_t port, const String& origin="", const String& protocol="arduino"); void begin(); void loop(); void close(); void onEvent(WebSocketServerEvent);
+ bool sendTXT(uint8_t, const uint8_t*, size_t l=0, bool h=false); bool sendTXT(uint8_t, const char*, size_t l=0, bool h=false); bool sendTXT(uint8_t, String&); bool broadcastTXT(const uint8_t*, size_t l=0, bool h=false); bool broadcastTXT(const char*, size_t l=0, bool h=false); bool broadcastTXT(String&);
+ bool sendBIN(uint8_t, const uint8_t*, size_t, bool h=false); bool broadcastBIN(const uint8_t*, size_t, bool h=false); void disconnect(uint8_t); IPAddress remoteIP(uint8_t); uint8_t connectedClients(bool p=false); bool clientIsConnected(uint8_t); };
@@ -0,0 +1,12 @@
+#include "esp_netif.h"
+#pragma once
+#include "Arduino.h"
+#include "WiFiUdp.h"
+#include "Network.h"
+typedef enum { WL_IDLE_STATUS=0, WL_NO_SSID_AVAIL, WL_SCAN_COMPLETED, WL_CONNECTED, WL_CONNECT_FAILED, WL_CONNECTION_LOST, WL_DISCONNECTED } wl_status_t;
+typedef enum { WIFI_MODE_NULL=0, WIFI_OFF=0, WIFI_STA, WIFI_AP, WIFI_AP_STA } wifi_mode_t;
+class WiFiClient : public Stream { public: WiFiClient(); bool connected(); operator bool(); void stop(); int available() override; int read() override; int read(uint8_t*, size_t); size_t write(uint8_t) override; size_t write(const uint8_t*, size_t) override; IPAddress remoteIP(); uint16_t remotePort(); void setNoDelay(bool); int fd() const; int setTimeout(uint32_t); int peek() override; void flush() override; IPAddress localIP(); };
+class WiFiServer { public: WiFiServer(uint16_t port=80, uint8_t max=4); void begin(uint16_t port=0); void setNoDelay(bool); WiFiClient available(); WiFiClient accept(); bool hasClient(); void end(); void stop(); operator bool(); };
+struct STAClass { esp_netif_t* netif(); };
+class WiFiClass { public: STAClass STA; wl_status_t status(); wl_status_t begin(const char*, const char* p=nullptr); wl_status_t begin(const String&, const String&); bool disconnect(bool w=false, bool e=false); bool reconnect(); bool mode(wifi_mode_t); wifi_mode_t getMode(); IPAddress localIP(); IPAddress gatewayIP(); IPAddress subnetMask(); IPAddress dnsIP(uint8_t i=0); IPAddress softAPIP(); IPAddress broadcastIP(); int8_t RSSI(); String SSID(); String macAddress(); bool softAP(const char*, const char* p=nullptr); bool softAPdisconnect(bool w=false); bool config(IPAddress, IPAddress, IPAddress, IPAddress d1=IPAddress(), IPAddress d2=IPAddress()); bool setAutoReconnect(bool); bool isConnected(); bool setHostname(const char*); const char* getHostname(); bool persistent(bool); bool setSleep(bool); int onEvent(std::function<void(arduino_event_id_t, arduino_event_info_t)>); int onEvent(void(*)(arduino_event_id_t)); String softAPmacAddress(); };
+extern WiFiClass WiFi;
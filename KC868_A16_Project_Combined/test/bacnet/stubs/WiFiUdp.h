@@ -0,0 +1,4 @@
+#pragma once
+#include "Arduino.h"
+class UDP : public Stream {};
+class WiFiUDP : public UDP { public: uint8_t begin(uint16_t); uint8_t begin(IPAddress, uint16_t); void stop(); int parsePacket(); IPAddress remoteIP(); uint16_t remotePort(); int read(uint8_t*, size_t); int read(); int beginPacket(IPAddress, uint16_t); int endPacket(); size_t write(const uint8_t*, size_t); size_t write(uint8_t); };
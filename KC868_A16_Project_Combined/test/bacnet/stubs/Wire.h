@@ -0,0 +1,4 @@
+#pragma once
+#include "Arduino.h"
+class TwoWire : public Stream { public: bool begin(int sda=-1, int scl=-1, uint32_t f=0); bool end(); bool setClock(uint32_t); uint32_t getClock(); void beginTransmission(uint8_t); uint8_t endTransmission(bool stop=true); uint8_t requestFrom(uint8_t, uint8_t, bool stop=true); size_t write(uint8_t) override; size_t write(const uint8_t*, size_t) override; int available() override; int read() override; void flush() override; void setTimeOut(uint16_t); uint16_t getTimeOut(); };
+extern TwoWire Wire;
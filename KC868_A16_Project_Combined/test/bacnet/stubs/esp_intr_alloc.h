@@ -0,0 +1,3 @@
+#pragma once
+#include <stdint.h>
+int esp_intr_alloc(int, int, void*, void*, void*);
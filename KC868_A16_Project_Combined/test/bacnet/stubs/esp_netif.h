@@ -0,0 +1,14 @@
+#pragma once
+#include <stdint.h>
+typedef int esp_err_t;
+#define ESP_OK 0
+#define ESP_FAIL -1
+typedef struct esp_netif_obj esp_netif_t;
+typedef struct { uint32_t addr; } esp_ip4_addr_t;
+typedef struct { esp_ip4_addr_t ip, netmask, gw; } esp_netif_ip_info_t;
+esp_err_t esp_netif_dhcpc_stop(esp_netif_t*); esp_err_t esp_netif_dhcpc_start(esp_netif_t*); esp_err_t esp_netif_set_ip_info(esp_netif_t*, const esp_netif_ip_info_t*); esp_err_t esp_netif_get_ip_info(esp_netif_t*, esp_netif_ip_info_t*);
+const char* esp_err_to_name(esp_err_t);
+#define IP4_ADDR(a,b,c,d,e)
+#define ESP_IP4TOADDR(a,b,c,d) 0
+#define ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED 0x5003
+void esp_netif_set_default_netif(esp_netif_t*);
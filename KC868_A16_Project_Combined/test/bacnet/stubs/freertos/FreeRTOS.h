@@ -0,0 +1,23 @@
+#pragma once
+#include <stdint.h>
+typedef void* TaskHandle_t; typedef void* QueueHandle_t; typedef void* SemaphoreHandle_t; typedef uint32_t TickType_t; typedef int BaseType_t; typedef unsigned UBaseType_t;
+typedef struct { int x; } portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {0}
+#define portMAX_DELAY 0xffffffff
+#define pdMS_TO_TICKS(x) (x)
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portTICK_PERIOD_MS 1
+#define tskNO_AFFINITY 0x7fffffff
+void portENTER_CRITICAL(portMUX_TYPE*); void portEXIT_CRITICAL(portMUX_TYPE*);
+void taskENTER_CRITICAL(portMUX_TYPE*); void taskEXIT_CRITICAL(portMUX_TYPE*);
+void portENTER_CRITICAL_ISR(portMUX_TYPE*); void portEXIT_CRITICAL_ISR(portMUX_TYPE*);
+typedef void (*TaskFunction_t)(void*);
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t, TaskHandle_t*, BaseType_t);
+BaseType_t xTaskCreate(TaskFunction_t, const char*, uint32_t, void*, UBaseType_t, TaskHandle_t*);
+void vTaskDelay(TickType_t); void vTaskDelete(TaskHandle_t); TaskHandle_t xTaskGetCurrentTaskHandle(); UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t); const char* pcTaskGetName(TaskHandle_t); TickType_t xTaskGetTickCount();
+void vTaskDelayUntil(TickType_t*, TickType_t);
+QueueHandle_t xQueueCreate(UBaseType_t, UBaseType_t); BaseType_t xQueueSend(QueueHandle_t, const void*, TickType_t); BaseType_t xQueueSendToBack(QueueHandle_t, const void*, TickType_t); BaseType_t xQueueReceive(QueueHandle_t, void*, TickType_t); BaseType_t xQueueSendFromISR(QueueHandle_t, const void*, BaseType_t*); UBaseType_t uxQueueMessagesWaiting(QueueHandle_t); BaseType_t xQueueOverwrite(QueueHandle_t,const void*); BaseType_t xQueuePeek(QueueHandle_t, void*, TickType_t);
+SemaphoreHandle_t xSemaphoreCreateMutex(); SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(); SemaphoreHandle_t xSemaphoreCreateBinary(); BaseType_t xSemaphoreTake(SemaphoreHandle_t, TickType_t); BaseType_t xSemaphoreGive(SemaphoreHandle_t); BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t, TickType_t); BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t);
+BaseType_t xTaskNotifyGive(TaskHandle_t); uint32_t ulTaskNotifyTake(BaseType_t, TickType_t);
@@ -0,0 +1,140 @@
+#!/usr/bin/env python3
+"""
+build_web_assets.py
+Minify + gzip the SPIFFS web UI (data/) and write a content-hash manifest.
+
+Usage:
+    python tools/build_web_assets.py [--src data] [--out build/spiffs]
+
+Output (upload the --out directory as the SPIFFS image, e.g. with mkspiffs
+or by copying it over data/ before "ESP32 Sketch Data Upload"):
+
+    /index.html.gz   /script.js.gz   /style.css.gz   /assets.json
+
+index.html references are rewritten to "script.js?v=<hash>" so the
+firmware can send script/style with a one-year immutable Cache-Control;
+index.html itself is revalidated with its ETag (304 on repeat visits).
+
+rjsmin / rcssmin are used when installed; otherwise a conservative
+whitespace/comment strip is applied and gzip does the rest.
+"""
+
+import argparse
+import gzip
+import hashlib
+import json
+import os
+import re
+import sys
+
+ASSETS = [
+    # (source file, content type, immutable)
+    ("style.css", "text/css", True),
+    ("script.js", "application/javascript", True),
+    ("index.html", "text/html", False),   # last: references the hashed assets
+]
+
+HASH_LEN = 12
+
+
+def minify_css(text):
+    try:
+        import rcssmin
+        return rcssmin.cssmin(text)
+    except ImportError:
+        pass
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};,>])\s*", r"\1", text)
+    text = re.sub(r":\s+", ":", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify_js(text):
+    try:
+        import rjsmin
+        return rjsmin.jsmin(text)
+    except ImportError:
+        pass
+    # Template literals make line-level comment stripping unsafe; only drop
+    # indentation, trailing whitespace and blank lines.
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line) + "\n"
+
+
+def minify_html(text):
+    text = re.sub(r"<!--(?!\[).*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line) + "\n"
+
+
+MINIFIERS = {
+    "text/css": minify_css,
+    "application/javascript": minify_js,
+    "text/html": minify_html,
+}
+
+
+def gzip_bytes(data):
+    # mtime=0 keeps the output (and its hash) reproducible
+    return gzip.compress(data, compresslevel=9, mtime=0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    root = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    parser.add_argument("--src", default=os.path.join(root, "data"))
+    parser.add_argument("--out", default=os.path.join(root, "build", "spiffs"))
+    args = parser.parse_args()
+
+    os.makedirs(args.out, exist_ok=True)
+
+    manifest = {"version": 1, "assets": {}}
+    hashes = {}
+    total_in = total_out = 0
+
+    for name, content_type, immutable in ASSETS:
+        src_path = os.path.join(args.src, name)
+        if not os.path.isfile(src_path):
+            print(f"error: {src_path} not found", file=sys.stderr)
+            return 1
+
+        with open(src_path, "r", encoding="utf-8") as f:
+            text = f.read()
+        raw_size = len(text.encode("utf-8"))
+
+        if name == "index.html":
+            for ref, digest in hashes.items():
+                text = re.sub(r'(["\'])' + re.escape(ref) + r'(["\'])',
+                              r"\g<1>" + ref + "?v=" + digest + r"\g<2>", text)
+
+        body = MINIFIERS[content_type](text).encode("utf-8")
+        digest = hashlib.sha256(body).hexdigest()[:HASH_LEN]
+        hashes[name] = digest
+
+        packed = gzip_bytes(body)
+        out_name = name + ".gz"
+        with open(os.path.join(args.out, out_name), "wb") as f:
+            f.write(packed)
+
+        manifest["assets"]["/" + name] = {
+            "file": "/" + out_name,
+            "type": content_type,
+            "etag": '"' + digest + '"',
+            "immutable": immutable,
+            "size": len(packed),
+        }
+
+        total_in += raw_size
+        total_out += len(packed)
+        print(f"{name:12s} {raw_size:8d} -> {len(body):8d} min -> {len(packed):7d} gz  {digest}")
+
+    with open(os.path.join(args.out, "assets.json"), "w", encoding="utf-8") as f:
+        json.dump(manifest, f, separators=(",", ":"))
+
+    print(f"{'total':12s} {total_in:8d} -> {total_out:7d} bytes  ({args.out})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+"""
+ota_upload.py
+Resumable firmware / filesystem image upload for the KC868-A16 web API.
+
+Usage:
+    python tools/ota_upload.py 192.168.1.50 build/KC868_A16.ino.bin
+    python tools/ota_upload.py 192.168.1.50 build/spiffs.bin --target fs
+
+The image is sent in --chunk sized pieces to /api/ota/chunk?offset=N. After a
+timeout or dropped connection the script asks /api/ota/status where the device
+got to and continues from there, so a flaky Wi-Fi link costs one chunk instead
+of the whole transfer. Pass --resume to continue a session started earlier.
+"""
+
+import argparse
+import hashlib
+import json
+import sys
+import time
+import urllib.error
+import urllib.request
+import uuid
+
+
+def request(url, data=None, content_type="application/json", timeout=30):
+    req = urllib.request.Request(url, data=data, method="POST" if data is not None else "GET")
+    if data is not None:
+        req.add_header("Content-Type", content_type)
+    try:
+        with urllib.request.urlopen(req, timeout=timeout) as resp:
+            return resp.status, json.loads(resp.read() or b"{}")
+    except urllib.error.HTTPError as e:
+        return e.code, json.loads(e.read() or b"{}")
+
+
+def multipart(payload):
+    boundary = uuid.uuid4().hex
+    head = (f"--{boundary}\r\n"
+            f'Content-Disposition: form-data; name="file"; filename="chunk.bin"\r\n'
+            f"Content-Type: application/octet-stream\r\n\r\n").encode()
+    tail = f"\r\n--{boundary}--\r\n".encode()
+    return head + payload + tail, "multipart/form-data; boundary=" + boundary
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("host")
+    parser.add_argument("image")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--target", choices=("app", "fs"), default="app")
+    parser.add_argument("--chunk", type=int, default=64 * 1024)
+    parser.add_argument("--retries", type=int, default=10)
+    parser.add_argument("--resume", action="store_true")
+    parser.add_argument("--no-reboot", action="store_true")
+    args = parser.parse_args()
+
+    base = f"http://{args.host}:{args.port}/api/ota"
+    with open(args.image, "rb") as f:
+        image = f.read()
+    digest = hashlib.sha256(image).hexdigest()
+
+    if args.resume:
+        _, status = request(base + "/status")
+        if status.get("state") != "receiving" or status.get("size") != len(image):
+            print("error: no matching update in progress on the device", file=sys.stderr)
+            return 1
+    else:
+        code, status = request(base + "/begin", json.dumps(
+            {"target": args.target, "size": len(image), "sha256": digest}).encode())
+        if code != 200:
+            print(f"error: {status.get('error', code)}", file=sys.stderr)
+            return 1
+
+    offset = status.get("received", 0)
+    failures = 0
+    start = time.time()
+    while offset < len(image):
+        body, content_type = multipart(image[offset:offset + args.chunk])
+        try:
+            code, status = request(f"{base}/chunk?offset={offset}", body, content_type)
+        except (OSError, ValueError) as e:
+            code, status = 0, {"error": str(e)}
+
+        if code == 200:
+            offset = status["received"]
+            failures = 0
+            rate = offset / max(time.time() - start, 0.001) / 1024
+            print(f"\r{offset:9d} / {len(image)} bytes  {rate:6.1f} KB/s", end="", flush=True)
+            continue
+
+        failures += 1
+        if failures > args.retries or (code == 400 and status.get("state") == "error"):
+            print(f"\nerror: {status.get('error', code)}", file=sys.stderr)
+            return 1
+        time.sleep(min(2 ** failures, 30))
+        try:
+            _, status = request(base + "/status")
+            offset = status.get("received", offset)
+        except OSError:
+            pass
+
+    print()
+    code, status = request(base + "/finish", json.dumps({"reboot": not args.no_reboot}).encode())
+    if code != 200:
+        print(f"error: {status.get('error', code)}", file=sys.stderr)
+        return 1
+    print(f"done: {status.get('partition')} sha256 {status.get('sha256')}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -94,4 +94,8 @@
 #define MB_REG_SERSET_START    240   // 240..243
 #define MB_REG_BUZZ_START      250   // 250..255
 
+// Heap telemetry input registers (FC 04), refreshed every HEAP_SAMPLE_INTERVAL_MS
+#define MB_REG_HEAP_START      260   // 260..267
+#define HEAP_SAMPLE_INTERVAL_MS 5000
+
 #endif // CONFIG_H
\ No newline at end of file
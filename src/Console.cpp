@@ -0,0 +1,48 @@
+/**
+ * @file Console.cpp
+ * @brief Implementation of LineReader and the console command lookup
+ */
+
+#include "Console.h"
+
+bool LineReader::feed(char c) {
+    // The previous line has been consumed by now
+    if (_ready) reset();
+
+    if (c == '\r' || c == '\n') {
+        // Trim trailing blanks; a blank line is not a command
+        while (_len > 0 && _buf[_len - 1] == ' ') _len--;
+        if (_len == 0 && !_overflow) return false;
+        _buf[_len] = '\0';
+        _ready = true;
+        return true;
+    }
+    if (c == 0x08 || c == 0x7F) {
+        if (_len > 0 && !_overflow) _len--;
+        return false;
+    }
+    if (_len == 0 && (c == ' ' || c == '\t')) return false;
+    if (_len < CONSOLE_LINE_MAX) _buf[_len++] = c;
+    else _overflow = true;
+    return false;
+}
+
+bool LineReader::poll(Stream& in) {
+    while (in.available()) {
+        if (feed((char)in.read())) return true;
+    }
+    return false;
+}
+
+const ConsoleCommand* findConsoleCommand(const ConsoleCommand* table, size_t count, const char* name) {
+    size_t lo = 0;
+    size_t hi = count;
+    while (lo < hi) {
+        const size_t mid = (lo + hi) / 2;
+        const int c = strcmp(name, table[mid].name);
+        if (c == 0) return &table[mid];
+        if (c < 0) hi = mid;
+        else lo = mid + 1;
+    }
+    return nullptr;
+}
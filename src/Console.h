@@ -0,0 +1,60 @@
+/**
+ * @file Console.h
+ * @brief Line assembly and command lookup shared by the serial and TCP consoles
+ *
+ * LineReader collects a command from whatever bytes a Stream already has and
+ * keeps a partial line for the next call, so a half-sent command never blocks
+ * loop() the way readStringUntil() with a stream timeout does:
+ *
+ *   static LineReader reader;
+ *   while (reader.poll(Serial)) {
+ *       if (reader.overflowed()) Serial.println("ERR TOOLONG");
+ *       else execSerialCommand(reader.line());
+ *   }
+ *
+ * A line longer than CONSOLE_LINE_MAX is still ended by '\r'/'\n' but comes
+ * back marked overflowed(); it must be rejected, never run truncated.
+ *
+ * ConsoleCommand tables map the (upper-case) command word to a handler and are
+ * searched with findConsoleCommand(); keep each table sorted by name.
+ */
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <Arduino.h>
+
+#define CONSOLE_LINE_MAX 384   // longest command: SCHED UPSERT with every field (~290)
+
+class LineReader {
+public:
+    LineReader() : _len(0), _ready(false), _overflow(false) {}
+
+    // Reads what is available; true when line() holds a complete command
+    bool poll(Stream& in);
+
+    // Same, one byte at a time; '\r' or '\n' ends a line, BS/DEL edit it
+    bool feed(char c);
+
+    const char* line() const { return _buf; }
+    bool overflowed() const { return _overflow; }
+    void reset() { _len = 0; _ready = false; _overflow = false; }
+
+private:
+    char _buf[CONSOLE_LINE_MAX + 1];
+    size_t _len;
+    bool _ready;
+    bool _overflow;     // bytes were dropped from the pending line
+};
+
+typedef void (*ConsoleHandler)(const String& args);
+
+struct ConsoleCommand {
+    const char* name;
+    ConsoleHandler handler;
+};
+
+// Binary search of a table sorted by name (strcmp order); nullptr if absent
+const ConsoleCommand* findConsoleCommand(const ConsoleCommand* table, size_t count, const char* name);
+
+#endif // CONSOLE_H
@@ -4,9 +4,13 @@
 
 #include "Debug.h"
 #include <stdarg.h>
+#ifdef ESP32
+#include <esp_heap_caps.h>
+#endif
 
 bool Debug::initialized = false;
 uint8_t Debug::currentLevel = DEBUG_LEVEL; // default from compile-time setting
+HeapStats Debug::heap = {};
 const char* Debug::levelNames[] = { "NONE", "ERROR", "WARNING", "INFO", "DEBUG", "TRACE" };
 
 void Debug::begin(unsigned long baudRate) {
@@ -45,11 +49,33 @@ void Debug::log(uint8_t level, const char* format, ...) {
 
 void Debug::logMemoryUsage() {
 #ifdef ESP32
-    Serial.print("Free heap: ");
-    Serial.println(ESP.getFreeHeap());
+    sampleHeap();
+    Serial.printf("Free heap: %lu (min %lu), largest block: %lu, fragmentation: %u%%, loop stack free: %lu\n",
+        (unsigned long)heap.freeBytes, (unsigned long)heap.minFreeBytes, (unsigned long)heap.largestBlock,
+        heap.fragmentationPct, (unsigned long)heap.loopStackFree);
 #endif
 }
 
+// Must be called from the loop task (its stack is the one measured)
+void Debug::sampleHeap() {
+#ifdef ESP32
+    const uint32_t freeBytes = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    const uint32_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    const bool first = (heap.freeBytes == 0);
+
+    heap.freeBytes = freeBytes;
+    heap.minFreeBytes = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    heap.largestBlock = largest;
+    if (first || largest < heap.largestBlockMin) heap.largestBlockMin = largest;
+    heap.fragmentationPct = freeBytes ? (uint8_t)(100 - (uint64_t)largest * 100 / freeBytes) : 0;
+    heap.loopStackFree = uxTaskGetStackHighWaterMark(nullptr);
+#endif
+}
+
+const HeapStats& Debug::heapStats() {
+    return heap;
+}
+
 void Debug::scanI2CDevices(TwoWire& wire) {
     Serial.println("I2C scan:");
     uint8_t deviceCount = 0;
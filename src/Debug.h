@@ -31,11 +31,23 @@
 
 #define LOG_MEMORY() Debug::logMemoryUsage()
 
+// Heap / stack sample taken by Debug::sampleHeap()
+struct HeapStats {
+    uint32_t freeBytes;
+    uint32_t minFreeBytes;      // lowest free heap since boot
+    uint32_t largestBlock;      // largest single allocation currently possible
+    uint32_t largestBlockMin;   // lowest sampled largest block
+    uint8_t fragmentationPct;   // 100 - largest block / free heap
+    uint32_t loopStackFree;     // loop task stack never used (bytes)
+};
+
 class Debug {
 public:
     static void begin(unsigned long baudRate = 115200);
     static void log(uint8_t level, const char* format, ...);
     static void logMemoryUsage();
+    static void sampleHeap();
+    static const HeapStats& heapStats();
     static void scanI2CDevices(TwoWire& wire = Wire);
     static void debugAssert(bool condition, const char* message = nullptr);
     static void MSGPrintln(String message);
@@ -52,6 +64,7 @@ private:
     static bool initialized;
     static const char* levelNames[];
     static uint8_t currentLevel;
+    static HeapStats heap;
 };
 
 #endif // DEBUG_H
\ No newline at end of file
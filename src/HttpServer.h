@@ -0,0 +1,256 @@
+#pragma once
+/**
+ * HttpServer.h
+ * Event-driven HTTP/1.1 server with the WebServer API subset used by this firmware.
+ *
+ * Socket work (accept, request parsing, body receive, response streaming) runs
+ * in a dedicated FreeRTOS task over non-blocking sockets and select(), so a slow
+ * client downloading script.js no longer holds up the main loop. Route handlers
+ * still run in the main loop from handleClient(), as they did with WebServer, so
+ * existing handlers touch application state without extra locking.
+ *
+ *  - up to HTTP_MAX_CONNECTIONS concurrent connections with keep-alive
+ *  - responses: fixed length, chunked (setContentLength(CONTENT_LENGTH_UNKNOWN)
+ *    followed by sendContent()), or a File streamed by the task. Response bytes
+ *    are queued in fixed HTTP_OUT_BLOCK blocks that the task frees as they go
+ *    out, so a long body never regrows or compacts one buffer
+ *  - request bodies come out of a bounded arena (HTTP_BODY_ARENA_BYTES total,
+ *    HTTP_MAX_BODY_BYTES per request); multipart uploads are streamed to the
+ *    upload handler in HTTP_UPLOAD_BUFLEN pieces and never buffered whole
+ *  - a handler writing more than HTTP_OUT_HIGH_WATER with sendContent() does
+ *    not wait for the client: the task starts sending while the handler is
+ *    still running. A fixed-length body may be buffered up to the length the
+ *    handler declared; a chunked one is cut off (and the client dropped) once
+ *    HTTP_OUT_MAX_BUFFERED is unsent
+ *  - long chunked bodies (journal, metrics) are pumped instead: the handler
+ *    sends the start, then passes pumpContent() a function that writes the next
+ *    piece with sendContent() and returns false after the last. handleClient()
+ *    calls it again each time the task has sent the backlog below
+ *    HTTP_OUT_HIGH_WATER, so the body is produced as fast as the client reads it
+ *  - long-lived streams (server-sent events): a handler calls beginStream()
+ *    instead of send() and keeps the returned id; the main loop then pushes
+ *    data with streamWrite() until the client goes away
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <WebServer.h>      // HTTPMethod, HTTPUpload, CONTENT_LENGTH_UNKNOWN
+#include <functional>
+#include <vector>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+// --------------------------- Configuration ---------------------------
+#define HTTP_MAX_CONNECTIONS        5
+#define HTTP_MAX_HEADER_BYTES       2048
+#define HTTP_MAX_BODY_BYTES         8192
+#define HTTP_BODY_ARENA_BYTES       16384
+#define HTTP_MAX_ARGS               24
+#define HTTP_MAX_COLLECTED_HEADERS  8
+#define HTTP_KEEPALIVE_MS           5000
+#define HTTP_REQUEST_TIMEOUT_MS     10000
+#define HTTP_OUT_HIGH_WATER         8192     // buffered response bytes before the task sends during the handler
+#define HTTP_OUT_MAX_BUFFERED       32768    // unsent response bytes before a slow client is dropped
+#define HTTP_OUT_BLOCK              1460     // response bytes per queued block (one TCP segment)
+#define HTTP_FILE_CHUNK             1460
+#define HTTP_TASK_STACK             6144
+#define HTTP_TASK_PRIORITY          2
+#define HTTP_TASK_CORE              0
+#define HTTP_MAX_STREAMS            2        // leaves the other slots for ordinary requests
+#define HTTP_STREAM_MAX_BACKLOG     4096     // unsent stream bytes before a slow reader is dropped
+
+class HttpServer {
+public:
+    typedef std::function<void(void)> THandlerFunction;
+    typedef std::function<bool(void)> TContentPump;    // false once the body is complete
+
+    explicit HttpServer(int port = 80);
+
+    void begin();
+    void stop();            // closes the listener and every connection; begin() reopens
+    void handleClient();    // runs ready route handlers; call from the main loop
+
+    // Routing
+    void on(const String& uri, THandlerFunction fn);
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn);
+    void on(const String& uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void onNotFound(THandlerFunction fn);
+
+    // Current request (valid inside a handler)
+    String uri() const;
+    HTTPMethod method() const;
+    String arg(const String& name) const;
+    String arg(int i) const;
+    String argName(int i) const;
+    int args() const;
+    bool hasArg(const String& name) const;
+    String header(const String& name) const;
+    bool hasHeader(const String& name) const;
+    void collectHeaders(const char* headerKeys[], const size_t headerKeysCount);
+    String hostHeader() const;
+    HTTPUpload& upload();
+    const uint8_t* rawBody(size_t& len) const;  // binary-safe body (not multipart / form)
+
+    // Response
+    void sendHeader(const String& name, const String& value, bool first = false);
+    void setContentLength(const size_t contentLength);
+    void send(int code, const char* contentType = nullptr, const String& content = String(""));
+    void send(int code, const String& contentType, const String& content);
+    void sendContent(const String& content);
+    void sendContent(const char* content, size_t size);
+    size_t streamFile(File& file, const String& contentType, const int code = 200);
+    void pumpContent(TContentPump fn);          // rest of the body, from the loop (see header comment)
+
+    // Streams (see header comment). Ids are never reused by a later connection.
+    int beginStream(const char* contentType);   // -1 when all stream slots are taken
+    bool streamWrite(int id, const char* data, size_t len);
+    void endStream(int id);
+
+    // Diagnostics
+    uint8_t activeConnections() const;
+    uint32_t requestCount() const { return _requests; }
+    TaskHandle_t taskHandle() const { return _task; }
+
+private:
+    enum ConnState : uint8_t {
+        CONN_FREE = 0,
+        CONN_READ_HEADERS,
+        CONN_READ_BODY,
+        CONN_UPLOAD_WAIT,       // upload event ready for the loop
+        CONN_READY,             // request complete, handler not yet run
+        CONN_DISPATCHING,       // owned by the loop (handler running)
+        CONN_RESPONDING,        // task drains the out queue / file
+        CONN_STREAMING,         // open-ended response fed by streamWrite()
+    };
+
+    enum MultipartState : uint8_t {
+        MP_PREAMBLE = 0,
+        MP_HEADERS,
+        MP_DATA,
+        MP_EPILOGUE,
+    };
+
+    struct OutBlock {
+        OutBlock* next;
+        uint16_t len;
+        uint16_t sent;
+        char data[HTTP_OUT_BLOCK];
+    };
+
+    struct Route {
+        String uri;
+        HTTPMethod method;
+        THandlerFunction fn;
+        THandlerFunction ufn;
+    };
+
+    struct Conn {
+        int fd;
+        uint8_t generation;                 // bumped per accepted connection (stream ids)
+        ConnState state;
+        uint32_t lastActivityMs;
+        uint32_t requestStartMs;
+
+        // Raw input (headers, multipart data, pipelined requests)
+        char* in;
+        size_t inLen;
+
+        // Parsed request
+        HTTPMethod method;
+        String uri;
+        String host;
+        String contentType;
+        bool http10;
+        bool keepAlive;
+        bool expectContinue;
+        int route;                          // index into _routes, -1 = not found
+        String argNames[HTTP_MAX_ARGS];
+        String argValues[HTTP_MAX_ARGS];
+        uint8_t argCount;
+        String headerValues[HTTP_MAX_COLLECTED_HEADERS];
+
+        // Body
+        size_t contentLength;
+        size_t bodyReceived;
+        char* body;                         // arena-accounted buffer (non-multipart)
+
+        // Multipart
+        bool multipart;
+        MultipartState mpState;
+        String boundary;
+        bool mpFile;
+        bool uploadOpen;
+        String mpField;
+        String mpValue;
+        HTTPUpload* upload;
+
+        // Response
+        OutBlock* outHead;                  // sent from here
+        OutBlock* outTail;                  // appended here
+        size_t outPending;                  // queued, not yet sent
+        File file;
+        uint8_t* chunk;
+        size_t chunkLen;
+        size_t chunkSent;
+        bool headersSent;
+        bool chunked;
+        bool closeAfter;
+        bool broken;                        // client dropped during the handler; output discarded
+        bool draining;                      // task sends the queue while the handler still writes
+        bool closing;                       // socket gone, waiting for the loop to release
+        bool lengthSet;
+        bool streaming;
+        size_t responseLength;
+        String extraHeaders;
+        TContentPump pump;                  // called and destroyed only by the loop
+    };
+
+    int _port;
+    int _listenFd;
+    TaskHandle_t _task;
+    SemaphoreHandle_t _lock;
+    std::vector<Route> _routes;
+    THandlerFunction _notFound;
+    String _collected[HTTP_MAX_COLLECTED_HEADERS];
+    uint8_t _collectedCount;
+    Conn _conns[HTTP_MAX_CONNECTIONS];
+    Conn* _current;
+    size_t _arenaUsed;
+    uint32_t _requests;
+
+    static void taskEntry(void* arg);
+    void taskLoop();
+
+    void acceptClient();
+    void resetConn(Conn& c);
+    void closeConn(Conn& c);
+    void releaseConn(Conn& c);
+    void resetRequest(Conn& c);
+    void freeBody(Conn& c);
+
+    void readConn(Conn& c);
+    void processInput(Conn& c);
+    int parseHeaders(Conn& c, size_t headerLen);
+    void startBody(Conn& c);
+    void finishBody(Conn& c);
+    void parseMultipart(Conn& c);
+    bool emitUpload(Conn& c, HTTPUploadStatus status);
+    void parseArgs(Conn& c, const char* query, size_t len);
+    void addArg(Conn& c, const String& name, const String& value);
+    void sendError(Conn& c, int code, const char* message);
+
+    void dispatch(Conn& c);
+    void finishResponse(Conn& c);
+    void pumpConn(Conn& c);
+    bool writeConn(Conn& c);
+    bool sendPending(Conn& c);
+    bool appendOut(Conn& c, const char* data, size_t len);
+    bool sendOut(Conn& c);
+    void freeOut(Conn& c);
+    void readStream(Conn& c);
+    Conn* streamConn(int id);
+
+    void lock();
+    void unlock();
+};
@@ -1,4 +1,5 @@
 #include "MQTT_Manager.h"
+#include "Debug.h"
 
 #ifdef ESP32
 #include <Preferences.h>
@@ -351,6 +352,11 @@ void MQTTManager::publishSys(bool) {
 
 #ifdef ESP32
     publish(topic("sys/heap_free"), String(ESP.getFreeHeap()), false);
+    const HeapStats& hs = Debug::heapStats();
+    publish(topic("sys/heap_min_free"), String(hs.minFreeBytes), false);
+    publish(topic("sys/heap_largest_block"), String(hs.largestBlock), false);
+    publish(topic("sys/heap_frag_pct"), String(hs.fragmentationPct), false);
+    publish(topic("sys/stack_free_loop"), String(hs.loopStackFree), false);
 #endif
     publish(topic("sys/failed_conn_count"), String(_failedConnCount), MQTT_RETAIN_STATES);
     publish(topic("sys/reconnect_backoff_ms"), String(_reconnectBackoffMs), false);
@@ -571,6 +577,10 @@ void MQTTManager::publishSnapshotJson(bool /*forceAll*/, bool retainedOverride)
     json += "\",\"uptime_ms\":" + String(millis());
 #ifdef ESP32
     json += ",\"heap_free\":" + String(ESP.getFreeHeap());
+    json += ",\"heap_min_free\":" + String(Debug::heapStats().minFreeBytes);
+    json += ",\"heap_largest_block\":" + String(Debug::heapStats().largestBlock);
+    json += ",\"heap_frag_pct\":" + String(Debug::heapStats().fragmentationPct);
+    json += ",\"stack_free_loop\":" + String(Debug::heapStats().loopStackFree);
 #endif
     json += ",\"failed_conn_count\":" + String(_failedConnCount);
     json += ",\"reconnect_backoff_ms\":" + String(_reconnectBackoffMs);
@@ -3,6 +3,7 @@
   MQTT_Manager.h (Refined)
   Added:
     - sys/heap_free, sys/failed_conn_count, sys/reconnect_backoff_ms publishing.
+    - sys/heap_min_free, sys/heap_largest_block, sys/heap_frag_pct, sys/stack_free_loop (see Debug::sampleHeap).
     - rtc/alarm1_active, rtc/alarm1_time topics.
     - Public getters for failed connection count & backoff for status display.
     - Extended snapshot JSON with new health + RTC alarm fields.
@@ -105,7 +105,7 @@ static const char* KEY_A_TOL = "a_tol";      // tolerance for EQUAL (mV or mA)
 // ======================================================================
 // WIFI AP / CONFIG PORTAL
 // ======================================================================
-WebServer g_http(80);
+HttpServer g_http(80);
 String g_apSsid = "A8RM-SETUP";
 String g_apPass = "cortexlink";
 bool   g_runConfigPortal = false;
@@ -15,7 +15,7 @@ static String contentTypeFromPath(const String& path) {
     return "application/octet-stream";
 }
 
-void WebDashboard::addNoCacheHeaders(WebServer& server) {
+void WebDashboard::addNoCacheHeaders(HttpServer& server) {
     server.sendHeader("Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
     server.sendHeader("Pragma", "no-cache");
     server.sendHeader("Expires", "0");
@@ -38,7 +38,7 @@ String WebDashboard::jsonEscape(const String& s) {
     return out;
 }
 
-bool WebDashboard::begin(WebServer& server, const DashboardMqttInfo& info) {
+bool WebDashboard::begin(HttpServer& server, const DashboardMqttInfo& info) {
     g_info = info;
 
     bool fsOk = LittleFS.begin(true);
@@ -69,8 +69,8 @@ bool WebDashboard::begin(WebServer& server, const DashboardMqttInfo& info) {
             return;
         }
         File f = LittleFS.open("/index.html", "r");
+        // The server task sends the file and closes it
         server.streamFile(f, "text/html; charset=utf-8");
-        f.close();
         });
 
     server.onNotFound([&server]() {
@@ -91,7 +91,6 @@ bool WebDashboard::begin(WebServer& server, const DashboardMqttInfo& info) {
 
         File f = LittleFS.open(path, "r");
         server.streamFile(f, contentTypeFromPath(path));
-        f.close();
         });
 
     return fsOk;
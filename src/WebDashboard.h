@@ -1,6 +1,6 @@
 #pragma once
 #include <Arduino.h>
-#include <WebServer.h>
+#include "HttpServer.h"
 
 struct DashboardMqttInfo {
 	String baseTopic;
@@ -18,9 +18,9 @@ struct DashboardMqttInfo {
 
 class WebDashboard {
 public:
-	static bool begin(WebServer& server, const DashboardMqttInfo& info);
+	static bool begin(HttpServer& server, const DashboardMqttInfo& info);
 
 private:
-	static void addNoCacheHeaders(WebServer& server);
+	static void addNoCacheHeaders(HttpServer& server);
 	static String jsonEscape(const String& s);
 };
\ No newline at end of file